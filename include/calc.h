@@ -18,6 +18,26 @@ enum {
     E_WTF	= 99
 };
 
+/* operators with vectorized implementations, see calc__binop() */
+enum {
+    CALC_ADD,
+    CALC_SUB,
+    CALC_MUL,
+    CALC_DIV,
+    CALC_MIN,
+    CALC_MAX,
+    CALC_EQ,
+    CALC_NE,
+    CALC_GT,
+    CALC_GE,
+    CALC_LT,
+    CALC_LE,
+    CALC_AND,
+    CALC_OR,
+    CALC_AND2,
+    CALC_OR2
+};
+
 typedef struct func_desc
 {
     const char *name;
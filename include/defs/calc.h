@@ -6,6 +6,11 @@ extern void calc_init(int);
 extern void pre_exec(void);
 extern void post_exec(void);
 
+extern int calc__binop(int, int, void *, const void *, const void *, int);
+extern int calc__if(int, void *, const DCELL *, const void *, const void *,
+		    int, int);
+extern int calc__isnull(int, CELL *, const void *, int);
+
 extern func_t f_add;
 extern func_t f_sub;
 extern func_t f_mul;
@@ -254,6 +254,14 @@ int
 G_zstd_expand(unsigned char *src, int src_sz, unsigned char *dst,
 	      int dst_sz);
 
+/* cmprshuf.c : byte-shuffle and prediction, then ZSTD or LZ4 */
+int
+G_shuffle_compress(unsigned char *src, int src_sz, unsigned char *dst,
+		   int dst_sz);
+int
+G_shuffle_expand(unsigned char *src, int src_sz, unsigned char *dst,
+		 int dst_sz);
+
 /* add more compression methods here */
 
 /* copy_dir.c */
@@ -739,6 +747,14 @@ int G_str_to_sql(char *);
 void G_squeeze(char *);
 char *G_strcasestr(const char *, const char *);
 
+/* task.c */
+struct G_task *G_task_spawn(void (*)(void *), void *);
+void G_task_wait(struct G_task *);
+int G_set_num_threads(int);
+int G_num_threads(void);
+void G_parallel_for(int, int, int, void (*)(int, int, void *), void *);
+void G_finish_tasks(void);
+
 /* tempfile.c */
 void G_init_tempfile(void);
 char *G_tempfile(void);
@@ -779,6 +795,11 @@ char **G_tokenize2(const char *, const char *, const char *);
 int G_number_of_tokens(char **);
 void G_free_tokens(char **);
 
+/* trace.c */
+double G_trace_begin(void);
+void G_trace_end(const char *, const char *, double);
+void G_trace_count(const char *, double);
+
 /* trim_dec.c */
 void G_trim_decimal(char *);
 
@@ -852,6 +873,7 @@ void G_begin_execute(void (*func)(void *), void *, void **, int);
 void G_end_execute(void **);
 void G_init_workers(void);
 void G_finish_workers(void);
+int G_num_workers(void);
 
 /* wr_cellhd.c */
 void G__write_Cell_head(FILE *, const struct Cell_head *, int);
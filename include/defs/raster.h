@@ -270,6 +270,21 @@ void Rast_histogram_eq_fp_colors(struct Colors *,
 void Rast_log_colors(struct Colors *, struct Colors *, int);
 void Rast_abs_log_colors(struct Colors *, struct Colors *, int);
 
+/* cross_stats.c */
+void Rast_init_cross_stats(struct Cross_stats *, int, int, const int *);
+void Rast_set_cross_stats_memory(struct Cross_stats *, int);
+void Rast_set_cross_stats_range(struct Cross_stats *, int, CELL, CELL);
+void Rast_update_cross_stats(struct Cross_stats *, const CELL *, long,
+			     const double *);
+void Rast_update_cross_stats_row(struct Cross_stats *, CELL **, int, long,
+				 const double *);
+void Rast_merge_cross_stats(struct Cross_stats *, struct Cross_stats *);
+int Rast_find_cross_stat(struct Cross_stats *, const CELL *, long *,
+			 double **);
+void Rast_rewind_cross_stats(struct Cross_stats *);
+int Rast_next_cross_stat(struct Cross_stats *, CELL *, long *, double *);
+void Rast_free_cross_stats(struct Cross_stats *);
+
 /* format.c */
 int Rast__check_format(int);
 int Rast__read_row_ptrs(int);
@@ -335,7 +350,23 @@ void Rast_get_c_row(int, CELL *, int);
 void Rast_get_f_row(int, FCELL *, int);
 void Rast_get_d_row(int, DCELL *, int);
 void Rast_get_null_value_row(int, char *, int);
+const void *Rast_get_row_ptr(int, int, RASTER_MAP_TYPE);
+void Rast_get_block(int, void *, int, int, int, int, RASTER_MAP_TYPE);
+void Rast_get_tile(int, void *, int, int, RASTER_MAP_TYPE);
+void Rast_get_rows(int, void *, int, int, RASTER_MAP_TYPE);
+void Rast_get_rows_2d(int, void **, int, int, RASTER_MAP_TYPE);
+void Rast__drop_mask_rows(void);
+void Rast__map_data(int);
+void Rast__unmap_data(int);
 int Rast__read_null_bits(int, int, unsigned char *);
+void Rast__init_read_ctx(struct R_read_ctx *, int);
+void Rast__free_read_ctx(struct R_read_ctx *);
+struct R_read_ctx *Rast_create_read_ctx(int);
+void Rast_free_read_ctx(struct R_read_ctx *);
+void Rast_get_row_ctx(struct R_read_ctx *, void *, int, RASTER_MAP_TYPE);
+void Rast_get_row_nomask_ctx(struct R_read_ctx *, void *, int,
+			     RASTER_MAP_TYPE);
+void Rast_get_null_value_row_ctx(struct R_read_ctx *, char *, int);
 
 /* get_row_colr.c */
 void Rast_get_row_colors(int, int, struct Colors *,
@@ -388,6 +419,7 @@ void Rast__check_init(void);
 void Rast_init_all(void);
 void Rast__init(void);
 void Rast__error_handler(void *);
+int Rast__num_workers(void);
 
 /* interp.c */
 DCELL Rast_interp_linear(double, DCELL, DCELL);
@@ -455,6 +487,7 @@ int Rast_get_cell_format(CELL);
 int Rast_open_fp_new(const char *);
 int Rast_open_fp_new_uncompressed(const char *);
 void Rast_set_fp_type(RASTER_MAP_TYPE);
+void Rast_set_compressor(int);
 int Rast_map_is_fp(const char *, const char *);
 RASTER_MAP_TYPE Rast_map_type(const char *, const char *);
 RASTER_MAP_TYPE Rast__check_fp_type(const char *, const char *);
@@ -462,8 +495,18 @@ RASTER_MAP_TYPE Rast_get_map_type(int);
 int Rast_open_new(const char *, RASTER_MAP_TYPE);
 int Rast_open_new_uncompressed(const char *, RASTER_MAP_TYPE);
 void Rast_set_quant_rules(int, struct Quant *);
+int Rast__open_overview_new(const char *, int, RASTER_MAP_TYPE);
 int Rast__open_null_write(const char *);
 
+/* overview.c */
+void Rast__overview_element(char *, int, const char *);
+void Rast_use_overviews(int);
+int Rast_get_overview(int);
+int Rast__select_overview(const char *, const char *, struct Cell_head *);
+void Rast__write_overview_level(int);
+void Rast_remove_overviews(const char *);
+void Rast_build_overviews(const char *, const int *, int, int);
+
 /* put_cellhd.c */
 void Rast_put_cellhd(const char *, struct Cell_head *);
 
@@ -473,6 +516,8 @@ void Rast_put_c_row(int, const CELL *);
 void Rast_put_f_row(int, const FCELL *);
 void Rast_put_d_row(int, const DCELL *);
 void Rast__write_null_bits(int, const unsigned char *);
+void Rast__flush_put_rows(int);
+void Rast__free_put_rows(int);
 
 /* put_title.c */
 int Rast_put_cell_title(const char *, const char *);
@@ -556,6 +601,13 @@ void Rast_write_vdatum(const char *, const char *);
 /* rast_to_img_string.c */
 int Rast_map_to_img_str(char *, int, unsigned char*);
 
+/* read_ahead.c */
+void Rast_set_read_ahead(int, int);
+int Rast__read_ahead_get(int, void *, int, RASTER_MAP_TYPE, int);
+void Rast__drop_read_ahead(int);
+void Rast__drop_all_read_ahead(void);
+void Rast__free_read_ahead(int);
+
 /* reclass.c */
 int Rast_is_reclass(const char *, const char *, char *, char *);
 int Rast_is_reclassed_to(const char *, const char *, int *, char ***);
@@ -576,6 +628,24 @@ void Rast_unset_window(void);
 void Rast_set_output_window(struct Cell_head *);
 void Rast_set_input_window(struct Cell_head *);
 
+/* simd.c */
+void Rast__xdr_put_f_row(void *, const FCELL *, char *, int);
+void Rast__xdr_put_d_row(void *, const DCELL *, char *, int);
+void Rast__xdr_get_f_row(FCELL *, const void *, int);
+void Rast__xdr_get_d_row(DCELL *, const void *, int);
+void Rast__decode_c_row(CELL *, const unsigned char *, int, int);
+void Rast__convert_row(void *, RASTER_MAP_TYPE, const void *, RASTER_MAP_TYPE,
+		       int);
+void Rast__embed_null_flags(void *, const char *, int, RASTER_MAP_TYPE, int);
+void Rast__pack_null_flags(unsigned char *, const char *, int);
+void Rast__unpack_null_bits(char *, const unsigned char *, int, int);
+
+/* tile.c */
+void Rast_set_tile_size(int, int);
+int Rast_get_tile_size(int, int *, int *);
+int Rast__tile_cols(int);
+int Rast__row_ptr_count(int);
+
 /* vrt.c */
 struct R_vrt *Rast_get_vrt(const char *, const char *);
 void Rast_close_vrt(struct R_vrt *);
@@ -50,7 +50,14 @@ extern stat_func_w w_var;
 extern stat_func_w w_skew;
 extern stat_func_w w_kurt;
 
+extern void c_quantiles(DCELL *, DCELL *, int, const double *, int);
+
 extern int sort_cell(DCELL *, int);
 extern int sort_cell_w(DCELL(*)[2], int);
 
+extern int compact_cell(DCELL *, int);
+extern int compact_cell_w(DCELL(*)[2], int);
+extern void select_cells(DCELL *, int, const int *, int);
+extern DCELL select_cell_w(DCELL(*)[2], int, double);
+
 #endif
@@ -21,6 +21,13 @@
 #define INTERP_BILINEAR  2		/* bilinear interpolation          */
 #define INTERP_BICUBIC   3		/* bicubic interpolation           */
 
+/*! \brief Resampling methods of overviews
+
+  For Rast_build_overviews()
+*/
+#define OVERVIEW_NEAREST 0		/* value of the center cell        */
+#define OVERVIEW_AVERAGE 1		/* average of the non-null cells   */
+
 /*** typedefs ***/
 typedef int RASTER_MAP_TYPE;
 
@@ -204,6 +211,45 @@ struct Cell_stats
     int curoffset;
 };
 
+/* Accumulators of the entries of a Cross_stats table */
+#define CROSS_STATS_SUM 0
+#define CROSS_STATS_MIN 1
+#define CROSS_STATS_MAX 2
+
+struct R_cross_run;
+
+/*! \brief Counts of combinations of categories (cross tabulation) */
+struct Cross_stats
+{
+    int nkeys;			/* categories of a combination */
+    int nvals;			/* accumulators of an entry */
+    int *ops;			/* CROSS_STATS_* of each accumulator */
+    size_t size;		/* slots, a power of two */
+    size_t n;			/* entries */
+    size_t max_entries;		/* entries kept in memory, 0: no limit */
+    unsigned int *tags;		/* hash of the slot, 0: empty */
+    CELL *keys;
+    long *counts;
+    double *vals;
+    size_t last;		/* slot of the last update */
+    int have_last;
+    size_t *order;		/* slots in the order of the keys */
+    size_t cur;
+    struct R_cross_run *runs;	/* sorted runs spilled to disk */
+    int nruns;
+    CELL *range_min;		/* categories of each key counted in */
+    CELL *range_max;		/* the dense array, max < min: not set */
+    size_t dense_size;		/* combinations of the ranges, 0: none */
+    unsigned char *dense_used;
+    long *dense_counts;
+    double *dense_vals;
+    size_t *dense_list;		/* indices of the used combinations */
+    size_t dense_n;
+    CELL *dense_key;
+    size_t *row_idx;		/* dense indices of the cells of a row */
+    int row_len;
+};
+
 struct Histogram
 {
     int num;
@@ -250,6 +296,7 @@ struct FP_stats {
 
 struct GDAL_link;
 struct R_vrt;
+struct R_read_ctx;
 
 /*** prototypes ***/
 #include <grass/defs/raster.h>
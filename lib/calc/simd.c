@@ -0,0 +1,1066 @@
+/*!
+   \file lib/calc/simd.c
+
+   \brief Calc library - Vectorized operators
+
+   Vectorized implementations of the binary arithmetic, comparison and
+   logical operators, min() and max(), if() and isnull(). On x86
+   processors the SSE2 or AVX2 variant is chosen at run time according
+   to the CPU (and to the GRASS_RASTER_SIMD environment variable).
+
+   The kernels process the leading cells of a buffer and return how many
+   cells they have done; the operator functions do the remaining cells,
+   or all of them where no kernel is available. The null handling is the
+   same as in the operator functions, so the results are bitwise
+   identical.
+
+   (C) 2026 by the GRASS Development Team
+
+   This program is free software under the GNU General Public License
+   (>=v2).  Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/calc.h>
+#include <grass/glocale.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define X86_KERNELS
+#include <immintrin.h>
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+#define CELL_NULL ((CELL) 0x80000000)
+
+static struct
+{
+    int (*binop) (int, int, void *, const void *, const void *, int);
+    int (*cond) (int, void *, const DCELL *, const void *, const void *,
+		 int, int);
+    int (*isnull) (int, CELL *, const void *, int);
+} kernel;
+
+static int initialized;
+
+/*--------------------------------------------------------------------------*/
+
+/* portable variants, the operator functions do all the work */
+
+static int binop_none(int op, int type, void *res, const void *a,
+		      const void *b, int n)
+{
+    return 0;
+}
+
+static int cond_none(int type, void *res, const DCELL * c, const void *a,
+		     const void *b, int argc, int n)
+{
+    return 0;
+}
+
+static int isnull_none(int type, CELL * res, const void *a, int n)
+{
+    return 0;
+}
+
+/*--------------------------------------------------------------------------*/
+
+#ifdef X86_KERNELS
+
+/* SSE2 variants */
+
+/* b in the lanes of mask m, a in the others */
+static SSE2 __m128i blend_sse2(__m128i a, __m128i b, __m128i m)
+{
+    return _mm_or_si128(_mm_andnot_si128(m, a), _mm_and_si128(m, b));
+}
+
+static SSE2 __m128 blend_ps_sse2(__m128 a, __m128 b, __m128 m)
+{
+    return _mm_or_ps(_mm_andnot_ps(m, a), _mm_and_ps(m, b));
+}
+
+static SSE2 __m128d blend_pd_sse2(__m128d a, __m128d b, __m128d m)
+{
+    return _mm_or_pd(_mm_andnot_pd(m, a), _mm_and_pd(m, b));
+}
+
+/* low 32 bits of the products, like _mm_mullo_epi32() of SSE4.1 */
+static SSE2 __m128i mullo_sse2(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, 0x08),
+			      _mm_shuffle_epi32(odd, 0x08));
+}
+
+/* 32 bit masks from the 64 bit masks of four DCELLs */
+static SSE2 __m128i narrow_sse2(__m128d m0, __m128d m1)
+{
+    return _mm_castps_si128(_mm_shuffle_ps(_mm_castpd_ps(m0),
+					   _mm_castpd_ps(m1), 0x88));
+}
+
+/* all bits set in the lanes which are neither null nor zero */
+static SSE2 __m128i true_sse2(__m128i x)
+{
+    __m128i null = _mm_set1_epi32(CELL_NULL);
+    __m128i zero = _mm_setzero_si128();
+
+    return _mm_xor_si128(_mm_or_si128(_mm_cmpeq_epi32(x, zero),
+				      _mm_cmpeq_epi32(x, null)),
+			 _mm_set1_epi32(-1));
+}
+
+/* the result is null where <nulls> is set */
+#define C_LOOP_SSE2(result, nulls)					\
+    for (i = 0; i + 4 <= n; i += 4) {					\
+	__m128i x = _mm_loadu_si128((const __m128i *)(a + i));		\
+	__m128i y = _mm_loadu_si128((const __m128i *)(b + i));		\
+	__m128i m = _mm_or_si128(_mm_cmpeq_epi32(x, null),		\
+				 _mm_cmpeq_epi32(y, null));		\
+									\
+	_mm_storeu_si128((__m128i *) (res + i),				\
+			 blend_sse2((result), null, (nulls)));		\
+    }
+
+static SSE2 int binop_c_sse2(int op, CELL * res, const CELL * a,
+			     const CELL * b, int n)
+{
+    __m128i null = _mm_set1_epi32(CELL_NULL);
+    __m128i zero = _mm_setzero_si128();
+    __m128i one = _mm_set1_epi32(1);
+    int i;
+
+    switch (op) {
+    case CALC_ADD:
+	C_LOOP_SSE2(_mm_add_epi32(x, y), m);
+	break;
+    case CALC_SUB:
+	C_LOOP_SSE2(_mm_sub_epi32(x, y), m);
+	break;
+    case CALC_MUL:
+	C_LOOP_SSE2(mullo_sse2(x, y), m);
+	break;
+    case CALC_MIN:
+	C_LOOP_SSE2(blend_sse2(x, y, _mm_cmpgt_epi32(x, y)), m);
+	break;
+    case CALC_MAX:
+	C_LOOP_SSE2(blend_sse2(x, y, _mm_cmplt_epi32(x, y)), m);
+	break;
+    case CALC_EQ:
+	C_LOOP_SSE2(_mm_and_si128(_mm_cmpeq_epi32(x, y), one), m);
+	break;
+    case CALC_NE:
+	C_LOOP_SSE2(_mm_andnot_si128(_mm_cmpeq_epi32(x, y), one), m);
+	break;
+    case CALC_GT:
+	C_LOOP_SSE2(_mm_and_si128(_mm_cmpgt_epi32(x, y), one), m);
+	break;
+    case CALC_GE:
+	C_LOOP_SSE2(_mm_andnot_si128(_mm_cmplt_epi32(x, y), one), m);
+	break;
+    case CALC_LT:
+	C_LOOP_SSE2(_mm_and_si128(_mm_cmplt_epi32(x, y), one), m);
+	break;
+    case CALC_LE:
+	C_LOOP_SSE2(_mm_andnot_si128(_mm_cmpgt_epi32(x, y), one), m);
+	break;
+    case CALC_AND:
+	C_LOOP_SSE2(_mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(x, zero),
+						  _mm_cmpeq_epi32(y, zero)),
+				     one), m);
+	break;
+    case CALC_OR:
+	C_LOOP_SSE2(_mm_andnot_si128(_mm_cmpeq_epi32(_mm_or_si128(x, y),
+						     zero), one), m);
+	break;
+    case CALC_AND2:
+	/* false wins over null */
+	C_LOOP_SSE2(_mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(x, zero),
+						  _mm_cmpeq_epi32(y, zero)),
+				     blend_sse2(one, null, m)), zero);
+	break;
+    case CALC_OR2:
+	/* true wins over null */
+	C_LOOP_SSE2(blend_sse2(_mm_and_si128(m, null), one,
+			       _mm_or_si128(true_sse2(x), true_sse2(y))),
+		    zero);
+	break;
+    default:
+	return 0;
+    }
+
+    return i;
+}
+
+#define F_LOOP_SSE2(result, nulls)					\
+    for (i = 0; i + 4 <= n; i += 4) {					\
+	__m128 x = _mm_loadu_ps(a + i);					\
+	__m128 y = _mm_loadu_ps(b + i);					\
+	__m128 m = _mm_or_ps(_mm_cmpunord_ps(x, x),			\
+			     _mm_cmpunord_ps(y, y));			\
+	__m128 k = (nulls);						\
+									\
+	_mm_storeu_ps(res + i, _mm_or_ps((result), k));			\
+    }
+
+#define F_CMP_SSE2(cmp)							\
+    for (i = 0; i + 4 <= n; i += 4) {					\
+	__m128 x = _mm_loadu_ps(a + i);					\
+	__m128 y = _mm_loadu_ps(b + i);					\
+	__m128 m = _mm_or_ps(_mm_cmpunord_ps(x, x),			\
+			     _mm_cmpunord_ps(y, y));			\
+	__m128i r = _mm_and_si128(_mm_castps_si128(cmp(x, y)), one);	\
+									\
+	_mm_storeu_si128((__m128i *) ((CELL *) res + i),		\
+			 blend_sse2(r, null, _mm_castps_si128(m)));	\
+    }
+
+static SSE2 int binop_f_sse2(int op, void *res_, const FCELL * a,
+			     const FCELL * b, int n)
+{
+    FCELL *res = res_;
+    __m128i null = _mm_set1_epi32(CELL_NULL);
+    __m128i one = _mm_set1_epi32(1);
+    __m128 zero = _mm_setzero_ps();
+    __m128 onef = _mm_set1_ps(1.0f);
+    int i;
+
+    switch (op) {
+    case CALC_ADD:
+	/* the sum starts at 0, which turns -0 into +0 */
+	F_LOOP_SSE2(_mm_add_ps(_mm_add_ps(zero, x), y), m);
+	break;
+    case CALC_SUB:
+	F_LOOP_SSE2(_mm_sub_ps(x, y), m);
+	break;
+    case CALC_MUL:
+	F_LOOP_SSE2(_mm_mul_ps(x, y), m);
+	break;
+    case CALC_DIV:
+	/* division by zero gives null, the divisor is 1 in those lanes */
+	F_LOOP_SSE2(_mm_div_ps(x, blend_ps_sse2(y, onef, k)),
+		    _mm_or_ps(m, _mm_cmpeq_ps(y, zero)));
+	break;
+    case CALC_MIN:
+	F_LOOP_SSE2(_mm_min_ps(y, x), m);
+	break;
+    case CALC_MAX:
+	F_LOOP_SSE2(_mm_max_ps(y, x), m);
+	break;
+    case CALC_EQ:
+	F_CMP_SSE2(_mm_cmpeq_ps);
+	break;
+    case CALC_NE:
+	F_CMP_SSE2(_mm_cmpneq_ps);
+	break;
+    case CALC_GT:
+	F_CMP_SSE2(_mm_cmpgt_ps);
+	break;
+    case CALC_GE:
+	F_CMP_SSE2(_mm_cmpge_ps);
+	break;
+    case CALC_LT:
+	F_CMP_SSE2(_mm_cmplt_ps);
+	break;
+    case CALC_LE:
+	F_CMP_SSE2(_mm_cmple_ps);
+	break;
+    default:
+	return 0;
+    }
+
+    return i;
+}
+
+#define D_LOOP_SSE2(result, nulls)					\
+    for (i = 0; i + 2 <= n; i += 2) {					\
+	__m128d x = _mm_loadu_pd(a + i);				\
+	__m128d y = _mm_loadu_pd(b + i);				\
+	__m128d m = _mm_or_pd(_mm_cmpunord_pd(x, x),			\
+			      _mm_cmpunord_pd(y, y));			\
+	__m128d k = (nulls);						\
+									\
+	_mm_storeu_pd(res + i, _mm_or_pd((result), k));			\
+    }
+
+#define D_CMP_SSE2(cmp)							\
+    for (i = 0; i + 4 <= n; i += 4) {					\
+	__m128d x0 = _mm_loadu_pd(a + i);				\
+	__m128d y0 = _mm_loadu_pd(b + i);				\
+	__m128d x1 = _mm_loadu_pd(a + i + 2);				\
+	__m128d y1 = _mm_loadu_pd(b + i + 2);				\
+	__m128i m = narrow_sse2(_mm_or_pd(_mm_cmpunord_pd(x0, x0),	\
+					  _mm_cmpunord_pd(y0, y0)),	\
+				_mm_or_pd(_mm_cmpunord_pd(x1, x1),	\
+					  _mm_cmpunord_pd(y1, y1)));	\
+	__m128i r = _mm_and_si128(narrow_sse2(cmp(x0, y0), cmp(x1, y1)),\
+				  one);					\
+									\
+	_mm_storeu_si128((__m128i *) ((CELL *) res + i),		\
+			 blend_sse2(r, null, m));			\
+    }
+
+static SSE2 int binop_d_sse2(int op, void *res_, const DCELL * a,
+			     const DCELL * b, int n)
+{
+    DCELL *res = res_;
+    __m128i null = _mm_set1_epi32(CELL_NULL);
+    __m128i one = _mm_set1_epi32(1);
+    __m128d zero = _mm_setzero_pd();
+    __m128d oned = _mm_set1_pd(1.0);
+    int i;
+
+    switch (op) {
+    case CALC_ADD:
+	D_LOOP_SSE2(_mm_add_pd(_mm_add_pd(zero, x), y), m);
+	break;
+    case CALC_SUB:
+	D_LOOP_SSE2(_mm_sub_pd(x, y), m);
+	break;
+    case CALC_MUL:
+	D_LOOP_SSE2(_mm_mul_pd(x, y), m);
+	break;
+    case CALC_DIV:
+	D_LOOP_SSE2(_mm_div_pd(x, blend_pd_sse2(y, oned, k)),
+		    _mm_or_pd(m, _mm_cmpeq_pd(y, zero)));
+	break;
+    case CALC_MIN:
+	D_LOOP_SSE2(_mm_min_pd(y, x), m);
+	break;
+    case CALC_MAX:
+	D_LOOP_SSE2(_mm_max_pd(y, x), m);
+	break;
+    case CALC_EQ:
+	D_CMP_SSE2(_mm_cmpeq_pd);
+	break;
+    case CALC_NE:
+	D_CMP_SSE2(_mm_cmpneq_pd);
+	break;
+    case CALC_GT:
+	D_CMP_SSE2(_mm_cmpgt_pd);
+	break;
+    case CALC_GE:
+	D_CMP_SSE2(_mm_cmpge_pd);
+	break;
+    case CALC_LT:
+	D_CMP_SSE2(_mm_cmplt_pd);
+	break;
+    case CALC_LE:
+	D_CMP_SSE2(_mm_cmple_pd);
+	break;
+    default:
+	return 0;
+    }
+
+    return i;
+}
+
+static SSE2 int binop_sse2(int op, int type, void *res, const void *a,
+			   const void *b, int n)
+{
+    switch (type) {
+    case CELL_TYPE:
+	return binop_c_sse2(op, res, a, b, n);
+    case FCELL_TYPE:
+	return binop_f_sse2(op, res, a, b, n);
+    case DCELL_TYPE:
+	return binop_d_sse2(op, res, a, b, n);
+    default:
+	return 0;
+    }
+}
+
+/* c: the condition, zero: where it is zero, nc: where it is null */
+static SSE2 int cond_sse2(int type, void *res, const DCELL * c,
+			  const void *a, const void *b, int argc, int n)
+{
+    __m128d zerod = _mm_setzero_pd();
+    int i;
+
+    if (argc < 1 || argc > 3 || (argc == 1 && type != CELL_TYPE))
+	return 0;
+
+    switch (type) {
+    case CELL_TYPE:
+	{
+	    __m128i null = _mm_set1_epi32(CELL_NULL);
+	    __m128i one = _mm_set1_epi32(1);
+
+	    for (i = 0; i + 4 <= n; i += 4) {
+		__m128d c0 = _mm_loadu_pd(c + i);
+		__m128d c1 = _mm_loadu_pd(c + i + 2);
+		__m128i nc = narrow_sse2(_mm_cmpunord_pd(c0, c0),
+					 _mm_cmpunord_pd(c1, c1));
+		__m128i zero = narrow_sse2(_mm_cmpeq_pd(c0, zerod),
+					   _mm_cmpeq_pd(c1, zerod));
+		__m128i r;
+
+		if (argc == 1)
+		    r = _mm_andnot_si128(zero, one);
+		else {
+		    __m128i x = _mm_loadu_si128((const __m128i *)
+						((const CELL *)a + i));
+
+		    if (argc == 2)
+			r = _mm_andnot_si128(zero, x);
+		    else
+			r = blend_sse2(x, _mm_loadu_si128((const __m128i *)
+							  ((const CELL *)b +
+							   i)), zero);
+		}
+
+		_mm_storeu_si128((__m128i *) ((CELL *) res + i),
+				 blend_sse2(r, null, nc));
+	    }
+	    return i;
+	}
+    case FCELL_TYPE:
+	for (i = 0; i + 4 <= n; i += 4) {
+	    __m128d c0 = _mm_loadu_pd(c + i);
+	    __m128d c1 = _mm_loadu_pd(c + i + 2);
+	    __m128 nc = _mm_castsi128_ps(narrow_sse2(_mm_cmpunord_pd(c0, c0),
+						     _mm_cmpunord_pd(c1, c1)));
+	    __m128 zero = _mm_castsi128_ps(narrow_sse2(_mm_cmpeq_pd(c0, zerod),
+						       _mm_cmpeq_pd(c1, zerod)));
+	    __m128 x = _mm_loadu_ps((const FCELL *)a + i);
+	    __m128 r;
+
+	    /* any NaN taken from the arguments becomes the null pattern */
+	    if (argc == 2)
+		r = _mm_andnot_ps(zero, x);
+	    else
+		r = blend_ps_sse2(x, _mm_loadu_ps((const FCELL *)b + i), zero);
+	    r = _mm_or_ps(r, _mm_or_ps(nc, _mm_cmpunord_ps(r, r)));
+
+	    _mm_storeu_ps((FCELL *) res + i, r);
+	}
+	return i;
+    case DCELL_TYPE:
+	for (i = 0; i + 2 <= n; i += 2) {
+	    __m128d c0 = _mm_loadu_pd(c + i);
+	    __m128d nc = _mm_cmpunord_pd(c0, c0);
+	    __m128d zero = _mm_cmpeq_pd(c0, zerod);
+	    __m128d x = _mm_loadu_pd((const DCELL *)a + i);
+	    __m128d r;
+
+	    if (argc == 2)
+		r = _mm_andnot_pd(zero, x);
+	    else
+		r = blend_pd_sse2(x, _mm_loadu_pd((const DCELL *)b + i), zero);
+	    r = _mm_or_pd(r, _mm_or_pd(nc, _mm_cmpunord_pd(r, r)));
+
+	    _mm_storeu_pd((DCELL *) res + i, r);
+	}
+	return i;
+    default:
+	return 0;
+    }
+}
+
+static SSE2 int isnull_sse2(int type, CELL * res, const void *a, int n)
+{
+    __m128i one = _mm_set1_epi32(1);
+    int i;
+
+    switch (type) {
+    case CELL_TYPE:
+	{
+	    __m128i null = _mm_set1_epi32(CELL_NULL);
+
+	    for (i = 0; i + 4 <= n; i += 4) {
+		__m128i x = _mm_loadu_si128((const __m128i *)
+					    ((const CELL *)a + i));
+
+		_mm_storeu_si128((__m128i *) (res + i),
+				 _mm_and_si128(_mm_cmpeq_epi32(x, null), one));
+	    }
+	    return i;
+	}
+    case FCELL_TYPE:
+	for (i = 0; i + 4 <= n; i += 4) {
+	    __m128 x = _mm_loadu_ps((const FCELL *)a + i);
+
+	    _mm_storeu_si128((__m128i *) (res + i),
+			     _mm_and_si128(_mm_castps_si128
+					   (_mm_cmpunord_ps(x, x)), one));
+	}
+	return i;
+    case DCELL_TYPE:
+	for (i = 0; i + 4 <= n; i += 4) {
+	    __m128d x0 = _mm_loadu_pd((const DCELL *)a + i);
+	    __m128d x1 = _mm_loadu_pd((const DCELL *)a + i + 2);
+
+	    _mm_storeu_si128((__m128i *) (res + i),
+			     _mm_and_si128(narrow_sse2
+					   (_mm_cmpunord_pd(x0, x0),
+					    _mm_cmpunord_pd(x1, x1)), one));
+	}
+	return i;
+    default:
+	return 0;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+
+/* AVX2 variants */
+
+static AVX2 __m256i blend_avx2(__m256i a, __m256i b, __m256i m)
+{
+    return _mm256_blendv_epi8(a, b, m);
+}
+
+/* 32 bit masks from the 64 bit masks of eight DCELLs */
+static AVX2 __m256i narrow_avx2(__m256d m0, __m256d m1)
+{
+    __m256 v = _mm256_shuffle_ps(_mm256_castpd_ps(m0), _mm256_castpd_ps(m1),
+				 0x88);
+
+    return _mm256_castpd_si256(_mm256_permute4x64_pd(_mm256_castps_pd(v),
+						      0xD8));
+}
+
+static AVX2 __m256i true_avx2(__m256i x)
+{
+    __m256i null = _mm256_set1_epi32(CELL_NULL);
+    __m256i zero = _mm256_setzero_si256();
+
+    return _mm256_xor_si256(_mm256_or_si256(_mm256_cmpeq_epi32(x, zero),
+					    _mm256_cmpeq_epi32(x, null)),
+			    _mm256_set1_epi32(-1));
+}
+
+#define C_LOOP_AVX2(result, nulls)					\
+    for (i = 0; i + 8 <= n; i += 8) {					\
+	__m256i x = _mm256_loadu_si256((const __m256i *)(a + i));	\
+	__m256i y = _mm256_loadu_si256((const __m256i *)(b + i));	\
+	__m256i m = _mm256_or_si256(_mm256_cmpeq_epi32(x, null),	\
+				    _mm256_cmpeq_epi32(y, null));	\
+									\
+	_mm256_storeu_si256((__m256i *) (res + i),			\
+			    blend_avx2((result), null, (nulls)));	\
+    }
+
+static AVX2 int binop_c_avx2(int op, CELL * res, const CELL * a,
+			     const CELL * b, int n)
+{
+    __m256i null = _mm256_set1_epi32(CELL_NULL);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i one = _mm256_set1_epi32(1);
+    int i;
+
+    switch (op) {
+    case CALC_ADD:
+	C_LOOP_AVX2(_mm256_add_epi32(x, y), m);
+	break;
+    case CALC_SUB:
+	C_LOOP_AVX2(_mm256_sub_epi32(x, y), m);
+	break;
+    case CALC_MUL:
+	C_LOOP_AVX2(_mm256_mullo_epi32(x, y), m);
+	break;
+    case CALC_MIN:
+	C_LOOP_AVX2(_mm256_min_epi32(x, y), m);
+	break;
+    case CALC_MAX:
+	C_LOOP_AVX2(_mm256_max_epi32(x, y), m);
+	break;
+    case CALC_EQ:
+	C_LOOP_AVX2(_mm256_and_si256(_mm256_cmpeq_epi32(x, y), one), m);
+	break;
+    case CALC_NE:
+	C_LOOP_AVX2(_mm256_andnot_si256(_mm256_cmpeq_epi32(x, y), one), m);
+	break;
+    case CALC_GT:
+	C_LOOP_AVX2(_mm256_and_si256(_mm256_cmpgt_epi32(x, y), one), m);
+	break;
+    case CALC_GE:
+	C_LOOP_AVX2(_mm256_andnot_si256(_mm256_cmpgt_epi32(y, x), one), m);
+	break;
+    case CALC_LT:
+	C_LOOP_AVX2(_mm256_and_si256(_mm256_cmpgt_epi32(y, x), one), m);
+	break;
+    case CALC_LE:
+	C_LOOP_AVX2(_mm256_andnot_si256(_mm256_cmpgt_epi32(x, y), one), m);
+	break;
+    case CALC_AND:
+	C_LOOP_AVX2(_mm256_andnot_si256
+		    (_mm256_or_si256(_mm256_cmpeq_epi32(x, zero),
+				     _mm256_cmpeq_epi32(y, zero)), one), m);
+	break;
+    case CALC_OR:
+	C_LOOP_AVX2(_mm256_andnot_si256
+		    (_mm256_cmpeq_epi32(_mm256_or_si256(x, y), zero), one), m);
+	break;
+    case CALC_AND2:
+	C_LOOP_AVX2(_mm256_andnot_si256
+		    (_mm256_or_si256(_mm256_cmpeq_epi32(x, zero),
+				     _mm256_cmpeq_epi32(y, zero)),
+		     blend_avx2(one, null, m)), zero);
+	break;
+    case CALC_OR2:
+	C_LOOP_AVX2(blend_avx2(_mm256_and_si256(m, null), one,
+			       _mm256_or_si256(true_avx2(x), true_avx2(y))),
+		    zero);
+	break;
+    default:
+	return 0;
+    }
+
+    return i;
+}
+
+#define F_LOOP_AVX2(result, nulls)					\
+    for (i = 0; i + 8 <= n; i += 8) {					\
+	__m256 x = _mm256_loadu_ps(a + i);				\
+	__m256 y = _mm256_loadu_ps(b + i);				\
+	__m256 m = _mm256_or_ps(_mm256_cmp_ps(x, x, _CMP_UNORD_Q),	\
+				_mm256_cmp_ps(y, y, _CMP_UNORD_Q));	\
+	__m256 k = (nulls);						\
+									\
+	_mm256_storeu_ps(res + i, _mm256_or_ps((result), k));		\
+    }
+
+#define F_CMP_AVX2(pred)						\
+    for (i = 0; i + 8 <= n; i += 8) {					\
+	__m256 x = _mm256_loadu_ps(a + i);				\
+	__m256 y = _mm256_loadu_ps(b + i);				\
+	__m256 m = _mm256_or_ps(_mm256_cmp_ps(x, x, _CMP_UNORD_Q),	\
+				_mm256_cmp_ps(y, y, _CMP_UNORD_Q));	\
+	__m256i r = _mm256_and_si256(_mm256_castps_si256		\
+				     (_mm256_cmp_ps(x, y, pred)), one);	\
+									\
+	_mm256_storeu_si256((__m256i *) ((CELL *) res + i),		\
+			    blend_avx2(r, null, _mm256_castps_si256(m)));\
+    }
+
+static AVX2 int binop_f_avx2(int op, void *res_, const FCELL * a,
+			     const FCELL * b, int n)
+{
+    FCELL *res = res_;
+    __m256i null = _mm256_set1_epi32(CELL_NULL);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 onef = _mm256_set1_ps(1.0f);
+    int i;
+
+    switch (op) {
+    case CALC_ADD:
+	F_LOOP_AVX2(_mm256_add_ps(_mm256_add_ps(zero, x), y), m);
+	break;
+    case CALC_SUB:
+	F_LOOP_AVX2(_mm256_sub_ps(x, y), m);
+	break;
+    case CALC_MUL:
+	F_LOOP_AVX2(_mm256_mul_ps(x, y), m);
+	break;
+    case CALC_DIV:
+	F_LOOP_AVX2(_mm256_div_ps(x, _mm256_blendv_ps(y, onef, k)),
+		    _mm256_or_ps(m, _mm256_cmp_ps(y, zero, _CMP_EQ_OQ)));
+	break;
+    case CALC_MIN:
+	F_LOOP_AVX2(_mm256_min_ps(y, x), m);
+	break;
+    case CALC_MAX:
+	F_LOOP_AVX2(_mm256_max_ps(y, x), m);
+	break;
+    case CALC_EQ:
+	F_CMP_AVX2(_CMP_EQ_OQ);
+	break;
+    case CALC_NE:
+	F_CMP_AVX2(_CMP_NEQ_UQ);
+	break;
+    case CALC_GT:
+	F_CMP_AVX2(_CMP_GT_OQ);
+	break;
+    case CALC_GE:
+	F_CMP_AVX2(_CMP_GE_OQ);
+	break;
+    case CALC_LT:
+	F_CMP_AVX2(_CMP_LT_OQ);
+	break;
+    case CALC_LE:
+	F_CMP_AVX2(_CMP_LE_OQ);
+	break;
+    default:
+	return 0;
+    }
+
+    return i;
+}
+
+#define D_LOOP_AVX2(result, nulls)					\
+    for (i = 0; i + 4 <= n; i += 4) {					\
+	__m256d x = _mm256_loadu_pd(a + i);				\
+	__m256d y = _mm256_loadu_pd(b + i);				\
+	__m256d m = _mm256_or_pd(_mm256_cmp_pd(x, x, _CMP_UNORD_Q),	\
+				 _mm256_cmp_pd(y, y, _CMP_UNORD_Q));	\
+	__m256d k = (nulls);						\
+									\
+	_mm256_storeu_pd(res + i, _mm256_or_pd((result), k));		\
+    }
+
+#define D_CMP_AVX2(pred)						\
+    for (i = 0; i + 8 <= n; i += 8) {					\
+	__m256d x0 = _mm256_loadu_pd(a + i);				\
+	__m256d y0 = _mm256_loadu_pd(b + i);				\
+	__m256d x1 = _mm256_loadu_pd(a + i + 4);			\
+	__m256d y1 = _mm256_loadu_pd(b + i + 4);			\
+	__m256i m = narrow_avx2(_mm256_or_pd				\
+				(_mm256_cmp_pd(x0, x0, _CMP_UNORD_Q),	\
+				 _mm256_cmp_pd(y0, y0, _CMP_UNORD_Q)),	\
+				_mm256_or_pd				\
+				(_mm256_cmp_pd(x1, x1, _CMP_UNORD_Q),	\
+				 _mm256_cmp_pd(y1, y1, _CMP_UNORD_Q)));	\
+	__m256i r = _mm256_and_si256(narrow_avx2			\
+				     (_mm256_cmp_pd(x0, y0, pred),	\
+				      _mm256_cmp_pd(x1, y1, pred)), one);\
+									\
+	_mm256_storeu_si256((__m256i *) ((CELL *) res + i),		\
+			    blend_avx2(r, null, m));			\
+    }
+
+static AVX2 int binop_d_avx2(int op, void *res_, const DCELL * a,
+			     const DCELL * b, int n)
+{
+    DCELL *res = res_;
+    __m256i null = _mm256_set1_epi32(CELL_NULL);
+    __m256i one = _mm256_set1_epi32(1);
+    __m256d zero = _mm256_setzero_pd();
+    __m256d oned = _mm256_set1_pd(1.0);
+    int i;
+
+    switch (op) {
+    case CALC_ADD:
+	D_LOOP_AVX2(_mm256_add_pd(_mm256_add_pd(zero, x), y), m);
+	break;
+    case CALC_SUB:
+	D_LOOP_AVX2(_mm256_sub_pd(x, y), m);
+	break;
+    case CALC_MUL:
+	D_LOOP_AVX2(_mm256_mul_pd(x, y), m);
+	break;
+    case CALC_DIV:
+	D_LOOP_AVX2(_mm256_div_pd(x, _mm256_blendv_pd(y, oned, k)),
+		    _mm256_or_pd(m, _mm256_cmp_pd(y, zero, _CMP_EQ_OQ)));
+	break;
+    case CALC_MIN:
+	D_LOOP_AVX2(_mm256_min_pd(y, x), m);
+	break;
+    case CALC_MAX:
+	D_LOOP_AVX2(_mm256_max_pd(y, x), m);
+	break;
+    case CALC_EQ:
+	D_CMP_AVX2(_CMP_EQ_OQ);
+	break;
+    case CALC_NE:
+	D_CMP_AVX2(_CMP_NEQ_UQ);
+	break;
+    case CALC_GT:
+	D_CMP_AVX2(_CMP_GT_OQ);
+	break;
+    case CALC_GE:
+	D_CMP_AVX2(_CMP_GE_OQ);
+	break;
+    case CALC_LT:
+	D_CMP_AVX2(_CMP_LT_OQ);
+	break;
+    case CALC_LE:
+	D_CMP_AVX2(_CMP_LE_OQ);
+	break;
+    default:
+	return 0;
+    }
+
+    return i;
+}
+
+static AVX2 int binop_avx2(int op, int type, void *res, const void *a,
+			   const void *b, int n)
+{
+    switch (type) {
+    case CELL_TYPE:
+	return binop_c_avx2(op, res, a, b, n);
+    case FCELL_TYPE:
+	return binop_f_avx2(op, res, a, b, n);
+    case DCELL_TYPE:
+	return binop_d_avx2(op, res, a, b, n);
+    default:
+	return 0;
+    }
+}
+
+static AVX2 int cond_avx2(int type, void *res, const DCELL * c,
+			  const void *a, const void *b, int argc, int n)
+{
+    __m256d zerod = _mm256_setzero_pd();
+    int i;
+
+    if (argc < 1 || argc > 3 || (argc == 1 && type != CELL_TYPE))
+	return 0;
+
+    switch (type) {
+    case CELL_TYPE:
+	{
+	    __m256i null = _mm256_set1_epi32(CELL_NULL);
+	    __m256i one = _mm256_set1_epi32(1);
+
+	    for (i = 0; i + 8 <= n; i += 8) {
+		__m256d c0 = _mm256_loadu_pd(c + i);
+		__m256d c1 = _mm256_loadu_pd(c + i + 4);
+		__m256i nc = narrow_avx2(_mm256_cmp_pd(c0, c0, _CMP_UNORD_Q),
+					 _mm256_cmp_pd(c1, c1, _CMP_UNORD_Q));
+		__m256i zero = narrow_avx2(_mm256_cmp_pd(c0, zerod, _CMP_EQ_OQ),
+					   _mm256_cmp_pd(c1, zerod, _CMP_EQ_OQ));
+		__m256i r;
+
+		if (argc == 1)
+		    r = _mm256_andnot_si256(zero, one);
+		else {
+		    __m256i x = _mm256_loadu_si256((const __m256i *)
+						   ((const CELL *)a + i));
+
+		    if (argc == 2)
+			r = _mm256_andnot_si256(zero, x);
+		    else
+			r = blend_avx2(x, _mm256_loadu_si256((const __m256i *)
+							     ((const CELL *)b
+							      + i)), zero);
+		}
+
+		_mm256_storeu_si256((__m256i *) ((CELL *) res + i),
+				    blend_avx2(r, null, nc));
+	    }
+	    return i;
+	}
+    case FCELL_TYPE:
+	for (i = 0; i + 8 <= n; i += 8) {
+	    __m256d c0 = _mm256_loadu_pd(c + i);
+	    __m256d c1 = _mm256_loadu_pd(c + i + 4);
+	    __m256 nc = _mm256_castsi256_ps
+		(narrow_avx2(_mm256_cmp_pd(c0, c0, _CMP_UNORD_Q),
+			     _mm256_cmp_pd(c1, c1, _CMP_UNORD_Q)));
+	    __m256 zero = _mm256_castsi256_ps
+		(narrow_avx2(_mm256_cmp_pd(c0, zerod, _CMP_EQ_OQ),
+			     _mm256_cmp_pd(c1, zerod, _CMP_EQ_OQ)));
+	    __m256 x = _mm256_loadu_ps((const FCELL *)a + i);
+	    __m256 r;
+
+	    if (argc == 2)
+		r = _mm256_andnot_ps(zero, x);
+	    else
+		r = _mm256_blendv_ps(x, _mm256_loadu_ps((const FCELL *)b + i),
+				     zero);
+	    r = _mm256_or_ps(r, _mm256_or_ps(nc, _mm256_cmp_ps(r, r,
+							       _CMP_UNORD_Q)));
+
+	    _mm256_storeu_ps((FCELL *) res + i, r);
+	}
+	return i;
+    case DCELL_TYPE:
+	for (i = 0; i + 4 <= n; i += 4) {
+	    __m256d c0 = _mm256_loadu_pd(c + i);
+	    __m256d nc = _mm256_cmp_pd(c0, c0, _CMP_UNORD_Q);
+	    __m256d zero = _mm256_cmp_pd(c0, zerod, _CMP_EQ_OQ);
+	    __m256d x = _mm256_loadu_pd((const DCELL *)a + i);
+	    __m256d r;
+
+	    if (argc == 2)
+		r = _mm256_andnot_pd(zero, x);
+	    else
+		r = _mm256_blendv_pd(x, _mm256_loadu_pd((const DCELL *)b + i),
+				     zero);
+	    r = _mm256_or_pd(r, _mm256_or_pd(nc, _mm256_cmp_pd(r, r,
+							       _CMP_UNORD_Q)));
+
+	    _mm256_storeu_pd((DCELL *) res + i, r);
+	}
+	return i;
+    default:
+	return 0;
+    }
+}
+
+static AVX2 int isnull_avx2(int type, CELL * res, const void *a, int n)
+{
+    __m256i one = _mm256_set1_epi32(1);
+    int i;
+
+    switch (type) {
+    case CELL_TYPE:
+	{
+	    __m256i null = _mm256_set1_epi32(CELL_NULL);
+
+	    for (i = 0; i + 8 <= n; i += 8) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)
+					       ((const CELL *)a + i));
+
+		_mm256_storeu_si256((__m256i *) (res + i),
+				    _mm256_and_si256(_mm256_cmpeq_epi32
+						     (x, null), one));
+	    }
+	    return i;
+	}
+    case FCELL_TYPE:
+	for (i = 0; i + 8 <= n; i += 8) {
+	    __m256 x = _mm256_loadu_ps((const FCELL *)a + i);
+
+	    _mm256_storeu_si256((__m256i *) (res + i),
+				_mm256_and_si256(_mm256_castps_si256
+						 (_mm256_cmp_ps
+						  (x, x, _CMP_UNORD_Q)), one));
+	}
+	return i;
+    case DCELL_TYPE:
+	for (i = 0; i + 8 <= n; i += 8) {
+	    __m256d x0 = _mm256_loadu_pd((const DCELL *)a + i);
+	    __m256d x1 = _mm256_loadu_pd((const DCELL *)a + i + 4);
+
+	    _mm256_storeu_si256((__m256i *) (res + i),
+				_mm256_and_si256(narrow_avx2
+						 (_mm256_cmp_pd
+						  (x0, x0, _CMP_UNORD_Q),
+						  _mm256_cmp_pd
+						  (x1, x1, _CMP_UNORD_Q)),
+						 one));
+	}
+	return i;
+    default:
+	return 0;
+    }
+}
+
+#endif /* X86_KERNELS */
+
+/*--------------------------------------------------------------------------*/
+
+static void init_kernels(void)
+{
+    const char *simd;
+    int level = 0;		/* 0: portable, 1: SSE2, 2: AVX2 */
+
+    if (G_is_initialized(&initialized))
+	return;
+
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+	level = 1;
+    if (__builtin_cpu_supports("avx2"))
+	level = 2;
+#endif
+
+    simd = getenv("GRASS_RASTER_SIMD");
+    if (simd && *simd) {
+	if (strcmp(simd, "none") == 0)
+	    level = 0;
+	else if (strcmp(simd, "sse2") == 0) {
+	    if (level > 1)
+		level = 1;
+	}
+	else if (strcmp(simd, "avx2") != 0)
+	    G_warning(_("Unknown instruction set '%s' in GRASS_RASTER_SIMD, "
+			"use none, sse2 or avx2"), simd);
+    }
+
+    kernel.binop = binop_none;
+    kernel.cond = cond_none;
+    kernel.isnull = isnull_none;
+
+#ifdef X86_KERNELS
+    if (level == 1) {
+	kernel.binop = binop_sse2;
+	kernel.cond = cond_sse2;
+	kernel.isnull = isnull_sse2;
+    }
+    else if (level == 2) {
+	kernel.binop = binop_avx2;
+	kernel.cond = cond_avx2;
+	kernel.isnull = isnull_avx2;
+    }
+#endif
+
+    G_debug(1, "Calc operator kernels: %s",
+	    level == 2 ? "AVX2" : level == 1 ? "SSE2" : "portable");
+
+    G_initialize_done(&initialized);
+}
+
+/*!
+   \brief Vectorized binary operator
+
+   Computes <i>op</i> (one of the CALC_* operators) of two arguments of
+   type <i>type</i> for the leading cells of the buffers. The result has
+   the type of the arguments, or CELL_TYPE for the comparisons. The
+   operators CALC_AND, CALC_OR, CALC_AND2 and CALC_OR2 take CELL
+   arguments only, CALC_DIV floating point arguments only.
+
+   \param op operator
+   \param type type of the arguments
+   \param[out] res result
+   \param a first argument
+   \param b second argument
+   \param n number of cells
+
+   \return number of cells done, the caller computes the others
+ */
+int calc__binop(int op, int type, void *res, const void *a, const void *b,
+		int n)
+{
+    init_kernels();
+
+    if ((op == CALC_DIV && type == CELL_TYPE) ||
+	(op >= CALC_AND && type != CELL_TYPE))
+	return 0;
+
+    return kernel.binop(op, type, res, a, b, n);
+}
+
+/*!
+   \brief Vectorized if()
+
+   Computes if(c), if(c,a) or if(c,a,b) with <i>argc</i> 1, 2 or 3 for
+   the leading cells of the buffers; if(c) only for a CELL result.
+
+   \param type type of the result and of <i>a</i> and <i>b</i>
+   \param[out] res result
+   \param c condition
+   \param a value where the condition is non-zero
+   \param b value where the condition is zero
+   \param argc number of arguments of if()
+   \param n number of cells
+
+   \return number of cells done, the caller computes the others
+ */
+int calc__if(int type, void *res, const DCELL * c, const void *a,
+	     const void *b, int argc, int n)
+{
+    init_kernels();
+
+    return kernel.cond(type, res, c, a, b, argc, n);
+}
+
+/*!
+   \brief Vectorized isnull()
+
+   \param type type of the argument
+   \param[out] res 1 where the argument is null, 0 elsewhere
+   \param a argument
+   \param n number of cells
+
+   \return number of cells done, the caller computes the others
+ */
+int calc__isnull(int type, CELL * res, const void *a, int n)
+{
+    init_kernels();
+
+    return kernel.isnull(type, res, a, n);
+}
@@ -9,7 +9,7 @@ add(a,b,c,...) = a + b + c + ...
 
 int f_add(int argc, const int *argt, void **args)
 {
-    int i, j;
+    int i, j, done;
 
     if (argc < 1)
 	return E_ARG_LO;
@@ -18,13 +18,18 @@ int f_add(int argc, const int *argt, void **args)
 	if (argt[i] != argt[0])
 	    return E_ARG_TYPE;
 
+    /* vectorized for two arguments */
+    done = argc == 2
+	? calc__binop(CALC_ADD, argt[0], args[0], args[1], args[2], columns)
+	: 0;
+
     switch (argt[0]) {
     case CELL_TYPE:
 	{
 	    CELL *res = args[0];
 	    CELL **argz = (CELL **) args;
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		res[i] = 0;
 		for (j = 1; j <= argc; j++) {
 		    if (IS_NULL_C(&argz[j][i])) {
@@ -41,7 +46,7 @@ int f_add(int argc, const int *argt, void **args)
 	    FCELL *res = args[0];
 	    FCELL **argz = (FCELL **) args;
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		res[i] = 0;
 		for (j = 1; j <= argc; j++) {
 		    if (IS_NULL_F(&argz[j][i])) {
@@ -58,7 +63,7 @@ int f_add(int argc, const int *argt, void **args)
 	    DCELL *res = args[0];
 	    DCELL **argz = (DCELL **) args;
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		res[i] = 0;
 		for (j = 1; j <= argc; j++) {
 		    if (IS_NULL_D(&argz[j][i])) {
@@ -11,7 +11,7 @@ int f_and(int argc, const int *argt, void **args)
 {
     CELL *res = args[0];
     CELL **argz = (CELL **) args;
-    int i, j;
+    int i, j, done;
 
     if (argc < 1)
 	return E_ARG_LO;
@@ -23,7 +23,12 @@ int f_and(int argc, const int *argt, void **args)
 	if (argt[i] != CELL_TYPE)
 	    return E_ARG_TYPE;
 
-    for (i = 0; i < columns; i++) {
+    /* vectorized for two arguments */
+    done = argc == 2
+	? calc__binop(CALC_AND, CELL_TYPE, args[0], args[1], args[2], columns)
+	: 0;
+
+    for (i = done; i < columns; i++) {
 	res[i] = 1;
 	for (j = 1; j <= argc; j++) {
 	    if (IS_NULL_C(&argz[j][i])) {
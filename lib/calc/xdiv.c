@@ -9,7 +9,7 @@ div(a,b) = a / b
 
 int f_div(int argc, const int *argt, void **args)
 {
-    int i;
+    int i, done;
 
     if (argc < 2)
 	return E_ARG_LO;
@@ -19,6 +19,8 @@ int f_div(int argc, const int *argt, void **args)
     if (argt[1] != argt[0] || argt[2] != argt[0])
 	return E_ARG_TYPE;
 
+    done = calc__binop(CALC_DIV, argt[0], args[0], args[1], args[2], columns);
+
     switch (argt[0]) {
     case CELL_TYPE:
 	{
@@ -26,7 +28,7 @@ int f_div(int argc, const int *argt, void **args)
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]) ||
 		    arg2[i] == 0)
 		    SET_NULL_C(&res[i]);
@@ -41,7 +43,7 @@ int f_div(int argc, const int *argt, void **args)
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_F(&arg1[i]) || IS_NULL_F(&arg2[i]) ||
 		    arg2[i] == 0.0f)
 		    SET_NULL_F(&res[i]);
@@ -60,7 +62,7 @@ int f_div(int argc, const int *argt, void **args)
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_D(&arg1[i]) || IS_NULL_D(&arg2[i]) ||
 		    arg2[i] == 0.0)
 		    SET_NULL_D(&res[i]);
@@ -10,7 +10,7 @@ eq(a,b) = a == b
 int f_eq(int argc, const int *argt, void **args)
 {
     CELL *res = args[0];
-    int i;
+    int i, done;
 
     if (argc < 2)
 	return E_ARG_LO;
@@ -24,13 +24,15 @@ int f_eq(int argc, const int *argt, void **args)
 	if (argt[i] != argt[1])
 	    return E_ARG_TYPE;
 
+    done = calc__binop(CALC_EQ, argt[1], args[0], args[1], args[2], columns);
+
     switch (argt[1]) {
     case CELL_TYPE:
 	{
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -43,7 +45,7 @@ int f_eq(int argc, const int *argt, void **args)
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_F(&arg1[i]) || IS_NULL_F(&arg2[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -56,7 +58,7 @@ int f_eq(int argc, const int *argt, void **args)
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_D(&arg1[i]) || IS_NULL_D(&arg2[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -10,20 +10,22 @@ ge(a,b) = a >= b
 int f_ge(int argc, const int *argt, void **args)
 {
     CELL *res = args[0];
-    int i;
+    int i, done;
 
     if (argc < 2)
 	return E_ARG_LO;
     if (argc > 2)
 	return E_ARG_HI;
 
+    done = calc__binop(CALC_GE, argt[1], args[0], args[1], args[2], columns);
+
     switch (argt[1]) {
     case CELL_TYPE:
 	{
 	    CELL *arg1 = args[1];
 	    CELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_C(&arg1[i]) || IS_NULL_C(&arg2[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -36,7 +38,7 @@ int f_ge(int argc, const int *argt, void **args)
 	    FCELL *arg1 = args[1];
 	    FCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_F(&arg1[i]) || IS_NULL_F(&arg2[i]))
 		    SET_NULL_C(&res[i]);
 		else
@@ -49,7 +51,7 @@ int f_ge(int argc, const int *argt, void **args)
 	    DCELL *arg1 = args[1];
 	    DCELL *arg2 = args[2];
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		if (IS_NULL_D(&arg1[i]) || IS_NULL_D(&arg2[i]))
 		    SET_NULL_C(&res[i]);
 		else
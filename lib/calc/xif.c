@@ -17,20 +17,22 @@ static int f_if_i(int argc, const int *argt, void **args)
     CELL *arg2 = (argc >= 2) ? args[2] : NULL;
     CELL *arg3 = (argc >= 3) ? args[3] : NULL;
     CELL *arg4 = (argc >= 4) ? args[4] : NULL;
-    int i;
+    int i, done;
+
+    done = calc__if(CELL_TYPE, res, arg1, arg2, arg3, argc, columns);
 
     switch (argc) {
     case 0:
 	return E_ARG_LO;
     case 1:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_C(&res[i]);
 	    else
 		res[i] = arg1[i] != 0.0 ? 1 : 0;
 	break;
     case 2:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_C(&res[i]);
 	    else if (arg1[i] == 0.0)
@@ -43,7 +45,7 @@ static int f_if_i(int argc, const int *argt, void **args)
 	    }
 	break;
     case 3:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_C(&res[i]);
 	    else if (arg1[i] == 0.0) {
@@ -60,7 +62,7 @@ static int f_if_i(int argc, const int *argt, void **args)
 	    }
 	break;
     case 4:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_C(&res[i]);
 	    else if (arg1[i] == 0.0) {
@@ -97,7 +99,9 @@ static int f_if_f(int argc, const int *argt, void **args)
     FCELL *arg2 = (argc >= 2) ? args[2] : NULL;
     FCELL *arg3 = (argc >= 3) ? args[3] : NULL;
     FCELL *arg4 = (argc >= 4) ? args[4] : NULL;
-    int i;
+    int i, done;
+
+    done = calc__if(FCELL_TYPE, res, arg1, arg2, arg3, argc, columns);
 
     switch (argc) {
     case 0:
@@ -105,7 +109,7 @@ static int f_if_f(int argc, const int *argt, void **args)
     case 1:
 	return E_ARG_TYPE;
     case 2:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_F(&res[i]);
 	    else if (arg1[i] == 0.0)
@@ -118,7 +122,7 @@ static int f_if_f(int argc, const int *argt, void **args)
 	    }
 	break;
     case 3:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_F(&res[i]);
 	    else if (arg1[i] == 0.0) {
@@ -135,7 +139,7 @@ static int f_if_f(int argc, const int *argt, void **args)
 	    }
 	break;
     case 4:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_F(&res[i]);
 	    else if (arg1[i] == 0.0) {
@@ -172,7 +176,9 @@ static int f_if_d(int argc, const int *argt, void **args)
     DCELL *arg2 = (argc >= 2) ? args[2] : NULL;
     DCELL *arg3 = (argc >= 3) ? args[3] : NULL;
     DCELL *arg4 = (argc >= 4) ? args[4] : NULL;
-    int i;
+    int i, done;
+
+    done = calc__if(DCELL_TYPE, res, arg1, arg2, arg3, argc, columns);
 
     switch (argc) {
     case 0:
@@ -180,7 +186,7 @@ static int f_if_d(int argc, const int *argt, void **args)
     case 1:
 	return E_ARG_TYPE;
     case 2:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_D(&res[i]);
 	    else if (arg1[i] == 0.0)
@@ -193,7 +199,7 @@ static int f_if_d(int argc, const int *argt, void **args)
 	    }
 	break;
     case 3:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_D(&res[i]);
 	    else if (arg1[i] == 0.0) {
@@ -210,7 +216,7 @@ static int f_if_d(int argc, const int *argt, void **args)
 	    }
 	break;
     case 4:
-	for (i = 0; i < columns; i++)
+	for (i = done; i < columns; i++)
 	    if (IS_NULL_D(&arg1[i]))
 		SET_NULL_D(&res[i]);
 	    else if (arg1[i] == 0.0) {
@@ -11,7 +11,7 @@ isnull(x)
 int f_isnull(int argc, const int *argt, void **args)
 {
     int *res = args[0];
-    int i;
+    int i, done;
 
     if (argc < 1)
 	return E_ARG_LO;
@@ -21,12 +21,14 @@ int f_isnull(int argc, const int *argt, void **args)
     if (argt[0] != CELL_TYPE)
 	return E_RES_TYPE;
 
+    done = calc__isnull(argt[1], res, args[1], columns);
+
     switch (argt[1]) {
     case CELL_TYPE:
 	{
 	    CELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = done; i < columns; i++)
 		res[i] = IS_NULL_C(&arg1[i]) ? 1 : 0;
 	    return 0;
 	}
@@ -34,7 +36,7 @@ int f_isnull(int argc, const int *argt, void **args)
 	{
 	    FCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = done; i < columns; i++)
 		res[i] = IS_NULL_F(&arg1[i]) ? 1 : 0;
 	    return 0;
 	}
@@ -42,7 +44,7 @@ int f_isnull(int argc, const int *argt, void **args)
 	{
 	    DCELL *arg1 = args[1];
 
-	    for (i = 0; i < columns; i++)
+	    for (i = done; i < columns; i++)
 		res[i] = IS_NULL_D(&arg1[i]) ? 1 : 0;
 	    return 0;
 	}
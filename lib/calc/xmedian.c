@@ -43,25 +43,10 @@ static int dcmp(const void *aa, const void *bb)
     return 0;
 }
 
-int f_median(int argc, const int *argt, void **args)
+static int do_median(int argc, const int *argt, void **args, void *array)
 {
-    static void *array;
-    static int alloc;
-    int size = argc * Rast_cell_size(argt[0]);
     int i, j;
 
-    if (argc < 1)
-	return E_ARG_LO;
-
-    for (i = 1; i <= argc; i++)
-	if (argt[i] != argt[0])
-	    return E_ARG_TYPE;
-
-    if (size > alloc) {
-	alloc = size;
-	array = G_realloc(array, size);
-    }
-
     switch (argt[0]) {
     case CELL_TYPE:
 	{
@@ -151,3 +136,23 @@ int f_median(int argc, const int *argt, void **args)
 	return E_INV_TYPE;
     }
 }
+
+int f_median(int argc, const int *argt, void **args)
+{
+    void *array;
+    int i, res;
+
+    if (argc < 1)
+	return E_ARG_LO;
+
+    for (i = 1; i <= argc; i++)
+	if (argt[i] != argt[0])
+	    return E_ARG_TYPE;
+
+    /* not static, r.mapcalc evaluates rows concurrently */
+    array = G_malloc(argc * Rast_cell_size(argt[0]));
+    res = do_median(argc, argt, args, array);
+    G_free(array);
+
+    return res;
+}
@@ -11,7 +11,7 @@ min(x0,x1,...,xn) returns minimum value
 
 int f_min(int argc, const int *argt, void **args)
 {
-    int i, j;
+    int i, j, done;
 
     if (argc < 1)
 	return E_ARG_LO;
@@ -20,13 +20,18 @@ int f_min(int argc, const int *argt, void **args)
 	if (argt[i] != argt[0])
 	    return E_ARG_TYPE;
 
+    /* vectorized for two arguments */
+    done = argc == 2
+	? calc__binop(CALC_MIN, argt[0], args[0], args[1], args[2], columns)
+	: 0;
+
     switch (argt[0]) {
     case CELL_TYPE:
 	{
 	    CELL *res = args[0];
 	    CELL **argz = (CELL **) args;
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		int nul = 0;
 		CELL min;
 
@@ -49,7 +54,7 @@ int f_min(int argc, const int *argt, void **args)
 	    FCELL *res = args[0];
 	    FCELL **argz = (FCELL **) args;
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		int nul = 0;
 		FCELL min;
 
@@ -73,7 +78,7 @@ int f_min(int argc, const int *argt, void **args)
 	    DCELL *res = args[0];
 	    DCELL **argz = (DCELL **) args;
 
-	    for (i = 0; i < columns; i++) {
+	    for (i = done; i < columns; i++) {
 		int nul = 0;
 		DCELL min;
 
@@ -50,25 +50,10 @@ static double mode(double *value, int argc)
     return mode_v;
 }
 
-int f_nmode(int argc, const int *argt, void **args)
+static int do_nmode(int argc, const int *argt, void **args, double *value)
 {
-    static double *value;
-    static int value_size;
-    int size = argc * sizeof(double);
     int i, j;
 
-    if (argc < 1)
-	return E_ARG_LO;
-
-    for (i = 1; i <= argc; i++)
-	if (argt[i] != argt[0])
-	    return E_ARG_TYPE;
-
-    if (size > value_size) {
-	value_size = size;
-	value = G_realloc(value, value_size);
-    }
-
     switch (argt[argc]) {
     case CELL_TYPE:
 	{
@@ -137,3 +122,23 @@ int f_nmode(int argc, const int *argt, void **args)
 	return E_INV_TYPE;
     }
 }
+
+int f_nmode(int argc, const int *argt, void **args)
+{
+    double *value;
+    int i, res;
+
+    if (argc < 1)
+	return E_ARG_LO;
+
+    for (i = 1; i <= argc; i++)
+	if (argt[i] != argt[0])
+	    return E_ARG_TYPE;
+
+    /* not static, r.mapcalc evaluates rows concurrently */
+    value = G_malloc(argc * sizeof(double));
+    res = do_nmode(argc, argt, args, value);
+    G_free(value);
+
+    return res;
+}
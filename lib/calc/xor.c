@@ -10,7 +10,7 @@ or(a,b,c,...) = a || b || c || ...
 int f_or(int argc, const int *argt, void **args)
 {
     CELL *res = args[0];
-    int i, j;
+    int i, j, done;
 
     if (argc < 1)
 	return E_ARG_LO;
@@ -22,7 +22,12 @@ int f_or(int argc, const int *argt, void **args)
 	if (argt[i] != argt[0])
 	    return E_ARG_TYPE;
 
-    for (i = 0; i < columns; i++) {
+    /* vectorized for two arguments */
+    done = argc == 2
+	? calc__binop(CALC_OR, CELL_TYPE, args[0], args[1], args[2], columns)
+	: 0;
+
+    for (i = done; i < columns; i++) {
 	res[i] = 0;
 	for (j = 1; j <= argc; j++) {
 	    CELL *arg = args[j];
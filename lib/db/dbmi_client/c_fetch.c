@@ -12,20 +12,11 @@
  * \author Joel Jones (CERL/UIUC), Radim Blazek
  */
 
+#include <grass/gis.h>
 #include <grass/dbmi.h>
 #include "macros.h"
 
-/*!
-  \brief Fetch data from open cursor
-
-  \param cursor pointer to dbCursor
-  \param position cursor position
-  \param[out] more get more (0 for no data to be fetched)
-
-  \return DB_OK on success
-  \return DB_FAILED on failure
- */
-int db_fetch(dbCursor * cursor, int position, int *more)
+static int fetch(dbCursor * cursor, int position, int *more)
 {
     int ret_code;
 
@@ -50,3 +41,23 @@ int db_fetch(dbCursor * cursor, int position, int *more)
     }
     return DB_OK;
 }
+
+/*!
+  \brief Fetch data from open cursor
+
+  \param cursor pointer to dbCursor
+  \param position cursor position
+  \param[out] more get more (0 for no data to be fetched)
+
+  \return DB_OK on success
+  \return DB_FAILED on failure
+ */
+int db_fetch(dbCursor * cursor, int position, int *more)
+{
+    double t = G_trace_begin();
+    int ret = fetch(cursor, position, more);
+
+    G_trace_end("db", "db_fetch", t);
+
+    return ret;
+}
@@ -0,0 +1,325 @@
+/*
+ ****************************************************************************
+ *                     -- GRASS Development Team --
+ *
+ * MODULE:      GRASS gis library
+ * FILENAME:    cmprshuf.c
+ * AUTHOR(S):   GRASS Development Team
+ * PURPOSE:     To provide a reversible byte-shuffle and prediction
+ *              transform in front of LZ4 or ZSTD.  Its primary use is in
+ *              the storage and reading of GRASS floating point rasters,
+ *              whose rows of big-endian floats compress poorly as
+ *              plain byte streams.
+ *
+ * DATE CREATED: Oct 2026
+ * COPYRIGHT:   (C) 2026 by the GRASS Development Team
+ *
+ *              This program is free software under the GNU General Public
+ *              License (version 2 or greater). Read the file COPYING that
+ *              comes with GRASS for details.
+ *
+ *****************************************************************************/
+
+/********************************************************************
+ * int                                                              *
+ * G_shuffle_compress (src, srz_sz, dst, dst_sz)                    *
+ *     int src_sz, dst_sz;                                          *
+ *     unsigned char *src, *dst;                                    *
+ * ---------------------------------------------------------------- *
+ * The source is treated as an array of big-endian elements of 1,   *
+ * 2, 3, 4 or 8 bytes.  Each element is replaced by its difference to  *
+ * (or its XOR with) the previous element, and the bytes of the     *
+ * residuals are regrouped into planes: all first bytes, then all   *
+ * second bytes, etc.  Trailing bytes which do not fill an element  *
+ * are appended unchanged.  The result is compressed with ZSTD if   *
+ * available, otherwise with LZ4.                                   *
+ *                                                                  *
+ * The element size and the predictor are not known to the caller  *
+ * of G_compress(): both are chosen from a sample at the start of   *
+ * the source as the combination giving the fewest byte changes     *
+ * within the planes.  The choice and the backend are stored in a   *
+ * header byte in front of the compressed data:                     *
+ *     bits 0-2: element size - 1                                   *
+ *     bits 3-4: predictor (0: none, 1: delta, 2: XOR)              *
+ *     bit 5: backend (0: LZ4, 1: ZSTD)                             *
+ *                                                                  *
+ * The function either returns the number of bytes of compressed    *
+ * data in dst, or an error code.                                   *
+ *                                                                  *
+ * Errors include:                                                  *
+ *        -1 -- Compression failed.                                 *
+ *        -2 -- dst is too small.                                   *
+ *                                                                  *
+ * ================================================================ *
+ * int                                                              *
+ * G_shuffle_expand (src, src_sz, dst, dst_sz)                      *
+ *     int src_sz, dst_sz;                                          *
+ *     unsigned char *src, *dst;                                    *
+ * ---------------------------------------------------------------- *
+ * Expands the data with the backend named in the header byte and   *
+ * reverses the shuffle and the prediction.                         *
+ *                                                                  *
+ * The function returns the number of bytes expanded into 'dst' or  *
+ * and error code.                                                  *
+ *                                                                  *
+ * Errors include:                                                  *
+ *        -1 -- Expansion failed.                                   *
+ *                                                                  *
+ ********************************************************************
+ */
+
+#include <grass/config.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <grass/gis.h>
+#include <grass/glocale.h>
+
+#define PRED_NONE  0
+#define PRED_DELTA 1
+#define PRED_XOR   2
+
+#define BACKEND_LZ4  0
+#define BACKEND_ZSTD 1
+
+/* bytes at the start of the source used to choose the transform */
+#define SAMPLE_SIZE 4096
+
+int G_lz4_compress_bound(int);
+int G_zstd_compress_bound(int);
+
+static int backend(void)
+{
+#ifdef HAVE_ZSTD_H
+    return BACKEND_ZSTD;
+#else
+    return BACKEND_LZ4;
+#endif
+}
+
+static uint64_t get_element(const unsigned char *p, int size)
+{
+    uint64_t v = 0;
+    int i;
+
+    for (i = 0; i < size; i++)
+	v = (v << 8) | p[i];
+
+    return v;
+}
+
+static void put_element(unsigned char *p, uint64_t v, int size)
+{
+    int i;
+
+    for (i = size - 1; i >= 0; i--) {
+	p[i] = (unsigned char)v;
+	v >>= 8;
+    }
+}
+
+/* predict and shuffle n bytes of src into dst */
+static void shuffle(const unsigned char *src, unsigned char *dst, int n,
+		    int size, int pred)
+{
+    int nel = n / size;
+    int i, b;
+    uint64_t prev = 0, v, r;
+
+    if (size == 1 && pred == PRED_NONE) {
+	memcpy(dst, src, n);
+	return;
+    }
+
+    for (i = 0; i < nel; i++) {
+	v = get_element(src + i * size, size);
+	if (pred == PRED_DELTA)
+	    r = v - prev;
+	else if (pred == PRED_XOR)
+	    r = v ^ prev;
+	else
+	    r = v;
+	prev = v;
+	for (b = size - 1; b >= 0; b--) {
+	    dst[b * nel + i] = (unsigned char)r;
+	    r >>= 8;
+	}
+    }
+    memcpy(dst + nel * size, src + nel * size, n - nel * size);
+}
+
+/* reverse shuffle() */
+static void unshuffle(const unsigned char *src, unsigned char *dst, int n,
+		      int size, int pred)
+{
+    int nel = n / size;
+    int i, b;
+    uint64_t prev = 0, v, r;
+
+    if (size == 1 && pred == PRED_NONE) {
+	memcpy(dst, src, n);
+	return;
+    }
+
+    for (i = 0; i < nel; i++) {
+	r = 0;
+	for (b = 0; b < size; b++)
+	    r = (r << 8) | src[b * nel + i];
+	if (pred == PRED_DELTA)
+	    v = r + prev;
+	else if (pred == PRED_XOR)
+	    v = r ^ prev;
+	else
+	    v = r;
+	prev = v;
+	put_element(dst + i * size, v, size);
+    }
+    memcpy(dst + nel * size, src + nel * size, n - nel * size);
+}
+
+/* choose element size and predictor from a sample of src,
+ * return the header byte without backend */
+static int choose_transform(const unsigned char *src, int src_sz)
+{
+    unsigned char buf[SAMPLE_SIZE];
+    int n = src_sz < SAMPLE_SIZE ? src_sz : SAMPLE_SIZE;
+    static const int sizes[] = { 1, 2, 3, 4, 8 };
+    int k, pred, best = 0, best_cost = -1;
+
+    for (k = 0; k < 5; k++) {
+	int size = sizes[k];
+	int nel = n / size;
+
+	if (nel < 2)
+	    break;
+	for (pred = PRED_NONE; pred <= PRED_XOR; pred++) {
+	    int i, cost = 0;
+
+	    if (size == 1 && pred == PRED_XOR)
+		continue;
+	    shuffle(src, buf, nel * size, size, pred);
+	    /* byte changes within each plane, a cheap estimate of
+	     * what is left for the backend */
+	    for (i = 1; i < nel * size; i++)
+		if (buf[i] != buf[i - 1] && i % nel)
+		    cost++;
+	    if (best_cost < 0 || cost < best_cost) {
+		best_cost = cost;
+		best = (size - 1) | (pred << 3);
+	    }
+	}
+    }
+
+    return best;
+}
+
+int
+G_shuffle_compress_bound(int src_sz)
+{
+    int bound;
+
+    if (backend() == BACKEND_ZSTD)
+	bound = G_zstd_compress_bound(src_sz);
+    else
+	bound = G_lz4_compress_bound(src_sz);
+
+    return bound + 1;
+}
+
+int
+G_shuffle_compress(unsigned char *src, int src_sz, unsigned char *dst,
+		   int dst_sz)
+{
+    int err, header;
+    unsigned char *buf;
+
+    /* Catch errors early */
+    if (src == NULL || dst == NULL) {
+	if (src == NULL)
+	    G_warning(_("No source buffer"));
+
+	if (dst == NULL)
+	    G_warning(_("No destination buffer"));
+	return -1;
+    }
+
+    /* Don't do anything if either of these are true */
+    if (src_sz <= 0 || dst_sz <= 0) {
+	if (src_sz <= 0)
+	    G_warning(_("Invalid source buffer size %d"), src_sz);
+	if (dst_sz <= 0)
+	    G_warning(_("Invalid destination buffer size %d"), dst_sz);
+	return 0;
+    }
+
+    header = choose_transform(src, src_sz) | (backend() << 5);
+
+    /* rows are compressed on several threads at once,
+     * the buffer must not be shared */
+    buf = G_malloc(src_sz);
+    shuffle(src, buf, src_sz, (header & 7) + 1, (header >> 3) & 3);
+
+    if (backend() == BACKEND_ZSTD)
+	err = G_zstd_compress(buf, src_sz, dst + 1, dst_sz - 1);
+    else
+	err = G_lz4_compress(buf, src_sz, dst + 1, dst_sz - 1);
+    G_free(buf);
+
+    if (err <= 0)
+	return err == 0 ? -1 : err;
+    if (err + 1 >= src_sz)
+	/* compression not possible */
+	return -2;
+
+    dst[0] = (unsigned char)header;
+
+    /* bytes of compressed data is return value */
+    return err + 1;
+}
+
+int
+G_shuffle_expand(unsigned char *src, int src_sz, unsigned char *dst,
+		 int dst_sz)
+{
+    int err, header;
+    unsigned char *buf;
+
+    /* Catch error condition */
+    if (src == NULL || dst == NULL) {
+	if (src == NULL)
+	    G_warning(_("No source buffer"));
+
+	if (dst == NULL)
+	    G_warning(_("No destination buffer"));
+	return -2;
+    }
+
+    /* Don't do anything if either of these are true */
+    if (src_sz <= 1 || dst_sz <= 0) {
+	if (src_sz <= 1)
+	    G_warning(_("Invalid source buffer size %d"), src_sz);
+	if (dst_sz <= 0)
+	    G_warning(_("Invalid destination buffer size %d"), dst_sz);
+	return 0;
+    }
+
+    header = src[0];
+    if ((header & 0xC0) || ((header >> 3) & 3) > PRED_XOR) {
+	G_warning(_("Invalid SHUFFLE header %d"), header);
+	return -1;
+    }
+
+    buf = G_malloc(dst_sz);
+    if ((header >> 5) == BACKEND_ZSTD)
+	err = G_zstd_expand(src + 1, src_sz - 1, buf, dst_sz);
+    else
+	err = G_lz4_expand(src + 1, src_sz - 1, buf, dst_sz);
+
+    if (err > 0)
+	unshuffle(buf, dst, err, (header & 7) + 1, (header >> 3) & 3);
+    G_free(buf);
+
+    /* number of bytes of uncompressed data */
+    return err;
+}
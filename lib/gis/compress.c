@@ -25,6 +25,7 @@
  * 3 : LZ4 (fastest, low compression)                               *
  * 4 : BZIP2 (slowest, high compression)                            *
  * 5 : ZSTD (faster than ZLIB, higher compression than ZLIB)        *
+ * 6 : SHUFFLE (byte-shuffle and prediction, then ZSTD or LZ4)      *
  *                                                                  *
  * int                                                              *
  * G_read_compressed (fd, rbytes, dst, nbytes, compression_type)    *
@@ -221,12 +222,19 @@ int G_compress_bound(int src_sz, int number)
 int G_compress(unsigned char *src, int src_sz, unsigned char *dst,
 	       int dst_sz, int number)
 {
+    double t;
+    int ret;
+
     if (number < 0 || number >= n_compressors) {
 	G_fatal_error(_("Request for unsupported compressor"));
 	return -1;
     }
 
-    return compressor[number].compress(src, src_sz, dst, dst_sz);
+    t = G_trace_begin();
+    ret = compressor[number].compress(src, src_sz, dst, dst_sz);
+    G_trace_end("compress", "G_compress", t);
+
+    return ret;
 }
 
 /* G_*_expand() returns
@@ -236,12 +244,19 @@ int G_compress(unsigned char *src, int src_sz, unsigned char *dst,
 int G_expand(unsigned char *src, int src_sz, unsigned char *dst,
 	     int dst_sz, int number)
 {
+    double t;
+    int ret;
+
     if (number < 0 || number >= n_compressors) {
 	G_fatal_error(_("Request for unsupported compressor"));
 	return -1;
     }
 
-    return compressor[number].expand(src, src_sz, dst, dst_sz);
+    t = G_trace_begin();
+    ret = compressor[number].expand(src, src_sz, dst, dst_sz);
+    G_trace_end("compress", "G_expand", t);
+
+    return ret;
 }
 
 int G_read_compressed(int fd, int rbytes, unsigned char *dst, int nbytes,
@@ -8,6 +8,8 @@
  * 3: LZ4, fastest but lowest compression ratio
  * 4: BZIP2: slowest but highest compression ratio
  * 5: ZSTD: faster than ZLIB, higher compression than ZLIB
+ * 6: SHUFFLE: byte-shuffle and prediction, then ZSTD or LZ4,
+ *    for floating point data
  */
 
 /* adding a new compressor:
@@ -24,6 +26,7 @@ int G_zlib_compress_bound(int);
 int G_lz4_compress_bound(int);
 int G_bz2_compress_bound(int);
 int G_zstd_compress_bound(int);
+int G_shuffle_compress_bound(int);
 
 typedef int compress_fn(unsigned char *src, int src_sz, unsigned char *dst,
 		int dst_sz);
@@ -47,9 +50,10 @@ struct compressor_list
  * 3: LZ4
  * 4: BZIP2
  * 5: ZSTD
+ * 6: SHUFFLE
  */
  
-static int n_compressors = 6; 
+static int n_compressors = 7; 
 
 struct compressor_list compressor[] = {
     {1, G_no_compress, G_no_expand, G_no_compress_bound, "NONE"},
@@ -66,6 +70,7 @@ struct compressor_list compressor[] = {
 #else
     {0, G_zstd_compress, G_zstd_expand, G_zstd_compress_bound, "ZSTD"},
 #endif
+    {1, G_shuffle_compress, G_shuffle_expand, G_shuffle_compress_bound, "SHUFFLE"},
     {0, NULL, NULL, NULL, NULL}
 };
 
@@ -0,0 +1,484 @@
+/*!
+ * \file lib/gis/task.c
+ *
+ * \brief GIS Library - Work-stealing task scheduler.
+ *
+ * Tasks are run by a pool of threads. Each thread of the pool owns a
+ * deque of tasks: it pushes the tasks it spawns at the bottom and takes
+ * its next task from the bottom as well, while idle threads steal the
+ * oldest task from the top of the deque of another thread. Threads
+ * outside of the pool (e.g. the main thread of a module) share deque 0.
+ * A thread waiting for a task runs other tasks in the meantime, so that
+ * tasks may spawn and wait for tasks of their own.
+ *
+ * (C) 2026 by the GRASS Development Team
+ *
+ * This program is free software under the GNU General Public License
+ * (>=v2). Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <grass/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <grass/gis.h>
+#include <grass/glocale.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+struct G_task
+{
+    void (*func)(void *);
+    void *closure;
+    int done;
+};
+
+struct range			/* Chunk of G_parallel_for()    */
+{
+    void (*func)(int, int, void *);
+    void *closure;
+    int first, last;
+};
+
+static int num_threads;		/* 0: not set yet               */
+
+static int cpu_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (n > 0)
+	return (int)n;
+#endif
+    return 1;
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/****************************************************************************/
+
+struct deque
+{
+    pthread_mutex_t mutex;
+    struct G_task **tasks;
+    int head, tail;		/* tasks[head] .. tasks[tail - 1] */
+    int size;
+};
+
+static int pool_threads;	/* threads incl. the caller, 0: no pool */
+static struct deque *deques;
+static pthread_t *threads;
+static pthread_key_t self_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static int num_queued;
+static int shutdown_pool;
+
+static void make_key(void)
+{
+    pthread_key_create(&self_key, NULL);
+}
+
+/* index of the deque of the calling thread */
+static int self(void)
+{
+    return (int)(size_t) pthread_getspecific(self_key);
+}
+
+static void push(struct deque *d, struct G_task *t)
+{
+    pthread_mutex_lock(&d->mutex);
+    if (d->tail == d->size) {
+	if (d->head > 0) {
+	    memmove(d->tasks, d->tasks + d->head,
+		    (d->tail - d->head) * sizeof(struct G_task *));
+	    d->tail -= d->head;
+	    d->head = 0;
+	}
+	else {
+	    d->size = d->size ? 2 * d->size : 64;
+	    d->tasks = G_realloc(d->tasks, d->size * sizeof(struct G_task *));
+	}
+    }
+    d->tasks[d->tail++] = t;
+    pthread_mutex_unlock(&d->mutex);
+
+    pthread_mutex_lock(&pool_mutex);
+    num_queued++;
+    pthread_cond_signal(&work_cond);
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+/* takes the newest task of the own deque (bottom) or the oldest task of
+   another deque (top) */
+static struct G_task *take(struct deque *d, int bottom)
+{
+    struct G_task *t = NULL;
+
+    pthread_mutex_lock(&d->mutex);
+    if (d->head < d->tail) {
+	t = bottom ? d->tasks[--d->tail] : d->tasks[d->head++];
+	if (d->head == d->tail)
+	    d->head = d->tail = 0;
+    }
+    pthread_mutex_unlock(&d->mutex);
+
+    if (t) {
+	pthread_mutex_lock(&pool_mutex);
+	num_queued--;
+	pthread_mutex_unlock(&pool_mutex);
+    }
+
+    return t;
+}
+
+static struct G_task *find_task(int me)
+{
+    struct G_task *t;
+    int i;
+
+    if (num_queued <= 0)
+	return NULL;
+
+    t = take(&deques[me], 1);
+    for (i = 1; !t && i < pool_threads; i++)
+	t = take(&deques[(me + i) % pool_threads], 0);
+
+    return t;
+}
+
+static void run_task(struct G_task *t)
+{
+    (*t->func) (t->closure);
+
+    pthread_mutex_lock(&pool_mutex);
+    t->done = 1;
+    pthread_cond_broadcast(&done_cond);
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+static void *pool_thread(void *arg)
+{
+    int me = (int)(size_t) arg;
+
+    pthread_setspecific(self_key, arg);
+
+    for (;;) {
+	struct G_task *t = find_task(me);
+
+	if (t) {
+	    run_task(t);
+	    continue;
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+	while (num_queued <= 0 && !shutdown_pool)
+	    pthread_cond_wait(&work_cond, &pool_mutex);
+	if (shutdown_pool && num_queued <= 0) {
+	    pthread_mutex_unlock(&pool_mutex);
+	    break;
+	}
+	pthread_mutex_unlock(&pool_mutex);
+    }
+
+    return NULL;
+}
+
+static void start_pool(void)
+{
+    int n = G_num_threads();
+    int i;
+
+    pthread_once(&key_once, make_key);
+
+    deques = G_calloc(n, sizeof(struct deque));
+    for (i = 0; i < n; i++)
+	pthread_mutex_init(&deques[i].mutex, NULL);
+
+    threads = G_calloc(n, sizeof(pthread_t));
+    shutdown_pool = 0;
+    pool_threads = n;
+
+    for (i = 1; i < n; i++)
+	if (pthread_create(&threads[i], NULL, pool_thread,
+			   (void *)(size_t) i) != 0)
+	    G_fatal_error(_("Unable to create thread %d of %d"), i, n - 1);
+
+    G_debug(1, "Task scheduler started with %d threads", n);
+}
+
+static void stop_pool(void)
+{
+    int i;
+
+    if (!pool_threads)
+	return;
+
+    pthread_mutex_lock(&pool_mutex);
+    shutdown_pool = 1;
+    pthread_cond_broadcast(&work_cond);
+    pthread_mutex_unlock(&pool_mutex);
+
+    for (i = 1; i < pool_threads; i++)
+	pthread_join(threads[i], NULL);
+
+    for (i = 0; i < pool_threads; i++) {
+	pthread_mutex_destroy(&deques[i].mutex);
+	G_free(deques[i].tasks);
+    }
+    G_free(deques);
+    G_free(threads);
+    deques = NULL;
+    threads = NULL;
+    pool_threads = 0;
+}
+
+/*!
+ * \brief Spawn a task
+ *
+ * Queues <em>func(closure)</em> for execution by the thread pool, see
+ * G_set_num_threads(). If only one thread is configured, the task is
+ * run right away. Every spawned task must be waited for with
+ * G_task_wait(), which releases it.
+ *
+ * \param func function to run
+ * \param closure argument of func
+ *
+ * \return task handle
+ */
+struct G_task *G_task_spawn(void (*func)(void *), void *closure)
+{
+    struct G_task *t = G_malloc(sizeof(struct G_task));
+
+    t->func = func;
+    t->closure = closure;
+    t->done = 0;
+
+    if (G_num_threads() <= 1) {
+	(*func) (closure);
+	t->done = 1;
+	return t;
+    }
+
+    pthread_mutex_lock(&pool_mutex);
+    if (!pool_threads)
+	start_pool();
+    pthread_mutex_unlock(&pool_mutex);
+
+    push(&deques[self()], t);
+
+    return t;
+}
+
+/*!
+ * \brief Wait for a task
+ *
+ * Returns when the task has finished, and releases it. While waiting,
+ * the calling thread runs other queued tasks.
+ *
+ * \param task task returned by G_task_spawn()
+ */
+void G_task_wait(struct G_task *task)
+{
+    int me;
+
+    if (!task)
+	return;
+
+    me = pool_threads ? self() : 0;
+
+    for (;;) {
+	struct G_task *t;
+
+	pthread_mutex_lock(&pool_mutex);
+	if (task->done) {
+	    pthread_mutex_unlock(&pool_mutex);
+	    break;
+	}
+	pthread_mutex_unlock(&pool_mutex);
+
+	t = find_task(me);
+	if (t) {
+	    run_task(t);
+	    continue;
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+	while (!task->done && num_queued <= 0)
+	    pthread_cond_wait(&done_cond, &pool_mutex);
+	pthread_mutex_unlock(&pool_mutex);
+    }
+
+    G_free(task);
+}
+
+/****************************************************************************/
+
+#else
+
+/****************************************************************************/
+
+static void stop_pool(void)
+{
+}
+
+struct G_task *G_task_spawn(void (*func)(void *), void *closure)
+{
+    (*func) (closure);
+
+    return NULL;
+}
+
+void G_task_wait(struct G_task *task)
+{
+}
+
+/****************************************************************************/
+
+#endif
+
+/*!
+ * \brief Set the number of threads used for parallel computing
+ *
+ * Modules with an <b>nprocs</b> option (see G_OPT_M_NPROCS) pass its
+ * value here. 0 selects the value of the GRASS_NPROCS environment
+ * variable, if set, otherwise one more than the number of worker
+ * threads requested with WORKERS, otherwise 1. A negative number
+ * selects all processors but that many.
+ *
+ * Must not be called while tasks are running.
+ *
+ * \param nprocs number of threads including the calling thread
+ *
+ * \return number of threads used
+ */
+int G_set_num_threads(int nprocs)
+{
+    int n = nprocs;
+
+    if (n == 0) {
+	const char *p;
+
+	if ((p = getenv("GRASS_NPROCS")) && *p)
+	    n = atoi(p);
+	else if ((p = getenv("WORKERS")) && *p)
+	    n = atoi(p) + 1;
+	else
+	    n = 1;
+    }
+
+    if (n < 0)
+	n += cpu_count();
+    if (n < 1)
+	n = 1;
+
+#ifndef HAVE_PTHREAD_H
+    n = 1;
+#endif
+
+    if (n != num_threads) {
+	stop_pool();
+	num_threads = n;
+	G_debug(1, "Using %d threads", n);
+    }
+
+    return n;
+}
+
+/*!
+ * \brief Get the number of threads used for parallel computing
+ *
+ * \return number of threads including the calling thread
+ */
+int G_num_threads(void)
+{
+    if (num_threads == 0)
+	G_set_num_threads(0);
+
+    return num_threads;
+}
+
+static void run_range(void *closure)
+{
+    struct range *r = closure;
+
+    (*r->func) (r->first, r->last, r->closure);
+}
+
+/*!
+ * \brief Run a loop in parallel
+ *
+ * Splits the range <em>first</em> .. <em>last</em> - 1 (e.g. raster
+ * rows) into chunks of at least <em>grain</em> items and calls
+ * <em>func(chunk_first, chunk_last, closure)</em> for each chunk on
+ * the threads of the pool. There are a few more chunks than threads so
+ * that idle threads can steal work from busy ones. Returns when all
+ * chunks are done.
+ *
+ * \param first first item
+ * \param last one past the last item
+ * \param grain minimum number of items per chunk
+ * \param func function called for each chunk
+ * \param closure argument of func
+ */
+void G_parallel_for(int first, int last, int grain,
+		    void (*func)(int, int, void *), void *closure)
+{
+    int n = last - first;
+    int threads = G_num_threads();
+    struct range *ranges;
+    struct G_task **tasks;
+    int nchunks, i;
+
+    if (grain < 1)
+	grain = 1;
+
+    if (n <= 0)
+	return;
+
+    nchunks = n / grain;
+    if (nchunks > 4 * threads)
+	nchunks = 4 * threads;
+
+    if (threads <= 1 || nchunks <= 1) {
+	(*func) (first, last, closure);
+	return;
+    }
+
+    ranges = G_malloc(nchunks * sizeof(struct range));
+    tasks = G_malloc(nchunks * sizeof(struct G_task *));
+
+    for (i = 0; i < nchunks; i++) {
+	ranges[i].func = func;
+	ranges[i].closure = closure;
+	ranges[i].first = first + (int)((long long)n * i / nchunks);
+	ranges[i].last = first + (int)((long long)n * (i + 1) / nchunks);
+    }
+
+    for (i = 1; i < nchunks; i++)
+	tasks[i] = G_task_spawn(run_range, &ranges[i]);
+
+    run_range(&ranges[0]);
+
+    for (i = 1; i < nchunks; i++)
+	G_task_wait(tasks[i]);
+
+    G_free(tasks);
+    G_free(ranges);
+}
+
+/*!
+ * \brief Stop the threads of the pool
+ *
+ * They are started again when needed. Must not be called while tasks
+ * are running.
+ */
+void G_finish_tasks(void)
+{
+    stop_pool();
+}
@@ -0,0 +1,79 @@
+"""Test of the performance trace (GRASS_TRACE)
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import glob
+import json
+import os
+import shutil
+import tempfile
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+
+class TraceTestCase(TestCase):
+    """Modules run with GRASS_TRACE write a Chrome trace file"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=50, s=0, w=0, e=60, res=1)
+        cls.runModule('r.mapcalc', expression='trace_in = row() * col()')
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=['trace_in', 'trace_out'])
+        cls.del_temp_region()
+
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def run_traced(self, min_duration):
+        os.environ['GRASS_TRACE'] = self.tmpdir
+        os.environ['GRASS_TRACE_MIN'] = str(min_duration)
+        try:
+            self.runModule('r.mapcalc', overwrite=True,
+                           expression='trace_out = trace_in + 1')
+        finally:
+            del os.environ['GRASS_TRACE']
+            del os.environ['GRASS_TRACE_MIN']
+        files = glob.glob(os.path.join(self.tmpdir, 'r.mapcalc-*.json'))
+        self.assertEqual(len(files), 1)
+        with open(files[0]) as f:
+            return json.load(f)
+
+    def test_spans(self):
+        """All spans are written with GRASS_TRACE_MIN=0"""
+        events = self.run_traced(0)
+        spans = [e['name'] for e in events if e['ph'] == 'X']
+        self.assertEqual(spans.count('Rast_get_row'), 50)
+        self.assertEqual(spans.count('Rast_put_row'), 50)
+        for e in events:
+            if e['ph'] == 'X':
+                self.assertGreaterEqual(e['dur'], 0)
+
+    def test_counters(self):
+        """Short spans and counters are written as counter events"""
+        events = self.run_traced(1e9)
+        self.assertFalse([e for e in events if e['ph'] == 'X'])
+        last = {}
+        for e in events:
+            if e['ph'] == 'C':
+                last[e['name']] = e['args']
+        self.assertEqual(last['raster rows decoded']['value'], 50)
+        self.assertEqual(last['Rast_put_row']['calls'], 50)
+
+
+if __name__ == '__main__':
+    test()
@@ -0,0 +1,314 @@
+/*!
+ * \file lib/gis/trace.c
+ *
+ * \brief GIS Library - Performance tracing.
+ *
+ * If the GRASS_TRACE environment variable names a directory, every
+ * process writes a timeline of the hot paths of the libraries to
+ * <em>program</em>-<em>pid</em>.json in that directory. The file is in
+ * the Chrome trace event format and can be loaded into chrome://tracing
+ * or Perfetto.
+ *
+ * Spans are recorded with G_trace_begin() and G_trace_end(). Spans
+ * shorter than GRASS_TRACE_MIN microseconds (default 100) are not
+ * written one by one; their number and total duration are written as
+ * counters instead, together with the counters of G_trace_count(), at
+ * most every 100 milliseconds and at exit.
+ *
+ * (C) 2026 by the GRASS Development Team
+ *
+ * This program is free software under the GNU General Public License
+ * (>=v2). Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <grass/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_GETTIMEOFDAY
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <grass/gis.h>
+#include <grass/glocale.h>
+
+#define MAX_COUNTERS 64
+#define FLUSH_INTERVAL 100000.0	/* microseconds between counter events */
+
+struct counter
+{
+    const char *name;
+    int span;			/* aggregated short spans       */
+    double value;		/* count, or total microseconds */
+    long calls;			/* number of short spans        */
+    int changed;
+};
+
+static int enabled = -1;	/* -1: not initialized yet      */
+static FILE *trace_fp;
+static double start_time;
+static double last_flush;
+static double min_duration = 100;
+static struct counter counters[MAX_COUNTERS];
+static int num_counters;
+
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t tid_key;
+static int num_tids;
+#endif
+
+static void lock(void)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&trace_mutex);
+#endif
+}
+
+static void unlock(void)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&trace_mutex);
+#endif
+}
+
+/* microseconds */
+static double now(void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+#else
+    return time(NULL) * 1e6;
+#endif
+}
+
+/* small number identifying the calling thread, called with the lock */
+static int thread_id(void)
+{
+#ifdef HAVE_PTHREAD_H
+    int tid = (int)(size_t) pthread_getspecific(tid_key);
+
+    if (!tid) {
+	tid = ++num_tids;
+	pthread_setspecific(tid_key, (void *)(size_t) tid);
+    }
+
+    return tid;
+#else
+    return 1;
+#endif
+}
+
+static void put_event(const char *json)
+{
+    fprintf(trace_fp, ",\n%s", json);
+}
+
+static struct counter *get_counter(const char *name, int span)
+{
+    int i;
+
+    for (i = 0; i < num_counters; i++)
+	if (counters[i].span == span &&
+	    (counters[i].name == name || strcmp(counters[i].name, name) == 0))
+	    return &counters[i];
+
+    if (num_counters == MAX_COUNTERS)
+	return NULL;
+
+    counters[num_counters].name = name;
+    counters[num_counters].span = span;
+
+    return &counters[num_counters++];
+}
+
+/* writes the counters which changed, called with the lock */
+static void flush_counters(double t)
+{
+    char buf[1024];
+    int i;
+
+    for (i = 0; i < num_counters; i++) {
+	struct counter *c = &counters[i];
+
+	if (!c->changed)
+	    continue;
+
+	if (c->span)
+	    sprintf(buf, "{\"name\":\"%.200s\",\"ph\":\"C\",\"ts\":%.0f,"
+		    "\"pid\":%d,\"args\":{\"calls\":%ld,\"ms\":%.3f}}",
+		    c->name, t - start_time, getpid(), c->calls,
+		    c->value / 1000);
+	else
+	    sprintf(buf, "{\"name\":\"%.200s\",\"ph\":\"C\",\"ts\":%.0f,"
+		    "\"pid\":%d,\"args\":{\"value\":%.0f}}",
+		    c->name, t - start_time, getpid(), c->value);
+	put_event(buf);
+	c->changed = 0;
+    }
+
+    last_flush = t;
+}
+
+static void close_trace(void)
+{
+    lock();
+    if (trace_fp) {
+	flush_counters(now());
+	fprintf(trace_fp, "\n]\n");
+	fclose(trace_fp);
+	trace_fp = NULL;
+    }
+    enabled = 0;
+    unlock();
+}
+
+static void init_trace(void)
+{
+    const char *dir = getenv("GRASS_TRACE");
+    const char *p;
+    char *path;
+
+    enabled = 0;
+    if (!dir || !*dir)
+	return;
+
+    if ((p = getenv("GRASS_TRACE_MIN")) && *p)
+	min_duration = atof(p);
+
+    G_asprintf(&path, "%s/%s-%d.json", dir, G_program_name(), getpid());
+    trace_fp = fopen(path, "w");
+    if (!trace_fp) {
+	G_warning(_("Unable to create trace file <%s>"), path);
+	G_free(path);
+	return;
+    }
+    G_free(path);
+
+#ifdef HAVE_PTHREAD_H
+    pthread_key_create(&tid_key, NULL);
+#endif
+
+    start_time = last_flush = now();
+    fprintf(trace_fp, "[\n{\"name\":\"process_name\",\"ph\":\"M\","
+	    "\"pid\":%d,\"args\":{\"name\":\"%.200s\"}}",
+	    getpid(), G_program_name());
+
+    atexit(close_trace);
+    enabled = 1;
+}
+
+static int is_enabled(void)
+{
+    if (enabled < 0) {
+	lock();
+	if (enabled < 0)
+	    init_trace();
+	unlock();
+    }
+
+    return enabled;
+}
+
+/*!
+ * \brief Start a span of the performance trace
+ *
+ * \return start time to be passed to G_trace_end(), 0 if tracing is
+ * disabled (GRASS_TRACE not set)
+ */
+double G_trace_begin(void)
+{
+    if (!is_enabled())
+	return 0;
+
+    return now();
+}
+
+/*!
+ * \brief End a span of the performance trace
+ *
+ * Records the span from <em>start</em> to now under <em>name</em>.
+ * Does nothing if <em>start</em> is 0.
+ *
+ * \param category category of the span, e.g. "raster"
+ * \param name name of the span (should be a string constant)
+ * \param start value returned by G_trace_begin()
+ */
+void G_trace_end(const char *category, const char *name, double start)
+{
+    char buf[512];
+    double t, dur;
+
+    if (start == 0)
+	return;
+
+    t = now();
+    dur = t - start;
+
+    lock();
+    if (!enabled) {
+	unlock();
+	return;
+    }
+
+    if (dur < min_duration) {
+	struct counter *c = get_counter(name, 1);
+
+	if (c) {
+	    c->value += dur;
+	    c->calls++;
+	    c->changed = 1;
+	}
+    }
+    else {
+	sprintf(buf, "{\"name\":\"%.200s\",\"cat\":\"%.100s\",\"ph\":\"X\","
+		"\"ts\":%.0f,\"dur\":%.0f,\"pid\":%d,\"tid\":%d}",
+		name, category, start - start_time, dur, getpid(),
+		thread_id());
+	put_event(buf);
+    }
+
+    if (t - last_flush >= FLUSH_INTERVAL)
+	flush_counters(t);
+    unlock();
+}
+
+/*!
+ * \brief Add to a counter of the performance trace
+ *
+ * Counters such as the number of bytes read are written to the trace
+ * at regular intervals. Does nothing if tracing is disabled.
+ *
+ * \param name name of the counter (should be a string constant)
+ * \param delta value to add
+ */
+void G_trace_count(const char *name, double delta)
+{
+    struct counter *c;
+
+    if (!is_enabled())
+	return;
+
+    lock();
+    if (enabled && (c = get_counter(name, 0))) {
+	double t = now();
+
+	c->value += delta;
+	c->changed = 1;
+	if (t - last_flush >= FLUSH_INTERVAL)
+	    flush_counters(t);
+    }
+    unlock();
+}
@@ -3,7 +3,7 @@
  *
  * \brief GIS Library - Worker functions.
  *
- * (C) 2008-2014 by the GRASS Development Team
+ * (C) 2008-2026 by the GRASS Development Team
  *
  * This program is free software under the GNU General Public License
  * (>=v2). Read the file COPYING that comes with GRASS for details.
@@ -16,172 +16,84 @@
 #include <grass/gis.h>
 #include <grass/glocale.h>
 
-#ifdef HAVE_PTHREAD_H
+/* The workers are the threads of the task scheduler (see task.c), the
+   functions below are kept for the existing callers. */
 
-/****************************************************************************/
-
-#include <pthread.h>
-
-#define DEFAULT_WORKERS 0
-
-struct worker {
-    void (*func)(void *);
-    void *closure;
-    void **ref;
-    pthread_t thread;
-    pthread_cond_t cond;
-    pthread_mutex_t mutex;
-    int cancel;
-};
-
-static int num_workers;
-static struct worker *workers;
-static pthread_cond_t worker_cond;
-static pthread_mutex_t worker_mutex;
-
-/****************************************************************************/
-
-static void *worker(void *arg)
-{
-    struct worker *w = arg;
-
-    while (!w->cancel) {
-	pthread_mutex_lock(&w->mutex);
-	while (!w->func)
-	    pthread_cond_wait(&w->cond, &w->mutex);
-
-	(*w->func)(w->closure);
-
-	w->func = NULL;
-	w->closure = NULL;
-	*w->ref = NULL;
-	pthread_mutex_unlock(&w->mutex);
-	pthread_cond_signal(&w->cond);
-	pthread_cond_signal(&worker_cond);
-    }
-
-    return NULL;
-}
-
-static struct worker *get_worker(void)
-{
-    int i;
-
-    for (i = 0; i < num_workers; i++) {
-	struct worker *w = &workers[i];
-	if (!w->func)
-	    return w;
-    }
-
-    return NULL;
-}
+static int init_count;
 
+/*!
+ * \brief Run a function on a worker thread
+ *
+ * Spawns <em>func(closure)</em> as a task (see G_task_spawn()) and
+ * stores it in <em>*ref</em>, or runs it right away if there are no
+ * worker threads. G_end_execute() waits for it.
+ *
+ * \param func function to run
+ * \param closure argument of func
+ * \param ref reference to the running function, must be NULL
+ * \param force unused, kept for compatibility
+ */
 void G_begin_execute(void (*func)(void *), void *closure, void **ref, int force)
 {
-    struct worker *w;
- 
     if (*ref)
 	G_fatal_error(_("Task already has a worker"));
 
-    pthread_mutex_lock(&worker_mutex);
-
-    while (w = get_worker(), force && num_workers > 0 && !w)
-	pthread_cond_wait(&worker_cond, &worker_mutex);
-    *ref = w;
-
-    if (!w) {
-	pthread_mutex_unlock(&worker_mutex);
+    if (G_num_threads() <= 1) {
 	(*func)(closure);
 	return;
     }
 
-    pthread_mutex_lock(&w->mutex);
-    w->func = func;
-    w->closure = closure;
-    w->ref = ref;
-    pthread_cond_signal(&w->cond);
-    pthread_mutex_unlock(&w->mutex);
-
-    pthread_mutex_unlock(&worker_mutex);
+    *ref = G_task_spawn(func, closure);
 }
 
+/*!
+ * \brief Wait for a function started with G_begin_execute()
+ *
+ * \param ref reference set by G_begin_execute(), reset to NULL
+ */
 void G_end_execute(void **ref)
 {
-    struct worker *w = *ref;
+    struct G_task *task = *ref;
 
-    if (!w)
+    if (!task)
 	return;
 
-    pthread_mutex_lock(&w->mutex);
-    while (*ref)
-	pthread_cond_wait(&w->cond, &w->mutex);
-    pthread_mutex_unlock(&w->mutex);
+    G_task_wait(task);
+    *ref = NULL;
 }
 
+/*!
+ * \brief Start the worker threads
+ *
+ * The number of threads is set by the WORKERS or GRASS_NPROCS
+ * environment variables, see G_set_num_threads(). The pool is shared
+ * by all users (modules and libraries) and started on first use.
+ */
 void G_init_workers(void)
 {
-    const char *p = getenv("WORKERS");
-    int i;
-
-    pthread_mutex_init(&worker_mutex, NULL);
-    pthread_cond_init(&worker_cond, NULL);
-
-    num_workers = p ? atoi(p) : DEFAULT_WORKERS;
-    workers = G_calloc(num_workers, sizeof(struct worker));
-
-    for (i = 0; i < num_workers; i++) {
-	struct worker *w = &workers[i];
-	pthread_mutex_init(&w->mutex, NULL);
-	pthread_cond_init(&w->cond, NULL);
-	pthread_create(&w->thread, NULL, worker, w);
-    }
+    init_count++;
 }
 
+/*!
+ * \brief Stop the worker threads
+ *
+ * The threads are stopped when every G_init_workers() has been matched
+ * by a call to this function.
+ */
 void G_finish_workers(void)
 {
-    int i;
-
-    for (i = 0; i < num_workers; i++) {
-	struct worker *w = &workers[i];
-	w->cancel = 1;
-	pthread_cancel(w->thread);
-    }
-
-    for (i = 0; i < num_workers; i++) {
-	struct worker *w = &workers[i];
-	pthread_join(w->thread, NULL);
-	pthread_mutex_destroy(&w->mutex);
-	pthread_cond_destroy(&w->cond);
-    }
-
-    pthread_mutex_destroy(&worker_mutex);
-    pthread_cond_destroy(&worker_cond);
-}
-
-/****************************************************************************/
-
-#else
-
-/****************************************************************************/
-
-void G_begin_execute(void (*func)(void *), void *closure, void **ref, int force)
-{
-    (*func)(closure);
-}
-
-void G_end_execute(void **ref)
-{
-}
+    if (init_count <= 0 || --init_count > 0)
+	return;
 
-void G_init_workers(void)
-{
+    G_finish_tasks();
 }
 
-void G_finish_workers(void)
+/*!
+ * \brief Get the number of worker threads
+ *
+ * \return number of threads besides the calling thread
+ */
+int G_num_workers(void)
 {
+    return G_num_threads() - 1;
 }
-
-/****************************************************************************/
-
-#endif
-
@@ -51,6 +51,63 @@ struct R_vrt
     struct ilist *tlist;
 };
 
+struct R_tile			/* One decoded tile             */
+{
+    int row;			/* Tile row, -1 if empty        */
+    unsigned char *data;	/* Cells, nbytes each, row by row */
+};
+
+struct R_band			/* File range read in one go    */
+{
+    off_t start, end;		/* Range held in buf            */
+    unsigned char *buf;		/* Raw file data                */
+    size_t size;		/* Allocated size of buf        */
+};
+
+struct R_null_band		/* Null rows decoded in one go  */
+{
+    int row, nrows;		/* Data rows held in bits       */
+    unsigned char *bits;	/* Null bitstreams, row by row  */
+};
+
+struct R_read_ctx		/* Decode state of one reader   */
+{
+    int fd;			/* Raster map file descriptor   */
+    int cur_row;		/* Current data row in memory   */
+    int null_cur_row;		/* Current null row in memory   */
+    int cur_nbytes;		/* nbytes per cell for current row */
+    unsigned char *data;	/* Decompressed data buffer     */
+    const unsigned char *row;	/* Current data row (data or mapped file) */
+    unsigned char *null_bits;	/* Null bitmap buffer           */
+    unsigned char *cmp;		/* Compressed data buffer       */
+    size_t cmp_size;		/* Allocated size of cmp        */
+    struct R_tile *tiles;	/* Decoded tiles, one per tile column */
+    int ntiles;			/* Number of tiles allocated    */
+    int col0, ncols;		/* Window columns to decode, ncols 0: all */
+    void *row_buf;		/* Row returned by Rast_get_row_ptr() */
+    size_t row_buf_size;	/* Allocated size of row_buf    */
+    struct R_band band;		/* Data records of Rast_get_rows() */
+    struct R_null_band null_band;	/* Null rows of Rast_get_rows() */
+    struct R_read_ctx *mask;	/* Own reader of the MASK       */
+    struct R_mask_row *mask_row;	/* Last MASK row used   */
+    int mask_serial;		/* R__.mask_serial of the above */
+};
+
+struct R_mask_row		/* One decoded MASK row         */
+{
+    int row;			/* Window row, -1 if empty      */
+    int state;			/* MASK_ROW_* below             */
+    unsigned int used;		/* Time of last use             */
+    char *flags;		/* 1 for cells masked out       */
+};
+
+#define MASK_ROW_MIXED 0
+#define MASK_ROW_ALL   1	/* all cells masked out         */
+#define MASK_ROW_NONE  2	/* no cell masked out           */
+
+struct R_read_ahead;
+struct R_write_queue;
+
 struct fileinfo			/* Information for opened cell files */
 {
     int open_mode;		/* see defines below            */
@@ -63,13 +120,14 @@ struct fileinfo			/* Information for opened cell files */
     int reclass_flag;		/* Automatic reclass flag       */
     off_t *row_ptr;		/* File row addresses           */
     COLUMN_MAPPING *col_map;	/* Data to window col mapping   */
+    int run_col, run_cols;	/* Window cols mapped to consecutive data
+				   cols, all others outside the map */
     double C1, C2;		/* Data to window row constants */
-    int cur_row;		/* Current data row in memory   */
-    int null_cur_row;		/* Current null row in memory   */
-    int cur_nbytes;		/* nbytes per cell for current row */
-    unsigned char *data;	/* Decompressed data buffer     */
+    int cur_row;		/* Next row to be written       */
+    int null_cur_row;		/* Next null row to be written  */
+    unsigned char *data;	/* Conversion buffer for writing */
     int null_fd;		/* Null bitmap fd               */
-    unsigned char *null_bits;	/* Null bitmap buffer           */
+    unsigned char *null_bits;	/* Null bitmap buffer for writing */
     int nbytes;			/* bytes per cell               */
     RASTER_MAP_TYPE map_type;	/* type: int, float or double map */
     char *temp_name;		/* Temporary name for NEW files */
@@ -81,8 +139,16 @@ struct fileinfo			/* Information for opened cell files */
     struct Quant quant;
     struct GDAL_link *gdal;
     int data_fd;		/* Raster data fd               */
+    unsigned char *map_data;	/* Mapped uncompressed data file */
+    size_t map_size;		/* Size of the mapping          */
+    int tile_rows, tile_cols;	/* Tile size, 0 for row based maps */
+    unsigned char *tile_buf;	/* Strip of rows being tiled (writing) */
+    int overview;		/* Factor of the overview read or written */
     off_t *null_row_ptr;	/* Null file row addresses      */
     struct R_vrt *vrt;
+    struct R_read_ctx rd;	/* Default reader for Rast_get_row() */
+    struct R_read_ahead *read_ahead;	/* Background read-ahead state */
+    struct R_write_queue *write_queue;	/* Rows being compressed */
 };
 
 struct R__			/*  Structure of library globals */
@@ -90,10 +156,16 @@ struct R__			/*  Structure of library globals */
     RASTER_MAP_TYPE fp_type;	/* type for writing floating maps */
     int mask_fd;		/* File descriptor for automatic mask   */
     int auto_mask;		/* Flag denoting automatic masking      */
+    struct R_mask_row *mask_rows;	/* MASK rows shared by all maps */
+    int mask_serial;		/* Incremented when the MASK changes */
     int want_histogram;
     int nbytes;
     int compression_type;
     int compress_nulls;
+    int read_ahead;		/* Rows to prefetch for new readers */
+    int tile_rows, tile_cols;	/* Tile size for new maps, 0 for rows */
+    int use_overviews;		/* Read overviews in coarse regions */
+    int map_data;		/* Map uncompressed data files */
     int window_set;		/* Flag: window set?                    */
     int split_window;           /* Separate windows for input and output */
     struct Cell_head rd_window;	/* Window used for input        */
@@ -61,6 +61,10 @@ int Rast__check_for_auto_masking(void)
 	return 0;
     }
 
+    /* prefetched rows may have been masked with the old MASK */
+    Rast__drop_all_read_ahead();
+    Rast__drop_mask_rows();
+
     if (R__.mask_fd >= 0)
 	Rast_unopen(R__.mask_fd);
     R__.mask_fd = Rast__open_old("MASK", G_mapset());
@@ -89,6 +93,8 @@ void Rast_suppress_masking(void)
     Rast__init();
 
     if (R__.auto_mask > 0) {
+	Rast__drop_all_read_ahead();
+	Rast__drop_mask_rows();
 	Rast_close(R__.mask_fd);
 	/* G_free (R__.mask_buf); */
 	R__.mask_fd = -1;
@@ -182,8 +182,8 @@ static int close_old(int fd)
     if (fcb->vrt)
 	Rast_close_vrt(fcb->vrt);
 
-    if (fcb->null_bits)
-	G_free(fcb->null_bits);
+    Rast__free_read_ahead(fd);
+    Rast__free_read_ctx(&fcb->rd);
     if (fcb->null_row_ptr)
 	G_free(fcb->null_row_ptr);
     if (fcb->null_fd >= 0)
@@ -192,9 +192,9 @@ static int close_old(int fd)
 
     if (fcb->cellhd.compressed)
 	G_free(fcb->row_ptr);
+    Rast__unmap_data(fd);
     G_free(fcb->col_map);
     G_free(fcb->mapset);
-    G_free(fcb->data);
     G_free(fcb->name);
     if (fcb->reclass_flag)
 	Rast_free_reclass(&fcb->reclass);
@@ -366,6 +366,85 @@ static int close_new_gdal(int fd, int ok)
     return stat;
 }
 
+static int close_new_overview(int fd, int ok)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    char element[GNAME_MAX], path[GPATH_MAX];
+    int stat = 1;
+
+    if (ok) {
+	if (fcb->cur_row < fcb->cellhd.rows) {
+	    int row;
+
+	    Rast_zero_output_buf(fcb->data, fcb->map_type);
+	    for (row = fcb->cur_row; row < fcb->cellhd.rows; row++)
+		Rast_put_row(fd, fcb->data, fcb->map_type);
+	}
+
+	/* write the rows still being compressed */
+	Rast__flush_put_rows(fd);
+
+	if (fcb->null_row_ptr) {			/* compressed nulls */
+	    fcb->null_row_ptr[fcb->cellhd.rows] = lseek(fcb->null_fd, 0L, SEEK_CUR);
+	    Rast__write_null_row_ptrs(fd, fcb->null_fd);
+	}
+
+	fcb->row_ptr[fcb->cellhd.rows] = lseek(fcb->data_fd, 0L, SEEK_CUR);
+	Rast__write_row_ptrs(fd);
+    }
+
+    Rast__free_put_rows(fd);
+
+    sync_and_close(fcb->data_fd, "cell_misc", fcb->name);
+    sync_and_close(fcb->null_fd,
+		   (fcb->null_row_ptr ? NULLC_FILE : NULL_FILE), fcb->name);
+    fcb->null_fd = -1;
+    fcb->open_mode = -1;
+
+    if (ok) {
+	G__make_mapset_element_misc("cell_misc", fcb->name);
+
+	Rast__overview_element(element, fcb->overview, "");
+	G_file_name_misc(path, "cell_misc", element, fcb->name, fcb->mapset);
+	if (rename(fcb->temp_name, path)) {
+	    G_warning(_("Unable to rename cell file '%s' to '%s': %s"),
+		      fcb->temp_name, path, strerror(errno));
+	    stat = -1;
+	}
+
+	Rast__overview_element(element, fcb->overview,
+			       fcb->null_row_ptr ? "." NULLC_FILE : "." NULL_FILE);
+	G_file_name_misc(path, "cell_misc", element, fcb->name, fcb->mapset);
+	if (rename(fcb->null_temp_name, path)) {
+	    G_warning(_("Unable to rename null file '%s' to '%s': %s"),
+		      fcb->null_temp_name, path, strerror(errno));
+	    stat = -1;
+	}
+
+	if (stat > 0)
+	    Rast__write_overview_level(fd);
+    }
+
+    remove(fcb->temp_name);
+    remove(fcb->null_temp_name);
+
+    G_free(fcb->temp_name);
+    G_free(fcb->null_temp_name);
+    G_free(fcb->name);
+    G_free(fcb->mapset);
+    G_free(fcb->data);
+    G_free(fcb->null_bits);
+    G_free(fcb->row_ptr);
+    if (fcb->null_row_ptr)
+	G_free(fcb->null_row_ptr);
+    if (fcb->want_histogram)
+	Rast_free_cell_stats(&fcb->statf);
+    if (fcb->map_type != CELL_TYPE)
+	Rast_quant_free(&fcb->quant);
+
+    return stat;
+}
+
 static int close_new(int fd, int ok)
 {
     struct fileinfo *fcb = &R__.fileinfo[fd];
@@ -377,6 +456,9 @@ static int close_new(int fd, int ok)
     if (fcb->gdal)
 	return close_new_gdal(fd, ok);
 
+    if (fcb->overview)
+	return close_new_overview(fd, ok);
+
     if (ok) {
 	switch (fcb->open_mode) {
 	case OPEN_NEW_COMPRESSED:
@@ -395,6 +477,9 @@ static int close_new(int fd, int ok)
 	    fcb->data = NULL;
 	}
 
+	/* write the rows still being compressed */
+	Rast__flush_put_rows(fd);
+
 	if (fcb->null_row_ptr) {			/* compressed nulls */
 	    fcb->null_row_ptr[fcb->cellhd.rows] = lseek(fcb->null_fd, 0L, SEEK_CUR);
 	    Rast__write_null_row_ptrs(fd, fcb->null_fd);
@@ -436,10 +521,14 @@ static int close_new(int fd, int ok)
 	}			/* null_cur_row > 0 */
 
 	if (fcb->open_mode == OPEN_NEW_COMPRESSED) {	/* auto compression */
-	    fcb->row_ptr[fcb->cellhd.rows] = lseek(fcb->data_fd, 0L, SEEK_CUR);
+	    fcb->row_ptr[Rast__row_ptr_count(fd)] =
+		lseek(fcb->data_fd, 0L, SEEK_CUR);
 	    Rast__write_row_ptrs(fd);
 	}
 
+	/* overviews of a map which is replaced are outdated */
+	Rast_remove_overviews(fcb->name);
+
 	if (fcb->map_type != CELL_TYPE) {	/* floating point map */
 	    int cell_fd;
 
@@ -466,6 +555,8 @@ static int close_new(int fd, int ok)
     }				/* ok */
     /* NOW CLOSE THE FILE DESCRIPTOR */
 
+    Rast__free_put_rows(fd);
+
     sync_and_close(fcb->data_fd,
                    (fcb->map_type == CELL_TYPE ? "cell" : "fcell"),
 		   fcb->name);
@@ -481,6 +572,11 @@ static int close_new(int fd, int ok)
     if (fcb->data != NULL)
 	G_free(fcb->data);
 
+    if (fcb->tile_buf != NULL) {
+	G_free(fcb->tile_buf);
+	fcb->tile_buf = NULL;
+    }
+
     if (fcb->null_temp_name != NULL) {
 	G_free(fcb->null_temp_name);
 	fcb->null_temp_name = NULL;
@@ -532,6 +628,9 @@ void Rast__close_null(int fd)
     struct fileinfo *fcb = &R__.fileinfo[fd];
     char path[GPATH_MAX];
 
+    Rast__flush_put_rows(fd);
+    Rast__free_put_rows(fd);
+
     if (fcb->null_row_ptr) {			/* compressed nulls */
 	fcb->null_row_ptr[fcb->cellhd.rows] = lseek(fcb->null_fd, 0L, SEEK_CUR);
 	Rast__write_null_row_ptrs(fd, fcb->null_fd);
@@ -558,6 +657,9 @@ void Rast__close_null(int fd)
 		  fcb->null_temp_name, path, strerror(errno));
     remove(fcb->null_temp_name);
 
+    /* the overviews do not have the new nulls */
+    Rast_remove_overviews(fcb->name);
+
     G_free(fcb->null_temp_name);
 
     G_free(fcb->name);
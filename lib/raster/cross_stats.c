@@ -0,0 +1,805 @@
+/*!
+ * \file lib/raster/cross_stats.c
+ *
+ * \brief Raster Library - Counts of combinations of categories
+ *
+ * The combinations of the categories of several maps (or of a single
+ * map) are counted in an open-addressing hash table keyed by the
+ * categories, with linear probing. Each entry has a count and a fixed
+ * number of accumulators, which are summed or hold the smallest or
+ * largest value added.
+ *
+ * Tables of parts of the maps (e.g. bands of rows read on several
+ * threads) are added to the table of the whole maps with
+ * Rast_merge_cross_stats(). When a memory limit is set, the entries
+ * are written to a temporary file sorted by their categories whenever
+ * the table is full, and the files are merged when the entries are read.
+ *
+ * When the ranges of the categories are known and have few combinations
+ * (e.g. maps with a few classes), the combinations in the ranges are
+ * counted in an array indexed by the categories, which is faster than
+ * hashing them. The other combinations are still counted in the hash
+ * table, the ranges need not hold all categories.
+ *
+ * (C) 2026 by the GRASS Development Team
+ *
+ * This program is free software under the GNU General Public License
+ * (>=v2). Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/glocale.h>
+
+#define INIT_SIZE 256
+
+/* most combinations counted in the dense array */
+#define DENSE_MAX (1 << 18)
+
+struct R_cross_run
+{
+    char *name;
+    FILE *fp;
+    CELL *key;			/* current entry */
+    long count;
+    double *vals;
+    int valid;
+};
+
+static const struct Cross_stats *sort_stats;	/* for compare_slots() */
+
+static unsigned int hash_key(const CELL * key, int n)
+{
+    unsigned int h = 0x9e3779b9U;
+    int i;
+
+    for (i = 0; i < n; i++) {
+	h ^= (unsigned int)key[i];
+	h *= 0x85ebca6bU;
+	h ^= h >> 13;
+    }
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+
+    return h | 1;		/* 0 marks the empty slots */
+}
+
+static int compare_keys(const CELL * a, const CELL * b, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	if (a[i] < b[i])
+	    return -1;
+	if (a[i] > b[i])
+	    return 1;
+    }
+
+    return 0;
+}
+
+static int same_key(const CELL * a, const CELL * b, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+	if (a[i] != b[i])
+	    return 0;
+
+    return 1;
+}
+
+static void combine(const struct Cross_stats *s, double *acc,
+		    const double *vals)
+{
+    int j;
+
+    for (j = 0; j < s->nvals; j++) {
+	switch (s->ops[j]) {
+	case CROSS_STATS_SUM:
+	    acc[j] += vals[j];
+	    break;
+	case CROSS_STATS_MIN:
+	    if (vals[j] < acc[j])
+		acc[j] = vals[j];
+	    break;
+	case CROSS_STATS_MAX:
+	    if (vals[j] > acc[j])
+		acc[j] = vals[j];
+	    break;
+	}
+    }
+}
+
+/* index of the key in the dense array, 0 if it is not in the ranges */
+static int dense_index(const struct Cross_stats *s, const CELL * key,
+		       size_t *idx)
+{
+    size_t k = 0;
+    int i;
+
+    for (i = 0; i < s->nkeys; i++) {
+	if (key[i] < s->range_min[i] || key[i] > s->range_max[i])
+	    return 0;
+	k = k * ((size_t) s->range_max[i] - s->range_min[i] + 1) +
+	    ((size_t) key[i] - s->range_min[i]);
+    }
+    *idx = k;
+
+    return 1;
+}
+
+/* key of the index in the dense array */
+static void dense_key(const struct Cross_stats *s, size_t k, CELL * key)
+{
+    int i;
+
+    for (i = s->nkeys - 1; i >= 0; i--) {
+	size_t n = (size_t) s->range_max[i] - s->range_min[i] + 1;
+
+	key[i] = s->range_min[i] + (CELL) (k % n);
+	k /= n;
+    }
+}
+
+static void add_dense(struct Cross_stats *s, size_t k, long count,
+		      const double *vals)
+{
+    if (s->dense_used[k]) {
+	s->dense_counts[k] += count;
+	combine(s, s->dense_vals + k * s->nvals, vals);
+	return;
+    }
+
+    s->dense_used[k] = 1;
+    s->dense_counts[k] = count;
+    if (s->nvals)
+	memcpy(s->dense_vals + k * s->nvals, vals, s->nvals * sizeof(double));
+    s->dense_list[s->dense_n++] = k;
+}
+
+static void free_dense(struct Cross_stats *s)
+{
+    if (!s->dense_size)
+	return;
+
+    G_free(s->dense_used);
+    G_free(s->dense_counts);
+    if (s->dense_vals)
+	G_free(s->dense_vals);
+    G_free(s->dense_list);
+    s->dense_size = 0;
+    s->dense_n = 0;
+}
+
+static void clear_dense(struct Cross_stats *s)
+{
+    size_t i;
+
+    for (i = 0; i < s->dense_n; i++)
+	s->dense_used[s->dense_list[i]] = 0;
+    s->dense_n = 0;
+}
+
+static void alloc_slots(struct Cross_stats *s, size_t size)
+{
+    s->size = size;
+    s->tags = G_calloc(size, sizeof(unsigned int));
+    s->keys = G_malloc(size * s->nkeys * sizeof(CELL));
+    s->counts = G_malloc(size * sizeof(long));
+    s->vals = s->nvals ? G_malloc(size * s->nvals * sizeof(double)) : NULL;
+}
+
+static void free_slots(struct Cross_stats *s)
+{
+    G_free(s->tags);
+    G_free(s->keys);
+    G_free(s->counts);
+    if (s->vals)
+	G_free(s->vals);
+}
+
+/* slot of the key, or the empty slot where it belongs */
+static size_t find_slot(const struct Cross_stats *s, const CELL * key,
+			unsigned int tag)
+{
+    size_t mask = s->size - 1;
+    size_t i = (tag >> 1) & mask;
+
+    for (;;) {
+	if (s->tags[i] == 0)
+	    return i;
+	if (s->tags[i] == tag &&
+	    same_key(s->keys + i * s->nkeys, key, s->nkeys))
+	    return i;
+	i = (i + 1) & mask;
+    }
+}
+
+static void grow(struct Cross_stats *s)
+{
+    struct Cross_stats old = *s;
+    size_t i;
+
+    alloc_slots(s, 2 * old.size);
+
+    for (i = 0; i < old.size; i++) {
+	size_t j;
+
+	if (!old.tags[i])
+	    continue;
+	j = find_slot(s, old.keys + i * s->nkeys, old.tags[i]);
+	s->tags[j] = old.tags[i];
+	memcpy(s->keys + j * s->nkeys, old.keys + i * s->nkeys,
+	       s->nkeys * sizeof(CELL));
+	s->counts[j] = old.counts[i];
+	if (s->nvals)
+	    memcpy(s->vals + j * s->nvals, old.vals + i * s->nvals,
+		   s->nvals * sizeof(double));
+    }
+
+    free_slots(&old);
+    s->have_last = 0;
+}
+
+static void clear(struct Cross_stats *s)
+{
+    memset(s->tags, 0, s->size * sizeof(unsigned int));
+    s->n = 0;
+    s->have_last = 0;
+}
+
+static int compare_slots(const void *aa, const void *bb)
+{
+    const size_t *a = aa, *b = bb;
+    int n = sort_stats->nkeys;
+
+    return compare_keys(sort_stats->keys + *a * n, sort_stats->keys + *b * n,
+			n);
+}
+
+/* the slots of the entries in the order of the keys */
+static void sort_entries(struct Cross_stats *s)
+{
+    size_t i, n;
+
+    s->order = G_realloc(s->order, (s->n ? s->n : 1) * sizeof(size_t));
+    for (i = n = 0; i < s->size; i++)
+	if (s->tags[i])
+	    s->order[n++] = i;
+
+    sort_stats = s;
+    qsort(s->order, n, sizeof(size_t), compare_slots);
+    sort_stats = NULL;
+}
+
+static void write_entry(const struct Cross_stats *s, FILE * fp, size_t i)
+{
+    if (fwrite(s->keys + i * s->nkeys, sizeof(CELL), s->nkeys, fp) !=
+	(size_t) s->nkeys ||
+	fwrite(&s->counts[i], sizeof(long), 1, fp) != 1 ||
+	(s->nvals &&
+	 fwrite(s->vals + i * s->nvals, sizeof(double), s->nvals, fp) !=
+	 (size_t) s->nvals))
+	G_fatal_error(_("Unable to write to temporary file"));
+}
+
+static int read_entry(const struct Cross_stats *s, struct R_cross_run *run)
+{
+    if (fread(run->key, sizeof(CELL), s->nkeys, run->fp) !=
+	(size_t) s->nkeys)
+	return 0;
+    if (fread(&run->count, sizeof(long), 1, run->fp) != 1 ||
+	(s->nvals &&
+	 fread(run->vals, sizeof(double), s->nvals, run->fp) !=
+	 (size_t) s->nvals))
+	G_fatal_error(_("Unable to read from temporary file"));
+
+    return 1;
+}
+
+/* write the entries sorted to a new run */
+static void spill(struct Cross_stats *s)
+{
+    struct R_cross_run *run;
+    size_t i;
+
+    s->runs = G_realloc(s->runs, (s->nruns + 1) * sizeof(struct R_cross_run));
+    run = &s->runs[s->nruns++];
+    run->name = G_tempfile();
+    run->fp = fopen(run->name, "w+b");
+    if (!run->fp)
+	G_fatal_error(_("Unable to create temporary file <%s>"), run->name);
+    run->key = G_malloc(s->nkeys * sizeof(CELL));
+    run->vals = s->nvals ? G_malloc(s->nvals * sizeof(double)) : NULL;
+    run->valid = 0;
+
+    sort_entries(s);
+    for (i = 0; i < s->n; i++)
+	write_entry(s, run->fp, s->order[i]);
+
+    G_debug(1, "Cross_stats: %lu entries written to run %d",
+	    (unsigned long)s->n, s->nruns);
+
+    clear(s);
+}
+
+static size_t add_entry(struct Cross_stats *s, const CELL * key,
+			unsigned int tag, long count, const double *vals)
+{
+    size_t i = find_slot(s, key, tag);
+
+    if (s->tags[i]) {
+	s->counts[i] += count;
+	combine(s, s->vals + i * s->nvals, vals);
+	return i;
+    }
+
+    if (s->max_entries && s->n >= s->max_entries) {
+	spill(s);
+	i = find_slot(s, key, tag);
+    }
+    else if (2 * (s->n + 1) > s->size) {
+	grow(s);
+	i = find_slot(s, key, tag);
+    }
+
+    s->tags[i] = tag;
+    memcpy(s->keys + i * s->nkeys, key, s->nkeys * sizeof(CELL));
+    s->counts[i] = count;
+    if (s->nvals)
+	memcpy(s->vals + i * s->nvals, vals, s->nvals * sizeof(double));
+    s->n++;
+
+    return i;
+}
+
+/* move the entries of the dense array to the hash table */
+static void flush_dense(struct Cross_stats *s)
+{
+    size_t i;
+
+    for (i = 0; i < s->dense_n; i++) {
+	size_t k = s->dense_list[i];
+
+	dense_key(s, k, s->dense_key);
+	add_entry(s, s->dense_key, hash_key(s->dense_key, s->nkeys),
+		  s->dense_counts[k], s->dense_vals + k * s->nvals);
+    }
+    free_dense(s);
+    s->have_last = 0;
+}
+
+/*!
+ * \brief Initialize a table of combinations of categories
+ *
+ * \param s pointer to Cross_stats structure
+ * \param nkeys number of categories of a combination
+ * \param nvals number of accumulators of an entry
+ * \param ops CROSS_STATS_SUM, CROSS_STATS_MIN or CROSS_STATS_MAX for
+ * each accumulator, NULL for sums only
+ */
+void Rast_init_cross_stats(struct Cross_stats *s, int nkeys, int nvals,
+			   const int *ops)
+{
+    int j;
+
+    s->nkeys = nkeys;
+    s->nvals = nvals;
+    s->ops = G_malloc((nvals ? nvals : 1) * sizeof(int));
+    for (j = 0; j < nvals; j++)
+	s->ops[j] = ops ? ops[j] : CROSS_STATS_SUM;
+
+    alloc_slots(s, INIT_SIZE);
+    s->n = 0;
+    s->max_entries = 0;
+    s->have_last = 0;
+    s->order = NULL;
+    s->cur = 0;
+    s->runs = NULL;
+    s->nruns = 0;
+
+    s->range_min = G_malloc(nkeys * sizeof(CELL));
+    s->range_max = G_malloc(nkeys * sizeof(CELL));
+    for (j = 0; j < nkeys; j++) {
+	s->range_min[j] = 1;
+	s->range_max[j] = 0;
+    }
+    s->dense_size = 0;
+    s->dense_n = 0;
+    s->dense_key = G_malloc(nkeys * sizeof(CELL));
+    s->row_idx = NULL;
+    s->row_len = 0;
+}
+
+/*!
+ * \brief Limit the memory of the table
+ *
+ * When the table is full its entries are written to a temporary file.
+ *
+ * \param s pointer to Cross_stats structure
+ * \param mb memory in MB, 0 for no limit
+ */
+void Rast_set_cross_stats_memory(struct Cross_stats *s, int mb)
+{
+    size_t entry = sizeof(unsigned int) + s->nkeys * sizeof(CELL) +
+	sizeof(long) + s->nvals * sizeof(double) + sizeof(size_t);
+    size_t slots = INIT_SIZE;
+
+    if (mb <= 0) {
+	s->max_entries = 0;
+	return;
+    }
+
+    /* at most half of the slots are used */
+    while (2 * slots * entry <= (size_t) mb << 20)
+	slots *= 2;
+    s->max_entries = slots / 2;
+}
+
+/*!
+ * \brief Set the range of the categories of a key
+ *
+ * When the ranges of all keys are set and have few combinations, the
+ * combinations in the ranges are counted in an array instead of the
+ * hash table. Categories outside the ranges are still counted. Must be
+ * called before the first entry is added.
+ *
+ * \param s pointer to Cross_stats structure
+ * \param i key, from 0 to the number of keys - 1
+ * \param min smallest category
+ * \param max largest category
+ */
+void Rast_set_cross_stats_range(struct Cross_stats *s, int i, CELL min,
+				CELL max)
+{
+    double size = 1;
+    int j;
+
+    s->range_min[i] = min;
+    s->range_max[i] = max;
+
+    free_dense(s);
+    for (j = 0; j < s->nkeys; j++) {
+	if (s->range_max[j] < s->range_min[j])
+	    return;
+	size *= (double)s->range_max[j] - s->range_min[j] + 1;
+    }
+    if (size > DENSE_MAX)
+	return;
+
+    s->dense_size = (size_t) size;
+    s->dense_used = G_calloc(s->dense_size, 1);
+    s->dense_counts = G_malloc(s->dense_size * sizeof(long));
+    s->dense_vals = s->nvals ?
+	G_malloc(s->dense_size * s->nvals * sizeof(double)) : NULL;
+    s->dense_list = G_malloc(s->dense_size * sizeof(size_t));
+
+    G_debug(3, "Cross_stats: %lu combinations counted in an array",
+	    (unsigned long)s->dense_size);
+}
+
+/*!
+ * \brief Add to the entry of a combination of categories
+ *
+ * \param s pointer to Cross_stats structure
+ * \param key categories of the combination
+ * \param count count to add
+ * \param vals values for the accumulators, NULL without accumulators
+ */
+void Rast_update_cross_stats(struct Cross_stats *s, const CELL * key,
+			     long count, const double *vals)
+{
+    size_t k;
+
+    if (s->dense_size && dense_index(s, key, &k)) {
+	add_dense(s, k, count, vals);
+	return;
+    }
+
+    /* neighbouring cells often have the same categories */
+    if (s->have_last && same_key(s->keys + s->last * s->nkeys, key, s->nkeys)) {
+	s->counts[s->last] += count;
+	combine(s, s->vals + s->last * s->nvals, vals);
+	return;
+    }
+
+    s->last = add_entry(s, key, hash_key(key, s->nkeys), count, vals);
+    s->have_last = 1;
+}
+
+/*!
+ * \brief Add to the entries of the combinations of the cells of rows
+ *
+ * The categories of key i of the cells are in row i. All cells are
+ * counted, nulls are categories like any other.
+ *
+ * \param s pointer to Cross_stats structure
+ * \param row categories of each key
+ * \param ncols number of cells
+ * \param count count to add for each cell
+ * \param vals values for the accumulators of each cell, NULL without
+ * accumulators
+ */
+void Rast_update_cross_stats_row(struct Cross_stats *s, CELL ** row,
+				 int ncols, long count, const double *vals)
+{
+    const size_t none = (size_t) - 1;
+    size_t *idx;
+    int i, col;
+
+    if (!s->dense_size) {
+	for (col = 0; col < ncols; col++) {
+	    for (i = 0; i < s->nkeys; i++)
+		s->dense_key[i] = row[i][col];
+	    Rast_update_cross_stats(s, s->dense_key, count, vals);
+	}
+	return;
+    }
+
+    if (s->row_len < ncols) {
+	s->row_len = ncols;
+	s->row_idx = G_realloc(s->row_idx, ncols * sizeof(size_t));
+    }
+    idx = s->row_idx;
+
+    /* the indices of the keys at once, a row of a key after the other */
+    for (col = 0; col < ncols; col++)
+	idx[col] = 0;
+    for (i = 0; i < s->nkeys; i++) {
+	CELL min = s->range_min[i], max = s->range_max[i];
+	size_t n = (size_t) max - min + 1;
+	const CELL *cell = row[i];
+
+	for (col = 0; col < ncols; col++) {
+	    if (idx[col] == none)
+		continue;
+	    if (cell[col] < min || cell[col] > max)
+		idx[col] = none;
+	    else
+		idx[col] = idx[col] * n + ((size_t) cell[col] - min);
+	}
+    }
+
+    for (col = 0; col < ncols; col++) {
+	size_t k = idx[col];
+
+	if (k == none) {
+	    for (i = 0; i < s->nkeys; i++)
+		s->dense_key[i] = row[i][col];
+	    Rast_update_cross_stats(s, s->dense_key, count, vals);
+	}
+	else if (s->dense_used[k] && !s->nvals)
+	    s->dense_counts[k] += count;
+	else
+	    add_dense(s, k, count, vals);
+    }
+}
+
+/*!
+ * \brief Add the entries of another table and empty it
+ *
+ * \param s pointer to Cross_stats structure
+ * \param other table with the same keys and accumulators, which is
+ * emptied but not freed
+ */
+void Rast_merge_cross_stats(struct Cross_stats *s, struct Cross_stats *other)
+{
+    size_t i, k;
+    int same = s->dense_size && other->dense_size &&
+	memcmp(s->range_min, other->range_min, s->nkeys * sizeof(CELL)) == 0
+	&& memcmp(s->range_max, other->range_max, s->nkeys * sizeof(CELL)) == 0;
+
+    for (i = 0; i < other->dense_n; i++) {
+	size_t j = other->dense_list[i];
+	const double *vals = other->dense_vals + j * s->nvals;
+
+	if (same)
+	    add_dense(s, j, other->dense_counts[j], vals);
+	else {
+	    dense_key(other, j, other->dense_key);
+	    if (s->dense_size && dense_index(s, other->dense_key, &k))
+		add_dense(s, k, other->dense_counts[j], vals);
+	    else
+		add_entry(s, other->dense_key,
+			  hash_key(other->dense_key, s->nkeys),
+			  other->dense_counts[j], vals);
+	}
+    }
+
+    for (i = 0; i < other->size; i++) {
+	const CELL *key = other->keys + i * s->nkeys;
+
+	if (!other->tags[i])
+	    continue;
+	if (s->dense_size && dense_index(s, key, &k))
+	    add_dense(s, k, other->counts[i], other->vals + i * s->nvals);
+	else
+	    add_entry(s, key, other->tags[i], other->counts[i],
+		      other->vals + i * s->nvals);
+    }
+
+    s->have_last = 0;
+    clear(other);
+    if (other->dense_size)
+	clear_dense(other);
+}
+
+/*!
+ * \brief Find the entry of a combination of categories
+ *
+ * Only the entries in memory are found, i.e. no memory limit should be
+ * set.
+ *
+ * \param s pointer to Cross_stats structure
+ * \param key categories of the combination
+ * \param[out] count count of the entry, may be NULL
+ * \param[out] vals set to the accumulators of the entry, which may be
+ * changed, may be NULL
+ *
+ * \return 1 if found, 0 otherwise
+ */
+int Rast_find_cross_stat(struct Cross_stats *s, const CELL * key,
+			 long *count, double **vals)
+{
+    size_t i;
+
+    if (s->dense_size && dense_index(s, key, &i) && s->dense_used[i]) {
+	if (count)
+	    *count = s->dense_counts[i];
+	if (vals)
+	    *vals = s->dense_vals + i * s->nvals;
+	return 1;
+    }
+
+    if (s->have_last && same_key(s->keys + s->last * s->nkeys, key, s->nkeys))
+	i = s->last;
+    else {
+	i = find_slot(s, key, hash_key(key, s->nkeys));
+	if (!s->tags[i])
+	    return 0;
+	s->last = i;
+	s->have_last = 1;
+    }
+
+    if (count)
+	*count = s->counts[i];
+    if (vals)
+	*vals = s->vals + i * s->nvals;
+
+    return 1;
+}
+
+/*!
+ * \brief Start reading the entries in the order of the categories
+ *
+ * No entries may be added while reading them.
+ *
+ * \param s pointer to Cross_stats structure
+ */
+void Rast_rewind_cross_stats(struct Cross_stats *s)
+{
+    int r;
+
+    /* the dense array is not used any more */
+    flush_dense(s);
+
+    if (s->nruns == 0) {
+	sort_entries(s);
+	s->cur = 0;
+	return;
+    }
+
+    if (s->n > 0)
+	spill(s);
+
+    for (r = 0; r < s->nruns; r++) {
+	struct R_cross_run *run = &s->runs[r];
+
+	if (fflush(run->fp) != 0 || fseek(run->fp, 0L, SEEK_SET) != 0)
+	    G_fatal_error(_("Unable to read from temporary file"));
+	run->valid = read_entry(s, run);
+    }
+}
+
+/*!
+ * \brief Read the next entry
+ *
+ * \param s pointer to Cross_stats structure
+ * \param[out] key categories of the combination
+ * \param[out] count count of the entry
+ * \param[out] vals accumulators of the entry, NULL without accumulators
+ *
+ * \return 1 if an entry was read, 0 after the last one
+ */
+int Rast_next_cross_stat(struct Cross_stats *s, CELL * key, long *count,
+			 double *vals)
+{
+    int r, first;
+
+    if (s->nruns == 0) {
+	size_t i;
+
+	if (s->cur >= s->n)
+	    return 0;
+
+	i = s->order[s->cur++];
+	memcpy(key, s->keys + i * s->nkeys, s->nkeys * sizeof(CELL));
+	*count = s->counts[i];
+	if (s->nvals)
+	    memcpy(vals, s->vals + i * s->nvals, s->nvals * sizeof(double));
+
+	return 1;
+    }
+
+    /* smallest key of the runs, each run has it at most once */
+    first = -1;
+    for (r = 0; r < s->nruns; r++)
+	if (s->runs[r].valid &&
+	    (first < 0 ||
+	     compare_keys(s->runs[r].key, s->runs[first].key, s->nkeys) < 0))
+	    first = r;
+
+    if (first < 0)
+	return 0;
+
+    memcpy(key, s->runs[first].key, s->nkeys * sizeof(CELL));
+    *count = 0;
+    for (r = first; r < s->nruns; r++) {
+	struct R_cross_run *run = &s->runs[r];
+
+	if (!run->valid || !same_key(run->key, key, s->nkeys))
+	    continue;
+
+	if (r == first) {
+	    *count = run->count;
+	    if (s->nvals)
+		memcpy(vals, run->vals, s->nvals * sizeof(double));
+	}
+	else {
+	    *count += run->count;
+	    combine(s, vals, run->vals);
+	}
+	run->valid = read_entry(s, run);
+    }
+
+    return 1;
+}
+
+/*!
+ * \brief Free the table and remove its temporary files
+ *
+ * \param s pointer to Cross_stats structure
+ */
+void Rast_free_cross_stats(struct Cross_stats *s)
+{
+    int r;
+
+    free_slots(s);
+    free_dense(s);
+    G_free(s->ops);
+    G_free(s->range_min);
+    G_free(s->range_max);
+    G_free(s->dense_key);
+    if (s->row_idx)
+	G_free(s->row_idx);
+    if (s->order)
+	G_free(s->order);
+
+    for (r = 0; r < s->nruns; r++) {
+	struct R_cross_run *run = &s->runs[r];
+
+	fclose(run->fp);
+	remove(run->name);
+	G_free(run->name);
+	G_free(run->key);
+	if (run->vals)
+	    G_free(run->vals);
+    }
+    if (s->runs)
+	G_free(s->runs);
+}
@@ -35,6 +35,19 @@
    0 0 0 74        offset of end of data
    \endverbatim
 
+   The offset table of a map stored in tiles (see tile.c) indexes the
+   tiles instead of the rows. It is preceded by a zero byte, which
+   readers of row based maps reject as an invalid offset size, and by
+   the number of rows and columns of a tile, 4 bytes each in big-endian
+   byte order:
+   \verbatim
+   0               tiled map
+   0 0 1 0         rows of a tile
+   0 0 1 0         columns of a tile
+   8               sizeof(off_t)
+   ...             offsets of the tiles and of the end of data
+   \endverbatim
+
    See Rast__write_row_ptrs() below for the code which writes this data. 
    However, note that the row offsets are initially zero; 
    they get overwritten later (if you are writing compressed data,
@@ -55,11 +68,49 @@
  *   format.   If it is, the offset table at the beginning of the 
  *   file (which gives seek addresses into the file where code for
  *   each row is found) is read into the File Control Buffer (FCB).
+ *   For tiled maps the table gives the addresses of the tiles and
+ *   the tile size is read from its header.
  *   The compressed flag in the FCB is appropriately set.
  *
  *   returns:    1 if row pointers were read successfully, -1 otherwise
  **********************************************************************/
 
+static int get_int(const unsigned char *b)
+{
+    return (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+}
+
+static void put_int(unsigned char *b, int v)
+{
+    b[0] = (v >> 24) & 0xff;
+    b[1] = (v >> 16) & 0xff;
+    b[2] = (v >> 8) & 0xff;
+    b[3] = v & 0xff;
+}
+
+/* read the tile size of a tiled map, leaving the file at the offset size */
+static int read_tile_header(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    unsigned char buf[8];
+
+    if (read(fcb->data_fd, buf, 1) != 1)
+	return -1;
+
+    if (buf[0] != 0)
+	return lseek(fcb->data_fd, -1, SEEK_CUR) < 0 ? -1 : 1;
+
+    if (read(fcb->data_fd, buf, 8) != 8)
+	return -1;
+
+    fcb->tile_rows = get_int(buf);
+    fcb->tile_cols = get_int(buf + 4);
+    if (fcb->tile_rows <= 0 || fcb->tile_cols <= 0)
+	return -1;
+
+    return 1;
+}
+
 int Rast__check_format(int fd)
 {
     struct fileinfo *fcb = &R__.fileinfo[fd];
@@ -81,11 +132,20 @@ int Rast__check_format(int fd)
 	    fcb->cellhd.compressed = 0;
     }
 
+    /* only compressed maps can be tiled */
+    fcb->tile_rows = fcb->tile_cols = 0;
+
     if (!fcb->cellhd.compressed)
 	return 1;
 
+    if (fcb->cellhd.compressed > 0 && read_tile_header(fd) < 0) {
+	G_warning(_("Fail of initial read of compressed file [%s in %s]"),
+		  fcb->name, fcb->mapset);
+	return -1;
+    }
+
     /* allocate space to hold the row address array */
-    fcb->row_ptr = G_calloc(fcb->cellhd.rows + 1, sizeof(off_t));
+    fcb->row_ptr = G_calloc(Rast__row_ptr_count(fd) + 1, sizeof(off_t));
 
     /* read the row address array */
     return Rast__read_row_ptrs(fd);
@@ -155,7 +215,7 @@ static int read_row_ptrs(int nrows, int old, off_t *row_ptr, int fd)
 int Rast__read_row_ptrs(int fd)
 {
     struct fileinfo *fcb = &R__.fileinfo[fd];
-    int nrows = fcb->cellhd.rows;
+    int nrows = Rast__row_ptr_count(fd);
     int old = fcb->cellhd.compressed < 0;
 
     if (read_row_ptrs(nrows, old, fcb->row_ptr, fcb->data_fd) < 0) {
@@ -181,7 +241,8 @@ int Rast__read_null_row_ptrs(int fd, int null_fd)
     return 1;
 }
 
-static int write_row_ptrs(int nrows, off_t *row_ptr, int fd)
+static int write_row_ptrs(int nrows, off_t *row_ptr, int fd,
+			  int tile_rows, int tile_cols)
 {
     int nbytes = sizeof(off_t);
     unsigned char *buf, *b;
@@ -190,7 +251,15 @@ static int write_row_ptrs(int nrows, off_t *row_ptr, int fd)
     lseek(fd, 0L, SEEK_SET);
 
     len = (nrows + 1) * nbytes + 1;
+    if (tile_rows > 0)
+	len += 9;
     b = buf = G_malloc(len);
+    if (tile_rows > 0) {
+	*b++ = 0;
+	put_int(b, tile_rows);
+	put_int(b + 4, tile_cols);
+	b += 8;
+    }
     *b++ = nbytes;
 
     for (row = 0; row <= nrows; row++) {
@@ -214,9 +283,10 @@ static int write_row_ptrs(int nrows, off_t *row_ptr, int fd)
 int Rast__write_row_ptrs(int fd)
 {
     struct fileinfo *fcb = &R__.fileinfo[fd];
-    int nrows = fcb->cellhd.rows;
+    int nrows = Rast__row_ptr_count(fd);
 
-    return write_row_ptrs(nrows, fcb->row_ptr, fcb->data_fd);
+    return write_row_ptrs(nrows, fcb->row_ptr, fcb->data_fd,
+			  fcb->tile_rows, fcb->tile_cols);
 }
 
 int Rast__write_null_row_ptrs(int fd, int null_fd)
@@ -224,5 +294,5 @@ int Rast__write_null_row_ptrs(int fd, int null_fd)
     struct fileinfo *fcb = &R__.fileinfo[fd];
     int nrows = fcb->cellhd.rows;
 
-    return write_row_ptrs(nrows, fcb->null_row_ptr, null_fd);
+    return write_row_ptrs(nrows, fcb->null_row_ptr, null_fd, 0, 0);
 }
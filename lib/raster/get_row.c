@@ -11,18 +11,129 @@
    \author Original author CERL
  */
 
+#include <grass/config.h>
+
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <errno.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
-#include <grass/config.h>
 #include <grass/raster.h>
 #include <grass/glocale.h>
 
 #include "R.h"
 
-static void embed_nulls(int, void *, int, RASTER_MAP_TYPE, int, int);
+static void embed_nulls(struct R_read_ctx *, void *, int, RASTER_MAP_TYPE,
+			int, int);
+static int mask_row_state(struct R_read_ctx *, int);
+
+#ifdef HAVE_PTHREAD_H
+/* serializes the readers which are not reentrant (GDAL, VRT) */
+static pthread_mutex_t serial_mutex;
+static pthread_once_t serial_once = PTHREAD_ONCE_INIT;
+
+static void make_serial_mutex(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&serial_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+#endif
+
+static void lock_serial(void)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_once(&serial_once, make_serial_mutex);
+    pthread_mutex_lock(&serial_mutex);
+#endif
+}
+
+static void unlock_serial(void)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&serial_mutex);
+#endif
+}
+
+/* read exactly size bytes at offset without moving the file pointer */
+static int read_at(int fd, void *buf, size_t size, off_t offset)
+{
+    unsigned char *p = buf;
+    double t = G_trace_begin();
+
+    G_trace_count("raster bytes read", size);
+
+#ifdef __MINGW32__
+    if (lseek(fd, offset, SEEK_SET) < 0)
+	return -1;
+#endif
+
+    while (size > 0) {
+#ifdef __MINGW32__
+	ssize_t n = read(fd, p, size);
+#else
+	ssize_t n = pread(fd, p, size, offset);
+#endif
+
+	if (n < 0 && errno == EINTR)
+	    continue;
+	if (n <= 0) {
+	    G_trace_end("io", "read", t);
+	    return -1;
+	}
+
+	p += n;
+	size -= n;
+	offset += n;
+    }
+
+    G_trace_end("io", "read", t);
+
+    return 0;
+}
+
+static unsigned char *get_cmp_buf(struct R_read_ctx *ctx, size_t size)
+{
+    if (size > ctx->cmp_size) {
+	ctx->cmp = G_realloc(ctx->cmp, size);
+	ctx->cmp_size = size;
+    }
+
+    return ctx->cmp;
+}
+
+/* returns size bytes of file fd at offset: from the band if there is
+   one and it holds them (see Rast_get_rows()), otherwise read into buf,
+   or into the compressed data buffer of the reader if buf is NULL */
+static const unsigned char *read_record(struct R_read_ctx *ctx,
+					const struct R_band *band, int fd,
+					unsigned char *buf, size_t size,
+					off_t offset)
+{
+    if (band && offset >= band->start &&
+	offset + (off_t) size <= band->end) {
+	G_trace_count("raster cache hits", 1);
+	return band->buf + (offset - band->start);
+    }
+
+    if (!buf)
+	buf = get_cmp_buf(ctx, size);
+
+    if (read_at(fd, buf, size, offset) < 0)
+	return NULL;
+
+    return buf;
+}
 
 static int compute_window_row(int fd, int row, int *cellRow)
 {
@@ -81,24 +192,42 @@ static void do_reclass_int(int fd, void *cell, int null_is_zero)
     }
 }
 
-static void read_data_fp_compressed(int fd, int row, unsigned char *data_buf,
+/* reads record row of the offset table (a row, or a tile of a tiled
+   map) holding ncells cells */
+static void read_data_fp_compressed(struct R_read_ctx *ctx, int row,
+				    int ncells, unsigned char *data_buf,
 				    int *nbytes)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     off_t t1 = fcb->row_ptr[row];
     off_t t2 = fcb->row_ptr[row + 1];
     size_t readamount = t2 - t1;
-    size_t bufsize = fcb->cellhd.cols * fcb->nbytes;
+    size_t bufsize = (size_t) ncells * fcb->nbytes;
+    const unsigned char *cmp;
     int ret;
 
-    if (lseek(fcb->data_fd, t1, SEEK_SET) < 0)
-	G_fatal_error(_("Error seeking fp raster data file for row %d of <%s>: %s"),
+    *nbytes = fcb->nbytes;
+
+    if (t2 <= t1)
+	G_fatal_error(_("Error uncompressing fp raster data for row %d of <%s>: error code %d"),
+		      row, fcb->name, -1);
+
+    cmp = read_record(ctx, &ctx->band, fcb->data_fd, NULL, readamount, t1);
+    if (!cmp)
+	G_fatal_error(_("Error reading fp raster data for row %d of <%s>: %s"),
 		      row, fcb->name, strerror(errno));
 
-    *nbytes = fcb->nbytes;
+    /* first byte is the compression flag, see lib/gis/compress.c */
+    if (cmp[0] == '0') {
+	ret = readamount - 1 < bufsize ? readamount - 1 : bufsize;
+	memcpy(data_buf, cmp + 1, ret);
+    }
+    else if (cmp[0] == '1')
+	ret = G_expand((unsigned char *)cmp + 1, readamount - 1, data_buf,
+		       bufsize, fcb->cellhd.compressed);
+    else
+	ret = -1;
 
-    ret = G_read_compressed(fcb->data_fd, readamount, data_buf,
-			    bufsize, fcb->cellhd.compressed);
     if (ret <= 0)
 	G_fatal_error(_("Error uncompressing fp raster data for row %d of <%s>: error code %d"),
 		      row, fcb->name, ret);
@@ -123,31 +252,22 @@ static void rle_decompress(unsigned char *dst, const unsigned char *src,
     }
 }
 
-static void read_data_compressed(int fd, int row, unsigned char *data_buf,
+static void read_data_compressed(struct R_read_ctx *ctx, int row,
+				 int ncells, unsigned char *data_buf,
 				 int *nbytes)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     off_t t1 = fcb->row_ptr[row];
     off_t t2 = fcb->row_ptr[row + 1];
     ssize_t readamount = t2 - t1;
     size_t bufsize;
-    unsigned char *cmp, *cmp2;
+    const unsigned char *cmp;
     int n;
 
-    if (lseek(fcb->data_fd, t1, SEEK_SET) < 0)
-	G_fatal_error(_("Error seeking raster data file for row %d of <%s>: %s"),
-		      row, fcb->name, strerror(errno));
-
-    cmp = G_malloc(readamount);
-
-    if (read(fcb->data_fd, cmp, readamount) != readamount) {
-	G_free(cmp);
+    cmp = read_record(ctx, &ctx->band, fcb->data_fd, NULL, readamount, t1);
+    if (!cmp)
 	G_fatal_error(_("Error reading raster data for row %d of <%s>: %s"),
 		      row, fcb->name, strerror(errno));
-    }
-
-    /* save cmp for free below */
-    cmp2 = cmp;
 
     /* Now decompress the row */
     if (fcb->cellhd.compressed > 0) {
@@ -159,12 +279,17 @@ static void read_data_compressed(int fd, int row, unsigned char *data_buf,
 	/* pre 3.0 compression */
 	n = *nbytes = fcb->nbytes;
 
-    bufsize = n * fcb->cellhd.cols;
+    /* tiles are decoded into buffers of fcb->nbytes per cell */
+    if (fcb->tile_rows > 0 && (n < 1 || n > fcb->nbytes))
+	G_fatal_error(_("Error uncompressing raster data for tile %d of <%s>"),
+		      row, fcb->name);
+
+    bufsize = (size_t) n * ncells;
     if (fcb->cellhd.compressed < 0 || readamount < bufsize) {
 	if (fcb->cellhd.compressed == 1)
 	    rle_decompress(data_buf, cmp, n, readamount);
 	else {
-	    if (G_expand(cmp, readamount, data_buf, bufsize,
+	    if (G_expand((unsigned char *)cmp, readamount, data_buf, bufsize,
 		     fcb->cellhd.compressed) != bufsize)
 	    G_fatal_error(_("Error uncompressing raster data for row %d of <%s>"),
 			  row, fcb->name);
@@ -172,32 +297,38 @@ static void read_data_compressed(int fd, int row, unsigned char *data_buf,
     }
     else
 	memcpy(data_buf, cmp, readamount);
-
-    G_free(cmp2);
 }
 
-static void read_data_uncompressed(int fd, int row, unsigned char *data_buf,
-				   int *nbytes)
+static const unsigned char *read_data_uncompressed(struct R_read_ctx *ctx,
+						   int row,
+						   unsigned char *data_buf,
+						   int *nbytes)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     ssize_t bufsize = fcb->cellhd.cols * fcb->nbytes;
+    const unsigned char *data;
 
     *nbytes = fcb->nbytes;
 
-    if (lseek(fcb->data_fd, (off_t) row * bufsize, SEEK_SET) == -1)
-	G_fatal_error(_("Error reading raster data for row %d of <%s>"),
-		      row, fcb->name);
+    /* mapped file: the row is used in place */
+    if (fcb->map_data)
+	return fcb->map_data + (size_t) row * bufsize;
 
-    if (read(fcb->data_fd, data_buf, bufsize) != bufsize)
+    /* as is the band of Rast_get_rows() */
+    data = read_record(ctx, &ctx->band, fcb->data_fd, data_buf, bufsize,
+		       (off_t) row * bufsize);
+    if (!data)
 	G_fatal_error(_("Error reading raster data for row %d of <%s>"),
 		      row, fcb->name);
+
+    return data;
 }
 
 #ifdef HAVE_GDAL
-static void read_data_gdal(int fd, int row, unsigned char *data_buf,
-			   int *nbytes)
+static void read_data_gdal(struct R_read_ctx *ctx, int row,
+			   unsigned char *data_buf, int *nbytes)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     unsigned char *buf;
     CPLErr err;
 
@@ -206,21 +337,24 @@ static void read_data_gdal(int fd, int row, unsigned char *data_buf,
     if (fcb->gdal->vflip)
 	row = fcb->cellhd.rows - 1 - row;
 
-    buf = fcb->gdal->hflip ? G_malloc(fcb->cellhd.cols * fcb->cur_nbytes)
+    buf = fcb->gdal->hflip ? G_malloc(fcb->cellhd.cols * fcb->nbytes)
 	: data_buf;
 
+    /* GDAL datasets must not be accessed from several threads at once */
+    lock_serial();
     err =
 	Rast_gdal_raster_IO(fcb->gdal->band, GF_Read, 0, row,
 			    fcb->cellhd.cols, 1, buf, fcb->cellhd.cols, 1,
 			    fcb->gdal->type, 0, 0);
+    unlock_serial();
 
     if (fcb->gdal->hflip) {
 	int i;
 
 	for (i = 0; i < fcb->cellhd.cols; i++)
-	    memcpy(data_buf + i * fcb->cur_nbytes,
-		   buf + (fcb->cellhd.cols - 1 - i) * fcb->cur_nbytes,
-		   fcb->cur_nbytes);
+	    memcpy(data_buf + i * fcb->nbytes,
+		   buf + (fcb->cellhd.cols - 1 - i) * fcb->nbytes,
+		   fcb->nbytes);
 	G_free(buf);
     }
 
@@ -230,23 +364,152 @@ static void read_data_gdal(int fd, int row, unsigned char *data_buf,
 }
 #endif
 
-static void read_data(int fd, int row, unsigned char *data_buf, int *nbytes)
+/* get tile tcol of tile row trow of a tiled map, decoding it unless it
+   is still cached; CELL tiles are widened to fcb->nbytes per cell */
+static const unsigned char *get_tile(struct R_read_ctx *ctx, int trow,
+				     int tcol)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
+    int ntcols = Rast__tile_cols(ctx->fd);
+    struct R_tile *tile;
+    int nrows, ncols, ncells, nbytes;
+
+    if (!ctx->tiles) {
+	int i;
+
+	ctx->tiles = G_calloc(ntcols, sizeof(struct R_tile));
+	ctx->ntiles = ntcols;
+	for (i = 0; i < ntcols; i++)
+	    ctx->tiles[i].row = -1;
+    }
+
+    tile = &ctx->tiles[tcol];
+    if (tile->row == trow)
+	return tile->data;
+
+    if (!tile->data)
+	tile->data = G_malloc((size_t) fcb->tile_rows * fcb->tile_cols *
+			      fcb->nbytes);
+    tile->row = -1;
+
+    /* tiles at the edges are truncated to the map */
+    nrows = fcb->cellhd.rows - trow * fcb->tile_rows;
+    if (nrows > fcb->tile_rows)
+	nrows = fcb->tile_rows;
+    ncols = fcb->cellhd.cols - tcol * fcb->tile_cols;
+    if (ncols > fcb->tile_cols)
+	ncols = fcb->tile_cols;
+    ncells = nrows * ncols;
+
+    if (fcb->map_type != CELL_TYPE)
+	read_data_fp_compressed(ctx, trow * ntcols + tcol, ncells,
+				tile->data, &nbytes);
+    else
+	read_data_compressed(ctx, trow * ntcols + tcol, ncells, tile->data,
+			     &nbytes);
+
+    if (nbytes < fcb->nbytes) {
+	int pad = fcb->nbytes - nbytes;
+	int i;
+
+	/* left pad with zero bytes, back to front to work in place */
+	for (i = ncells - 1; i >= 0; i--) {
+	    unsigned char *dst = tile->data + (size_t) i * fcb->nbytes;
+
+	    memmove(dst + pad, tile->data + (size_t) i * nbytes, nbytes);
+	    memset(dst, 0, pad);
+	}
+    }
+
+    tile->row = trow;
+
+    return tile->data;
+}
+
+/* assembles a row of a tiled map from its tiles; only the tiles holding
+   the window columns ctx->col0 .. ctx->col0 + ctx->ncols - 1 are read */
+static void read_data_tiled(struct R_read_ctx *ctx, int row,
+			    unsigned char *data_buf, int *nbytes)
+{
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
+    int trow = row / fcb->tile_rows;
+    int r = row - trow * fcb->tile_rows;
+    int col0 = ctx->col0;
+    int col1 = ctx->ncols > 0 ? col0 + ctx->ncols : R__.rd_window.cols;
+    int first = fcb->cellhd.cols, last = -1;
+    int tcol, i;
+
+    *nbytes = fcb->nbytes;
+
+    for (i = col0; i < col1; i++) {
+	int c = fcb->col_map[i] - 1;
+
+	if (c < 0)
+	    continue;
+	if (c < first)
+	    first = c;
+	if (c > last)
+	    last = c;
+    }
+
+    if (last < 0)
+	return;
+
+    for (tcol = first / fcb->tile_cols; tcol <= last / fcb->tile_cols; tcol++) {
+	const unsigned char *tile = get_tile(ctx, trow, tcol);
+	int col = tcol * fcb->tile_cols;
+	int ncols = fcb->cellhd.cols - col;
+
+	if (ncols > fcb->tile_cols)
+	    ncols = fcb->tile_cols;
+
+	memcpy(data_buf + (size_t) col * fcb->nbytes,
+	       tile + (size_t) r * ncols * fcb->nbytes,
+	       (size_t) ncols * fcb->nbytes);
+    }
+}
+
+/* returns the row data, either in data_buf or in the mapped file */
+static const unsigned char *read_data(struct R_read_ctx *ctx, int row,
+				      unsigned char *data_buf, int *nbytes)
+{
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
 
 #ifdef HAVE_GDAL
     if (fcb->gdal) {
-	read_data_gdal(fd, row, data_buf, nbytes);
-	return;
+	read_data_gdal(ctx, row, data_buf, nbytes);
+	return data_buf;
     }
 #endif
 
     if (!fcb->cellhd.compressed)
-	read_data_uncompressed(fd, row, data_buf, nbytes);
+	return read_data_uncompressed(ctx, row, data_buf, nbytes);
+
+    if (fcb->tile_rows > 0)
+	read_data_tiled(ctx, row, data_buf, nbytes);
     else if (fcb->map_type == CELL_TYPE)
-	read_data_compressed(fd, row, data_buf, nbytes);
+	read_data_compressed(ctx, row, fcb->cellhd.cols, data_buf, nbytes);
     else
-	read_data_fp_compressed(fd, row, data_buf, nbytes);
+	read_data_fp_compressed(ctx, row, fcb->cellhd.cols, data_buf, nbytes);
+
+    return data_buf;
+}
+
+/* if the window columns map one to one to the data columns, zeroes the
+   cells outside the map and returns 1: the run of cells inside is
+   converted at once */
+static int run_values(int fd, void *cell, size_t size, int n)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    int end = fcb->run_col + fcb->run_cols;
+
+    if (fcb->run_cols <= 0 || n != R__.rd_window.cols)
+	return 0;
+
+    memset(cell, 0, fcb->run_col * size);
+    memset((char *)cell + end * size, 0, (n - end) * size);
+
+    return 1;
 }
 
 /* copy cell file data to user buffer translated by window column mapping */
@@ -254,11 +517,19 @@ static void cell_values_int(int fd, const unsigned char *data,
 			    const COLUMN_MAPPING * cmap, int nbytes,
 			    void *cell, int n)
 {
+    struct fileinfo *fcb = &R__.fileinfo[fd];
     CELL *c = cell;
     COLUMN_MAPPING cmapold = 0;
     int big = (size_t) nbytes >= sizeof(CELL);
     int i;
 
+    if (nbytes <= (int)sizeof(CELL) && run_values(fd, cell, sizeof(CELL), n)) {
+	i = fcb->run_col;
+	Rast__decode_c_row(c + i, data + (cmap[i] - 1) * nbytes, nbytes,
+			   fcb->run_cols);
+	return;
+    }
+
     for (i = 0; i < n; i++) {
 	const unsigned char *d;
 	int neg;
@@ -299,11 +570,17 @@ static void cell_values_float(int fd, const unsigned char *data,
 			      const COLUMN_MAPPING * cmap, int nbytes,
 			      void *cell, int n)
 {
+    const float *work_buf = (const float *) data;
     struct fileinfo *fcb = &R__.fileinfo[fd];
-    const float *work_buf = (const float *) fcb->data;
     FCELL *c = cell;
     int i;
 
+    if (run_values(fd, cell, sizeof(FCELL), n)) {
+	i = fcb->run_col;
+	Rast__xdr_get_f_row(c + i, &work_buf[cmap[i] - 1], fcb->run_cols);
+	return;
+    }
+
     for (i = 0; i < n; i++) {
 	if (!cmap[i]) {
 	    c[i] = 0;
@@ -318,11 +595,17 @@ static void cell_values_double(int fd, const unsigned char *data,
 			       const COLUMN_MAPPING * cmap, int nbytes,
 			       void *cell, int n)
 {
+    const double *work_buf = (const double *) data;
     struct fileinfo *fcb = &R__.fileinfo[fd];
-    const double *work_buf = (const double *) fcb->data;
     DCELL *c = cell;
     int i;
 
+    if (run_values(fd, cell, sizeof(DCELL), n)) {
+	i = fcb->run_col;
+	Rast__xdr_get_d_row(c + i, &work_buf[cmap[i] - 1], fcb->run_cols);
+	return;
+    }
+
     for (i = 0; i < n; i++) {
 	if (!cmap[i]) {
 	    c[i] = 0;
@@ -431,7 +714,7 @@ static void gdal_values_double(int fd, const double *data,
 }
 #endif
 
-/* transfer_to_cell_XY takes bytes from fcb->data, converts these bytes with
+/* transfer_to_cell_XY takes bytes from ctx->row, converts these bytes with
    the appropriate procedure (e.g. XDR or byte reordering) into type X 
    values which are put into array work_buf.  
    finally the values in work_buf are converted into 
@@ -440,7 +723,7 @@ static void gdal_values_double(int fd, const double *data,
    work_buf might be omitted. check the appropriate function for XY to
    determine the procedure of conversion. 
  */
-static void transfer_to_cell_XX(int fd, void *cell)
+static void transfer_to_cell_XX(struct R_read_ctx *ctx, void *cell)
 {
     static void (*cell_values_type[3]) () = {
     cell_values_int, cell_values_float, cell_values_double};
@@ -448,27 +731,28 @@ static void transfer_to_cell_XX(int fd, void *cell)
     static void (*gdal_values_type[3]) () = {
     gdal_values_int, gdal_values_float, gdal_values_double};
 #endif
+    int fd = ctx->fd;
     struct fileinfo *fcb = &R__.fileinfo[fd];
 
 #ifdef HAVE_GDAL
     if (fcb->gdal)
-	(gdal_values_type[fcb->map_type]) (fd, fcb->data, fcb->col_map,
-					   fcb->cur_nbytes, cell,
+	(gdal_values_type[fcb->map_type]) (fd, ctx->row, fcb->col_map,
+					   ctx->cur_nbytes, cell,
 					   R__.rd_window.cols);
     else
 #endif
-	(cell_values_type[fcb->map_type]) (fd, fcb->data, fcb->col_map,
-					   fcb->cur_nbytes, cell,
+	(cell_values_type[fcb->map_type]) (fd, ctx->row, fcb->col_map,
+					   ctx->cur_nbytes, cell,
 					   R__.rd_window.cols);
 }
 
-static void transfer_to_cell_fi(int fd, void *cell)
+static void transfer_to_cell_fi(struct R_read_ctx *ctx, void *cell)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     FCELL *work_buf = G_malloc(R__.rd_window.cols * sizeof(FCELL));
     int i;
 
-    transfer_to_cell_XX(fd, work_buf);
+    transfer_to_cell_XX(ctx, work_buf);
 
     for (i = 0; i < R__.rd_window.cols; i++)
 	((CELL *) cell)[i] = (fcb->col_map[i] == 0)
@@ -477,13 +761,13 @@ static void transfer_to_cell_fi(int fd, void *cell)
     G_free(work_buf);
 }
 
-static void transfer_to_cell_di(int fd, void *cell)
+static void transfer_to_cell_di(struct R_read_ctx *ctx, void *cell)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     DCELL *work_buf = G_malloc(R__.rd_window.cols * sizeof(DCELL));
     int i;
 
-    transfer_to_cell_XX(fd, work_buf);
+    transfer_to_cell_XX(ctx, work_buf);
 
     for (i = 0; i < R__.rd_window.cols; i++)
 	((CELL *) cell)[i] = (fcb->col_map[i] == 0)
@@ -492,54 +776,46 @@ static void transfer_to_cell_di(int fd, void *cell)
     G_free(work_buf);
 }
 
-static void transfer_to_cell_if(int fd, void *cell)
+static void transfer_to_cell_if(struct R_read_ctx *ctx, void *cell)
 {
     CELL *work_buf = G_malloc(R__.rd_window.cols * sizeof(CELL));
-    int i;
 
-    transfer_to_cell_XX(fd, work_buf);
+    transfer_to_cell_XX(ctx, work_buf);
 
-    for (i = 0; i < R__.rd_window.cols; i++)
-	((FCELL *) cell)[i] = work_buf[i];
+    Rast__convert_row(cell, FCELL_TYPE, work_buf, CELL_TYPE, R__.rd_window.cols);
 
     G_free(work_buf);
 }
 
-static void transfer_to_cell_df(int fd, void *cell)
+static void transfer_to_cell_df(struct R_read_ctx *ctx, void *cell)
 {
     DCELL *work_buf = G_malloc(R__.rd_window.cols * sizeof(DCELL));
-    int i;
 
-    transfer_to_cell_XX(fd, work_buf);
+    transfer_to_cell_XX(ctx, work_buf);
 
-    for (i = 0; i < R__.rd_window.cols; i++)
-	((FCELL *) cell)[i] = work_buf[i];
+    Rast__convert_row(cell, FCELL_TYPE, work_buf, DCELL_TYPE, R__.rd_window.cols);
 
     G_free(work_buf);
 }
 
-static void transfer_to_cell_id(int fd, void *cell)
+static void transfer_to_cell_id(struct R_read_ctx *ctx, void *cell)
 {
     CELL *work_buf = G_malloc(R__.rd_window.cols * sizeof(CELL));
-    int i;
 
-    transfer_to_cell_XX(fd, work_buf);
+    transfer_to_cell_XX(ctx, work_buf);
 
-    for (i = 0; i < R__.rd_window.cols; i++)
-	((DCELL *) cell)[i] = work_buf[i];
+    Rast__convert_row(cell, DCELL_TYPE, work_buf, CELL_TYPE, R__.rd_window.cols);
 
     G_free(work_buf);
 }
 
-static void transfer_to_cell_fd(int fd, void *cell)
+static void transfer_to_cell_fd(struct R_read_ctx *ctx, void *cell)
 {
     FCELL *work_buf = G_malloc(R__.rd_window.cols * sizeof(FCELL));
-    int i;
 
-    transfer_to_cell_XX(fd, work_buf);
+    transfer_to_cell_XX(ctx, work_buf);
 
-    for (i = 0; i < R__.rd_window.cols; i++)
-	((DCELL *) cell)[i] = work_buf[i];
+    Rast__convert_row(cell, DCELL_TYPE, work_buf, FCELL_TYPE, R__.rd_window.cols);
 
     G_free(work_buf);
 }
@@ -548,7 +824,7 @@ static void transfer_to_cell_fd(int fd, void *cell)
  *   works for all map types and doesn't consider
  *   null row corresponding to the requested row 
  */
-static int get_map_row_nomask(int fd, void *rast, int row,
+static int get_map_row_nomask(struct R_read_ctx *ctx, void *rast, int row,
 			      RASTER_MAP_TYPE data_type)
 {
     static void (*transfer_to_cell_FtypeOtype[3][3]) () = {
@@ -557,45 +833,60 @@ static int get_map_row_nomask(int fd, void *rast, int row,
 	transfer_to_cell_fi, transfer_to_cell_XX, transfer_to_cell_fd}, {
 	transfer_to_cell_di, transfer_to_cell_df, transfer_to_cell_XX}
     };
+    int fd = ctx->fd;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     int r;
     int row_status;
 
     /* is this the best place to read a vrt row, or
      * call Rast_get_vrt_row() earlier ? */
-    if (fcb->vrt)
-	return Rast_get_vrt_row(fd, rast, row, data_type);
+    if (fcb->vrt) {
+	int ret;
+
+	/* reading a vrt opens and closes its tiles */
+	lock_serial();
+	ret = Rast_get_vrt_row(fd, rast, row, data_type);
+	unlock_serial();
+
+	return ret;
+    }
 
     row_status = compute_window_row(fd, row, &r);
 
     if (!row_status) {
-	fcb->cur_row = -1;
+	ctx->cur_row = -1;
 	Rast_zero_input_buf(rast, data_type);
 	return 0;
     }
 
     /* read cell file row if not in memory */
-    if (r != fcb->cur_row) {
-	fcb->cur_row = r;
-	read_data(fd, fcb->cur_row, fcb->data, &fcb->cur_nbytes);
+    if (r != ctx->cur_row) {
+	double t = G_trace_begin();
+
+	ctx->cur_row = r;
+	ctx->row = read_data(ctx, ctx->cur_row, ctx->data, &ctx->cur_nbytes);
+	G_trace_end("raster", "decode row", t);
+	G_trace_count("raster rows decoded", 1);
     }
 
-    (transfer_to_cell_FtypeOtype[fcb->map_type][data_type]) (fd, rast);
+    (transfer_to_cell_FtypeOtype[fcb->map_type][data_type]) (ctx, rast);
 
     return 1;
 }
 
-static void get_map_row_no_reclass(int fd, void *rast, int row,
-				   RASTER_MAP_TYPE data_type, int null_is_zero,
-				   int with_mask)
+static void get_map_row_no_reclass(struct R_read_ctx *ctx, void *rast,
+				   int row, RASTER_MAP_TYPE data_type,
+				   int null_is_zero, int with_mask)
 {
-    get_map_row_nomask(fd, rast, row, data_type);
-    embed_nulls(fd, rast, row, data_type, null_is_zero, with_mask);
+    get_map_row_nomask(ctx, rast, row, data_type);
+    embed_nulls(ctx, rast, row, data_type, null_is_zero, with_mask);
 }
 
-static void get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
-			int null_is_zero, int with_mask)
+static void get_map_row(struct R_read_ctx *ctx, void *rast, int row,
+			RASTER_MAP_TYPE data_type, int null_is_zero,
+			int with_mask)
 {
+    int fd = ctx->fd;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     int size = Rast_cell_size(data_type);
     CELL *temp_buf = NULL;
@@ -603,6 +894,30 @@ static void get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
     int type;
     int i;
 
+    /* rows decoded in the background, see read_ahead.c */
+    if (fcb->read_ahead && ctx == &fcb->rd && !null_is_zero &&
+	Rast__read_ahead_get(fd, rast, row, data_type, with_mask)) {
+	G_trace_count("raster cache hits", 1);
+	return;
+    }
+
+    /* rows masked out completely are not read at all, for rows not
+       masked at all the MASK is not applied */
+    if (with_mask && R__.auto_mask > 0 && fd != R__.mask_fd &&
+	row >= 0 && row < R__.rd_window.rows) {
+	switch (mask_row_state(ctx, row)) {
+	case MASK_ROW_ALL:
+	    if (null_is_zero)
+		Rast_zero_input_buf(rast, data_type);
+	    else
+		Rast_set_null_value(rast, R__.rd_window.cols, data_type);
+	    return;
+	case MASK_ROW_NONE:
+	    with_mask = 0;
+	    break;
+	}
+    }
+
     if (fcb->reclass_flag && data_type != CELL_TYPE) {
 	temp_buf = G_malloc(R__.rd_window.cols * sizeof(CELL));
 	buf = temp_buf;
@@ -613,7 +928,7 @@ static void get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
 	type = data_type;
     }
 
-    get_map_row_no_reclass(fd, buf, row, type, null_is_zero, with_mask);
+    get_map_row_no_reclass(ctx, buf, row, type, null_is_zero, with_mask);
 
     if (!fcb->reclass_flag)
 	return;
@@ -665,7 +980,7 @@ static void get_map_row(int fd, void *rast, int row, RASTER_MAP_TYPE data_type,
  */
 void Rast_get_row_nomask(int fd, void *buf, int row, RASTER_MAP_TYPE data_type)
 {
-    get_map_row(fd, buf, row, data_type, 0, 0);
+    get_map_row(&R__.fileinfo[fd].rd, buf, row, data_type, 0, 0);
 }
 
 /*!
@@ -758,7 +1073,10 @@ void Rast_get_d_row_nomask(int fd, DCELL * buf, int row)
  */
 void Rast_get_row(int fd, void *buf, int row, RASTER_MAP_TYPE data_type)
 {
-    get_map_row(fd, buf, row, data_type, 0, 1);
+    double t = G_trace_begin();
+
+    get_map_row(&R__.fileinfo[fd].rd, buf, row, data_type, 0, 1);
+    G_trace_end("raster", "Rast_get_row", t);
 }
 
 /*!
@@ -822,56 +1140,57 @@ void Rast_get_d_row(int fd, DCELL * buf, int row)
     Rast_get_row(fd, buf, row, DCELL_TYPE);
 }
 
-static int read_null_bits_compressed(int null_fd, unsigned char *flags,
-				     int row, size_t size, int fd)
+static int read_null_bits_compressed(struct R_read_ctx *ctx, int null_fd,
+				     unsigned char *flags, int row,
+				     size_t size)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     off_t t1 = fcb->null_row_ptr[row];
     off_t t2 = fcb->null_row_ptr[row + 1];
     size_t readamount = t2 - t1;
-    unsigned char *compressed_buf;
-
-    if (lseek(null_fd, t1, SEEK_SET) < 0)
-	G_fatal_error(_("Error seeking compressed null data for row %d of <%s>"),
-		      row, fcb->name);
+    const unsigned char *compressed_buf;
 
     if (readamount == size) {
-	if (read(null_fd, flags, size) != size) {
+	const unsigned char *bits =
+	    read_record(ctx, NULL, null_fd, flags, size, t1);
+
+	if (!bits) {
 	    G_fatal_error(_("Error reading compressed null data for row %d of <%s>"),
 			  row, fcb->name);
 	}
+	if (bits != flags)
+	    memcpy(flags, bits, size);
 	return 1;
     }
 
-    compressed_buf = G_malloc(readamount);
-
-    if (read(null_fd, compressed_buf, readamount) != readamount) {
-	G_free(compressed_buf);
+    compressed_buf =
+	read_record(ctx, NULL, null_fd, NULL, readamount, t1);
+    if (!compressed_buf)
 	G_fatal_error(_("Error reading compressed null data for row %d of <%s>"),
 		      row, fcb->name);
-    }
 
     /* null bits file compressed with LZ4, see lib/gis/compress.h */
-    if (G_lz4_expand(compressed_buf, readamount, flags, size) < 1) {
+    if (G_lz4_expand((unsigned char *)compressed_buf, readamount, flags,
+		     size) < 1) {
 	G_fatal_error(_("Error uncompressing null data for row %d of <%s>"),
 		      row, fcb->name);
     }
 
-    G_free(compressed_buf);
-
     return 1;
 }
 
-int Rast__read_null_bits(int fd, int row, unsigned char *flags)
+static int read_null_bits(struct R_read_ctx *ctx, int row,
+			  unsigned char *flags)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     int null_fd = fcb->null_fd;
     int cols = fcb->cellhd.cols;
     off_t offset;
     ssize_t size;
+    const unsigned char *bits;
     int R;
 
-    if (compute_window_row(fd, row, &R) <= 0) {
+    if (compute_window_row(ctx->fd, row, &R) <= 0) {
 	Rast__init_null_bits(flags, cols);
 	return 1;
     }
@@ -881,25 +1200,39 @@ int Rast__read_null_bits(int fd, int row, unsigned char *flags)
 
     size = Rast__null_bitstream_size(cols);
 
+    /* decoded by Rast_get_rows() */
+    if (R >= ctx->null_band.row &&
+	R < ctx->null_band.row + ctx->null_band.nrows) {
+	memcpy(flags, ctx->null_band.bits +
+	       (size_t) (R - ctx->null_band.row) * size, size);
+	return 1;
+    }
+
     if (fcb->null_row_ptr)
-	return read_null_bits_compressed(null_fd, flags, R, size, fd);
+	return read_null_bits_compressed(ctx, null_fd, flags, R, size);
 
     offset = (off_t) size * R;
 
-    if (lseek(null_fd, offset, SEEK_SET) < 0)
-	G_fatal_error(_("Error seeking null row %d for <%s>"), R, fcb->name);
-
-    if (read(null_fd, flags, size) != size)
+    bits = read_record(ctx, NULL, null_fd, flags, size, offset);
+    if (!bits)
 	G_fatal_error(_("Error reading null row %d for <%s>"), R, fcb->name);
+    if (bits != flags)
+	memcpy(flags, bits, size);
 
     return 1;
 }
 
+int Rast__read_null_bits(int fd, int row, unsigned char *flags)
+{
+    return read_null_bits(&R__.fileinfo[fd].rd, row, flags);
+}
+
 #define check_null_bit(flags, bit_num) ((flags)[(bit_num)>>3] & ((unsigned char)0x80>>((bit_num)&7)) ? 1 : 0)
 
-static void get_null_value_row_nomask(int fd, char *flags, int row)
+static void get_null_value_row_nomask(struct R_read_ctx *ctx, char *flags,
+				      int row)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     int j;
 
     if (row > R__.rd_window.rows || row < 0) {
@@ -916,14 +1249,14 @@ static void get_null_value_row_nomask(int fd, char *flags, int row)
 	return;
     }
 
-    if (row != fcb->null_cur_row) {
-	if (!Rast__read_null_bits(fd, row, fcb->null_bits)) {
-	    fcb->null_cur_row = -1;
+    if (row != ctx->null_cur_row) {
+	if (!read_null_bits(ctx, row, ctx->null_bits)) {
+	    ctx->null_cur_row = -1;
 	    if (fcb->map_type == CELL_TYPE) {
 		/* If can't read null row, assume  that all map 0's are nulls */
 		CELL *mask_buf = G_malloc(R__.rd_window.cols * sizeof(CELL));
 
-		get_map_row_nomask(fd, mask_buf, row, CELL_TYPE);
+		get_map_row_nomask(ctx, mask_buf, row, CELL_TYPE);
 		for (j = 0; j < R__.rd_window.cols; j++)
 		    flags[j] = (mask_buf[j] == 0);
 
@@ -938,15 +1271,25 @@ static void get_null_value_row_nomask(int fd, char *flags, int row)
 	    return;
 	}			/*if no null file */
 	else
-	    fcb->null_cur_row = row;
+	    ctx->null_cur_row = row;
     }
 
     /* copy null row to flags row translated by window column mapping */
+    if (fcb->run_cols > 0) {
+	int end = fcb->run_col + fcb->run_cols;
+
+	memset(flags, 1, fcb->run_col);
+	Rast__unpack_null_bits(flags + fcb->run_col, ctx->null_bits,
+			       fcb->col_map[fcb->run_col] - 1, fcb->run_cols);
+	memset(flags + end, 1, R__.rd_window.cols - end);
+	return;
+    }
+
     for (j = 0; j < R__.rd_window.cols; j++) {
 	if (!fcb->col_map[j])
 	    flags[j] = 1;
 	else
-	    flags[j] = check_null_bit(fcb->null_bits, fcb->col_map[j] - 1);
+	    flags[j] = check_null_bit(ctx->null_bits, fcb->col_map[j] - 1);
     }
 }
 
@@ -954,13 +1297,14 @@ static void get_null_value_row_nomask(int fd, char *flags, int row)
 
 #ifdef HAVE_GDAL
 
-static void get_null_value_row_gdal(int fd, char *flags, int row)
+static void get_null_value_row_gdal(struct R_read_ctx *ctx, char *flags,
+				    int row)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     DCELL *tmp_buf = Rast_allocate_d_input_buf();
     int i;
 
-    if (get_map_row_nomask(fd, tmp_buf, row, DCELL_TYPE) <= 0) {
+    if (get_map_row_nomask(ctx, tmp_buf, row, DCELL_TYPE) <= 0) {
 	memset(flags, 1, R__.rd_window.cols);
 	G_free(tmp_buf);
 	return;
@@ -981,55 +1325,230 @@ static void get_null_value_row_gdal(int fd, char *flags, int row)
 
 /*--------------------------------------------------------------------------*/
 
-static void embed_mask(char *flags, int row)
+/* the MASK is decoded once per window row for all maps: the rows are
+   kept in a few slots shared by all readers (and threads), the least
+   recently used one being replaced. Each reader decodes MASK rows with
+   its own MASK reader and keeps a copy of the last row it used, so the
+   lock is only held to look up or to fill a slot. */
+#define MASK_ROWS 16
+
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t mask_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lock_mask(void)
 {
-    CELL *mask_buf = G_malloc(R__.rd_window.cols * sizeof(CELL));
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&mask_mutex);
+#endif
+}
+
+static void unlock_mask(void)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&mask_mutex);
+#endif
+}
+
+static struct R_mask_row *alloc_mask_rows(int n)
+{
+    struct R_mask_row *m = G_malloc(n * sizeof(struct R_mask_row));
     int i;
 
-    if (R__.auto_mask <= 0) {
-	G_free(mask_buf);
-	return;
+    for (i = 0; i < n; i++) {
+	m[i].row = -1;
+	m[i].used = 0;
+	m[i].flags = G_malloc(R__.rd_window.cols);
     }
 
-    if (get_map_row_nomask(R__.mask_fd, mask_buf, row, CELL_TYPE) < 0) {
+    return m;
+}
+
+static void free_mask_rows(struct R_mask_row *m, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+	G_free(m[i].flags);
+    G_free(m);
+}
+
+static void copy_mask_row(struct R_mask_row *dst,
+			  const struct R_mask_row *src)
+{
+    dst->row = src->row;
+    dst->state = src->state;
+    if (src->state == MASK_ROW_MIXED)
+	memcpy(dst->flags, src->flags, R__.rd_window.cols);
+}
+
+/* returns the MASK reader of ctx, dropping the one of an earlier MASK
+   or region */
+static struct R_read_ctx *get_mask_reader(struct R_read_ctx *ctx)
+{
+    if (ctx->mask_serial != R__.mask_serial) {
+	if (ctx->mask) {
+	    Rast__free_read_ctx(ctx->mask);
+	    G_free(ctx->mask);
+	    ctx->mask = NULL;
+	}
+	if (ctx->mask_row) {
+	    free_mask_rows(ctx->mask_row, 1);
+	    ctx->mask_row = NULL;
+	}
+	ctx->mask_serial = R__.mask_serial;
+    }
+
+    if (!ctx->mask) {
+	ctx->mask = G_malloc(sizeof(struct R_read_ctx));
+	Rast__init_read_ctx(ctx->mask, R__.mask_fd);
+	ctx->mask_row = alloc_mask_rows(1);
+    }
+
+    return ctx->mask;
+}
+
+static void decode_mask_row(struct R_read_ctx *mctx, struct R_mask_row *m,
+			    int row)
+{
+    CELL *mask_buf = G_malloc(R__.rd_window.cols * sizeof(CELL));
+    int i, masked = 0;
+
+    m->row = row;
+
+    if (get_map_row_nomask(mctx, mask_buf, row, CELL_TYPE) < 0) {
+	m->state = MASK_ROW_NONE;
 	G_free(mask_buf);
 	return;
     }
 
     if (R__.fileinfo[R__.mask_fd].reclass_flag) {
-	embed_nulls(R__.mask_fd, mask_buf, row, CELL_TYPE, 0, 0);
+	embed_nulls(mctx, mask_buf, row, CELL_TYPE, 0, 0);
 	do_reclass_int(R__.mask_fd, mask_buf, 1);
     }
 
-    for (i = 0; i < R__.rd_window.cols; i++)
-	if (mask_buf[i] == 0 || Rast_is_c_null_value(&mask_buf[i]))
-	    flags[i] = 1;
+    for (i = 0; i < R__.rd_window.cols; i++) {
+	m->flags[i] = mask_buf[i] == 0 || Rast_is_c_null_value(&mask_buf[i]);
+	masked += m->flags[i];
+    }
+
+    m->state = masked == 0 ? MASK_ROW_NONE :
+	masked == R__.rd_window.cols ? MASK_ROW_ALL : MASK_ROW_MIXED;
 
     G_free(mask_buf);
 }
 
-static void get_null_value_row(int fd, char *flags, int row, int with_mask)
+/* returns MASK row row, from the copy of ctx, from a shared slot or
+   decoded by the MASK reader of ctx */
+static const struct R_mask_row *get_mask_row(struct R_read_ctx *ctx,
+					     int row)
+{
+    static unsigned int mask_clock;
+    struct R_read_ctx *mctx = get_mask_reader(ctx);
+    struct R_mask_row *m = ctx->mask_row, *slot;
+    int i;
+
+    if (m->row == row) {
+	G_trace_count("raster cache hits", 1);
+	return m;
+    }
+
+    lock_mask();
+
+    if (!R__.mask_rows)
+	R__.mask_rows = alloc_mask_rows(MASK_ROWS);
+
+    for (i = 0; i < MASK_ROWS; i++) {
+	slot = &R__.mask_rows[i];
+	if (slot->row == row) {
+	    slot->used = ++mask_clock;
+	    copy_mask_row(m, slot);
+	    unlock_mask();
+	    G_trace_count("raster cache hits", 1);
+	    return m;
+	}
+    }
+
+    unlock_mask();
+
+    decode_mask_row(mctx, m, row);
+
+    lock_mask();
+
+    slot = &R__.mask_rows[0];
+    for (i = 1; i < MASK_ROWS; i++)
+	if (R__.mask_rows[i].used < slot->used)
+	    slot = &R__.mask_rows[i];
+    slot->used = ++mask_clock;
+    copy_mask_row(slot, m);
+
+    unlock_mask();
+
+    return m;
+}
+
+/* tells whether window row row is masked out completely, not at all, or
+   in part */
+static int mask_row_state(struct R_read_ctx *ctx, int row)
+{
+    return get_mask_row(ctx, row)->state;
+}
+
+static void embed_mask(struct R_read_ctx *ctx, char *flags, int row)
+{
+    const struct R_mask_row *m;
+    int i;
+
+    if (R__.auto_mask <= 0 || ctx->fd == R__.mask_fd)
+	return;
+
+    m = get_mask_row(ctx, row);
+    if (m->state == MASK_ROW_ALL)
+	memset(flags, 1, R__.rd_window.cols);
+    else if (m->state == MASK_ROW_MIXED)
+	for (i = 0; i < R__.rd_window.cols; i++)
+	    flags[i] |= m->flags[i];
+}
+
+/*!
+   \brief Discard the decoded MASK rows
+
+   Must be called whenever the MASK or the region changes. The MASK
+   readers of the maps are dropped the next time they are used.
+ */
+void Rast__drop_mask_rows(void)
+{
+    lock_mask();
+    R__.mask_serial++;
+    if (R__.mask_rows) {
+	free_mask_rows(R__.mask_rows, MASK_ROWS);
+	R__.mask_rows = NULL;
+    }
+    unlock_mask();
+}
+
+static void get_null_value_row(struct R_read_ctx *ctx, char *flags, int row,
+			       int with_mask)
 {
 #ifdef HAVE_GDAL
-    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
 
     if (fcb->gdal)
-	get_null_value_row_gdal(fd, flags, row);
+	get_null_value_row_gdal(ctx, flags, row);
     else
 #endif
-	get_null_value_row_nomask(fd, flags, row);
+	get_null_value_row_nomask(ctx, flags, row);
 
     if (with_mask)
-	embed_mask(flags, row);
+	embed_mask(ctx, flags, row);
 }
 
-static void embed_nulls(int fd, void *buf, int row, RASTER_MAP_TYPE map_type,
-			int null_is_zero, int with_mask)
+static void embed_nulls(struct R_read_ctx *ctx, void *buf, int row,
+			RASTER_MAP_TYPE map_type, int null_is_zero,
+			int with_mask)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
-    size_t size = Rast_cell_size(map_type);
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
     char *null_buf;
-    int i;
 
     /* this is because without null file the nulls can be only due to 0's
        in data row or mask */
@@ -1039,18 +1558,12 @@ static void embed_nulls(int fd, void *buf, int row, RASTER_MAP_TYPE map_type,
 
     null_buf = G_malloc(R__.rd_window.cols);
 
-    get_null_value_row(fd, null_buf, row, with_mask);
+    get_null_value_row(ctx, null_buf, row, with_mask);
 
-    for (i = 0; i < R__.rd_window.cols; i++) {
-	/* also check for nulls which might be already embedded by quant
-	   rules in case of fp map. */
-	if (null_buf[i] || Rast_is_null_value(buf, map_type)) {
-	    /* G__set_[f/d]_null_value() sets it to 0 is the embedded mode
-	       is not set and calls G_set_[f/d]_null_value() otherwise */
-	    Rast__set_null_value(buf, 1, null_is_zero, map_type);
-	}
-	buf = G_incr_void_ptr(buf, size);
-    }
+    /* also sets nulls which might be already embedded by quant rules in
+       case of fp map */
+    Rast__embed_null_flags(buf, null_buf, R__.rd_window.cols, map_type,
+			   null_is_zero);
 
     G_free(null_buf);
 }
@@ -1073,16 +1586,699 @@ static void embed_nulls(int fd, void *buf, int row, RASTER_MAP_TYPE map_type,
    \return void
  */
 void Rast_get_null_value_row(int fd, char *flags, int row)
+{
+    Rast_get_null_value_row_ctx(&R__.fileinfo[fd].rd, flags, row);
+}
+
+/* a row of a mapped map can be handed out in place if the file holds
+   it in the requested type and native byte order (XDR floating point
+   on big-endian hosts), the region columns match the map and no cell
+   of the row is null */
+static const void *get_mapped_row(struct R_read_ctx *ctx, int row,
+				  RASTER_MAP_TYPE data_type)
+{
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
+    size_t rowsize = (size_t) fcb->cellhd.cols * fcb->nbytes;
+    char *flags;
+    int r, i;
+
+    if (!fcb->map_data || fcb->reclass_flag || data_type == CELL_TYPE ||
+	data_type != fcb->map_type || G_is_little_endian())
+	return NULL;
+
+    if (R__.rd_window.cols != fcb->cellhd.cols ||
+	R__.rd_window.west != fcb->cellhd.west ||
+	R__.rd_window.ew_res != fcb->cellhd.ew_res)
+	return NULL;
+
+    if (!compute_window_row(ctx->fd, row, &r))
+	return NULL;
+
+    flags = ctx->row_buf;
+    get_null_value_row(ctx, flags, row, 1);
+    for (i = 0; i < R__.rd_window.cols; i++)
+	if (flags[i])
+	    return NULL;
+
+    return fcb->map_data + (size_t) r * rowsize;
+}
+
+/*!
+ * \brief Get a pointer to a raster row
+ *
+ * Same as Rast_get_row() except that the row is not copied into a
+ * buffer of the caller: a pointer to the row is returned instead. The
+ * row must not be modified and is only valid until the next call of
+ * this function for the same map, or until the map is closed.
+ *
+ * For uncompressed maps the data file is mapped into memory. When the
+ * file already holds the row in the requested type and in the byte
+ * order of the host, the region columns match the map and the row
+ * holds no null cells, the pointer refers directly to the mapped file
+ * and no data is copied at all. Otherwise the row is decoded into a
+ * buffer owned by the file descriptor.
+ *
+ * \param fd file descriptor for the opened raster map
+ * \param row data row desired
+ * \param data_type data type
+ *
+ * \return pointer to the row
+ */
+const void *Rast_get_row_ptr(int fd, int row, RASTER_MAP_TYPE data_type)
+{
+    struct R_read_ctx *ctx = &R__.fileinfo[fd].rd;
+    size_t size = R__.rd_window.cols * sizeof(DCELL);
+    const void *p;
+
+    if (ctx->row_buf_size < size) {
+	ctx->row_buf = G_realloc(ctx->row_buf, size);
+	ctx->row_buf_size = size;
+    }
+
+    p = get_mapped_row(ctx, row, data_type);
+    if (p)
+	return p;
+
+    get_map_row(ctx, ctx->row_buf, row, data_type, 0, 1);
+
+    return ctx->row_buf;
+}
+
+/* reads nrows x ncols cells at window row, col into buf, stride cells
+   apart from row to row */
+static void get_block(int fd, void *buf, int row, int col, int nrows,
+		      int ncols, int stride, RASTER_MAP_TYPE data_type)
 {
     struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct R_read_ctx *ctx = &fcb->rd;
+    size_t size = Rast_cell_size(data_type);
+    unsigned char *row_buf;
+    int r;
+
+    if (row < 0 || col < 0 || nrows < 0 || ncols < 0 ||
+	row + nrows > R__.rd_window.rows || col + ncols > R__.rd_window.cols)
+	G_fatal_error(_("Reading raster map <%s@%s> request for block at row %d, "
+			"col %d of %d x %d cells is outside region"),
+		      fcb->name, fcb->mapset, row, col, nrows, ncols);
+
+    row_buf = G_malloc(R__.rd_window.cols * size);
+
+    /* the rows read are incomplete, keep them out of the row cache */
+    ctx->col0 = col;
+    ctx->ncols = ncols;
+    ctx->cur_row = -1;
+
+    for (r = 0; r < nrows; r++) {
+	get_map_row(ctx, row_buf, row + r, data_type, 0, 1);
+	memcpy(G_incr_void_ptr(buf, (size_t) r * stride * size),
+	       row_buf + col * size, ncols * size);
+    }
+
+    ctx->col0 = 0;
+    ctx->ncols = 0;
+    ctx->cur_row = -1;
+
+    G_free(row_buf);
+}
+
+/*!
+ * \brief Read a block of a raster map
+ *
+ * Reads <em>nrows</em> rows of <em>ncols</em> cells starting at
+ * <em>row</em>, <em>col</em> of the current region into <em>buf</em>,
+ * row by row, like Rast_get_row() (the MASK is applied). For maps
+ * stored in tiles (see Rast_set_tile_size()) only the tiles covering
+ * the block are read and decompressed, so that small windows of a
+ * large map can be accessed in any order. Decoded tiles are cached by
+ * the file descriptor, one row of tiles at a time.
+ *
+ * \param fd file descriptor for the opened raster map
+ * \param buf buffer for nrows x ncols cells
+ * \param row first row of the block
+ * \param col first column of the block
+ * \param nrows number of rows
+ * \param ncols number of columns
+ * \param data_type data type
+ */
+void Rast_get_block(int fd, void *buf, int row, int col, int nrows,
+		    int ncols, RASTER_MAP_TYPE data_type)
+{
+    get_block(fd, buf, row, col, nrows, ncols, ncols, data_type);
+}
+
+/*!
+ * \brief Read a tile of a raster map
+ *
+ * Reads the block of the current region at tile row <em>trow</em> and
+ * tile column <em>tcol</em> of the tile grid of the map, see
+ * Rast_get_tile_size(). When the region matches the map, these are the
+ * tiles as stored in the data file. The buffer holds a full tile, row
+ * by row; cells of tiles at the edges which are outside the region are
+ * set to null.
+ *
+ * \param fd file descriptor for the opened raster map
+ * \param buf buffer for the cells of a tile
+ * \param trow tile row
+ * \param tcol tile column
+ * \param data_type data type
+ */
+void Rast_get_tile(int fd, void *buf, int trow, int tcol,
+		   RASTER_MAP_TYPE data_type)
+{
+    int tile_rows, tile_cols;
+    int row, col, nrows, ncols;
+
+    Rast_get_tile_size(fd, &tile_rows, &tile_cols);
+
+    row = trow * tile_rows;
+    col = tcol * tile_cols;
+    nrows = R__.rd_window.rows - row;
+    if (nrows > tile_rows)
+	nrows = tile_rows;
+    ncols = R__.rd_window.cols - col;
+    if (ncols > tile_cols)
+	ncols = tile_cols;
+
+    if (trow < 0 || tcol < 0 || nrows <= 0 || ncols <= 0)
+	G_fatal_error(_("Reading raster map <%s@%s> request for tile %d,%d "
+			"is outside region"),
+		      R__.fileinfo[fd].name, R__.fileinfo[fd].mapset,
+		      trow, tcol);
+
+    if (nrows < tile_rows || ncols < tile_cols)
+	Rast_set_null_value(buf, tile_rows * tile_cols, data_type);
+
+    get_block(fd, buf, row, col, nrows, ncols, tile_cols, data_type);
+}
+
+/* largest band read by Rast_get_rows() in one go */
+#define BAND_MAX (16 << 20)
+
+/* file range holding data row r, of the null file if null is set;
+   returns 0 if the rows are not read from a file */
+static int record_range(int fd, int r, int null, off_t *start, off_t *end)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    off_t size;
+
+    if (fcb->vrt || fcb->gdal)
+	return 0;
+
+    if (null) {
+	if (fcb->null_fd < 0)
+	    return 0;
+	if (fcb->null_row_ptr) {
+	    *start = fcb->null_row_ptr[r];
+	    *end = fcb->null_row_ptr[r + 1];
+	    return 1;
+	}
+	size = Rast__null_bitstream_size(fcb->cellhd.cols);
+    }
+    else {
+	/* tiles are cached by the reader, mapped rows need no reading */
+	if (fcb->tile_rows > 0 || fcb->map_data)
+	    return 0;
+	if (fcb->cellhd.compressed) {
+	    *start = fcb->row_ptr[r];
+	    *end = fcb->row_ptr[r + 1];
+	    return 1;
+	}
+	size = (off_t) fcb->cellhd.cols * fcb->nbytes;
+    }
+
+    *start = size * r;
+    *end = *start + size;
+
+    return 1;
+}
+
+/* reads the data records of window rows row .. row + nrows - 1 with a
+   single read into the band of the reader; stops at BAND_MAX bytes and
+   returns the number of rows covered. Nothing is read if the rows are
+   not stored in a file, or if the window skips most of the data rows
+   between them. */
+static int load_band(struct R_read_ctx *ctx, int row, int nrows)
+{
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
+    struct R_band *band = &ctx->band;
+    off_t start = -1, end = -1, need = 0;
+    int last = -1;
+    int i;
+
+    for (i = 0; i < nrows; i++) {
+	off_t s, e;
+	int r;
+
+	if (!compute_window_row(ctx->fd, row + i, &r) || r == last)
+	    continue;
+	if (!record_range(ctx->fd, r, 0, &s, &e))
+	    return nrows;
+	if (start < 0)
+	    start = s;
+	else if (e - start > BAND_MAX)
+	    break;
+	end = e;
+	need += e - s;
+	last = r;
+    }
+
+    if (start < 0 || end - start > 2 * need ||
+	(start >= band->start && end <= band->end))
+	return i;
+
+    /* a row of an uncompressed map may be held in place */
+    ctx->cur_row = -1;
+
+    if ((size_t) (end - start) > band->size) {
+	band->size = end - start;
+	band->buf = G_realloc(band->buf, band->size);
+    }
+    band->start = band->end = 0;
+
+    if (read_at(fcb->data_fd, band->buf, end - start, start) < 0)
+	G_fatal_error(_("Error reading rows %d to %d of <%s>: %s"),
+		      row, row + i - 1, fcb->name, strerror(errno));
+
+    band->start = start;
+    band->end = end;
+
+    return i;
+}
+
+/* same as load_band() for the null records, which are decoded right
+   away into the null bitstreams of the data rows; BAND_MAX also bounds
+   the decoded size */
+static int load_null_band(struct R_read_ctx *ctx, int row, int nrows)
+{
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
+    struct R_null_band *band = &ctx->null_band;
+    size_t size = Rast__null_bitstream_size(fcb->cellhd.cols);
+    off_t start = -1, end = -1, need = 0;
+    int first = -1, last = -1;
+    unsigned char *buf;
+    int i, r;
+
+    for (i = 0; i < nrows; i++) {
+	off_t s, e;
+
+	if (!compute_window_row(ctx->fd, row + i, &r) || r == last)
+	    continue;
+	if (!record_range(ctx->fd, r, 1, &s, &e))
+	    return nrows;
+	if (start < 0) {
+	    start = s;
+	    first = r;
+	}
+	else if (e - start > BAND_MAX ||
+		 (size_t) (r - first + 1) * size > BAND_MAX)
+	    break;
+	end = e;
+	need += e - s;
+	last = r;
+    }
+
+    if (start < 0 || end - start > 2 * need ||
+	(first >= band->row && last < band->row + band->nrows))
+	return i;
+
+    band->bits = G_realloc(band->bits, (size_t) (last - first + 1) * size);
+    band->nrows = 0;
+
+    /* uncompressed bitstreams are read in place */
+    buf = fcb->null_row_ptr ? G_malloc(end - start) : band->bits;
+
+    if (read_at(fcb->null_fd, buf, end - start, start) < 0)
+	G_fatal_error(_("Error reading null rows %d to %d of <%s>: %s"),
+		      row, row + i - 1, fcb->name, strerror(errno));
+
+    for (r = first; fcb->null_row_ptr && r <= last; r++) {
+	off_t t1 = fcb->null_row_ptr[r], t2 = fcb->null_row_ptr[r + 1];
+	unsigned char *bits = band->bits + (size_t) (r - first) * size;
+
+	if ((size_t) (t2 - t1) == size)
+	    memcpy(bits, buf + (t1 - start), size);
+	/* null bits file compressed with LZ4, see lib/gis/compress.h */
+	else if (G_lz4_expand(buf + (t1 - start), t2 - t1, bits, size) < 1)
+	    G_fatal_error(_("Error uncompressing null data for row %d of <%s>"),
+			  r, fcb->name);
+    }
+
+    if (buf != band->bits)
+	G_free(buf);
+
+    band->row = first;
+    band->nrows = last - first + 1;
+
+    return i;
+}
+
+/* loads the bands of ctx and of its MASK reader, returns the number of
+   rows covered by all of them */
+static int load_bands(struct R_read_ctx *ctx, int row, int nrows,
+		      int with_mask)
+{
+    nrows = load_band(ctx, row, nrows);
+    nrows = load_null_band(ctx, row, nrows);
+
+    if (with_mask && R__.auto_mask > 0 && ctx->fd != R__.mask_fd) {
+	struct R_read_ctx *mctx = get_mask_reader(ctx);
+
+	nrows = load_band(mctx, row, nrows);
+	nrows = load_null_band(mctx, row, nrows);
+    }
+
+    return nrows > 0 ? nrows : 1;
+}
+
+/* releases the bands of ctx, which could hold up to 2 * BAND_MAX bytes
+   for as long as the map is open */
+static void drop_bands(struct R_read_ctx *ctx)
+{
+    /* a row of an uncompressed map may be held in the band */
+    ctx->cur_row = -1;
+    ctx->row = ctx->data;
+
+    G_free(ctx->band.buf);
+    G_free(ctx->null_band.bits);
+    memset(&ctx->band, 0, sizeof(struct R_band));
+    memset(&ctx->null_band, 0, sizeof(struct R_null_band));
+}
+
+static void get_rows(int fd, void **bufs, void *buf, int row, int nrows,
+		     RASTER_MAP_TYPE data_type)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct R_read_ctx *ctx = &fcb->rd;
+    size_t size = (size_t) R__.rd_window.cols * Rast_cell_size(data_type);
+    int i, n = 0;
+
+    if (row < 0 || nrows < 0 || row + nrows > R__.rd_window.rows)
+	G_fatal_error(_("Reading raster map <%s@%s> request for rows %d to %d "
+			"is outside region"),
+		      fcb->name, fcb->mapset, row, row + nrows - 1);
+
+    for (i = 0; i < nrows; i++) {
+	/* rows read ahead in the background are already decoded */
+	if (n == 0 && !fcb->read_ahead)
+	    n = load_bands(ctx, row + i, nrows - i, 1);
+	if (n > 0)
+	    n--;
+
+	get_map_row(ctx, bufs ? bufs[i] : G_incr_void_ptr(buf, i * size),
+		    row + i, data_type, 0, 1);
+    }
+
+    drop_bands(ctx);
+    if (ctx->mask)
+	drop_bands(ctx->mask);
+}
+
+/*!
+ * \brief Read a band of raster rows
+ *
+ * Reads the <em>nrows</em> rows starting at window row <em>row</em>
+ * into <em>buf</em>, one row of the current region after the other,
+ * like Rast_get_row() does for each of them (the MASK is applied).
+ *
+ * The records of the rows in the data file and in the null file are
+ * each fetched with a single large read instead of one read per row,
+ * up to 16 MB at a time, and the null rows are decoded in one go. The
+ * buffers holding them are released before the function returns. This makes a difference on network file
+ * systems, in particular for modules with moving windows which need
+ * several rows at once.
+ *
+ * \param fd file descriptor for the opened raster map
+ * \param buf buffer for nrows rows of the current region
+ * \param row first row
+ * \param nrows number of rows
+ * \param data_type data type
+ */
+void Rast_get_rows(int fd, void *buf, int row, int nrows,
+		   RASTER_MAP_TYPE data_type)
+{
+    get_rows(fd, NULL, buf, row, nrows, data_type);
+}
+
+/*!
+ * \brief Read a band of raster rows into separate buffers
+ *
+ * Same as Rast_get_rows() except that row <em>row</em> + i is placed
+ * into the buffer <em>bufs</em>[i], as needed e.g. for the rotating
+ * row buffers of moving window modules.
+ *
+ * \param fd file descriptor for the opened raster map
+ * \param bufs nrows row buffers
+ * \param row first row
+ * \param nrows number of rows
+ * \param data_type data type
+ */
+void Rast_get_rows_2d(int fd, void **bufs, int row, int nrows,
+		      RASTER_MAP_TYPE data_type)
+{
+    get_rows(fd, bufs, NULL, row, nrows, data_type);
+}
+
+/*!
+   \brief Map the data file of an uncompressed raster map into memory
+
+   Rows are then decoded straight from the page cache instead of being
+   read into the buffer of the reader, see Rast_get_row_ptr(). Nothing
+   is done if memory mapping is not available, is disabled with
+   GRASS_RASTER_MMAP=0, or fails.
+
+   \param fd file descriptor of a raster map opened for reading
+ */
+void Rast__map_data(int fd)
+{
+#ifdef HAVE_SYS_MMAN_H
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    off_t size = (off_t) fcb->cellhd.rows * fcb->cellhd.cols * fcb->nbytes;
+    struct stat st;
+    void *p;
+
+    if (!R__.map_data || size <= 0 || (off_t) (size_t) size != size)
+	return;
+
+    if (fstat(fcb->data_fd, &st) < 0 || st.st_size < size)
+	return;
+
+    p = mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, fcb->data_fd, 0);
+    if (p == MAP_FAILED) {
+	G_debug(1, "Unable to map <%s@%s>: %s", fcb->name, fcb->mapset,
+		strerror(errno));
+	return;
+    }
+
+    fcb->map_data = p;
+    fcb->map_size = (size_t) size;
+#endif
+}
+
+/*!
+   \brief Unmap the data file of a raster map
+
+   \param fd file descriptor
+ */
+void Rast__unmap_data(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+
+#ifdef HAVE_SYS_MMAN_H
+    if (fcb->map_data)
+	munmap(fcb->map_data, fcb->map_size);
+#endif
+    fcb->map_data = NULL;
+    fcb->map_size = 0;
+}
+
+/*!
+   \brief Initialize the decode state of a reader
+
+   \param ctx decode state to be initialized
+   \param fd file descriptor of a raster map opened for reading
+ */
+void Rast__init_read_ctx(struct R_read_ctx *ctx, int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+
+    ctx->fd = fd;
+    ctx->cur_row = -1;
+    ctx->null_cur_row = -1;
+    ctx->cur_nbytes = fcb->nbytes;
+    ctx->data = G_calloc(fcb->cellhd.cols, fcb->nbytes);
+    ctx->row = ctx->data;
+    ctx->null_bits = Rast__allocate_null_bits(fcb->cellhd.cols);
+    ctx->cmp = NULL;
+    ctx->cmp_size = 0;
+    ctx->tiles = NULL;
+    ctx->ntiles = 0;
+    ctx->col0 = 0;
+    ctx->ncols = 0;
+    ctx->row_buf = NULL;
+    ctx->row_buf_size = 0;
+    memset(&ctx->band, 0, sizeof(struct R_band));
+    memset(&ctx->null_band, 0, sizeof(struct R_null_band));
+    ctx->mask = NULL;
+    ctx->mask_row = NULL;
+    ctx->mask_serial = R__.mask_serial;
+}
+
+/*!
+   \brief Release the buffers of a reader
+
+   \param ctx decode state
+ */
+void Rast__free_read_ctx(struct R_read_ctx *ctx)
+{
+    if (ctx->tiles) {
+	int i;
+
+	/* the map of a MASK reader may be closed already */
+	for (i = 0; i < ctx->ntiles; i++)
+	    G_free(ctx->tiles[i].data);
+	G_free(ctx->tiles);
+    }
+    G_free(ctx->data);
+    G_free(ctx->null_bits);
+    G_free(ctx->cmp);
+    G_free(ctx->row_buf);
+    drop_bands(ctx);
+    if (ctx->mask) {
+	Rast__free_read_ctx(ctx->mask);
+	G_free(ctx->mask);
+    }
+    if (ctx->mask_row)
+	free_mask_rows(ctx->mask_row, 1);
+    ctx->data = NULL;
+    ctx->row = NULL;
+    ctx->null_bits = NULL;
+    ctx->cmp = NULL;
+    ctx->cmp_size = 0;
+    ctx->tiles = NULL;
+    ctx->ntiles = 0;
+    ctx->row_buf = NULL;
+    ctx->row_buf_size = 0;
+    ctx->mask = NULL;
+    ctx->mask_row = NULL;
+}
+
+/*!
+   \brief Create a reentrant reader for a raster map
+
+   Rast_get_row() and friends keep the decoded row, the null bitmap and
+   the decompression buffers of a map in the file descriptor itself, so
+   only one thread at a time may read from a given map. A read context
+   owns its own copy of this state: rows of the same map can be decoded
+   concurrently by calling Rast_get_row_ctx() on different contexts from
+   different threads. File data is read with pread(), so the contexts do
+   not share the file position either.
+
+   A context must only be used by one thread at a time. No raster map
+   may be opened or closed while contexts are being read from other
+   threads, and the context must be freed with Rast_free_read_ctx()
+   before the map is closed. Quantization rules set with
+   Rast_set_quant_rules() must be set before the context is created.
+   GDAL-linked and virtual raster maps are read under a global lock.
+
+   \param fd file descriptor of a raster map opened for reading
+
+   \return pointer to the new read context
+ */
+struct R_read_ctx *Rast_create_read_ctx(int fd)
+{
+    struct fileinfo *fcb;
+    struct R_read_ctx *ctx;
+
+    if (fd < 0 || fd >= R__.fileinfo_count ||
+	R__.fileinfo[fd].open_mode != OPEN_OLD)
+	G_fatal_error(_("Unable to create read context: "
+			"file descriptor %d is not open for reading"), fd);
+
+    fcb = &R__.fileinfo[fd];
+
+    /* the fp lookup table is otherwise built lazily on first use */
+    if (fcb->map_type != CELL_TYPE && !fcb->quant.fp_lookup.active)
+	Rast__quant_organize_fp_lookup(&fcb->quant);
+
+    ctx = G_malloc(sizeof(struct R_read_ctx));
+    Rast__init_read_ctx(ctx, fd);
+
+    return ctx;
+}
+
+/*!
+   \brief Free a read context created by Rast_create_read_ctx()
+
+   \param ctx read context
+ */
+void Rast_free_read_ctx(struct R_read_ctx *ctx)
+{
+    Rast__free_read_ctx(ctx);
+    G_free(ctx);
+}
+
+/*!
+   \brief Read raster row through a read context
+
+   Same as Rast_get_row() except that the decode state is taken from
+   <em>ctx</em> instead of the file descriptor. Different contexts of
+   the same map can be read concurrently, see Rast_create_read_ctx().
+
+   \param ctx read context
+   \param buf buffer for the row to be placed into
+   \param row data row desired
+   \param data_type data type
+
+   \return void
+ */
+void Rast_get_row_ctx(struct R_read_ctx *ctx, void *buf, int row,
+		      RASTER_MAP_TYPE data_type)
+{
+    get_map_row(ctx, buf, row, data_type, 0, 1);
+}
+
+/*!
+   \brief Read raster row without masking through a read context
+
+   Same as Rast_get_row_nomask() except that the decode state is taken
+   from <em>ctx</em>, see Rast_get_row_ctx().
+
+   \param ctx read context
+   \param buf buffer for the row to be placed into
+   \param row data row desired
+   \param data_type data type
+
+   \return void
+ */
+void Rast_get_row_nomask_ctx(struct R_read_ctx *ctx, void *buf, int row,
+			     RASTER_MAP_TYPE data_type)
+{
+    get_map_row(ctx, buf, row, data_type, 0, 0);
+}
+
+/*!
+   \brief Read or simulate null value row through a read context
+
+   Same as Rast_get_null_value_row() except that the decode state is
+   taken from <em>ctx</em>, see Rast_get_row_ctx().
+
+   \param ctx read context
+   \param flags buffer for the null flags
+   \param row data row desired
+
+   \return void
+ */
+void Rast_get_null_value_row_ctx(struct R_read_ctx *ctx, char *flags, int row)
+{
+    struct fileinfo *fcb = &R__.fileinfo[ctx->fd];
 
     if (!fcb->reclass_flag)
-	get_null_value_row(fd, flags, row, 1);
+	get_null_value_row(ctx, flags, row, 1);
     else {
 	CELL *buf = G_malloc(R__.rd_window.cols * sizeof(CELL));
 	int i;
 
-	Rast_get_c_row(fd, buf, row);
+	get_map_row(ctx, buf, row, CELL_TYPE, 0, 1);
 	for (i = 0; i < R__.rd_window.cols; i++)
 	    flags[i] = Rast_is_c_null_value(&buf[i]) ? 1 : 0;
 
@@ -77,7 +77,7 @@ void Rast__error_handler(void *p)
 
 static int init(void)
 {
-    char *zlib, *nulls, *cname;
+    char *zlib, *nulls, *cname, *ahead, *tiles, *overviews, *map_data;
 
     Rast__init_window();
 
@@ -129,6 +129,34 @@ static int init(void)
     nulls = getenv("GRASS_COMPRESS_NULLS");
     R__.compress_nulls = (nulls && atoi(nulls) == 0) ? 0 : 1;
 
+    ahead = getenv("GRASS_RASTER_READ_AHEAD");
+    R__.read_ahead = (ahead && atoi(ahead) > 0) ? atoi(ahead) : 0;
+
+    /* tile size for new maps: rows[xcols] */
+    R__.tile_rows = R__.tile_cols = 0;
+    tiles = getenv("GRASS_RASTER_TILE_SIZE");
+    if (tiles && *tiles) {
+	int rows, cols;
+	int n = sscanf(tiles, "%dx%d", &rows, &cols);
+
+	if (n == 1)
+	    cols = rows;
+
+	if (n >= 1 && rows > 0 && cols > 0) {
+	    R__.tile_rows = rows;
+	    R__.tile_cols = cols;
+	}
+	else
+	    G_warning(_("Invalid tile size <%s>, writing row based maps"),
+		      tiles);
+    }
+
+    overviews = getenv("GRASS_RASTER_OVERVIEWS");
+    R__.use_overviews = (overviews && atoi(overviews) == 0) ? 0 : 1;
+
+    map_data = getenv("GRASS_RASTER_MMAP");
+    R__.map_data = (map_data && atoi(map_data) == 0) ? 0 : 1;
+
     G_add_error_handler(Rast__error_handler, NULL);
 
     initialized = 1;
@@ -142,3 +170,23 @@ void Rast_init_all(void)
     Rast__check_for_auto_masking();
     Rast_init_gdal();
 }
+
+/*!
+ * \brief Get the number of worker threads available to the library
+ *
+ * Starts the worker threads of the GIS library (see G_init_workers())
+ * on first use.
+ *
+ * \return number of worker threads, 0 if there are none
+ */
+int Rast__num_workers(void)
+{
+    static int workers_initialized;
+
+    if (!workers_initialized) {
+	G_init_workers();
+	workers_initialized = 1;
+    }
+
+    return G_num_workers();
+}
@@ -36,34 +36,15 @@ static void EmbedGivenNulls(void *, char *, RASTER_MAP_TYPE, int);
 void EmbedGivenNulls(void *cell, char *nulls, RASTER_MAP_TYPE map_type,
 		     int ncols)
 {
-    CELL *c;
-    FCELL *f;
-    DCELL *d;
-    int i;
-
-    c = (CELL *) cell;
-    f = (FCELL *) cell;
-    d = (DCELL *) cell;
-
-    for (i = 0; i < ncols; i++) {
-	if (nulls[i]) {
-	    switch (map_type) {
-	    case CELL_TYPE:
-		Rast_set_c_null_value((CELL *) (c + i), 1);
-		break;
-
-	    case FCELL_TYPE:
-		Rast_set_f_null_value((FCELL *) (f + i), 1);
-		break;
-
-	    case DCELL_TYPE:
-		Rast_set_d_null_value((DCELL *) (d + i), 1);
-		break;
+    switch (map_type) {
+    case CELL_TYPE:
+    case FCELL_TYPE:
+    case DCELL_TYPE:
+	Rast__embed_null_flags(cell, nulls, ncols, map_type, 0);
+	break;
 
-	    default:
-		G_warning(_("EmbedGivenNulls: wrong data type"));
-	    }
-	}
+    default:
+	G_warning(_("EmbedGivenNulls: wrong data type"));
     }
 }
 
@@ -137,13 +118,9 @@ void Rast_set_c_null_value(CELL * cellVals, int numVals)
  */
 void Rast_set_f_null_value(FCELL * fcellVals, int numVals)
 {
-    static const unsigned char null_bits[4] = {
-	0xFF, 0xFF, 0xFF, 0xFF
-    };
-    int i;
-
-    for (i = 0; i < numVals; i++)
-	memcpy(&fcellVals[i], null_bits, sizeof(null_bits));
+    /* the null pattern has all bits set */
+    if (numVals > 0)
+	memset(fcellVals, 0xFF, numVals * sizeof(FCELL));
 }
 
 /*!
@@ -154,13 +131,9 @@ void Rast_set_f_null_value(FCELL * fcellVals, int numVals)
  */
 void Rast_set_d_null_value(DCELL * dcellVals, int numVals)
 {
-    static const unsigned char null_bits[8] = {
-	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
-    };
-    int i;
-
-    for (i = 0; i < numVals; i++)
-	memcpy(&dcellVals[i], null_bits, sizeof(null_bits));
+    /* the null pattern has all bits set */
+    if (numVals > 0)
+	memset(dcellVals, 0xFF, numVals * sizeof(DCELL));
 }
 
 /*!
@@ -423,30 +396,7 @@ int G__set_flags_from_01_random(const char *zero_ones, unsigned char *flags,
 void Rast__convert_01_flags(const char *zero_ones, unsigned char *flags,
 			    int n)
 {
-    unsigned char *v;
-    int count;
-    int size;
-    int i, k;
-
-    /* pad the flags with 0's to make size multiple of 8 */
-    v = flags;
-    size = Rast__null_bitstream_size(n);
-    count = 0;
-
-    for (i = 0; i < size; i++) {
-	*v = 0;
-	k = 8;
-
-	while (k-- > 0) {
-	    if (count < n) {
-		*v = *v | ((unsigned char)zero_ones[count] << k);
-	    }
-
-	    count++;
-	}
-
-	v++;
-    }
+    Rast__pack_null_flags(flags, zero_ones, n);
 }
 
 /*!
@@ -461,27 +411,7 @@ void Rast__convert_01_flags(const char *zero_ones, unsigned char *flags,
 void Rast__convert_flags_01(char *zero_ones, const unsigned char *flags,
 			    int n)
 {
-    const unsigned char *v;
-    int count;
-    int size;
-    int i, k;
-
-    count = 0;
-    v = flags;
-    size = Rast__null_bitstream_size(n);
-
-    for (i = 0; i < size; i++) {
-	k = 8;
-
-	while (k-- > 0) {
-	    if (count < n) {
-		zero_ones[count] = ((*v & ((unsigned char)1 << k)) != 0);
-		count++;
-	    }
-	}
-
-	v++;
-    }
+    Rast__unpack_null_bits(zero_ones, flags, 0, n);
 }
 
 /*!
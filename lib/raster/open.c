@@ -48,6 +48,9 @@ static int new_fileinfo(void)
     else
 	newsize *= 2;
 
+    /* worker threads must not access the table while it moves */
+    Rast__drop_all_read_ahead();
+
     R__.fileinfo = G_realloc(R__.fileinfo, newsize * sizeof(struct fileinfo));
 
     /* Mark all cell files as closed */
@@ -123,6 +126,9 @@ int Rast_open_old(const char *name, const char *mapset)
     /* mask_buf is used for reading MASK file when mask is set and
        for reading map rows when the null file doesn't exist */
 
+    if (R__.read_ahead > 0)
+	Rast_set_read_ahead(fd, R__.read_ahead);
+
     return fd;
 }
 
@@ -166,6 +172,8 @@ int Rast__open_old(const char *name, const char *mapset)
     char xname[GNAME_MAX], xmapset[GMAPSET_MAX];
     struct GDAL_link *gdal;
     struct R_vrt *vrt;
+    int overview;
+    char element[GNAME_MAX], celement[GNAME_MAX];
 
     Rast__init();
 
@@ -202,6 +210,9 @@ int Rast__open_old(const char *name, const char *mapset)
     /* read the cell header */
     Rast_get_cellhd(r_name, r_mapset, &cellhd);
 
+    /* in a coarse region, read an overview instead (see overview.c) */
+    overview = Rast__select_overview(r_name, r_mapset, &cellhd);
+
     /* now check the type */
     MAP_TYPE = Rast_map_type(r_name, r_mapset);
     if (MAP_TYPE < 0)
@@ -282,6 +293,13 @@ int Rast__open_old(const char *name, const char *mapset)
     else if (vrt) {
 	cell_fd = -1;
     }
+    else if (overview) {
+	Rast__overview_element(element, overview, "");
+	cell_fd = G_open_old_misc("cell_misc", element, r_name, r_mapset);
+	if (cell_fd < 0)
+	    G_fatal_error(_("Unable to open overview 1:%d of raster map <%s@%s>"),
+			  overview, r_name, r_mapset);
+    }
     else {
 	/* now actually open file for reading */
 	cell_fd = G_open_old(cell_dir, r_name, r_mapset);
@@ -299,10 +317,7 @@ int Rast__open_old(const char *name, const char *mapset)
     /* Save cell header */
     fcb->cellhd = cellhd;
 
-    /* allocate null bitstream buffers for reading null rows */
     fcb->null_fd = -1;
-    fcb->null_cur_row = -1;
-    fcb->null_bits = Rast__allocate_null_bits(cellhd.cols);
 
     /* mark closed */
     fcb->open_mode = -1;
@@ -311,15 +326,13 @@ int Rast__open_old(const char *name, const char *mapset)
     fcb->name = G_store(name);
     fcb->mapset = G_store(mapset);
 
-    /* mark no data row in memory  */
-    fcb->cur_row = -1;
-
     /* if reclass, copy reclass structure */
     if ((fcb->reclass_flag = reclass_flag))
 	fcb->reclass = reclass;
 
     fcb->gdal = gdal;
     fcb->vrt = vrt;
+    fcb->overview = overview;
     if (!gdal && !vrt) {
 	/* check for compressed data format, making initial reads if necessary */
 	if (Rast__check_format(fd) < 0) {
@@ -334,15 +347,6 @@ int Rast__open_old(const char *name, const char *mapset)
 	Rast__create_window_mapping(fd);
     }
 
-    /*
-     * allocate the data buffer
-     * number of bytes per cell is cellhd.format+1
-     */
-
-    /* for reading fcb->data is allocated to be fcb->cellhd.cols * fcb->nbytes 
-       (= XDR_FLOAT/DOUBLE_NBYTES) */
-    fcb->data = (unsigned char *)G_calloc(fcb->cellhd.cols, MAP_NBYTES);
-
     /* initialize/read in quant rules for float point maps */
     if (fcb->map_type != CELL_TYPE) {
 	if (fcb->reclass_flag)
@@ -359,11 +363,30 @@ int Rast__open_old(const char *name, const char *mapset)
     fcb->nbytes = MAP_NBYTES;
     fcb->null_row_ptr = NULL;
 
+    /*
+     * allocate the buffers of the default reader
+     * number of bytes per cell is cellhd.format+1
+     * (= XDR_FLOAT/DOUBLE_NBYTES for fp maps)
+     */
+    Rast__init_read_ctx(&fcb->rd, fd);
+
+    if (!gdal && !vrt && !fcb->cellhd.compressed)
+	Rast__map_data(fd);
+
     if (!gdal && !vrt) {
+	const char *null_file = NULL_FILE, *nullc_file = NULLC_FILE;
+
+	if (overview) {
+	    Rast__overview_element(element, overview, "." NULL_FILE);
+	    Rast__overview_element(celement, overview, "." NULLC_FILE);
+	    null_file = element;
+	    nullc_file = celement;
+	}
+
 	/* First, check for compressed null file */
-	fcb->null_fd = G_open_old_misc("cell_misc", NULL_FILE, r_name, r_mapset);
+	fcb->null_fd = G_open_old_misc("cell_misc", null_file, r_name, r_mapset);
 	if (fcb->null_fd < 0) {
-	    fcb->null_fd = G_open_old_misc("cell_misc", NULLC_FILE, r_name, r_mapset);
+	    fcb->null_fd = G_open_old_misc("cell_misc", nullc_file, r_name, r_mapset);
 	    if (fcb->null_fd >= 0) {
 		fcb->null_row_ptr = G_calloc(fcb->cellhd.rows + 1, sizeof(off_t));
 		if (Rast__read_null_row_ptrs(fd, fcb->null_fd) < 0) {
@@ -661,12 +684,17 @@ static int open_raster_new(const char *name, int open_mode,
      *   allocate space to hold the row address array
      */
     fcb->cellhd = R__.wr_window;
+
+    /* compressed maps can be written in tiles, see tile.c */
+    if (open_mode == OPEN_NEW_COMPRESSED) {
+	fcb->tile_rows = R__.tile_rows;
+	fcb->tile_cols = R__.tile_cols;
+    }
     
     /* change open_mode to OPEN_NEW_UNCOMPRESSED if R__.compression_type == 0 ? */
 
     if (open_mode == OPEN_NEW_COMPRESSED && fcb->map_type == CELL_TYPE) {
-	fcb->row_ptr = G_calloc(fcb->cellhd.rows + 1, sizeof(off_t));
-	G_zero(fcb->row_ptr, (fcb->cellhd.rows + 1) * sizeof(off_t));
+	fcb->row_ptr = G_calloc(Rast__row_ptr_count(fd) + 1, sizeof(off_t));
 	Rast__write_row_ptrs(fd);
 	fcb->cellhd.compressed = R__.compression_type;
 
@@ -675,8 +703,8 @@ static int open_raster_new(const char *name, int open_mode,
     else {
 	fcb->nbytes = nbytes;
 	if (open_mode == OPEN_NEW_COMPRESSED) {
-	    fcb->row_ptr = G_calloc(fcb->cellhd.rows + 1, sizeof(off_t));
-	    G_zero(fcb->row_ptr, (fcb->cellhd.rows + 1) * sizeof(off_t));
+	    fcb->row_ptr = G_calloc(Rast__row_ptr_count(fd) + 1,
+				    sizeof(off_t));
 	    Rast__write_row_ptrs(fd);
 	    fcb->cellhd.compressed = R__.compression_type;
 	}
@@ -748,6 +776,43 @@ static int open_raster_new(const char *name, int open_mode,
     return fd;
 }
 
+/*!
+   \brief Open an overview of a raster map for writing
+
+   The overview is written like a new compressed map by Rast_put_row()
+   in the current output window, and stored in the cell_misc directory
+   of map <i>name</i> by Rast_close(). Only used by
+   Rast_build_overviews().
+
+   \param name name of a raster map in the current mapset
+   \param factor decimation factor of the overview
+   \param map_type type of the map
+
+   \return file descriptor
+ */
+int Rast__open_overview_new(const char *name, int factor,
+			    RASTER_MAP_TYPE map_type)
+{
+    int tile_rows = R__.tile_rows, tile_cols = R__.tile_cols;
+    int fd;
+
+    Rast__init();
+
+    /* overviews are stored in rows */
+    R__.tile_rows = R__.tile_cols = 0;
+    fd = open_raster_new(name, OPEN_NEW_COMPRESSED, map_type);
+    R__.tile_rows = tile_rows;
+    R__.tile_cols = tile_cols;
+
+    if (R__.fileinfo[fd].gdal)
+	G_fatal_error(_("Overviews of raster map <%s> cannot be written "
+			"to GDAL output"), name);
+
+    R__.fileinfo[fd].overview = factor;
+
+    return fd;
+}
+
 int Rast__open_null_write(const char *name)
 {
     char xname[GNAME_MAX], xmapset[GMAPSET_MAX];
@@ -831,6 +896,28 @@ void Rast_set_fp_type(RASTER_MAP_TYPE map_type)
     }
 }
 
+/*!
+   \brief Set the compression method for new raster maps
+
+   Overrides GRASS_COMPRESSOR for the compressed maps opened for writing
+   after this call. Like Rast_set_fp_type(), this is meant for special
+   applications such as benchmarks, modules should respect the user's
+   choice.
+
+   \param number compressor number (see G_compressor_number())
+ */
+void Rast_set_compressor(int number)
+{
+    Rast__init();
+
+    if (number < 1 || G_check_compressor(number) != 1)
+	G_fatal_error(_("Compressor %s is not available"),
+		      G_compressor_name(number) ? G_compressor_name(number) :
+		      "?");
+
+    R__.compression_type = number;
+}
+
 /*!
    \brief Check if raster map is floating-point
 
@@ -1038,6 +1125,8 @@ void Rast_set_quant_rules(int fd, struct Quant *q)
 	G_fatal_error(_("Rast_set_quant_rules() can be called only for "
 			"raster maps opened for reading"));
 
+    Rast__drop_read_ahead(fd);
+
     /* copy all info from q to fcb->quant) */
     Rast_quant_init(&fcb->quant);
     if (q->truncate_only) {
@@ -0,0 +1,422 @@
+/*!
+   \file lib/raster/overview.c
+
+   \brief Raster library - Overviews (reduced resolution levels)
+
+   An overview of a raster map holds the map at a resolution reduced by
+   an integer factor. Overviews are built by Rast_build_overviews() (see
+   r.support) and stored in the cell_misc directory of the map: the
+   data and null files of level 1:<i>f</i> are called ovr<i>f</i>,
+   ovr<i>f</i>.null or ovr<i>f</i>.nullcmpr, and the file "overviews"
+   lists the levels together with the format and compression of their
+   data files. When a map is opened for reading in a region which is
+   coarser than the map, the coarsest overview whose resolution is
+   still at least as fine as the region is read instead of the map.
+
+   (C) 2026 by the GRASS Development Team
+
+   This program is free software under the GNU General Public License
+   (>=v2).  Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/glocale.h>
+
+#include "R.h"
+
+#define OVERVIEW_FILE "overviews"
+
+/* tolerance for comparing resolutions */
+#define RES_EPSILON 1e-6
+
+static void overview_cellhd(const struct Cell_head *cellhd, int factor,
+			    struct Cell_head *hd)
+{
+    struct Cell_head map = *cellhd;
+
+    /* the last row and column of the overview may extend beyond the map */
+    *hd = map;
+    hd->rows = (map.rows + factor - 1) / factor;
+    hd->cols = (map.cols + factor - 1) / factor;
+    hd->ns_res = map.ns_res * factor;
+    hd->ew_res = map.ew_res * factor;
+    hd->south = map.north - hd->rows * hd->ns_res;
+    hd->east = map.west + hd->cols * hd->ew_res;
+}
+
+/*!
+   \brief Get the name of a file of an overview level
+
+   \param[out] element file name in the cell_misc directory of the map
+   \param factor decimation factor of the level
+   \param file "" for the data file, ".null" or ".nullcmpr" for the
+   null file
+ */
+void Rast__overview_element(char *element, int factor, const char *file)
+{
+    sprintf(element, "ovr%d%s", factor, file);
+}
+
+/*!
+   \brief Enable or disable the automatic use of overviews
+
+   By default, maps opened with Rast_open_old() are read from the most
+   suitable overview if the region is coarser than the map, unless the
+   environment variable GRASS_RASTER_OVERVIEWS is set to 0. Modules
+   which need the values of the map itself, e.g. to compute statistics,
+   can disable overviews for the maps they open afterwards.
+
+   \param flag 0 to disable overviews, 1 to enable them
+ */
+void Rast_use_overviews(int flag)
+{
+    Rast__init();
+
+    R__.use_overviews = flag;
+}
+
+/*!
+   \brief Get the overview level a map is read from
+
+   \param fd file descriptor of a raster map opened for reading
+
+   \return decimation factor of the overview read
+   \return 1 if the map itself is read
+ */
+int Rast_get_overview(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+
+    return fcb->overview > 0 ? fcb->overview : 1;
+}
+
+/*!
+   \brief Select the overview to read for the current region
+
+   If the map has overviews and the region is coarser than the map, the
+   header of the coarsest suitable overview replaces <i>cellhd</i>.
+
+   \param name map name
+   \param mapset mapset name
+   \param[in,out] cellhd header of the map, of the overview on return
+
+   \return decimation factor of the overview
+   \return 0 if the map itself is to be read
+ */
+int Rast__select_overview(const char *name, const char *mapset,
+			  struct Cell_head *cellhd)
+{
+    char path[GPATH_MAX], key[32];
+    struct Key_Value *keys;
+    const char *str;
+    int best = 0, format = 0, compressed = 0;
+
+    if (!R__.use_overviews)
+	return 0;
+
+    G_file_name_misc(path, "cell_misc", OVERVIEW_FILE, name, mapset);
+    if (access(path, 0) != 0)
+	return 0;
+
+    keys = G_read_key_value_file(path);
+
+    if ((str = G_find_key_value("levels", keys)) != NULL) {
+	char *end;
+	long factor;
+
+	for (;;) {
+	    const char *level;
+	    int f, c;
+
+	    factor = strtol(str, &end, 10);
+	    if (end == str)
+		break;
+	    str = end;
+
+	    if (factor <= best ||
+		cellhd->ns_res * factor >
+		R__.rd_window.ns_res * (1 + RES_EPSILON) ||
+		cellhd->ew_res * factor >
+		R__.rd_window.ew_res * (1 + RES_EPSILON))
+		continue;
+
+	    Rast__overview_element(key, (int)factor, "");
+	    level = G_find_key_value(key, keys);
+	    if (level && sscanf(level, "%d %d", &f, &c) == 2) {
+		best = (int)factor;
+		format = f;
+		compressed = c;
+	    }
+	}
+    }
+
+    G_free_key_value(keys);
+
+    if (best <= 1)
+	return 0;
+
+    overview_cellhd(cellhd, best, cellhd);
+    cellhd->format = format;
+    cellhd->compressed = compressed;
+
+    G_debug(1, "Reading overview 1:%d of <%s@%s>", best, name, mapset);
+
+    return best;
+}
+
+/*!
+   \brief Record an overview level written by Rast_close()
+
+   \param fd file descriptor of the overview being closed
+ */
+void Rast__write_overview_level(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    char path[GPATH_MAX], key[32], value[32];
+    struct Key_Value *keys;
+
+    G_file_name_misc(path, "cell_misc", OVERVIEW_FILE, fcb->name,
+		     fcb->mapset);
+
+    keys = access(path, 0) == 0 ? G_read_key_value_file(path)
+	: G_create_key_value();
+
+    Rast__overview_element(key, fcb->overview, "");
+    sprintf(value, "%d %d", fcb->map_type == CELL_TYPE ? fcb->nbytes - 1 : -1,
+	    fcb->cellhd.compressed);
+    G_set_key_value(key, value, keys);
+
+    G_write_key_value_file(path, keys);
+    G_free_key_value(keys);
+}
+
+/*!
+   \brief Remove the overviews of a raster map
+
+   \param name name of a raster map in the current mapset
+ */
+void Rast_remove_overviews(const char *name)
+{
+    const char *mapset = G_mapset();
+    char path[GPATH_MAX], element[64];
+    struct Key_Value *keys;
+    int i;
+
+    G_file_name_misc(path, "cell_misc", OVERVIEW_FILE, name, mapset);
+    if (access(path, 0) != 0)
+	return;
+
+    keys = G_read_key_value_file(path);
+
+    for (i = 0; i < keys->nitems; i++) {
+	int factor;
+
+	if (sscanf(keys->key[i], "ovr%d", &factor) != 1)
+	    continue;
+
+	Rast__overview_element(element, factor, "");
+	G_remove_misc("cell_misc", element, name);
+	Rast__overview_element(element, factor, ".null");
+	G_remove_misc("cell_misc", element, name);
+	Rast__overview_element(element, factor, ".nullcmpr");
+	G_remove_misc("cell_misc", element, name);
+    }
+
+    G_free_key_value(keys);
+
+    G_remove_misc("cell_misc", OVERVIEW_FILE, name);
+}
+
+/* the value of the cell at the center of each block, which is what
+   reading the map in the region of the overview returns */
+static void build_nearest(const char *name, const char *mapset,
+			  RASTER_MAP_TYPE map_type,
+			  struct Cell_head *hd, int factor)
+{
+    int in_fd, out_fd, row;
+    void *buf;
+
+    Rast_set_input_window(hd);
+    Rast_set_output_window(hd);
+
+    in_fd = Rast_open_old(name, mapset);
+    out_fd = Rast__open_overview_new(name, factor, map_type);
+    buf = Rast_allocate_input_buf(map_type);
+
+    for (row = 0; row < hd->rows; row++) {
+	G_percent(row, hd->rows, 2);
+	Rast_get_row_nomask(in_fd, buf, row, map_type);
+	Rast_put_row(out_fd, buf, map_type);
+    }
+    G_percent(row, hd->rows, 2);
+
+    G_free(buf);
+    Rast_close(in_fd);
+    Rast_close(out_fd);
+}
+
+/* the average of the non-null cells of each block, rounded for CELL
+   maps */
+static void build_average(const char *name, const char *mapset,
+			  RASTER_MAP_TYPE map_type,
+			  struct Cell_head *cellhd, struct Cell_head *hd,
+			  int factor)
+{
+    int in_fd, out_fd, row, col;
+    DCELL *in, *out, *sum;
+    int *count;
+
+    Rast_set_input_window(cellhd);
+    Rast_set_output_window(hd);
+
+    in_fd = Rast_open_old(name, mapset);
+    out_fd = Rast__open_overview_new(name, factor, map_type);
+
+    in = Rast_allocate_d_input_buf();
+    out = Rast_allocate_d_output_buf();
+    sum = G_calloc(hd->cols, sizeof(DCELL));
+    count = G_calloc(hd->cols, sizeof(int));
+
+    for (row = 0; row < cellhd->rows; row++) {
+	G_percent(row, cellhd->rows, 2);
+
+	Rast_get_d_row_nomask(in_fd, in, row);
+
+	for (col = 0; col < cellhd->cols; col++) {
+	    if (Rast_is_d_null_value(&in[col]))
+		continue;
+	    sum[col / factor] += in[col];
+	    count[col / factor]++;
+	}
+
+	if ((row + 1) % factor != 0 && row < cellhd->rows - 1)
+	    continue;
+
+	for (col = 0; col < hd->cols; col++) {
+	    if (count[col] == 0)
+		Rast_set_d_null_value(&out[col], 1);
+	    else if (map_type == CELL_TYPE)
+		out[col] = floor(sum[col] / count[col] + 0.5);
+	    else
+		out[col] = sum[col] / count[col];
+	    sum[col] = 0;
+	    count[col] = 0;
+	}
+
+	Rast_put_d_row(out_fd, out);
+    }
+    G_percent(row, cellhd->rows, 2);
+
+    G_free(in);
+    G_free(out);
+    G_free(sum);
+    G_free(count);
+    Rast_close(in_fd);
+    Rast_close(out_fd);
+}
+
+/*!
+   \brief Build the overviews of a raster map
+
+   Existing overviews of the map are replaced. Each level is computed
+   from the map itself; the region and the MASK do not apply. The
+   region is restored when done, but no raster maps may be open while
+   the overviews are built.
+
+   With OVERVIEW_NEAREST a cell of an overview is the cell at the
+   center of its block of the map, i.e. reading an overview gives the
+   same values as reading the map itself in the region of the overview.
+   OVERVIEW_AVERAGE averages the non-null cells of the block (rounded
+   for CELL maps), which suits continuous data such as elevation.
+
+   \param name name of a raster map in the current mapset
+   \param factors decimation factors of the levels, e.g. 2, 4, 8, 16
+   \param count number of factors
+   \param method OVERVIEW_NEAREST or OVERVIEW_AVERAGE
+ */
+void Rast_build_overviews(const char *name, const int *factors, int count,
+			  int method)
+{
+    const char *mapset = G_mapset();
+    char rname[GNAME_MAX], rmapset[GMAPSET_MAX];
+    char path[GPATH_MAX], levels[1024];
+    struct Cell_head cellhd, hd, rd_window, wr_window;
+    int split_window, use_overviews;
+    RASTER_MAP_TYPE map_type;
+    struct Key_Value *keys;
+    int i;
+
+    Rast__init();
+
+    if (!G_find_raster2(name, mapset))
+	G_fatal_error(_("Raster map <%s> not found in current mapset"),
+		      name);
+
+    if (Rast_is_reclass(name, mapset, rname, rmapset) > 0)
+	G_fatal_error(_("Raster map <%s> is a reclass of another map, "
+			"build the overviews of <%s@%s>"),
+		      name, rname, rmapset);
+
+    if (G_find_file2_misc("cell_misc", "gdal", name, mapset) ||
+	G_find_file2_misc("cell_misc", "vrt", name, mapset))
+	G_fatal_error(_("Overviews of linked or virtual raster map <%s> "
+			"are not supported"), name);
+
+    Rast_remove_overviews(name);
+
+    Rast_get_cellhd(name, mapset, &cellhd);
+    map_type = Rast_map_type(name, mapset);
+
+    rd_window = R__.rd_window;
+    wr_window = R__.wr_window;
+    split_window = R__.split_window;
+    use_overviews = R__.use_overviews;
+
+    /* levels are built from the map itself */
+    R__.use_overviews = 0;
+
+    *levels = '\0';
+    for (i = 0; i < count; i++) {
+	int factor = factors[i];
+
+	if (factor < 2)
+	    G_fatal_error(_("Invalid overview factor %d"), factor);
+
+	overview_cellhd(&cellhd, factor, &hd);
+
+	G_message(_("Building overview 1:%d of <%s> (%d rows, %d columns)..."),
+		  factor, name, hd.rows, hd.cols);
+
+	if (method == OVERVIEW_AVERAGE)
+	    build_average(name, mapset, map_type, &cellhd, &hd, factor);
+	else
+	    build_nearest(name, mapset, map_type, &hd, factor);
+
+	sprintf(levels + strlen(levels), "%s%d", *levels ? " " : "", factor);
+    }
+
+    Rast_set_input_window(&rd_window);
+    Rast_set_output_window(&wr_window);
+    R__.split_window = split_window;
+    R__.use_overviews = use_overviews;
+
+    if (!*levels)
+	return;
+
+    /* the levels are listed last, so that partly built overviews are
+       never read */
+    G_file_name_misc(path, "cell_misc", OVERVIEW_FILE, name, mapset);
+    keys = G_read_key_value_file(path);
+    G_set_key_value("method",
+		    method == OVERVIEW_AVERAGE ? "average" : "nearest", keys);
+    G_set_key_value("levels", levels, keys);
+    G_write_key_value_file(path, keys);
+    G_free_key_value(keys);
+}
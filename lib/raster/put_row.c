@@ -64,7 +64,10 @@ static void put_raster_row(int, const void *, RASTER_MAP_TYPE, int);
  */
 void Rast_put_row(int fd, const void *buf, RASTER_MAP_TYPE data_type)
 {
+    double t = G_trace_begin();
+
     put_raster_row(fd, buf, data_type, 0);
+    G_trace_end("raster", "Rast_put_row", t);
 }
 
 /*!
@@ -122,94 +125,18 @@ static void write_data(int fd, int row, unsigned char *buf, int n)
 		      row, fcb->name, strerror(errno));
 }
 
-static void write_data_compressed(int fd, int row, unsigned char *buf, int n, int compressor)
-{
-    struct fileinfo *fcb = &R__.fileinfo[fd];
-    int nwrite = fcb->nbytes * n;
-
-    if (G_write_compressed(fcb->data_fd, buf, nwrite, compressor) < 0)
-	G_fatal_error(_("Error writing compressed FP data for row %d of <%s>: %s"),
-		      row, fcb->name, strerror(errno));
-}
-
-static void set_file_pointer(int fd, int row)
-{
-    struct fileinfo *fcb = &R__.fileinfo[fd];
-
-    fcb->row_ptr[row] = lseek(fcb->data_fd, 0L, SEEK_CUR);
-}
-
 static void convert_float(float *work_buf, int size, char *null_buf,
 			  const FCELL *rast, int row, int n)
 {
-    int i;
-
-    for (i = 0; i < n; i++) {
-	FCELL f;
-
-	/* substitute embedded null vals by 0's */
-	if (Rast_is_f_null_value(&rast[i])) {
-	    f = 0.;
-	    null_buf[i] = 1;
-	}
-	else
-	    f = rast[i];
-
-	G_xdr_put_float(&work_buf[i], &f);
-    }
+    /* substitute embedded null vals by 0's */
+    Rast__xdr_put_f_row(work_buf, rast, null_buf, n);
 }
 
 static void convert_double(double *work_buf, int size, char *null_buf,
 			   const DCELL *rast, int row, int n)
 {
-    int i;
-
-    for (i = 0; i < n; i++) {
-	DCELL d;
-
-	/* substitute embedded null vals by 0's */
-	if (Rast_is_d_null_value(&rast[i])) {
-	    d = 0.;
-	    null_buf[i] = 1;
-	}
-	else
-	    d = rast[i];
-
-	G_xdr_put_double(&work_buf[i], &d);
-    }
-}
-
-/* writes data to fcell file for either full or partial rows */
-static void put_fp_data(int fd, char *null_buf, const void *rast,
-			int row, int n, RASTER_MAP_TYPE data_type)
-{
-    struct fileinfo *fcb = &R__.fileinfo[fd];
-    int compressed = (fcb->open_mode == OPEN_NEW_COMPRESSED);
-    int size = fcb->nbytes * fcb->cellhd.cols;
-    void *work_buf;
-
-    if (row < 0 || row >= fcb->cellhd.rows)
-	return;
-
-    if (n <= 0)
-	return;
-
-    work_buf = G_malloc(size + 1);
-
-    if (compressed)
-	set_file_pointer(fd, row);
-
-    if (data_type == FCELL_TYPE)
-	convert_float(work_buf, size, null_buf, rast, row, n);
-    else
-	convert_double(work_buf, size, null_buf, rast, row, n);
-
-    if (compressed)
-	write_data_compressed(fd, row, work_buf, n, fcb->cellhd.compressed);
-    else
-	write_data(fd, row, work_buf, n);
-
-    G_free(work_buf);
+    /* substitute embedded null vals by 0's */
+    Rast__xdr_put_d_row(work_buf, rast, null_buf, n);
 }
 
 static void convert_int(unsigned char *wk, char *null_buf, const CELL * rast,
@@ -325,13 +252,346 @@ static int rle_compress(unsigned char *dst, unsigned char *src, int n,
     return (nwrite >= total) ? 0 : nwrite;
 }
 
+/* Rows of compressed maps are queued: they are compressed on the worker
+   threads of the GIS library (see G_begin_execute()) and written in
+   order by the calling thread, which also fills in the row pointers.
+   Without worker threads every row is written as soon as it is queued. */
+
+#define PUT_CELL 0
+#define PUT_FP   1
+#define PUT_NULL 2
+
+struct put_slot			/* One row waiting to be written */
+{
+    int kind;			/* PUT_CELL, PUT_FP or PUT_NULL */
+    int row;			/* row number                   */
+    int compressor;		/* compression method           */
+    int nbytes;			/* bytes per cell for PUT_CELL  */
+    unsigned char *buf;		/* converted row                */
+    size_t size;		/* bytes in buf                 */
+    size_t buf_size;		/* allocated size of buf        */
+    unsigned char *out;		/* header byte + compressed row */
+    size_t out_size;		/* allocated size of out        */
+    ssize_t nwrite;		/* bytes in out, 0 to write buf */
+    void *worker;		/* worker reference             */
+};
+
+struct R_write_queue
+{
+    int nslots;			/* size of the ring             */
+    int first;			/* oldest queued row            */
+    int count;			/* number of queued rows        */
+    struct put_slot *slots;
+};
+
+static void compress_slot(void *closure)
+{
+    struct put_slot *s = closure;
+    int cmax = s->out_size - 1;
+    int nwrite;
+
+    switch (s->kind) {
+    case PUT_CELL:
+	s->out[0] = s->nbytes;
+	if (s->compressor == 1)
+	    nwrite = rle_compress(s->out + 1, s->buf, s->size / s->nbytes,
+				  s->nbytes);
+	else
+	    nwrite = G_compress(s->buf, s->size, s->out + 1, cmax,
+				s->compressor);
+	break;
+    case PUT_FP:
+	s->out[0] = '1';
+	nwrite = G_compress(s->buf, s->size, s->out + 1, cmax, s->compressor);
+	break;
+    default:
+	/* compress null bits file with LZ4, see lib/gis/compress.h */
+	nwrite = G_compress(s->buf, s->size, s->out, cmax + 1, 3);
+	break;
+    }
+
+    /* rows which do not get smaller are written uncompressed */
+    if (nwrite > 0 && nwrite < s->size)
+	s->nwrite = (s->kind == PUT_NULL) ? nwrite : nwrite + 1;
+    else
+	s->nwrite = 0;
+}
+
+static void write_slot(int fd, struct put_slot *s)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    int out_fd = (s->kind == PUT_NULL) ? fcb->null_fd : fcb->data_fd;
+    off_t *row_ptr = (s->kind == PUT_NULL) ? fcb->null_row_ptr : fcb->row_ptr;
+    int ok;
+
+    G_end_execute(&s->worker);
+
+    row_ptr[s->row] = lseek(out_fd, 0L, SEEK_CUR);
+
+    if (s->nwrite > 0)
+	ok = (write(out_fd, s->out, s->nwrite) == s->nwrite);
+    else {
+	/* header byte (if any) followed by the uncompressed row */
+	if (s->kind == PUT_FP)
+	    s->out[0] = '0';
+	ok = (s->kind == PUT_NULL || write(out_fd, s->out, 1) == 1) &&
+	    write(out_fd, s->buf, s->size) == s->size;
+    }
+
+    if (ok)
+	return;
+
+    switch (s->kind) {
+    case PUT_CELL:
+	G_fatal_error(_("Error writing compressed data for row %d of <%s>"),
+		      s->row, fcb->name);
+	break;
+    case PUT_FP:
+	G_fatal_error(_("Error writing compressed FP data for row %d of <%s>: %s"),
+		      s->row, fcb->name, strerror(errno));
+	break;
+    default:
+	G_fatal_error(_("Error writing compressed null data for row %d of <%s>"),
+		      s->row, fcb->name);
+	break;
+    }
+}
+
+static void write_oldest(int fd)
+{
+    struct R_write_queue *wq = R__.fileinfo[fd].write_queue;
+    struct put_slot *s = &wq->slots[wq->first];
+
+    /* dequeue first, write_slot() may not return */
+    wq->first = (wq->first + 1) % wq->nslots;
+    wq->count--;
+
+    write_slot(fd, s);
+}
+
+/* get a free slot for a row of at most size bytes */
+static struct put_slot *get_slot(int fd, int kind, int row, size_t size)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct R_write_queue *wq = fcb->write_queue;
+    struct put_slot *s;
+    size_t cmax;
+
+    if (!wq) {
+	int workers = Rast__num_workers();
+
+	wq = fcb->write_queue = G_malloc(sizeof(struct R_write_queue));
+	/* enough rows to keep all workers busy while one is written */
+	wq->nslots = workers > 0 ? 2 * workers : 1;
+	wq->first = 0;
+	wq->count = 0;
+	wq->slots = G_calloc(wq->nslots, sizeof(struct put_slot));
+    }
+
+    if (wq->count == wq->nslots)
+	write_oldest(fd);
+
+    s = &wq->slots[(wq->first + wq->count) % wq->nslots];
+
+    s->kind = kind;
+    s->row = row;
+    s->compressor = (kind == PUT_NULL) ? 3 : fcb->cellhd.compressed;
+
+    if (s->buf_size < size) {
+	s->buf = G_realloc(s->buf, size);
+	s->buf_size = size;
+    }
+
+    /* get upper bound of compressed size */
+    if (s->compressor == 1)
+	cmax = size;
+    else
+	cmax = G_compress_bound(size, s->compressor);
+
+    if (s->out_size < cmax + 1) {
+	s->out = G_realloc(s->out, cmax + 1);
+	s->out_size = cmax + 1;
+    }
+
+    return s;
+}
+
+/* hand a filled slot to the workers */
+static void queue_slot(int fd, struct put_slot *s)
+{
+    struct R_write_queue *wq = R__.fileinfo[fd].write_queue;
+
+    wq->count++;
+
+    G_begin_execute(compress_slot, s, &s->worker, 0);
+
+    if (wq->nslots == 1)
+	write_oldest(fd);
+}
+
+/*!
+   \brief Write all queued rows of a map
+
+   Waits for the rows being compressed and writes them in order, so that
+   the row pointers of the data and null files are complete.
+
+   \param fd file descriptor
+ */
+void Rast__flush_put_rows(int fd)
+{
+    struct R_write_queue *wq = R__.fileinfo[fd].write_queue;
+
+    while (wq && wq->count > 0)
+	write_oldest(fd);
+}
+
+/*!
+   \brief Free the write queue of a map
+
+   Queued rows which have not been written with Rast__flush_put_rows()
+   are discarded.
+
+   \param fd file descriptor
+ */
+void Rast__free_put_rows(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct R_write_queue *wq = fcb->write_queue;
+    int i;
+
+    if (!wq)
+	return;
+
+    for (i = 0; i < wq->nslots; i++) {
+	G_end_execute(&wq->slots[i].worker);
+	G_free(wq->slots[i].buf);
+	G_free(wq->slots[i].out);
+    }
+
+    G_free(wq->slots);
+    G_free(wq);
+    fcb->write_queue = NULL;
+}
+
+/* Tiled maps (see tile.c): the rows of a row of tiles are converted into
+   fcb->tile_buf, len bytes per cell. Once the last row of the strip has
+   been put, each tile is gathered into a slot of its own and queued, so
+   that tiles are compressed on the workers just like rows. */
+
+static unsigned char *get_strip_row(int fd, int row, int len)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    size_t size = (size_t) fcb->cellhd.cols * len;
+
+    if (!fcb->tile_buf)
+	fcb->tile_buf = G_malloc(fcb->tile_rows * size);
+
+    return fcb->tile_buf + (row % fcb->tile_rows) * size;
+}
+
+static void put_tiles(int fd, int kind, int row, int len)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    int ntcols = Rast__tile_cols(fd);
+    int trow = row / fcb->tile_rows;
+    int nrows = row % fcb->tile_rows + 1;
+    int tcol;
+
+    /* wait for the last row of the strip */
+    if (nrows < fcb->tile_rows && row < fcb->cellhd.rows - 1)
+	return;
+
+    for (tcol = 0; tcol < ntcols; tcol++) {
+	int col = tcol * fcb->tile_cols;
+	int ncols = fcb->cellhd.cols - col;
+	struct put_slot *s;
+	int n, r;
+
+	if (ncols > fcb->tile_cols)
+	    ncols = fcb->tile_cols;
+	n = nrows * ncols;
+
+	s = get_slot(fd, kind, trow * ntcols + tcol, (size_t) n * len);
+
+	for (r = 0; r < nrows; r++)
+	    memcpy(s->buf + (size_t) r * ncols * len,
+		   fcb->tile_buf + ((size_t) r * fcb->cellhd.cols + col) * len,
+		   (size_t) ncols * len);
+
+	if (kind == PUT_CELL) {
+	    int nbytes = count_bytes(s->buf, n, len);
+
+	    if (fcb->nbytes < nbytes)
+		fcb->nbytes = nbytes;
+
+	    if (nbytes < len)
+		trim_bytes(s->buf, n, len, len - nbytes);
+
+	    s->nbytes = nbytes;
+	    s->size = (size_t) nbytes * n;
+	}
+	else
+	    s->size = (size_t) n * len;
+
+	queue_slot(fd, s);
+    }
+}
+
+/* writes data to fcell file for either full or partial rows */
+static void put_fp_data(int fd, char *null_buf, const void *rast,
+			int row, int n, RASTER_MAP_TYPE data_type)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    int compressed = (fcb->open_mode == OPEN_NEW_COMPRESSED);
+    int size = fcb->nbytes * fcb->cellhd.cols;
+    struct put_slot *s = NULL;
+    void *work_buf;
+
+    if (row < 0 || row >= fcb->cellhd.rows)
+	return;
+
+    if (n <= 0)
+	return;
+
+    if (compressed && fcb->tile_rows > 0) {
+	work_buf = get_strip_row(fd, row, fcb->nbytes);
+	if (data_type == FCELL_TYPE)
+	    convert_float(work_buf, size, null_buf, rast, row, n);
+	else
+	    convert_double(work_buf, size, null_buf, rast, row, n);
+	put_tiles(fd, PUT_FP, row, fcb->nbytes);
+	return;
+    }
+
+    if (compressed) {
+	s = get_slot(fd, PUT_FP, row, size);
+	work_buf = s->buf;
+    }
+    else
+	work_buf = G_malloc(size + 1);
+
+    if (data_type == FCELL_TYPE)
+	convert_float(work_buf, size, null_buf, rast, row, n);
+    else
+	convert_double(work_buf, size, null_buf, rast, row, n);
+
+    if (compressed) {
+	s->size = fcb->nbytes * n;
+	queue_slot(fd, s);
+    }
+    else {
+	write_data(fd, row, work_buf, n);
+	G_free(work_buf);
+    }
+}
+
 static void put_data(int fd, char *null_buf, const CELL * cell,
 		     int row, int n, int zeros_r_nulls)
 {
     struct fileinfo *fcb = &R__.fileinfo[fd];
     int compressed = (fcb->open_mode == OPEN_NEW_COMPRESSED);
     int len = compressed ? sizeof(CELL) : fcb->nbytes;
-    unsigned char *work_buf, *wk;
+    unsigned char *work_buf;
     ssize_t nwrite;
 
     if (row < 0 || row >= fcb->cellhd.rows)
@@ -340,73 +600,44 @@ static void put_data(int fd, char *null_buf, const CELL * cell,
     if (n <= 0)
 	return;
 
-    work_buf = G_malloc(fcb->cellhd.cols * sizeof(CELL) + 1);
-    wk = work_buf;
-
-    if (compressed)
-	set_file_pointer(fd, row);
-
-    if (compressed)
-	wk++;
-
-    convert_int(wk, null_buf, cell, n, len, zeros_r_nulls);
+    if (compressed && fcb->tile_rows > 0) {
+	work_buf = get_strip_row(fd, row, len);
+	convert_int(work_buf, null_buf, cell, n, len, zeros_r_nulls);
+	put_tiles(fd, PUT_CELL, row, len);
+	return;
+    }
 
     if (compressed) {
-	int nbytes = count_bytes(wk, n, len);
-	unsigned char *compressed_buf;
-	int total, cmax;
+	struct put_slot *s = get_slot(fd, PUT_CELL, row, n * sizeof(CELL));
+	int nbytes;
 
+	convert_int(s->buf, null_buf, cell, n, len, zeros_r_nulls);
+
+	nbytes = count_bytes(s->buf, n, len);
 	if (fcb->nbytes < nbytes)
 	    fcb->nbytes = nbytes;
 
 	/* first trim away zero high bytes */
 	if (nbytes < len)
-	    trim_bytes(wk, n, len, len - nbytes);
-
-	total = nbytes * n;
-	/* get upper bound of compressed size */
-	if (fcb->cellhd.compressed == 1)
-	    cmax = total;
-	else
-	    cmax = G_compress_bound(total, fcb->cellhd.compressed);
-	compressed_buf = G_malloc(cmax + 1);
-
-	compressed_buf[0] = work_buf[0] = nbytes;
+	    trim_bytes(s->buf, n, len, len - nbytes);
 
 	/* then compress the data */
-	if (fcb->cellhd.compressed == 1)
-	    nwrite = rle_compress(compressed_buf + 1, work_buf + 1, n, nbytes);
-	else {
-	    nwrite = G_compress(work_buf + 1, total, compressed_buf + 1, cmax,
-	                        fcb->cellhd.compressed);
-	}
+	s->nbytes = nbytes;
+	s->size = nbytes * n;
+	queue_slot(fd, s);
 
-	if (nwrite >= total)
-	    nwrite = 0;
+	return;
+    }
 
-	if (nwrite > 0) {
-	    nwrite++;
+    work_buf = G_malloc(fcb->cellhd.cols * sizeof(CELL) + 1);
 
-	    if (write(fcb->data_fd, compressed_buf, nwrite) != nwrite)
-		G_fatal_error(_("Error writing compressed data for row %d of <%s>"),
-			      row, fcb->name);
-	}
-	else {
-	    nwrite = nbytes * n + 1;
-	    if (write(fcb->data_fd, work_buf, nwrite) != nwrite)
-		G_fatal_error(_("Error writing compressed data for row %d of <%s>"),
-			      row, fcb->name);
-	}
+    convert_int(work_buf, null_buf, cell, n, len, zeros_r_nulls);
 
-	G_free(compressed_buf);
-    }
-    else {
-	nwrite = fcb->nbytes * n;
+    nwrite = fcb->nbytes * n;
 
-	if (write(fcb->data_fd, work_buf, nwrite) != nwrite)
-	    G_fatal_error(_("Error writing uncompressed data for row %d of <%s>"),
-			  row, fcb->name);
-    }
+    if (write(fcb->data_fd, work_buf, nwrite) != nwrite)
+	G_fatal_error(_("Error writing uncompressed data for row %d of <%s>"),
+		      row, fcb->name);
 
     G_free(work_buf);
 }
@@ -502,32 +733,11 @@ static void put_null_value_row(int fd, const char *flags)
 static void write_null_bits_compressed(const unsigned char *flags,
 				       int row, size_t size, int fd)
 {
-    struct fileinfo *fcb = &R__.fileinfo[fd];
-    unsigned char *compressed_buf;
-    ssize_t nwrite;
-    size_t cmax;
-
-    fcb->null_row_ptr[row] = lseek(fcb->null_fd, 0L, SEEK_CUR);
+    struct put_slot *s = get_slot(fd, PUT_NULL, row, size);
 
-    /* get upper bound of compressed size */
-    cmax = G_compress_bound(size, 3);
-    compressed_buf = G_malloc(cmax);
-
-    /* compress null bits file with LZ4, see lib/gis/compress.h */
-    nwrite = G_compress(flags, size, compressed_buf, cmax, 3);
-
-    if (nwrite > 0 && nwrite < size) {
-	if (write(fcb->null_fd, compressed_buf, nwrite) != nwrite)
-	    G_fatal_error(_("Error writing compressed null data for row %d of <%s>"),
-			  row, fcb->name);
-    }
-    else {
-	if (write(fcb->null_fd, flags, size) != size)
-	    G_fatal_error(_("Error writing compressed null data for row %d of <%s>"),
-			  row, fcb->name);
-    }
-
-    G_free(compressed_buf);
+    memcpy(s->buf, flags, size);
+    s->size = size;
+    queue_slot(fd, s);
 }
 
 /*!
@@ -565,96 +775,60 @@ void Rast__write_null_bits(int fd, const unsigned char *flags)
 
 static void convert_and_write_if(int fd, const void *vbuf)
 {
-    const CELL *buf = vbuf;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     FCELL *p = (FCELL *) fcb->data;
-    int i;
 
-    for (i = 0; i < fcb->cellhd.cols; i++)
-	if (Rast_is_c_null_value(&buf[i]))
-	    Rast_set_f_null_value(&p[i], 1);
-	else
-	    p[i] = (FCELL) buf[i];
+    Rast__convert_row(p, FCELL_TYPE, vbuf, CELL_TYPE, fcb->cellhd.cols);
 
     Rast_put_f_row(fd, p);
 }
 
 static void convert_and_write_df(int fd, const void *vbuf)
 {
-    const DCELL *buf = vbuf;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     FCELL *p = (FCELL *) fcb->data;
-    int i;
 
-    for (i = 0; i < fcb->cellhd.cols; i++)
-	if (Rast_is_d_null_value(&buf[i]))
-	    Rast_set_f_null_value(&p[i], 1);
-	else
-	    p[i] = (FCELL) buf[i];
+    Rast__convert_row(p, FCELL_TYPE, vbuf, DCELL_TYPE, fcb->cellhd.cols);
 
     Rast_put_f_row(fd, p);
 }
 
 static void convert_and_write_id(int fd, const void *vbuf)
 {
-    const CELL *buf = vbuf;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     DCELL *p = (DCELL *) fcb->data;
-    int i;
 
-    for (i = 0; i < fcb->cellhd.cols; i++)
-	if (Rast_is_c_null_value(&buf[i]))
-	    Rast_set_d_null_value(&p[i], 1);
-	else
-	    p[i] = (DCELL) buf[i];
+    Rast__convert_row(p, DCELL_TYPE, vbuf, CELL_TYPE, fcb->cellhd.cols);
 
     Rast_put_d_row(fd, p);
 }
 
 static void convert_and_write_fd(int fd, const void *vbuf)
 {
-    const FCELL *buf = vbuf;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     DCELL *p = (DCELL *) fcb->data;
-    int i;
 
-    for (i = 0; i < fcb->cellhd.cols; i++)
-	if (Rast_is_f_null_value(&buf[i]))
-	    Rast_set_d_null_value(&p[i], 1);
-	else
-	    p[i] = (DCELL) buf[i];
+    Rast__convert_row(p, DCELL_TYPE, vbuf, FCELL_TYPE, fcb->cellhd.cols);
 
     Rast_put_d_row(fd, p);
 }
 
 static void convert_and_write_fi(int fd, const void *vbuf)
 {
-    const FCELL *buf = vbuf;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     CELL *p = (CELL *) fcb->data;
-    int i;
 
-    for (i = 0; i < fcb->cellhd.cols; i++)
-	if (Rast_is_f_null_value(&buf[i]))
-	    Rast_set_c_null_value(&p[i], 1);
-	else
-	    p[i] = (CELL) buf[i];
+    Rast__convert_row(p, CELL_TYPE, vbuf, FCELL_TYPE, fcb->cellhd.cols);
 
     Rast_put_c_row(fd, p);
 }
 
 static void convert_and_write_di(int fd, const void *vbuf)
 {
-    const DCELL *buf = vbuf;
     struct fileinfo *fcb = &R__.fileinfo[fd];
     CELL *p = (CELL *) fcb->data;
-    int i;
 
-    for (i = 0; i < fcb->cellhd.cols; i++)
-	if (Rast_is_d_null_value(&buf[i]))
-	    Rast_set_c_null_value(&p[i], 1);
-	else
-	    p[i] = (CELL) buf[i];
+    Rast__convert_row(p, CELL_TYPE, vbuf, DCELL_TYPE, fcb->cellhd.cols);
 
     Rast_put_c_row(fd, p);
 }
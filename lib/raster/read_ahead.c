@@ -0,0 +1,250 @@
+/*!
+   \file lib/raster/read_ahead.c
+
+   \brief Raster library - Background read-ahead of raster rows
+
+   Most modules read the rows of their input maps in order. When
+   read-ahead is enabled for a map, a sequential scan is detected and
+   the following rows are read, decompressed and resampled on the
+   worker threads of the GIS library (see G_begin_execute()), so that
+   Rast_get_row() only has to copy an already decoded row.
+
+   (C) 2026 by the GRASS Development Team
+
+   This program is free software under the GNU General Public License
+   (>=v2).  Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <string.h>
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/glocale.h>
+
+#include "R.h"
+
+struct prefetch			/* One row decoded in the background */
+{
+    int row;			/* window row, -1 if empty      */
+    RASTER_MAP_TYPE data_type;	/* type of the decoded row      */
+    int with_mask;		/* MASK applied to the row      */
+    void *buf;			/* decoded row                  */
+    struct R_read_ctx *ctx;	/* reader used by the worker    */
+    void *worker;		/* worker reference             */
+};
+
+struct R_read_ahead
+{
+    int nrows;			/* number of rows to prefetch   */
+    int last_row;		/* last row requested           */
+    struct prefetch *slots;	/* allocated on first sequential read */
+};
+
+static void prefetch_row(void *closure)
+{
+    struct prefetch *p = closure;
+
+    if (p->with_mask)
+	Rast_get_row_ctx(p->ctx, p->buf, p->row, p->data_type);
+    else
+	Rast_get_row_nomask_ctx(p->ctx, p->buf, p->row, p->data_type);
+}
+
+static void schedule_row(int fd, struct R_read_ahead *ra, int row,
+			 RASTER_MAP_TYPE data_type, int with_mask)
+{
+    struct prefetch *p = &ra->slots[row % ra->nrows];
+
+    if (p->row == row && p->data_type == data_type &&
+	p->with_mask == with_mask)
+	return;
+
+    G_end_execute(&p->worker);
+
+    if (!p->ctx) {
+	p->ctx = Rast_create_read_ctx(fd);
+	p->buf = G_malloc(R__.rd_window.cols * sizeof(DCELL));
+    }
+
+    p->row = row;
+    p->data_type = data_type;
+    p->with_mask = with_mask;
+
+    G_begin_execute(prefetch_row, p, &p->worker, 0);
+}
+
+/*!
+   \brief Enable background read-ahead for a raster map
+
+   When the rows of the map are requested in sequential order, the next
+   <i>nrows</i> rows are decoded on the worker threads while the caller
+   processes the current one. Read-ahead only has an effect if worker
+   threads are available, i.e. the WORKERS environment variable is set
+   to a positive number. It is enabled for all maps opened with
+   Rast_open_old() if GRASS_RASTER_READ_AHEAD is set to the number of
+   rows to prefetch.
+
+   Read-ahead only applies to Rast_get_row() and
+   Rast_get_row_nomask(); reads through a read context (see
+   Rast_create_read_ctx()) are not affected. Maps stored in tiles are
+   not read ahead, see Rast_set_tile_size().
+
+   \param fd file descriptor of a raster map opened for reading
+   \param nrows number of rows to prefetch, 0 to disable read-ahead
+ */
+void Rast_set_read_ahead(int fd, int nrows)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+    struct R_read_ahead *ra;
+
+    if (fcb->open_mode != OPEN_OLD)
+	G_fatal_error(_("Read-ahead can only be enabled for raster maps "
+			"opened for reading"));
+
+    Rast__free_read_ahead(fd);
+
+    if (nrows <= 0)
+	return;
+
+    if (Rast__num_workers() <= 0) {
+	G_debug(1, "No worker threads, read-ahead disabled for <%s@%s>",
+		fcb->name, fcb->mapset);
+	return;
+    }
+
+    /* the readers of the workers would each decode the same tiles */
+    if (fcb->tile_rows > 0) {
+	G_debug(1, "Tiled map, read-ahead disabled for <%s@%s>",
+		fcb->name, fcb->mapset);
+	return;
+    }
+
+    ra = G_malloc(sizeof(struct R_read_ahead));
+    ra->nrows = nrows;
+    ra->last_row = -2;
+    ra->slots = NULL;
+
+    fcb->read_ahead = ra;
+
+    G_debug(2, "Read-ahead of %d rows for <%s@%s>", nrows, fcb->name,
+	    fcb->mapset);
+}
+
+/*!
+   \brief Get a row decoded in the background
+
+   Must only be called by get_map_row() for the default reader of a map
+   with read-ahead enabled. Detects sequential access and schedules the
+   following rows.
+
+   \param fd file descriptor
+   \param buf buffer for the row
+   \param row window row
+   \param data_type requested data type
+   \param with_mask whether the MASK is applied
+
+   \return 1 if the row was copied into buf
+   \return 0 if it has to be read by the caller
+ */
+int Rast__read_ahead_get(int fd, void *buf, int row,
+			 RASTER_MAP_TYPE data_type, int with_mask)
+{
+    struct R_read_ahead *ra = R__.fileinfo[fd].read_ahead;
+    int sequential = (row == ra->last_row + 1);
+    int found = 0;
+    int r;
+
+    ra->last_row = row;
+
+    if (!ra->slots) {
+	if (!sequential)
+	    return 0;
+
+	ra->slots = G_calloc(ra->nrows, sizeof(struct prefetch));
+	for (r = 0; r < ra->nrows; r++)
+	    ra->slots[r].row = -1;
+    }
+    else {
+	struct prefetch *p = &ra->slots[row % ra->nrows];
+
+	if (p->row == row && p->data_type == data_type &&
+	    p->with_mask == with_mask) {
+	    G_end_execute(&p->worker);
+	    memcpy(buf, p->buf,
+		   R__.rd_window.cols * Rast_cell_size(data_type));
+	    p->row = -1;
+	    found = 1;
+	}
+    }
+
+    if (sequential) {
+	for (r = row + 1; r <= row + ra->nrows && r < R__.rd_window.rows;
+	     r++)
+	    schedule_row(fd, ra, r, data_type, with_mask);
+    }
+
+    return found;
+}
+
+/*!
+   \brief Discard the prefetched rows of a map
+
+   Waits for the rows being decoded and releases the readers. Must be
+   called whenever the state the rows depend on (window, MASK,
+   quantization rules) changes, or before the file descriptor table is
+   reallocated.
+
+   \param fd file descriptor
+ */
+void Rast__drop_read_ahead(int fd)
+{
+    struct R_read_ahead *ra = R__.fileinfo[fd].read_ahead;
+    int i;
+
+    if (!ra || !ra->slots)
+	return;
+
+    for (i = 0; i < ra->nrows; i++) {
+	struct prefetch *p = &ra->slots[i];
+
+	G_end_execute(&p->worker);
+	if (p->ctx) {
+	    Rast_free_read_ctx(p->ctx);
+	    G_free(p->buf);
+	}
+    }
+
+    G_free(ra->slots);
+    ra->slots = NULL;
+    ra->last_row = -2;
+}
+
+/*!
+   \brief Discard the prefetched rows of all open maps
+ */
+void Rast__drop_all_read_ahead(void)
+{
+    int i;
+
+    for (i = 0; i < R__.fileinfo_count; i++)
+	if (R__.fileinfo[i].open_mode == OPEN_OLD &&
+	    R__.fileinfo[i].read_ahead)
+	    Rast__drop_read_ahead(i);
+}
+
+/*!
+   \brief Free the read-ahead state of a map
+
+   \param fd file descriptor
+ */
+void Rast__free_read_ahead(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+
+    if (!fcb->read_ahead)
+	return;
+
+    Rast__drop_read_ahead(fd);
+    G_free(fcb->read_ahead);
+    fcb->read_ahead = NULL;
+}
@@ -134,6 +134,7 @@ static void update_window_mappings(void)
     }
 
     /* close the mask */
+    Rast__drop_mask_rows();
     if (R__.auto_mask > 0) {
 	Rast_close(maskfd);
 	/* G_free (R__.mask_buf); */
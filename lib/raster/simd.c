@@ -0,0 +1,1046 @@
+/*!
+   \file lib/raster/simd.c
+
+   \brief Raster library - Vectorized row kernels
+
+   Whole-row helpers for the conversions on the raster I/O path: XDR
+   encoding and decoding of floating point rows, decoding of CELL data
+   bytes, conversion between cell types, embedding of nulls and packing
+   and unpacking of null bitmaps. On x86 processors the SSE2 or AVX2
+   variant is chosen at run time according to the CPU (and to the
+   GRASS_RASTER_SIMD environment variable); elsewhere, or with
+   GRASS_RASTER_SIMD=none, the portable variant is used. All variants
+   give bitwise identical results.
+
+   (C) 2026 by the GRASS Development Team
+
+   This program is free software under the GNU General Public License
+   (>=v2).  Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/glocale.h>
+
+#include "R.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define X86_KERNELS
+#include <immintrin.h>
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+#endif
+
+#define CELL_NULL ((CELL) 0x80000000)
+
+static struct
+{
+    void (*put_f) (unsigned char *, const FCELL *, char *, int);
+    void (*put_d) (unsigned char *, const DCELL *, char *, int);
+    void (*get_f) (FCELL *, const unsigned char *, int);
+    void (*get_d) (DCELL *, const unsigned char *, int);
+    void (*get_c) (CELL *, const unsigned char *, int, int);
+    void (*convert) (void *, RASTER_MAP_TYPE, const void *, RASTER_MAP_TYPE,
+		     int);
+    void (*embed) (void *, const char *, int, RASTER_MAP_TYPE, int);
+    void (*pack) (unsigned char *, const char *, int);
+} kernel;
+
+static int initialized;
+
+/* bit reversal of a byte, and the 0/1 flags of the bits of a byte */
+static unsigned char reverse_bits[256];
+static unsigned char bit_flags[256][8];
+
+/*--------------------------------------------------------------------------*/
+
+/* portable variants */
+
+static void put_f_c(unsigned char *dst, const FCELL * src, char *nulls,
+		    int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	FCELL f = src[i];
+
+	/* substitute embedded null vals by 0's */
+	if (Rast_is_f_null_value(&f)) {
+	    f = 0.;
+	    nulls[i] = 1;
+	}
+
+	G_xdr_put_float(dst + i * XDR_FLOAT_NBYTES, &f);
+    }
+}
+
+static void put_d_c(unsigned char *dst, const DCELL * src, char *nulls,
+		    int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	DCELL d = src[i];
+
+	/* substitute embedded null vals by 0's */
+	if (Rast_is_d_null_value(&d)) {
+	    d = 0.;
+	    nulls[i] = 1;
+	}
+
+	G_xdr_put_double(dst + i * XDR_DOUBLE_NBYTES, &d);
+    }
+}
+
+static void get_f_c(FCELL * dst, const unsigned char *src, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+	G_xdr_get_float(&dst[i], src + i * XDR_FLOAT_NBYTES);
+}
+
+static void get_d_c(DCELL * dst, const unsigned char *src, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+	G_xdr_get_double(&dst[i], src + i * XDR_DOUBLE_NBYTES);
+}
+
+static void get_c_c(CELL * dst, const unsigned char *src, int nbytes, int n)
+{
+    int big = (size_t) nbytes >= sizeof(CELL);
+    int i, j;
+
+    for (i = 0; i < n; i++) {
+	const unsigned char *d = src + i * nbytes;
+	int neg;
+	CELL v;
+
+	if (big && (*d & 0x80)) {
+	    neg = 1;
+	    v = *d++ & 0x7f;
+	}
+	else {
+	    neg = 0;
+	    v = *d++;
+	}
+
+	for (j = 1; j < nbytes; j++)
+	    v = (v << 8) + *d++;
+
+	dst[i] = neg ? -v : v;
+    }
+}
+
+static void convert_c(void *dst, RASTER_MAP_TYPE dst_type, const void *src,
+		      RASTER_MAP_TYPE src_type, int n)
+{
+    size_t dst_size = Rast_cell_size(dst_type);
+    size_t src_size = Rast_cell_size(src_type);
+    int i;
+
+    for (i = 0; i < n; i++) {
+	if (Rast_is_null_value(src, src_type))
+	    Rast_set_null_value(dst, 1, dst_type);
+	else if (dst_type == CELL_TYPE)
+	    *(CELL *) dst = src_type == FCELL_TYPE
+		? (CELL) *(const FCELL *)src : (CELL) *(const DCELL *)src;
+	else if (dst_type == FCELL_TYPE)
+	    *(FCELL *) dst = src_type == CELL_TYPE
+		? (FCELL) *(const CELL *)src : (FCELL) *(const DCELL *)src;
+	else
+	    *(DCELL *) dst = src_type == CELL_TYPE
+		? (DCELL) *(const CELL *)src : (DCELL) *(const FCELL *)src;
+
+	dst = G_incr_void_ptr(dst, dst_size);
+	src = (const char *)src + src_size;
+    }
+}
+
+static void embed_c(void *buf, const char *flags, int n,
+		    RASTER_MAP_TYPE map_type, int null_is_zero)
+{
+    size_t size = Rast_cell_size(map_type);
+    int i;
+
+    for (i = 0; i < n; i++) {
+	/* also check for nulls which might be already embedded */
+	if (flags[i] || Rast_is_null_value(buf, map_type))
+	    Rast__set_null_value(buf, 1, null_is_zero, map_type);
+	buf = G_incr_void_ptr(buf, size);
+    }
+}
+
+static void pack_c(unsigned char *bits, const char *flags, int n)
+{
+    int size = (n + 7) / 8;
+    int i, k, count = 0;
+
+    /* pad the flags with 0's to make size multiple of 8 */
+    for (i = 0; i < size; i++) {
+	unsigned char v = 0;
+
+	for (k = 7; k >= 0; k--, count++)
+	    if (count < n && flags[count])
+		v |= (unsigned char)1 << k;
+
+	bits[i] = v;
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+
+#ifdef X86_KERNELS
+
+/* SSE2 variants */
+
+static SSE2 __m128i bswap32_sse2(__m128i v)
+{
+    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+static SSE2 __m128i bswap64_sse2(__m128i v)
+{
+    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+/* 0xFF... in the lanes whose flag is set, from 4 flag bytes */
+static SSE2 __m128i flags32_sse2(const char *flags)
+{
+    int f;
+    __m128i m;
+
+    memcpy(&f, flags, sizeof(f));
+    m = _mm_cmpeq_epi8(_mm_cvtsi32_si128(f), _mm_setzero_si128());
+    m = _mm_unpacklo_epi16(_mm_unpacklo_epi8(m, m),
+			   _mm_unpacklo_epi8(m, m));
+
+    return _mm_xor_si128(m, _mm_set1_epi32(-1));
+}
+
+static void set_flags(char *nulls, int mask)
+{
+    for (; mask; mask &= mask - 1)
+	nulls[__builtin_ctz(mask)] = 1;
+}
+
+static SSE2 void put_f_sse2(unsigned char *dst, const FCELL * src,
+			    char *nulls, int n)
+{
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+	__m128 v = _mm_loadu_ps(src + i);
+	__m128 m = _mm_cmpunord_ps(v, v);
+
+	if (_mm_movemask_ps(m))
+	    set_flags(nulls + i, _mm_movemask_ps(m));
+	v = _mm_andnot_ps(m, v);
+	_mm_storeu_si128((__m128i *) (dst + i * 4),
+			 bswap32_sse2(_mm_castps_si128(v)));
+    }
+
+    put_f_c(dst + i * 4, src + i, nulls + i, n - i);
+}
+
+static SSE2 void put_d_sse2(unsigned char *dst, const DCELL * src,
+			    char *nulls, int n)
+{
+    int i;
+
+    for (i = 0; i + 2 <= n; i += 2) {
+	__m128d v = _mm_loadu_pd(src + i);
+	__m128d m = _mm_cmpunord_pd(v, v);
+
+	if (_mm_movemask_pd(m))
+	    set_flags(nulls + i, _mm_movemask_pd(m));
+	v = _mm_andnot_pd(m, v);
+	_mm_storeu_si128((__m128i *) (dst + i * 8),
+			 bswap64_sse2(_mm_castpd_si128(v)));
+    }
+
+    put_d_c(dst + i * 8, src + i, nulls + i, n - i);
+}
+
+static SSE2 void get_f_sse2(FCELL * dst, const unsigned char *src, int n)
+{
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+	_mm_storeu_si128((__m128i *) (dst + i),
+			 bswap32_sse2(_mm_loadu_si128
+				      ((const __m128i *)(src + i * 4))));
+
+    get_f_c(dst + i, src + i * 4, n - i);
+}
+
+static SSE2 void get_d_sse2(DCELL * dst, const unsigned char *src, int n)
+{
+    int i;
+
+    for (i = 0; i + 2 <= n; i += 2)
+	_mm_storeu_si128((__m128i *) (dst + i),
+			 bswap64_sse2(_mm_loadu_si128
+				      ((const __m128i *)(src + i * 8))));
+
+    get_d_c(dst + i, src + i * 8, n - i);
+}
+
+static SSE2 void get_c_sse2(CELL * dst, const unsigned char *src,
+			    int nbytes, int n)
+{
+    __m128i zero = _mm_setzero_si128();
+    int i = 0;
+
+    switch (nbytes) {
+    case 1:
+	for (; i + 16 <= n; i += 16) {
+	    __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+	    __m128i lo = _mm_unpacklo_epi8(v, zero);
+	    __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+	    _mm_storeu_si128((__m128i *) (dst + i),
+			     _mm_unpacklo_epi16(lo, zero));
+	    _mm_storeu_si128((__m128i *) (dst + i + 4),
+			     _mm_unpackhi_epi16(lo, zero));
+	    _mm_storeu_si128((__m128i *) (dst + i + 8),
+			     _mm_unpacklo_epi16(hi, zero));
+	    _mm_storeu_si128((__m128i *) (dst + i + 12),
+			     _mm_unpackhi_epi16(hi, zero));
+	}
+	break;
+    case 2:
+	for (; i + 8 <= n; i += 8) {
+	    __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+
+	    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	    _mm_storeu_si128((__m128i *) (dst + i),
+			     _mm_unpacklo_epi16(v, zero));
+	    _mm_storeu_si128((__m128i *) (dst + i + 4),
+			     _mm_unpackhi_epi16(v, zero));
+	}
+	break;
+    case 4:
+	/* sign and magnitude */
+	for (; i + 4 <= n; i += 4) {
+	    __m128i v = bswap32_sse2(_mm_loadu_si128
+				     ((const __m128i *)(src + i * 4)));
+	    __m128i neg = _mm_srai_epi32(v, 31);
+
+	    v = _mm_and_si128(v, _mm_set1_epi32(0x7fffffff));
+	    v = _mm_sub_epi32(_mm_xor_si128(v, neg), neg);
+	    _mm_storeu_si128((__m128i *) (dst + i), v);
+	}
+	break;
+    }
+
+    get_c_c(dst + i, src + i * nbytes, nbytes, n - i);
+}
+
+static SSE2 void convert_sse2(void *dst, RASTER_MAP_TYPE dst_type,
+			      const void *src, RASTER_MAP_TYPE src_type,
+			      int n)
+{
+    __m128i cnull = _mm_set1_epi32(CELL_NULL);
+    int i = 0;
+
+    /* truncation gives CELL_NULL for NaN and out of range values,
+       like the cast on this platform */
+    if (src_type == CELL_TYPE && dst_type == FCELL_TYPE) {
+	const CELL *s = src;
+	FCELL *d = dst;
+
+	for (; i + 4 <= n; i += 4) {
+	    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+	    __m128i m = _mm_cmpeq_epi32(v, cnull);
+
+	    _mm_storeu_ps(d + i, _mm_or_ps(_mm_cvtepi32_ps(v),
+					   _mm_castsi128_ps(m)));
+	}
+    }
+    else if (src_type == CELL_TYPE && dst_type == DCELL_TYPE) {
+	const CELL *s = src;
+	DCELL *d = dst;
+
+	for (; i + 2 <= n; i += 2) {
+	    __m128i v = _mm_loadl_epi64((const __m128i *)(s + i));
+	    __m128i m = _mm_cmpeq_epi32(v, cnull);
+
+	    m = _mm_unpacklo_epi32(m, m);
+	    _mm_storeu_pd(d + i, _mm_or_pd(_mm_cvtepi32_pd(v),
+					   _mm_castsi128_pd(m)));
+	}
+    }
+    else if (src_type == FCELL_TYPE && dst_type == DCELL_TYPE) {
+	const FCELL *s = src;
+	DCELL *d = dst;
+
+	for (; i + 2 <= n; i += 2) {
+	    __m128 v = _mm_castsi128_ps(_mm_loadl_epi64
+					((const __m128i *)(s + i)));
+	    __m128i m = _mm_castps_si128(_mm_cmpunord_ps(v, v));
+
+	    m = _mm_unpacklo_epi32(m, m);
+	    _mm_storeu_pd(d + i, _mm_or_pd(_mm_cvtps_pd(v),
+					   _mm_castsi128_pd(m)));
+	}
+    }
+    else if (src_type == DCELL_TYPE && dst_type == FCELL_TYPE) {
+	const DCELL *s = src;
+	FCELL *d = dst;
+
+	for (; i + 2 <= n; i += 2) {
+	    __m128d v = _mm_loadu_pd(s + i);
+	    __m128i m = _mm_castpd_si128(_mm_cmpunord_pd(v, v));
+	    __m128 f = _mm_cvtpd_ps(v);
+
+	    m = _mm_shuffle_epi32(m, 0x08);
+	    f = _mm_or_ps(f, _mm_castsi128_ps(m));
+	    _mm_storel_epi64((__m128i *) (d + i), _mm_castps_si128(f));
+	}
+    }
+    else if (src_type == FCELL_TYPE && dst_type == CELL_TYPE) {
+	const FCELL *s = src;
+	CELL *d = dst;
+
+	for (; i + 4 <= n; i += 4)
+	    _mm_storeu_si128((__m128i *) (d + i),
+			     _mm_cvttps_epi32(_mm_loadu_ps(s + i)));
+    }
+    else if (src_type == DCELL_TYPE && dst_type == CELL_TYPE) {
+	const DCELL *s = src;
+	CELL *d = dst;
+
+	for (; i + 2 <= n; i += 2)
+	    _mm_storel_epi64((__m128i *) (d + i),
+			     _mm_cvttpd_epi32(_mm_loadu_pd(s + i)));
+    }
+
+    convert_c(G_incr_void_ptr(dst, i * Rast_cell_size(dst_type)), dst_type,
+	      (const char *)src + i * Rast_cell_size(src_type), src_type,
+	      n - i);
+}
+
+static SSE2 void embed_sse2(void *buf, const char *flags, int n,
+			    RASTER_MAP_TYPE map_type, int null_is_zero)
+{
+    int i = 0;
+
+    if (map_type == CELL_TYPE) {
+	CELL *c = buf;
+	__m128i cnull = _mm_set1_epi32(null_is_zero ? 0 : CELL_NULL);
+
+	for (; i + 4 <= n; i += 4) {
+	    __m128i v = _mm_loadu_si128((const __m128i *)(c + i));
+	    __m128i m = _mm_or_si128(flags32_sse2(flags + i),
+				     _mm_cmpeq_epi32(v,
+						     _mm_set1_epi32
+						     (CELL_NULL)));
+
+	    v = _mm_or_si128(_mm_andnot_si128(m, v), _mm_and_si128(m, cnull));
+	    _mm_storeu_si128((__m128i *) (c + i), v);
+	}
+    }
+    else if (map_type == FCELL_TYPE) {
+	FCELL *f = buf;
+
+	for (; i + 4 <= n; i += 4) {
+	    __m128 v = _mm_loadu_ps(f + i);
+	    __m128 m = _mm_or_ps(_mm_castsi128_ps(flags32_sse2(flags + i)),
+				 _mm_cmpunord_ps(v, v));
+
+	    /* the null pattern has all bits set */
+	    v = null_is_zero ? _mm_andnot_ps(m, v) : _mm_or_ps(v, m);
+	    _mm_storeu_ps(f + i, v);
+	}
+    }
+    else {
+	DCELL *d = buf;
+
+	for (; i + 4 <= n; i += 4) {
+	    __m128i m32 = flags32_sse2(flags + i);
+	    int k;
+
+	    for (k = 0; k < 2; k++) {
+		__m128d v = _mm_loadu_pd(d + i + 2 * k);
+		__m128i m64 = k ? _mm_unpackhi_epi32(m32, m32)
+		    : _mm_unpacklo_epi32(m32, m32);
+		__m128d m = _mm_or_pd(_mm_castsi128_pd(m64),
+				      _mm_cmpunord_pd(v, v));
+
+		v = null_is_zero ? _mm_andnot_pd(m, v) : _mm_or_pd(v, m);
+		_mm_storeu_pd(d + i + 2 * k, v);
+	    }
+	}
+    }
+
+    embed_c(G_incr_void_ptr(buf, i * Rast_cell_size(map_type)), flags + i,
+	    n - i, map_type, null_is_zero);
+}
+
+static SSE2 void pack_sse2(unsigned char *bits, const char *flags, int n)
+{
+    int i;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+	__m128i v = _mm_loadu_si128((const __m128i *)(flags + i));
+	int set = ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+
+	bits[i / 8] = reverse_bits[set & 0xff];
+	bits[i / 8 + 1] = reverse_bits[(set >> 8) & 0xff];
+    }
+
+    pack_c(bits + i / 8, flags + i, n - i);
+}
+
+/* AVX2 variants */
+
+static AVX2 __m256i bswap32_avx2(__m256i v)
+{
+    const __m256i shuf = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+					  11, 10, 9, 8, 15, 14, 13, 12,
+					  3, 2, 1, 0, 7, 6, 5, 4,
+					  11, 10, 9, 8, 15, 14, 13, 12);
+
+    return _mm256_shuffle_epi8(v, shuf);
+}
+
+static AVX2 __m256i bswap64_avx2(__m256i v)
+{
+    const __m256i shuf = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+					  15, 14, 13, 12, 11, 10, 9, 8,
+					  7, 6, 5, 4, 3, 2, 1, 0,
+					  15, 14, 13, 12, 11, 10, 9, 8);
+
+    return _mm256_shuffle_epi8(v, shuf);
+}
+
+/* 0xFF... in the lanes whose flag is set, from 8 (or 4) flag bytes */
+static AVX2 __m256i flags32_avx2(const char *flags)
+{
+    __m128i f = _mm_loadl_epi64((const __m128i *)flags);
+
+    f = _mm_cmpeq_epi8(f, _mm_setzero_si128());
+
+    return _mm256_xor_si256(_mm256_cvtepi8_epi32(f), _mm256_set1_epi32(-1));
+}
+
+static AVX2 __m256i flags64_avx2(const char *flags)
+{
+    int f;
+    __m128i m;
+
+    memcpy(&f, flags, sizeof(f));
+    m = _mm_cmpeq_epi8(_mm_cvtsi32_si128(f), _mm_setzero_si128());
+
+    return _mm256_xor_si256(_mm256_cvtepi8_epi64(m), _mm256_set1_epi32(-1));
+}
+
+static AVX2 void put_f_avx2(unsigned char *dst, const FCELL * src,
+			    char *nulls, int n)
+{
+    int i;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+	__m256 v = _mm256_loadu_ps(src + i);
+	__m256 m = _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+
+	if (_mm256_movemask_ps(m))
+	    set_flags(nulls + i, _mm256_movemask_ps(m));
+	v = _mm256_andnot_ps(m, v);
+	_mm256_storeu_si256((__m256i *) (dst + i * 4),
+			    bswap32_avx2(_mm256_castps_si256(v)));
+    }
+
+    put_f_c(dst + i * 4, src + i, nulls + i, n - i);
+}
+
+static AVX2 void put_d_avx2(unsigned char *dst, const DCELL * src,
+			    char *nulls, int n)
+{
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+	__m256d v = _mm256_loadu_pd(src + i);
+	__m256d m = _mm256_cmp_pd(v, v, _CMP_UNORD_Q);
+
+	if (_mm256_movemask_pd(m))
+	    set_flags(nulls + i, _mm256_movemask_pd(m));
+	v = _mm256_andnot_pd(m, v);
+	_mm256_storeu_si256((__m256i *) (dst + i * 8),
+			    bswap64_avx2(_mm256_castpd_si256(v)));
+    }
+
+    put_d_c(dst + i * 8, src + i, nulls + i, n - i);
+}
+
+static AVX2 void get_f_avx2(FCELL * dst, const unsigned char *src, int n)
+{
+    int i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+	_mm256_storeu_si256((__m256i *) (dst + i),
+			    bswap32_avx2(_mm256_loadu_si256
+					 ((const __m256i *)(src + i * 4))));
+
+    get_f_c(dst + i, src + i * 4, n - i);
+}
+
+static AVX2 void get_d_avx2(DCELL * dst, const unsigned char *src, int n)
+{
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+	_mm256_storeu_si256((__m256i *) (dst + i),
+			    bswap64_avx2(_mm256_loadu_si256
+					 ((const __m256i *)(src + i * 8))));
+
+    get_d_c(dst + i, src + i * 8, n - i);
+}
+
+static AVX2 void get_c_avx2(CELL * dst, const unsigned char *src,
+			    int nbytes, int n)
+{
+    int i = 0;
+
+    switch (nbytes) {
+    case 1:
+	for (; i + 8 <= n; i += 8)
+	    _mm256_storeu_si256((__m256i *) (dst + i),
+				_mm256_cvtepu8_epi32(_mm_loadl_epi64
+						     ((const __m128i *)(src +
+									i))));
+	break;
+    case 2:
+	for (; i + 8 <= n; i += 8) {
+	    __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+
+	    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	    _mm256_storeu_si256((__m256i *) (dst + i),
+				_mm256_cvtepu16_epi32(v));
+	}
+	break;
+    case 3:
+	{
+	    /* 4 cells from the first 12 of 16 bytes loaded */
+	    const __m128i shuf = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1,
+					       8, 7, 6, -1, 11, 10, 9, -1);
+
+	    for (; i + 6 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i * 3));
+
+		_mm_storeu_si128((__m128i *) (dst + i),
+				 _mm_shuffle_epi8(v, shuf));
+	    }
+	}
+	break;
+    case 4:
+	/* sign and magnitude */
+	for (; i + 8 <= n; i += 8) {
+	    __m256i v = bswap32_avx2(_mm256_loadu_si256
+				     ((const __m256i *)(src + i * 4)));
+	    __m256i neg = _mm256_srai_epi32(v, 31);
+
+	    v = _mm256_and_si256(v, _mm256_set1_epi32(0x7fffffff));
+	    v = _mm256_sub_epi32(_mm256_xor_si256(v, neg), neg);
+	    _mm256_storeu_si256((__m256i *) (dst + i), v);
+	}
+	break;
+    }
+
+    get_c_c(dst + i, src + i * nbytes, nbytes, n - i);
+}
+
+static AVX2 void convert_avx2(void *dst, RASTER_MAP_TYPE dst_type,
+			      const void *src, RASTER_MAP_TYPE src_type,
+			      int n)
+{
+    __m256i cnull = _mm256_set1_epi32(CELL_NULL);
+    int i = 0;
+
+    if (src_type == CELL_TYPE && dst_type == FCELL_TYPE) {
+	const CELL *s = src;
+	FCELL *d = dst;
+
+	for (; i + 8 <= n; i += 8) {
+	    __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+	    __m256i m = _mm256_cmpeq_epi32(v, cnull);
+
+	    _mm256_storeu_ps(d + i, _mm256_or_ps(_mm256_cvtepi32_ps(v),
+						 _mm256_castsi256_ps(m)));
+	}
+    }
+    else if (src_type == CELL_TYPE && dst_type == DCELL_TYPE) {
+	const CELL *s = src;
+	DCELL *d = dst;
+
+	for (; i + 4 <= n; i += 4) {
+	    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+	    __m256i m = _mm256_cvtepi32_epi64(_mm_cmpeq_epi32
+					      (v, _mm_set1_epi32(CELL_NULL)));
+
+	    _mm256_storeu_pd(d + i, _mm256_or_pd(_mm256_cvtepi32_pd(v),
+						 _mm256_castsi256_pd(m)));
+	}
+    }
+    else if (src_type == FCELL_TYPE && dst_type == DCELL_TYPE) {
+	const FCELL *s = src;
+	DCELL *d = dst;
+
+	for (; i + 4 <= n; i += 4) {
+	    __m128 v = _mm_loadu_ps(s + i);
+	    __m256i m = _mm256_cvtepi32_epi64(_mm_castps_si128
+					      (_mm_cmpunord_ps(v, v)));
+
+	    _mm256_storeu_pd(d + i, _mm256_or_pd(_mm256_cvtps_pd(v),
+						 _mm256_castsi256_pd(m)));
+	}
+    }
+    else if (src_type == DCELL_TYPE && dst_type == FCELL_TYPE) {
+	const DCELL *s = src;
+	FCELL *d = dst;
+
+	for (; i + 4 <= n; i += 4) {
+	    __m256d v = _mm256_loadu_pd(s + i);
+	    __m256d m = _mm256_cmp_pd(v, v, _CMP_UNORD_Q);
+	    __m128 mf = _mm256_cvtpd_ps(m);	/* NaN for the null lanes */
+	    __m128 f = _mm256_cvtpd_ps(v);
+
+	    /* all bits set in the null lanes */
+	    mf = _mm_cmpunord_ps(mf, mf);
+	    _mm_storeu_ps(d + i, _mm_or_ps(f, mf));
+	}
+    }
+    else if (src_type == FCELL_TYPE && dst_type == CELL_TYPE) {
+	const FCELL *s = src;
+	CELL *d = dst;
+
+	for (; i + 8 <= n; i += 8)
+	    _mm256_storeu_si256((__m256i *) (d + i),
+				_mm256_cvttps_epi32(_mm256_loadu_ps(s + i)));
+    }
+    else if (src_type == DCELL_TYPE && dst_type == CELL_TYPE) {
+	const DCELL *s = src;
+	CELL *d = dst;
+
+	for (; i + 4 <= n; i += 4)
+	    _mm_storeu_si128((__m128i *) (d + i),
+			     _mm256_cvttpd_epi32(_mm256_loadu_pd(s + i)));
+    }
+
+    convert_c(G_incr_void_ptr(dst, i * Rast_cell_size(dst_type)), dst_type,
+	      (const char *)src + i * Rast_cell_size(src_type), src_type,
+	      n - i);
+}
+
+static AVX2 void embed_avx2(void *buf, const char *flags, int n,
+			    RASTER_MAP_TYPE map_type, int null_is_zero)
+{
+    int i = 0;
+
+    if (map_type == CELL_TYPE) {
+	CELL *c = buf;
+	__m256i cnull = _mm256_set1_epi32(null_is_zero ? 0 : CELL_NULL);
+
+	for (; i + 8 <= n; i += 8) {
+	    __m256i v = _mm256_loadu_si256((const __m256i *)(c + i));
+	    __m256i m = _mm256_or_si256(flags32_avx2(flags + i),
+					_mm256_cmpeq_epi32(v,
+							   _mm256_set1_epi32
+							   (CELL_NULL)));
+
+	    _mm256_storeu_si256((__m256i *) (c + i),
+				_mm256_blendv_epi8(v, cnull, m));
+	}
+    }
+    else if (map_type == FCELL_TYPE) {
+	FCELL *f = buf;
+
+	for (; i + 8 <= n; i += 8) {
+	    __m256 v = _mm256_loadu_ps(f + i);
+	    __m256 m = _mm256_or_ps(_mm256_castsi256_ps(flags32_avx2(flags + i)),
+				    _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+
+	    /* the null pattern has all bits set */
+	    v = null_is_zero ? _mm256_andnot_ps(m, v) : _mm256_or_ps(v, m);
+	    _mm256_storeu_ps(f + i, v);
+	}
+    }
+    else {
+	DCELL *d = buf;
+
+	for (; i + 4 <= n; i += 4) {
+	    __m256d v = _mm256_loadu_pd(d + i);
+	    __m256d m = _mm256_or_pd(_mm256_castsi256_pd(flags64_avx2(flags + i)),
+				     _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+
+	    v = null_is_zero ? _mm256_andnot_pd(m, v) : _mm256_or_pd(v, m);
+	    _mm256_storeu_pd(d + i, v);
+	}
+    }
+
+    embed_c(G_incr_void_ptr(buf, i * Rast_cell_size(map_type)), flags + i,
+	    n - i, map_type, null_is_zero);
+}
+
+static AVX2 void pack_avx2(unsigned char *bits, const char *flags, int n)
+{
+    int i;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+	__m256i v = _mm256_loadu_si256((const __m256i *)(flags + i));
+	unsigned int set =
+	    ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8
+						(v, _mm256_setzero_si256()));
+
+	bits[i / 8] = reverse_bits[set & 0xff];
+	bits[i / 8 + 1] = reverse_bits[(set >> 8) & 0xff];
+	bits[i / 8 + 2] = reverse_bits[(set >> 16) & 0xff];
+	bits[i / 8 + 3] = reverse_bits[set >> 24];
+    }
+
+    pack_c(bits + i / 8, flags + i, n - i);
+}
+
+#endif /* X86_KERNELS */
+
+/*--------------------------------------------------------------------------*/
+
+static void init_kernels(void)
+{
+    const char *simd;
+    int level = 0;		/* 0: portable, 1: SSE2, 2: AVX2 */
+    int i, k;
+
+    if (G_is_initialized(&initialized))
+	return;
+
+    for (i = 0; i < 256; i++)
+	for (k = 0; k < 8; k++) {
+	    bit_flags[i][k] = (i >> (7 - k)) & 1;
+	    if (i & (1 << k))
+		reverse_bits[i] |= 0x80 >> k;
+	}
+
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+	level = 1;
+    if (__builtin_cpu_supports("avx2"))
+	level = 2;
+#endif
+
+    simd = getenv("GRASS_RASTER_SIMD");
+    if (simd && *simd) {
+	if (strcmp(simd, "none") == 0)
+	    level = 0;
+	else if (strcmp(simd, "sse2") == 0) {
+	    if (level > 1)
+		level = 1;
+	}
+	else if (strcmp(simd, "avx2") != 0)
+	    G_warning(_("Unknown instruction set '%s' in GRASS_RASTER_SIMD, "
+			"use none, sse2 or avx2"), simd);
+    }
+
+    kernel.put_f = put_f_c;
+    kernel.put_d = put_d_c;
+    kernel.get_f = get_f_c;
+    kernel.get_d = get_d_c;
+    kernel.get_c = get_c_c;
+    kernel.convert = convert_c;
+    kernel.embed = embed_c;
+    kernel.pack = pack_c;
+
+#ifdef X86_KERNELS
+    /* XDR is big-endian; x86 is always little-endian */
+    if (level == 1) {
+	kernel.put_f = put_f_sse2;
+	kernel.put_d = put_d_sse2;
+	kernel.get_f = get_f_sse2;
+	kernel.get_d = get_d_sse2;
+	kernel.get_c = get_c_sse2;
+	kernel.convert = convert_sse2;
+	kernel.embed = embed_sse2;
+	kernel.pack = pack_sse2;
+    }
+    else if (level == 2) {
+	kernel.put_f = put_f_avx2;
+	kernel.put_d = put_d_avx2;
+	kernel.get_f = get_f_avx2;
+	kernel.get_d = get_d_avx2;
+	kernel.get_c = get_c_avx2;
+	kernel.convert = convert_avx2;
+	kernel.embed = embed_avx2;
+	kernel.pack = pack_avx2;
+    }
+#endif
+
+    G_debug(1, "Raster row kernels: %s",
+	    level == 2 ? "AVX2" : level == 1 ? "SSE2" : "portable");
+
+    G_initialize_done(&initialized);
+}
+
+/*!
+   \brief Encode a FCELL row in XDR format
+
+   Null cells are written as 0 and flagged in <i>nulls</i>; the other
+   flags are left unchanged.
+
+   \param[out] dst XDR data, 4 bytes per cell
+   \param src cell values
+   \param[in,out] nulls null flags
+   \param n number of cells
+ */
+void Rast__xdr_put_f_row(void *dst, const FCELL * src, char *nulls, int n)
+{
+    init_kernels();
+    kernel.put_f(dst, src, nulls, n);
+}
+
+/*!
+   \brief Encode a DCELL row in XDR format
+
+   Same as Rast__xdr_put_f_row() for DCELL values.
+
+   \param[out] dst XDR data, 8 bytes per cell
+   \param src cell values
+   \param[in,out] nulls null flags
+   \param n number of cells
+ */
+void Rast__xdr_put_d_row(void *dst, const DCELL * src, char *nulls, int n)
+{
+    init_kernels();
+    kernel.put_d(dst, src, nulls, n);
+}
+
+/*!
+   \brief Decode a FCELL row from XDR format
+
+   \param[out] dst cell values
+   \param src XDR data, 4 bytes per cell
+   \param n number of cells
+ */
+void Rast__xdr_get_f_row(FCELL * dst, const void *src, int n)
+{
+    init_kernels();
+    kernel.get_f(dst, src, n);
+}
+
+/*!
+   \brief Decode a DCELL row from XDR format
+
+   \param[out] dst cell values
+   \param src XDR data, 8 bytes per cell
+   \param n number of cells
+ */
+void Rast__xdr_get_d_row(DCELL * dst, const void *src, int n)
+{
+    init_kernels();
+    kernel.get_d(dst, src, n);
+}
+
+/*!
+   \brief Decode the data bytes of a CELL row
+
+   Each cell is stored in <i>nbytes</i> bytes, most significant byte
+   first; with 4 or more bytes the highest bit is the sign.
+
+   \param[out] dst cell values
+   \param src data bytes
+   \param nbytes number of bytes per cell
+   \param n number of cells
+ */
+void Rast__decode_c_row(CELL * dst, const unsigned char *src, int nbytes,
+			int n)
+{
+    init_kernels();
+    kernel.get_c(dst, src, nbytes, n);
+}
+
+/*!
+   \brief Convert a row between cell types
+
+   Null cells stay null. Floating point values are truncated when
+   converted to CELL.
+
+   \param[out] dst converted row
+   \param dst_type type of <i>dst</i>
+   \param src row to convert
+   \param src_type type of <i>src</i>, different from <i>dst_type</i>
+   \param n number of cells
+ */
+void Rast__convert_row(void *dst, RASTER_MAP_TYPE dst_type, const void *src,
+		       RASTER_MAP_TYPE src_type, int n)
+{
+    init_kernels();
+    kernel.convert(dst, dst_type, src, src_type, n);
+}
+
+/*!
+   \brief Set the flagged cells of a row to null
+
+   Cells which hold a null value already are set to the null value
+   again, so that all nulls have the same bit pattern.
+
+   \param[in,out] buf row
+   \param flags null flags
+   \param n number of cells
+   \param map_type type of the row
+   \param null_is_zero set nulls to 0 instead of the null value
+ */
+void Rast__embed_null_flags(void *buf, const char *flags, int n,
+			    RASTER_MAP_TYPE map_type, int null_is_zero)
+{
+    init_kernels();
+    kernel.embed(buf, flags, n, map_type, null_is_zero);
+}
+
+/*!
+   \brief Pack null flags into a null bitmap
+
+   \param[out] bits bitmap of Rast__null_bitstream_size(n) bytes, padded
+   with 0 bits
+   \param flags null flags
+   \param n number of flags
+ */
+void Rast__pack_null_flags(unsigned char *bits, const char *flags, int n)
+{
+    init_kernels();
+    kernel.pack(bits, flags, n);
+}
+
+/*!
+   \brief Unpack null flags from a null bitmap
+
+   \param[out] flags null flags, 0 or 1
+   \param bits null bitmap
+   \param first index of the first bit to unpack
+   \param n number of flags
+ */
+void Rast__unpack_null_bits(char *flags, const unsigned char *bits,
+			    int first, int n)
+{
+    int i = 0;
+
+    init_kernels();
+
+    for (; i < n && (first + i) & 7; i++)
+	flags[i] = bit_flags[bits[(first + i) >> 3]][(first + i) & 7];
+
+    for (; i + 8 <= n; i += 8)
+	memcpy(flags + i, bit_flags[bits[(first + i) >> 3]], 8);
+
+    for (; i < n; i++)
+	flags[i] = bit_flags[bits[(first + i) >> 3]][(first + i) & 7];
+}
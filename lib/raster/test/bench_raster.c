@@ -0,0 +1,452 @@
+/*****************************************************************************
+*
+* MODULE:       Grass raster Library
+* AUTHOR(S):    GRASS Development Team
+*
+* PURPOSE:      Benchmarks of Rast_put_row() and Rast_get_row()
+*
+* COPYRIGHT:    (C) 2026 by the GRASS Development Team
+*
+*               This program is free software under the GNU General Public
+*               License (>=v2). Read the file COPYING that comes with GRASS
+*               for details.
+*
+*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <grass/spawn.h>
+#include "test_raster_lib.h"
+
+/* distinct rows generated per map, the rows are compressed one by one
+ * so repeating them does not change the results */
+#define GEN_ROWS 64
+
+static const struct bench_params *P;
+static struct Cell_head window;
+static char prefix[64];
+static int num_records;
+static int have_input[3];
+
+static const char *type_name(RASTER_MAP_TYPE type)
+{
+    return type == CELL_TYPE ? "CELL" : type == FCELL_TYPE ? "FCELL" : "DCELL";
+}
+
+static const char *map_element(RASTER_MAP_TYPE type)
+{
+    return type == CELL_TYPE ? "cell" : "fcell";
+}
+
+static void remove_map(const char *name)
+{
+    char *arg;
+
+    G_asprintf(&arg, "name=%s", name);
+    G_spawn("g.remove", "g.remove", "-f", "--q", "type=raster", arg, NULL);
+    G_free(arg);
+}
+
+static off_t file_size(RASTER_MAP_TYPE type, const char *name)
+{
+    char path[GPATH_MAX];
+    struct stat st;
+
+    G_file_name(path, map_element(type), name, G_mapset());
+    if (stat(path, &st) != 0)
+	return 0;
+
+    return st.st_size;
+}
+
+/* *************************************************************** */
+/* Print one result ********************************************** */
+/* *************************************************************** */
+static void report(const char *test, RASTER_MAP_TYPE type, int compressor,
+		   int nulls, const char *variant, int rows, int cols,
+		   double secs, off_t bytes)
+{
+    double mb = (double)rows * cols * Rast_cell_size(type) / 1e6;
+    const char *comp = compressor < 0 ? "" : G_compressor_name(compressor);
+
+    if (secs <= 0)
+	secs = 1e-6;
+
+    switch (P->format) {
+    case BENCH_CSV:
+	printf("%s,%s,%s,%d,%s,%d,%d,%g,%.6f,%.2f,%.1f,%ld\n", test,
+	       type_name(type), comp, nulls, variant, rows, cols, P->entropy,
+	       secs, mb / secs, rows / secs, (long)bytes);
+	break;
+    case BENCH_JSON:
+	printf("%s{\"test\": \"%s\", \"type\": \"%s\", \"compressor\": \"%s\", "
+	       "\"nulls\": %s, \"variant\": \"%s\", \"rows\": %d, "
+	       "\"cols\": %d, \"entropy\": %g, \"seconds\": %.6f, "
+	       "\"mb_per_s\": %.2f, \"rows_per_s\": %.1f, \"file_bytes\": %ld}",
+	       num_records ? ",\n  " : "  ", test, type_name(type), comp,
+	       nulls ? "true" : "false", variant, rows, cols, P->entropy, secs,
+	       mb / secs, rows / secs, (long)bytes);
+	break;
+    default:
+	printf("%-4s %-6s %-8s %-6s %-10s %9.1f MB/s %10.0f rows/s",
+	       test, type_name(type), comp, nulls ? "nulls" : "-", variant,
+	       mb / secs, rows / secs);
+	if (bytes)
+	    printf(" %12ld bytes", (long)bytes);
+	printf("\n");
+	break;
+    }
+    fflush(stdout);
+    num_records++;
+}
+
+/* *************************************************************** */
+/* Synthetic maps ************************************************ */
+/* *************************************************************** */
+
+/* a smooth surface plus noise with entropy * 24 random bits, nulls in
+ * blocks and scattered */
+static void fill_row(void *buf, RASTER_MAP_TYPE type, int row, int nulls)
+{
+    int bits = (int)(P->entropy * 24 + 0.5);
+    size_t size = Rast_cell_size(type);
+    int col;
+
+    for (col = 0; col < P->cols; col++) {
+	void *p = G_incr_void_ptr(buf, col * size);
+	long noise = bits ? G_lrand48() & ((1L << bits) - 1) : 0;
+	double smooth = (row + col) / 8.0 + 100 * ((row / 50 + col / 50) % 4);
+
+	if (nulls && ((row / 16 + col / 32) % 8 == 0 ||
+		      G_lrand48() % 20 == 0)) {
+	    Rast_set_null_value(p, 1, type);
+	    continue;
+	}
+
+	if (type == CELL_TYPE)
+	    *(CELL *) p = (CELL) (smooth * 16) + noise;
+	else
+	    Rast_set_d_value(p, smooth + noise / 4096.0, type);
+    }
+}
+
+/* writes a map, returns the seconds taken */
+static double write_map(const char *name, RASTER_MAP_TYPE type,
+			int compressor, int nulls)
+{
+    struct timeval tstart, tend;
+    size_t size = Rast_cell_size(type) * P->cols;
+    int gen_rows = P->rows < GEN_ROWS ? P->rows : GEN_ROWS;
+    unsigned char *rows = G_malloc(gen_rows * size);
+    int fd, row;
+
+    G_srand48(12345);
+    for (row = 0; row < gen_rows; row++)
+	fill_row(rows + row * size, type, row, nulls);
+
+    gettimeofday(&tstart, NULL);
+
+    if (compressor == 0)
+	fd = Rast_open_new_uncompressed(name, type);
+    else {
+	Rast_set_compressor(compressor);
+	fd = Rast_open_new(name, type);
+    }
+    for (row = 0; row < P->rows; row++)
+	Rast_put_row(fd, rows + (row % gen_rows) * size, type);
+    Rast_close(fd);
+
+    gettimeofday(&tend, NULL);
+
+    G_free(rows);
+
+    return compute_time_difference(tstart, tend);
+}
+
+/* reads a map in the current input window, returns the seconds taken */
+static double read_map(const char *name, RASTER_MAP_TYPE type)
+{
+    struct timeval tstart, tend;
+    void *buf = Rast_allocate_input_buf(type);
+    int nrows = Rast_input_window_rows();
+    int fd, row;
+
+    gettimeofday(&tstart, NULL);
+
+    fd = Rast_open_old(name, G_mapset());
+    for (row = 0; row < nrows; row++)
+	Rast_get_row(fd, buf, row, type);
+    Rast_close(fd);
+
+    gettimeofday(&tend, NULL);
+
+    G_free(buf);
+
+    return compute_time_difference(tstart, tend);
+}
+
+/* the map with nulls and the default compressor read by the other
+ * benchmarks */
+static const char *input_map(RASTER_MAP_TYPE type)
+{
+    static const char *suffix[3] = { "cell", "fcell", "dcell" };
+    static char name[3][GNAME_MAX];
+
+    if (!have_input[type]) {
+	sprintf(name[type], "%s_%s", prefix, suffix[type]);
+	write_map(name[type], type, G_default_compressor(), 1);
+	have_input[type] = 1;
+    }
+
+    return name[type];
+}
+
+/* *************************************************************** */
+/* Setup and cleanup ********************************************* */
+/* *************************************************************** */
+void bench_begin(const struct bench_params *params)
+{
+    P = params;
+
+    if (G_find_raster("MASK", G_mapset()))
+	G_fatal_error(_("Remove the MASK before running the benchmarks"));
+
+    sprintf(prefix, "rbench_%d", (int)getpid());
+
+    G_get_window(&window);
+    window.north = P->rows;
+    window.south = 0;
+    window.east = P->cols;
+    window.west = 0;
+    window.ns_res = window.ew_res = 1;
+    G_adjust_Cell_head(&window, 0, 0);
+    Rast_set_window(&window);
+
+    switch (P->format) {
+    case BENCH_CSV:
+	printf("test,type,compressor,nulls,variant,rows,cols,entropy,"
+	       "seconds,mb_per_s,rows_per_s,file_bytes\n");
+	break;
+    case BENCH_JSON:
+	printf("[\n");
+	break;
+    default:
+	G_message(_("Raster benchmarks, %d rows x %d columns, entropy %g"),
+		  P->rows, P->cols, P->entropy);
+	break;
+    }
+}
+
+void bench_end(void)
+{
+    int type;
+
+    for (type = CELL_TYPE; type <= DCELL_TYPE; type++)
+	if (have_input[type])
+	    remove_map(input_map(type));
+
+    if (P->format == BENCH_JSON)
+	printf("\n]\n");
+}
+
+/* *************************************************************** */
+/* Put and get rows with every compressor ************************ */
+/* *************************************************************** */
+void bench_raster_rows(const struct bench_params *params)
+{
+    int t, c, nulls;
+
+    for (t = 0; params->types[t] >= 0; t++) {
+	RASTER_MAP_TYPE type = params->types[t];
+
+	for (c = 0; params->compressors[c] >= 0; c++) {
+	    int comp = params->compressors[c];
+
+	    for (nulls = 0; nulls <= 1; nulls++) {
+		char name[GNAME_MAX];
+		double secs;
+
+		sprintf(name, "%s_%d_%d_%d", prefix, type, comp, nulls);
+
+		secs = write_map(name, type, comp, nulls);
+		report("put", type, comp, nulls, "aligned", P->rows, P->cols,
+		       secs, file_size(type, name));
+
+		secs = read_map(name, type);
+		report("get", type, comp, nulls, "aligned", P->rows, P->cols,
+		       secs, file_size(type, name));
+
+		remove_map(name);
+	    }
+	}
+    }
+
+    Rast_set_compressor(G_default_compressor());
+}
+
+/* *************************************************************** */
+/* Get rows with a MASK ****************************************** */
+/* *************************************************************** */
+void bench_raster_mask(const struct bench_params *params)
+{
+    CELL *buf = Rast_allocate_c_buf();
+    int t, fd, row, col;
+
+    for (t = 0; params->types[t] >= 0; t++)
+	input_map(params->types[t]);
+
+    /* a checkerboard, and some rows masked out completely */
+    fd = Rast_open_c_new("MASK");
+    for (row = 0; row < P->rows; row++) {
+	for (col = 0; col < P->cols; col++)
+	    if (row % 128 < 16 || (row / 64 + col / 64) % 2)
+		Rast_set_c_null_value(&buf[col], 1);
+	    else
+		buf[col] = 1;
+	Rast_put_c_row(fd, buf);
+    }
+    Rast_close(fd);
+    G_free(buf);
+
+    Rast__check_for_auto_masking();
+
+    for (t = 0; params->types[t] >= 0; t++) {
+	RASTER_MAP_TYPE type = params->types[t];
+	double secs = read_map(input_map(type), type);
+
+	report("get", type, G_default_compressor(), 1, "mask", P->rows,
+	       P->cols, secs, 0);
+    }
+
+    remove_map("MASK");
+    Rast__check_for_auto_masking();
+}
+
+/* *************************************************************** */
+/* Get rows in a region which is not aligned with the map ******** */
+/* *************************************************************** */
+void bench_raster_region(const struct bench_params *params)
+{
+    struct Cell_head shifted = window;
+    int t;
+
+    /* the columns do not map one to one, every row is resampled */
+    shifted.north -= 0.35;
+    shifted.south += 0.35;
+    shifted.east -= 0.35;
+    shifted.west += 0.35;
+    shifted.ns_res = shifted.ew_res = 0.7;
+    G_adjust_Cell_head(&shifted, 0, 0);
+
+    for (t = 0; params->types[t] >= 0; t++) {
+	RASTER_MAP_TYPE type = params->types[t];
+	const char *name = input_map(type);
+	double secs;
+
+	Rast_set_input_window(&shifted);
+	secs = read_map(name, type);
+	Rast_set_input_window(&window);
+
+	report("get", type, G_default_compressor(), 1, "resampled",
+	       shifted.rows, shifted.cols, secs, 0);
+    }
+}
+
+/* *************************************************************** */
+/* Get rows through a virtual raster ***************************** */
+/* *************************************************************** */
+void bench_raster_vrt(const struct bench_params *params)
+{
+    int t;
+
+    for (t = 0; params->types[t] >= 0; t++) {
+	RASTER_MAP_TYPE type = params->types[t];
+	const char *name = input_map(type);
+	char vrt[GNAME_MAX], *input, *output;
+	double secs;
+	int ret;
+
+	sprintf(vrt, "%s_vrt", name);
+	G_asprintf(&input, "input=%s", name);
+	G_asprintf(&output, "output=%s", vrt);
+	ret = G_spawn("r.buildvrt", "r.buildvrt", "--q", "--o", input,
+		      output, NULL);
+	G_free(input);
+	G_free(output);
+	if (ret != 0) {
+	    G_warning(_("Unable to create virtual raster <%s>"), vrt);
+	    return;
+	}
+
+	secs = read_map(vrt, type);
+	report("get", type, -1, 1, "vrt", P->rows, P->cols, secs, 0);
+
+	remove_map(vrt);
+    }
+}
+
+/* *************************************************************** */
+/* Get rows through a GDAL link ********************************** */
+/* *************************************************************** */
+void bench_raster_gdal(const struct bench_params *params)
+{
+    int t;
+
+    for (t = 0; params->types[t] >= 0; t++) {
+	RASTER_MAP_TYPE type = params->types[t];
+	const char *name = input_map(type);
+	char link[GNAME_MAX], *file, *arg1, *arg2;
+	double secs;
+	int ret;
+
+	sprintf(link, "%s_gdal", name);
+	G_asprintf(&file, "%s.tif", G_tempfile());
+
+	G_asprintf(&arg1, "input=%s", name);
+	G_asprintf(&arg2, "output=%s", file);
+	ret = G_spawn("r.out.gdal", "r.out.gdal", "--q", "--o", "format=GTiff",
+		      arg1, arg2, NULL);
+	G_free(arg1);
+	G_free(arg2);
+
+	if (ret == 0) {
+	    G_asprintf(&arg1, "input=%s", file);
+	    G_asprintf(&arg2, "output=%s", link);
+	    ret = G_spawn("r.external", "r.external", "--q", "--o", arg1,
+			  arg2, NULL);
+	    G_free(arg1);
+	    G_free(arg2);
+	}
+
+	if (ret != 0) {
+	    G_warning(_("Unable to create GDAL link <%s>"), link);
+	    unlink(file);
+	    G_free(file);
+	    return;
+	}
+
+	secs = read_map(link, type);
+	report("get", type, -1, 1, "gdal", P->rows, P->cols, secs, 0);
+
+	remove_map(link);
+	unlink(file);
+	G_free(file);
+    }
+}
+
+/* *************************************************************** */
+/* Compute the difference between two time steps ***************** */
+/* *************************************************************** */
+double compute_time_difference(struct timeval start, struct timeval end)
+{
+    int sec;
+    int usec;
+
+    sec = end.tv_sec - start.tv_sec;
+    usec = end.tv_usec - start.tv_usec;
+
+    return (double)sec + (double)usec / 1000000;
+}
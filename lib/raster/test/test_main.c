@@ -0,0 +1,179 @@
+/****************************************************************************
+ *
+ * MODULE:       test.raster.lib
+ *
+ * AUTHOR(S):    GRASS Development Team
+ *
+ * PURPOSE:      Benchmarks of the raster library
+ *
+ * COPYRIGHT:    (C) 2026 by the GRASS Development Team
+ *
+ *               This program is free software under the GNU General Public
+ *   	    	License (>=v2). Read the file COPYING that comes with GRASS
+ *   	    	for details.
+ *
+ *****************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "test_raster_lib.h"
+
+/*- Parameters and global variables -----------------------------------------*/
+typedef struct {
+    struct Option *bench, *rows, *cols, *entropy, *type, *compressor,
+	*format;
+} paramType;
+
+paramType param; /*Parameters */
+
+/*- prototypes --------------------------------------------------------------*/
+static void set_params(void); /*Fill the paramType structure */
+
+/* ************************************************************************* */
+/* Set up the arguments we are expecting ********************************** */
+
+/* ************************************************************************* */
+void set_params(void) {
+    param.bench = G_define_option();
+    param.bench->key = "bench";
+    param.bench->type = TYPE_STRING;
+    param.bench->required = NO;
+    param.bench->multiple = YES;
+    param.bench->options = "rows,mask,region,vrt,gdal";
+    param.bench->answer = "rows,mask,region,vrt,gdal";
+    param.bench->description = _("Choose the benchmarks to run");
+
+    param.rows = G_define_option();
+    param.rows->key = "rows";
+    param.rows->type = TYPE_INTEGER;
+    param.rows->required = NO;
+    param.rows->answer = "1000";
+    param.rows->description = _("The number of rows of the benchmark maps");
+
+    param.cols = G_define_option();
+    param.cols->key = "cols";
+    param.cols->type = TYPE_INTEGER;
+    param.cols->required = NO;
+    param.cols->answer = "1000";
+    param.cols->description = _("The number of columns of the benchmark maps");
+
+    param.entropy = G_define_option();
+    param.entropy->key = "entropy";
+    param.entropy->type = TYPE_DOUBLE;
+    param.entropy->required = NO;
+    param.entropy->answer = "0.5";
+    param.entropy->options = "0-1";
+    param.entropy->description =
+	_("Randomness of the cell values, 0: smooth surface, 1: random");
+
+    param.type = G_define_option();
+    param.type->key = "type";
+    param.type->type = TYPE_STRING;
+    param.type->required = NO;
+    param.type->multiple = YES;
+    param.type->options = "cell,fcell,dcell";
+    param.type->answer = "cell,fcell,dcell";
+    param.type->description = _("Choose the map types");
+
+    param.compressor = G_define_option();
+    param.compressor->key = "compressor";
+    param.compressor->type = TYPE_STRING;
+    param.compressor->required = NO;
+    param.compressor->multiple = YES;
+    param.compressor->options = "NONE,RLE,ZLIB,LZ4,BZIP2,ZSTD,SHUFFLE";
+    param.compressor->description =
+	_("Choose the compressors for the rows benchmark (default: all available)");
+
+    param.format = G_define_option();
+    param.format->key = "format";
+    param.format->type = TYPE_STRING;
+    param.format->required = NO;
+    param.format->options = "plain,csv,json";
+    param.format->answer = "plain";
+    param.format->description = _("Output format of the results");
+}
+
+/* ************************************************************************* */
+/* ************************************************************************* */
+
+/* ************************************************************************* */
+int main(int argc, char *argv[]) {
+    struct GModule *module;
+    struct bench_params bp;
+    int i, n;
+
+    /* Initialize GRASS */
+    G_gisinit(argv[0]);
+
+    module = G_define_module();
+    module->description
+            = _("Performs benchmarks of the raster library");
+
+    /* Get parameters from user */
+    set_params();
+
+    if (G_parser(argc, argv))
+        exit(EXIT_FAILURE);
+
+    bp.rows = atoi(param.rows->answer);
+    bp.cols = atoi(param.cols->answer);
+    bp.entropy = atof(param.entropy->answer);
+    if (bp.rows < 1 || bp.cols < 1)
+        G_fatal_error(_("The maps need at least one row and column"));
+
+    n = 0;
+    for (i = 0; param.type->answers[i] && n < 3; i++) {
+        if (strcmp(param.type->answers[i], "cell") == 0)
+            bp.types[n++] = CELL_TYPE;
+        else if (strcmp(param.type->answers[i], "fcell") == 0)
+            bp.types[n++] = FCELL_TYPE;
+        else
+            bp.types[n++] = DCELL_TYPE;
+    }
+    bp.types[n] = -1;
+
+    n = 0;
+    if (param.compressor->answers) {
+        for (i = 0; param.compressor->answers[i] && n < 15; i++) {
+            int c = G_compressor_number(param.compressor->answers[i]);
+
+            if (c < 0 || G_check_compressor(c) != 1)
+                G_warning(_("Compressor %s is not available"),
+                          param.compressor->answers[i]);
+            else
+                bp.compressors[n++] = c;
+        }
+    }
+    else {
+        /* NONE (0) stands for uncompressed maps */
+        for (i = 0; G_compressor_name(i); i++)
+            if (G_check_compressor(i) == 1)
+                bp.compressors[n++] = i;
+    }
+    bp.compressors[n] = -1;
+
+    if (strcmp(param.format->answer, "csv") == 0)
+        bp.format = BENCH_CSV;
+    else if (strcmp(param.format->answer, "json") == 0)
+        bp.format = BENCH_JSON;
+    else
+        bp.format = BENCH_PLAIN;
+
+    bench_begin(&bp);
+
+    for (i = 0; param.bench->answers[i]; i++) {
+        if (strcmp(param.bench->answers[i], "rows") == 0)
+            bench_raster_rows(&bp);
+        if (strcmp(param.bench->answers[i], "mask") == 0)
+            bench_raster_mask(&bp);
+        if (strcmp(param.bench->answers[i], "region") == 0)
+            bench_raster_region(&bp);
+        if (strcmp(param.bench->answers[i], "vrt") == 0)
+            bench_raster_vrt(&bp);
+        if (strcmp(param.bench->answers[i], "gdal") == 0)
+            bench_raster_gdal(&bp);
+    }
+
+    bench_end();
+
+    return EXIT_SUCCESS;
+}
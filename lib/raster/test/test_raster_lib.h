@@ -0,0 +1,47 @@
+/*****************************************************************************
+*
+* MODULE:       Grass raster Library
+* AUTHOR(S):    GRASS Development Team
+*
+* PURPOSE:      Benchmarks of the raster library
+*
+* COPYRIGHT:    (C) 2026 by the GRASS Development Team
+*
+*               This program is free software under the GNU General Public
+*               License (>=v2). Read the file COPYING that comes with GRASS
+*               for details.
+*
+*****************************************************************************/
+
+#ifndef _TEST_RASTER_LIB_H_
+#define _TEST_RASTER_LIB_H_
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/glocale.h>
+#include <sys/time.h>
+
+#define BENCH_PLAIN 0
+#define BENCH_CSV 1
+#define BENCH_JSON 2
+
+struct bench_params
+{
+    int rows, cols;		/* size of the synthetic maps */
+    double entropy;		/* 0: smooth surface, 1: random values */
+    int types[4];		/* map types to run, -1 terminated */
+    int compressors[16];	/* compressor numbers, -1 terminated */
+    int format;			/* BENCH_PLAIN, BENCH_CSV or BENCH_JSON */
+};
+
+double compute_time_difference(struct timeval, struct timeval);
+
+void bench_begin(const struct bench_params *);
+void bench_end(void);
+void bench_raster_rows(const struct bench_params *);
+void bench_raster_mask(const struct bench_params *);
+void bench_raster_region(const struct bench_params *);
+void bench_raster_vrt(const struct bench_params *);
+void bench_raster_gdal(const struct bench_params *);
+
+#endif
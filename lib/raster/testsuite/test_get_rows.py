@@ -0,0 +1,79 @@
+"""Test of Rast_get_rows() followed by Rast_get_row() of the same rows
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import ctypes
+import os
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+# uncompressed rows are then held in the band of the reader instead of
+# the mapped file; must be set before the library is initialized
+os.environ['GRASS_RASTER_MMAP'] = '0'
+
+import grass.lib.gis as libgis
+import grass.lib.raster as libraster
+
+ROWS = 200
+# bands of 64 rows are larger than the threshold of malloc() for
+# memory returned to the system when freed
+COLS = 1000
+
+
+def value(row, col):
+    """Cell of the map, rows and columns counted from 0"""
+    return (row + 1) * 7 + col + 1
+
+
+class GetRowsTestCase(TestCase):
+    """Rows of uncompressed maps read in bands and then one by one"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        libgis.G_gisinit('test_get_rows')
+        fd = libraster.Rast_open_c_new_uncompressed('get_rows')
+        row = (ctypes.c_int * COLS)()
+        for r in range(ROWS):
+            row[:] = [value(r, c) for c in range(COLS)]
+            libraster.Rast_put_c_row(fd, row)
+        libraster.Rast_close(fd)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.runModule('g.remove', flags='f', type='raster', name='get_rows')
+        cls.del_temp_region()
+
+    def test_rows_then_row(self):
+        """The last row of a band is read again after the band"""
+        fd = libraster.Rast_open_old('get_rows', '')
+        try:
+            for first, nrows in [(0, 64), (64, 64), (150, 50)]:
+                rows = (ctypes.c_int * (nrows * COLS))()
+                libraster.Rast_get_rows(fd, ctypes.cast(rows, ctypes.c_void_p),
+                                        first, nrows, libraster.CELL_TYPE)
+                for i in range(nrows):
+                    self.assertEqual(rows[i * COLS:(i + 1) * COLS],
+                                     [value(first + i, c)
+                                      for c in range(COLS)])
+
+                last = first + nrows - 1
+                row = (ctypes.c_int * COLS)()
+                libraster.Rast_get_row(fd, ctypes.cast(row, ctypes.c_void_p),
+                                       last, libraster.CELL_TYPE)
+                self.assertEqual(row[:], [value(last, c)
+                                          for c in range(COLS)])
+        finally:
+            libraster.Rast_close(fd)
+
+
+if __name__ == '__main__':
+    test()
@@ -0,0 +1,75 @@
+"""Test of raster overviews built by r.support
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+
+class OverviewsTestCase(TestCase):
+    """Coarse regions must read the overviews like the map itself"""
+
+    expression = 'if(row() % 7 == 0, null(), float(row() * 0.5 + col() * 0.25))'
+    maps = ['ovr_map', 'ovr_ref', 'ovr_avg', 'ovr_resamp']
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.set_map_region()
+        for name in cls.maps[:3]:
+            cls.runModule('r.mapcalc',
+                          expression='%s = %s' % (name, cls.expression))
+        cls.runModule('r.support', map='ovr_map', overviews=[2, 4, 8])
+        cls.runModule('r.support', map='ovr_avg', overviews=[4],
+                      resample='average')
+
+    @classmethod
+    def set_map_region(cls):
+        # the last row and column of the overviews are partly outside
+        cls.runModule('g.region', n=1000, s=0, w=0, e=1210, res=1)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.runModule('g.remove', flags='f', type='raster', name=cls.maps)
+        cls.del_temp_region()
+
+    def setUp(self):
+        self.set_map_region()
+
+    def test_nearest(self):
+        """Nearest neighbour overviews read like the map itself"""
+        for res in (1, 2, 4, 8):
+            self.runModule('g.region', flags='a', res=res)
+            self.assertRastersNoDifference(actual='ovr_map',
+                                           reference='ovr_ref',
+                                           precision=0)
+
+    def test_average(self):
+        """Average overviews hold the mean of the non-null cells"""
+        self.runModule('g.region', flags='a', res=4)
+        self.assertModule('r.resamp.stats', input='ovr_ref',
+                          output='ovr_resamp', method='average')
+        self.assertRastersNoDifference(actual='ovr_avg',
+                                       reference='ovr_resamp',
+                                       precision=1e-3)
+
+    def test_rewrite(self):
+        """Rewriting the map removes its overviews"""
+        self.runModule('r.support', map='ovr_ref', overviews=[2])
+        self.runModule('r.mapcalc', overwrite=True,
+                       expression='ovr_ref = %s' % self.expression)
+        self.runModule('g.region', flags='a', res=2)
+        self.assertRastersNoDifference(actual='ovr_map',
+                                       reference='ovr_ref',
+                                       precision=0)
+        self.assertModule('r.support', flags='o', map='ovr_map')
+
+
+if __name__ == '__main__':
+    test()
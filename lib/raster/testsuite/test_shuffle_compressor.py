@@ -0,0 +1,85 @@
+"""Test of the SHUFFLE compressor (GRASS_COMPRESSOR=SHUFFLE)
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import os
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+from grass.gunittest.gmodules import SimpleModule
+
+
+class ShuffleCompressorTestCase(TestCase):
+    """Maps written with SHUFFLE must read back unchanged"""
+
+    expressions = {
+        'cell': 'if(col() % 5 == 0, null(), int(row() * 131 - col() * 7))',
+        'fcell': 'if(row() % 7 == col() % 3, null(), float(sin(row()) * col()))',
+        'dcell': 'double(row() * 0.5 - col() / 3.0)',
+    }
+    maps = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=100, s=0, w=0, e=203, res=1)
+        for name, expr in cls.expressions.items():
+            cls.runModule('r.mapcalc', expression='%s = %s' % (name, expr))
+            cls.maps.append(name)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.maps + [m + '_shuf' for m in cls.maps])
+        cls.del_temp_region()
+
+    def test_write(self):
+        """Compare maps written with SHUFFLE to the originals"""
+        os.environ['GRASS_COMPRESSOR'] = 'SHUFFLE'
+        try:
+            for name in self.expressions:
+                self.runModule('r.mapcalc', overwrite=True,
+                               expression='%s_shuf = %s' % (name, name))
+        finally:
+            del os.environ['GRASS_COMPRESSOR']
+        for name in self.expressions:
+            self.assertRastersNoDifference(actual=name + '_shuf',
+                                           reference=name, precision=0)
+
+    def test_method(self):
+        """r.compress reports the method of maps written with SHUFFLE"""
+        os.environ['GRASS_COMPRESSOR'] = 'SHUFFLE'
+        try:
+            self.runModule('r.mapcalc', overwrite=True,
+                           expression='fcell_shuf = fcell')
+        finally:
+            del os.environ['GRASS_COMPRESSOR']
+        module = SimpleModule('r.compress', map='fcell_shuf', flags='g')
+        self.assertModule(module)
+        self.assertIn('|SHUFFLE|', module.outputs.stdout)
+
+    def test_recompress(self):
+        """Re-compress with r.compress and back"""
+        for name in self.expressions:
+            self.runModule('g.copy', overwrite=True,
+                           raster=(name, name + '_shuf'))
+            os.environ['GRASS_COMPRESSOR'] = 'SHUFFLE'
+            try:
+                self.assertModule('r.compress', map=name + '_shuf')
+            finally:
+                del os.environ['GRASS_COMPRESSOR']
+            self.assertRastersNoDifference(actual=name + '_shuf',
+                                           reference=name, precision=0)
+            self.assertModule('r.compress', map=name + '_shuf', flags='u')
+            self.assertRastersNoDifference(actual=name + '_shuf',
+                                           reference=name, precision=0)
+
+
+if __name__ == '__main__':
+    test()
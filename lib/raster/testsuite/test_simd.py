@@ -0,0 +1,77 @@
+"""Test of the vectorized row conversions (GRASS_RASTER_SIMD)
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import os
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+
+class SimdTestCase(TestCase):
+    """Maps written and read with and without SIMD must be identical"""
+
+    expressions = {
+        'cell': 'if(col() % 5 == 0, null(), int(row() * 131 - col() * 7))',
+        'fcell': 'if(row() % 7 == col() % 3, null(), float(row()) / col())',
+        'dcell': 'if(row() == col(), null(), double(row() * 0.5 - col()))',
+    }
+    maps = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        # an odd number of columns leaves a tail for the scalar code
+        cls.runModule('g.region', n=100, s=0, w=0, e=203, res=1)
+        for name, expr in cls.expressions.items():
+            os.environ['GRASS_RASTER_SIMD'] = 'none'
+            try:
+                cls.runModule('r.mapcalc',
+                              expression='%s_none = %s' % (name, expr))
+            finally:
+                del os.environ['GRASS_RASTER_SIMD']
+            cls.runModule('r.mapcalc',
+                          expression='%s_simd = %s' % (name, expr))
+            cls.maps += [name + '_none', name + '_simd']
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.runModule('g.remove', flags='f', type='raster', name=cls.maps)
+        cls.del_temp_region()
+
+    def test_same_values(self):
+        """Compare maps written with and without SIMD"""
+        for name in self.expressions:
+            self.assertRastersNoDifference(actual=name + '_simd',
+                                           reference=name + '_none',
+                                           precision=0)
+
+    def test_converted(self):
+        """Compare maps converted to other types with and without SIMD"""
+        for name in self.expressions:
+            for func in ('int', 'float', 'double'):
+                os.environ['GRASS_RASTER_SIMD'] = 'none'
+                try:
+                    self.runModule('r.mapcalc', overwrite=True,
+                                   expression='conv_none = %s(%s_none)'
+                                   % (func, name))
+                finally:
+                    del os.environ['GRASS_RASTER_SIMD']
+                self.runModule('r.mapcalc', overwrite=True,
+                               expression='conv_simd = %s(%s_simd)'
+                               % (func, name))
+                self.assertRastersNoDifference(actual='conv_simd',
+                                               reference='conv_none',
+                                               precision=0)
+        self.runModule('g.remove', flags='f', type='raster',
+                       name=['conv_none', 'conv_simd'])
+
+
+if __name__ == '__main__':
+    test()
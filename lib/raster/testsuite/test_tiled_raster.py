@@ -0,0 +1,85 @@
+"""Test of raster maps stored in tiles (GRASS_RASTER_TILE_SIZE)
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import os
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+from grass.script import core as gcore
+
+
+class TiledRasterTestCase(TestCase):
+    """Tiled maps must read back like the same maps stored in rows"""
+
+    expressions = {
+        'cell': 'int(row() * 131 + col()) % 1000 - 300',
+        'fcell': 'float(row() * 0.5 + col() * 0.25)',
+        'dcell': 'if(row() % 7 == 0, null(), double(row()) / col())',
+    }
+    maps = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.set_map_region()
+        for name, expr in cls.expressions.items():
+            cls.runModule('r.mapcalc', expression='%s_rows = %s' % (name, expr))
+            os.environ['GRASS_RASTER_TILE_SIZE'] = '128x96'
+            try:
+                cls.runModule('r.mapcalc',
+                              expression='%s_tiles = %s' % (name, expr))
+            finally:
+                del os.environ['GRASS_RASTER_TILE_SIZE']
+            cls.maps += [name + '_rows', name + '_tiles']
+
+    @classmethod
+    def set_map_region(cls):
+        # edge tiles are truncated: neither dimension is a tile multiple
+        cls.runModule('g.region', n=1000, s=0, w=0, e=1210, rows=1000,
+                      cols=1210)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.runModule('g.remove', flags='f', type='raster', name=cls.maps)
+        cls.del_temp_region()
+
+    def setUp(self):
+        self.set_map_region()
+
+    def test_same_values(self):
+        """Compare tiled and row based maps in the map region"""
+        for name in self.expressions:
+            self.assertRastersNoDifference(actual=name + '_tiles',
+                                           reference=name + '_rows',
+                                           precision=0)
+
+    def test_header(self):
+        """Tiled maps are marked in the data file, not in cell_misc"""
+        for name in self.expressions:
+            for suffix, marker in [('_rows', False), ('_tiles', True)]:
+                path = gcore.find_file(name + suffix)['file']
+                with open(path, 'rb') as data:
+                    self.assertEqual(data.read(1) == b'\0', marker)
+                misc = path.replace(os.sep + 'cell' + os.sep,
+                                    os.sep + 'cell_misc' + os.sep)
+                self.assertFalse(os.path.exists(os.path.join(misc, 'tiles')))
+
+    def test_resampled(self):
+        """Compare tiled and row based maps in a shifted, coarser region"""
+        self.runModule('g.region', n=990.5, s=10.5, w=-7.25, e=1195,
+                       nsres=2, ewres=3)
+        for name in self.expressions:
+            self.assertRastersNoDifference(actual=name + '_tiles',
+                                           reference=name + '_rows',
+                                           precision=0)
+
+
+if __name__ == '__main__':
+    test()
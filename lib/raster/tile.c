@@ -0,0 +1,115 @@
+/*!
+   \file lib/raster/tile.c
+
+   \brief Raster library - Tiled raster storage
+
+   A compressed raster map can be stored in tiles instead of rows: the
+   data file then holds one compressed record per tile, and its offset
+   table indexes the tiles (row by row of tiles) instead of the rows.
+   Each tile record has the same layout as a compressed row of the map
+   type, holding the cells of the tile row by row. Tiles at the right
+   and bottom edges of the map are truncated to the map extent. The
+   tile size is stored in the header of the offset table (see
+   format.c), so that readers unaware of tiles refuse the map instead
+   of taking tile offsets for row offsets; the null file stays row
+   based.
+
+   (C) 2026 by the GRASS Development Team
+
+   This program is free software under the GNU General Public License
+   (>=v2).  Read the file COPYING that comes with GRASS for details.
+ */
+
+#include <stdlib.h>
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/glocale.h>
+
+#include "R.h"
+
+/*!
+   \brief Set the tile size for new raster maps
+
+   Compressed raster maps opened for writing after this call are stored
+   in tiles of <i>rows</i> x <i>cols</i> cells. Pass 0 to write row
+   based maps again (the default, unless GRASS_RASTER_TILE_SIZE is
+   set). Reading tiled maps is transparent to Rast_get_row(); see also
+   Rast_get_tile() and Rast_get_block().
+
+   \param rows number of rows of a tile
+   \param cols number of columns of a tile
+ */
+void Rast_set_tile_size(int rows, int cols)
+{
+    Rast__init();
+
+    if (rows <= 0 || cols <= 0)
+	rows = cols = 0;
+
+    R__.tile_rows = rows;
+    R__.tile_cols = cols;
+}
+
+/*!
+   \brief Get the tile size of a raster map
+
+   For row based maps, a tile is one row of the current region.
+
+   \param fd file descriptor of a raster map opened for reading
+   \param[out] rows number of rows of a tile
+   \param[out] cols number of columns of a tile
+
+   \return 1 if the map is stored in tiles
+   \return 0 if the map is row based
+ */
+int Rast_get_tile_size(int fd, int *rows, int *cols)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+
+    if (fcb->tile_rows > 0) {
+	*rows = fcb->tile_rows;
+	*cols = fcb->tile_cols;
+	return 1;
+    }
+
+    *rows = 1;
+    *cols = R__.rd_window.cols;
+
+    return 0;
+}
+
+/*!
+   \brief Get the number of tile columns of a map
+
+   \param fd file descriptor
+
+   \return number of tile columns, 0 for row based maps
+ */
+int Rast__tile_cols(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+
+    if (fcb->tile_rows <= 0)
+	return 0;
+
+    return (fcb->cellhd.cols + fcb->tile_cols - 1) / fcb->tile_cols;
+}
+
+/*!
+   \brief Get the number of records indexed by the offset table
+
+   \param fd file descriptor
+
+   \return number of tiles for tiled maps, number of rows otherwise
+ */
+int Rast__row_ptr_count(int fd)
+{
+    struct fileinfo *fcb = &R__.fileinfo[fd];
+
+    if (fcb->tile_rows <= 0)
+	return fcb->cellhd.rows;
+
+    return Rast__tile_cols(fd) *
+	((fcb->cellhd.rows + fcb->tile_rows - 1) / fcb->tile_rows);
+}
@@ -41,8 +41,10 @@ void Rast__create_window_mapping(int fd)
 
     if (fcb->open_mode >= 0 && fcb->open_mode != OPEN_OLD)	/* open for write? */
 	return;
-    if (fcb->open_mode == OPEN_OLD)	/* already open ? */
+    if (fcb->open_mode == OPEN_OLD) {	/* already open ? */
+	Rast__drop_read_ahead(fd);
 	G_free(fcb->col_map);
+    }
 
     col = fcb->col_map = alloc_index(R__.rd_window.cols);
 
@@ -104,6 +106,18 @@ void Rast__create_window_mapping(int fd)
 	}
     }
 
+    /* find the window columns which map one to one to the data columns,
+       so that whole runs of cells can be converted at once */
+    col = fcb->col_map;
+    for (i = 0; i < R__.rd_window.cols && !col[i]; i++) ;
+    fcb->run_col = i;
+    for (; i < R__.rd_window.cols && col[i] &&
+	 (i == fcb->run_col || col[i] == col[i - 1] + 1); i++) ;
+    fcb->run_cols = i - fcb->run_col;
+    for (; i < R__.rd_window.cols; i++)
+	if (col[i])
+	    fcb->run_cols = 0;
+
     G_debug(3, "create window mapping (%d columns)", R__.rd_window.cols);
     /*  for (i = 0; i < R__.rd_window.cols; i++)
        fprintf(stderr, "%s%ld", i % 15 ? " " : "\n", (long)fcb->col_map[i]);
@@ -38,10 +38,13 @@ int seg_pagein(SEGMENT * SEG, int n)
 {
     int cur;
     int read_result;
+    double t;
 
     /* is n the current segment? */
-    if (n == SEG->scb[SEG->cur].n)
+    if (n == SEG->scb[SEG->cur].n) {
+	G_trace_count("segment cache hits", 1);
 	return SEG->cur;
+    }
 
     /* segment n is in memory ? */
 
@@ -61,9 +64,12 @@ int seg_pagein(SEGMENT * SEG, int n)
 	    SEG->youngest = SEG->scb[cur].age;
 	}
 
+	G_trace_count("segment cache hits", 1);
 	return SEG->cur = cur;
     }
 
+    t = G_trace_begin();
+
     /* find a slot to use to hold segment */
     if (!SEG->nfreeslots) {
 	/* use oldest segment */
@@ -77,8 +83,10 @@ int seg_pagein(SEGMENT * SEG, int n)
 
 	    /* write it out if dirty */
 	    if (SEG->scb[cur].dirty) {
-		if (seg_pageout(SEG, cur) < 0)
+		if (seg_pageout(SEG, cur) < 0) {
+		    G_trace_end("segment", "seg_pagein", t);
 		    return -1;
+		}
 	    }
 	}
     }
@@ -112,6 +120,7 @@ int seg_pagein(SEGMENT * SEG, int n)
 		("Segment pagein: short count during read(), got %d, expected %d",
 		 read_result, SEG->size);
 
+	G_trace_end("segment", "seg_pagein", t);
 	return -1;
     }
 
@@ -123,5 +132,8 @@ int seg_pagein(SEGMENT * SEG, int n)
     SEG->scb[cur].age = SEG->youngest;
     SEG->youngest->cur = cur;
 
+    G_trace_end("segment", "seg_pagein", t);
+    G_trace_count("segment bytes read", SEG->size);
+
     return SEG->cur = cur;
 }
@@ -36,6 +36,8 @@
 
 int seg_pageout(SEGMENT * SEG, int i)
 {
+    double t = G_trace_begin();
+
     SEG->seek(SEG, SEG->scb[i].n, 0);
     errno = 0;
     if (write(SEG->fd, SEG->scb[i].buf, SEG->size) != SEG->size) {
@@ -45,9 +47,13 @@ int seg_pageout(SEGMENT * SEG, int i)
 	    G_warning("Segment pageout: %s", strerror(err));
 	else
 	    G_warning("Segment pageout: insufficient disk space?");
+	G_trace_end("segment", "seg_pageout", t);
 	return -1;
     }
     SEG->scb[i].dirty = 0;
 
+    G_trace_end("segment", "seg_pageout", t);
+    G_trace_count("segment bytes written", SEG->size);
+
     return 1;
 }
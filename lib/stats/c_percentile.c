@@ -1,29 +1,102 @@
+#include <stdlib.h>
 #include <math.h>
 
 #include <grass/gis.h>
 #include <grass/raster.h>
 #include <grass/stats.h>
 
+/* ranks of the values interpolated for a quantile */
+static double quant_ranks(int n, double quant, int *i0, int *i1)
+{
+    double k = n * quant;
+
+    *i0 = (int)floor(k);
+    *i1 = (int)ceil(k);
+    if (*i1 > n - 1)
+	*i1 = n - 1;
+    if (*i0 > *i1)
+	*i0 = *i1;
+
+    return k;
+}
+
+static DCELL quant_value(const DCELL * values, double k, int i0, int i1)
+{
+    return (i0 == i1)
+	? values[i0]
+	: values[i0] * (i1 - k) + values[i1] * (k - i0);
+}
+
 void c_quant(DCELL * result, DCELL * values, int n, const void *closure)
 {
     double quant = *(const double *)closure;
     double k;
-    int i0, i1;
+    int ranks[2];
 
-    n = sort_cell(values, n);
+    n = compact_cell(values, n);
 
     if (n < 1) {
 	Rast_set_d_null_value(result, 1);
 	return;
     }
 
-    k = n * quant;
-    i0 = (int)floor(k);
-    i1 = (int)ceil(k);
+    k = quant_ranks(n, quant, &ranks[0], &ranks[1]);
+    select_cells(values, n, ranks, 2);
 
-    *result = (i0 == i1)
-	? values[i0]
-	: values[i0] * (i1 - k) + values[i1] * (k - i0);
+    *result = quant_value(values, k, ranks[0], ranks[1]);
+}
+
+static int ascending_int(const void *aa, const void *bb)
+{
+    const int *a = aa, *b = bb;
+
+    return (*a > *b) - (*a < *b);
+}
+
+/*!
+   \brief Several quantiles of the same values
+
+   Same as calling c_quant() for each quantile on a copy of the values,
+   but the values are partitioned only once for all quantiles.
+
+   \param results nq results
+   \param values values, reordered
+   \param n number of values
+   \param quants nq quantiles
+   \param nq number of quantiles
+ */
+void c_quantiles(DCELL * results, DCELL * values, int n,
+		 const double *quants, int nq)
+{
+    int stack_ranks[32];
+    int *ranks = stack_ranks;
+    int i;
+
+    n = compact_cell(values, n);
+
+    if (n < 1) {
+	Rast_set_d_null_value(results, nq);
+	return;
+    }
+
+    if (2 * nq > 32)
+	ranks = G_malloc(2 * nq * sizeof(int));
+
+    for (i = 0; i < nq; i++)
+	quant_ranks(n, quants[i], &ranks[2 * i], &ranks[2 * i + 1]);
+    qsort(ranks, 2 * nq, sizeof(int), ascending_int);
+
+    select_cells(values, n, ranks, 2 * nq);
+
+    for (i = 0; i < nq; i++) {
+	int i0, i1;
+	double k = quant_ranks(n, quants[i], &i0, &i1);
+
+	results[i] = quant_value(values, k, i0, i1);
+    }
+
+    if (ranks != stack_ranks)
+	G_free(ranks);
 }
 
 void c_quart1(DCELL * result, DCELL * values, int n, const void *closure)
@@ -47,29 +120,15 @@ void c_perc90(DCELL * result, DCELL * values, int n, const void *closure)
 void w_quant(DCELL * result, DCELL(*values)[2], int n, const void *closure)
 {
     double quant = *(const double *)closure;
-    DCELL total;
-    int i;
-    DCELL k;
 
-    n = sort_cell_w(values, n);
+    n = compact_cell_w(values, n);
 
     if (n < 1) {
 	Rast_set_d_null_value(result, 1);
 	return;
     }
 
-    total = 0.0;
-    for (i = 0; i < n; i++)
-	total += values[i][1];
-
-    k = 0.0;
-    for (i = 0; i < n; i++) {
-	k += values[i][1];
-	if (k >= total * quant)
-	    break;
-    }
-
-    *result = values[i][0];
+    *result = select_cell_w(values, n, quant);
 }
 
 void w_quart1(DCELL * result, DCELL(*values)[2], int n, const void *closure)
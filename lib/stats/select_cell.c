@@ -0,0 +1,378 @@
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/stats.h>
+
+/*
+   order statistics by partial selection instead of sorting
+
+   select_cells() moves the values of the given ranks to their places
+   in the sorted order, as sort_cell() would, with the smaller values
+   before and the larger ones after them; Floyd-Rivest selection takes
+   expected linear time, ranges which do not shrink fast enough are
+   sorted instead
+
+   select_cell_w() selects a weighted quantile the same way, dropping
+   the partitions whose cumulated weight cannot hold the target
+ */
+
+#define SAMPLE_MIN 600		/* smallest range for the sampling step */
+#define CUMULATE_MAX 32		/* largest range cumulated after sorting */
+
+static int ascending(const void *aa, const void *bb)
+{
+    const DCELL *a = aa, *b = bb;
+
+    if (*a < *b)
+	return -1;
+    return (*a > *b);
+}
+
+/* values in ascending order, equal values by their weights */
+static int ascending_w(const void *aa, const void *bb)
+{
+    const DCELL *a = aa, *b = bb;
+
+    if (a[0] != b[0])
+	return a[0] < b[0] ? -1 : 1;
+    return (a[1] > b[1]) - (a[1] < b[1]);
+}
+
+#define SWAP(a, b) do { DCELL t_ = (a); (a) = (b); (b) = t_; } while (0)
+
+/* Floyd-Rivest selection of rank k in array[left .. right] */
+static void select_range(DCELL * array, int left, int right, int k)
+{
+    int iter = 0;
+
+    while (right > left) {
+	DCELL t;
+	int i, j;
+
+	/* smallest or largest value of the range, e.g. the second of the
+	   middle values of an even number of values */
+	if (k == left || k == right) {
+	    j = k;
+	    for (i = left; i <= right; i++)
+		if (k == left ? array[i] < array[j] : array[i] > array[j])
+		    j = i;
+	    SWAP(array[k], array[j]);
+	    return;
+	}
+
+	/* too many unbalanced partitions */
+	if (++iter > 64) {
+	    qsort(&array[left], right - left + 1, sizeof(DCELL), ascending);
+	    return;
+	}
+
+	/* move the range around k to a sample whose k-th value is
+	   close to the one of the whole range */
+	if (right - left > SAMPLE_MIN) {
+	    double n = right - left + 1;
+	    double m = k - left + 1;
+	    double z = log(n);
+	    double s = 0.5 * exp(2 * z / 3);
+	    double sd = 0.5 * sqrt(z * s * (n - s) / n) * (m < n / 2 ? -1 : 1);
+	    int l = (int)(k - m * s / n + sd);
+	    int r = (int)(k + (n - m) * s / n + sd);
+
+	    select_range(array, l > left ? l : left, r < right ? r : right, k);
+	}
+
+	t = array[k];
+	i = left;
+	j = right;
+	SWAP(array[left], array[k]);
+	if (array[right] > t)
+	    SWAP(array[right], array[left]);
+	while (i < j) {
+	    SWAP(array[i], array[j]);
+	    i++;
+	    j--;
+	    while (array[i] < t)
+		i++;
+	    while (array[j] > t)
+		j--;
+	}
+	if (array[left] == t)
+	    SWAP(array[left], array[j]);
+	else {
+	    j++;
+	    SWAP(array[j], array[right]);
+	}
+
+	if (j <= k)
+	    left = j + 1;
+	if (k <= j)
+	    right = j - 1;
+    }
+}
+
+#define SWAP_W(a, b) do { SWAP((a)[0], (b)[0]); SWAP((a)[1], (b)[1]); } while (0)
+
+/* select_range() of values and weights */
+static void select_range_w(DCELL(*array)[2], int left, int right, int k)
+{
+    int iter = 0;
+
+    while (right > left) {
+	DCELL t;
+	int i, j;
+
+	if (k == left || k == right) {
+	    j = k;
+	    for (i = left; i <= right; i++)
+		if (k == left ? array[i][0] < array[j][0]
+		    : array[i][0] > array[j][0])
+		    j = i;
+	    SWAP_W(array[k], array[j]);
+	    return;
+	}
+
+	if (++iter > 64) {
+	    qsort(&array[left], right - left + 1, 2 * sizeof(DCELL),
+		  ascending);
+	    return;
+	}
+
+	if (right - left > SAMPLE_MIN) {
+	    double n = right - left + 1;
+	    double m = k - left + 1;
+	    double z = log(n);
+	    double s = 0.5 * exp(2 * z / 3);
+	    double sd = 0.5 * sqrt(z * s * (n - s) / n) * (m < n / 2 ? -1 : 1);
+	    int l = (int)(k - m * s / n + sd);
+	    int r = (int)(k + (n - m) * s / n + sd);
+
+	    select_range_w(array, l > left ? l : left, r < right ? r : right,
+			   k);
+	}
+
+	t = array[k][0];
+	i = left;
+	j = right;
+	SWAP_W(array[left], array[k]);
+	if (array[right][0] > t)
+	    SWAP_W(array[right], array[left]);
+	while (i < j) {
+	    SWAP_W(array[i], array[j]);
+	    i++;
+	    j--;
+	    while (array[i][0] < t)
+		i++;
+	    while (array[j][0] > t)
+		j--;
+	}
+	if (array[left][0] == t)
+	    SWAP_W(array[left], array[j]);
+	else {
+	    j++;
+	    SWAP_W(array[j], array[right]);
+	}
+
+	if (j <= k)
+	    left = j + 1;
+	if (k <= j)
+	    right = j - 1;
+    }
+}
+
+static void select_ranks(DCELL * array, int left, int right,
+			 const int *ranks, int nranks)
+{
+    int m, lo, hi;
+
+    while (nranks > 0) {
+	m = nranks / 2;
+	select_range(array, left, right, ranks[m]);
+
+	/* ranks below and above the selected one */
+	for (lo = m; lo > 0 && ranks[lo - 1] == ranks[m]; lo--) ;
+	for (hi = m + 1; hi < nranks && ranks[hi] == ranks[m]; hi++) ;
+
+	if (lo > 0)
+	    select_ranks(array, left, ranks[m] - 1, ranks, lo);
+
+	left = ranks[m] + 1;
+	ranks += hi;
+	nranks -= hi;
+    }
+}
+
+/*!
+   \brief Remove the null values
+
+   \param array values
+   \param n number of values
+
+   \return number of non-null values, which are moved to the start
+ */
+int compact_cell(DCELL * array, int n)
+{
+    int i, j;
+
+    j = 0;
+    for (i = 0; i < n; i++) {
+	if (!Rast_is_d_null_value(&array[i])) {
+	    array[j] = array[i];
+	    j++;
+	}
+    }
+
+    return j;
+}
+
+/*!
+   \brief Remove the pairs with a null value or weight
+
+   \param array values and weights
+   \param n number of pairs
+
+   \return number of remaining pairs, which are moved to the start
+ */
+int compact_cell_w(DCELL(*array)[2], int n)
+{
+    int i, j;
+
+    j = 0;
+    for (i = 0; i < n; i++) {
+	if (!Rast_is_d_null_value(&array[i][0]) &&
+	    !Rast_is_d_null_value(&array[i][1])) {
+	    array[j][0] = array[i][0];
+	    array[j][1] = array[i][1];
+	    j++;
+	}
+    }
+
+    return j;
+}
+
+/*!
+   \brief Select the values of the given ranks
+
+   Afterwards array[ranks[i]] holds the same value as after sorting the
+   non-null values with sort_cell(), for each i.
+
+   \param array non-null values
+   \param n number of values
+   \param ranks ranks in ascending order, between 0 and n - 1
+   \param nranks number of ranks
+ */
+void select_cells(DCELL * array, int n, const int *ranks, int nranks)
+{
+    if (n > 1)
+	select_ranks(array, 0, n - 1, ranks, nranks);
+}
+
+/* weighted quantile of all pairs, the weights summed after sorting */
+static DCELL cumulate_sorted_w(DCELL(*array)[2], int n, double quant)
+{
+    DCELL total, k;
+    int i;
+
+    qsort(array, n, 2 * sizeof(DCELL), ascending_w);
+
+    total = 0.0;
+    for (i = 0; i < n; i++)
+	total += array[i][1];
+
+    k = 0.0;
+    for (i = 0; i < n - 1; i++) {
+	k += array[i][1];
+	if (k >= total * quant)
+	    break;
+    }
+
+    return array[i][0];
+}
+
+/*!
+   \brief Select a weighted quantile
+
+   Returns the first value in ascending order at which the sum of the
+   weights of this and the smaller values reaches <em>quant</em> times
+   the total weight, the same value as found by sorting the pairs, equal
+   values by their weights, and summing the weights in that order.
+
+   The pairs are partitioned around the middle rank of the range and
+   the side which cannot hold the target is dropped, until the range
+   is small enough to be sorted and cumulated. The partitions are summed
+   in another order than the sorted pairs, so if the target is reached
+   within the rounding error of the sums, all pairs are sorted instead;
+   sums of integer weights are exact. Negative weights are sorted too.
+
+   \param array values and weights without nulls, reordered
+   \param n number of pairs, at least 1
+   \param quant quantile, between 0 and 1
+
+   \return value
+ */
+DCELL select_cell_w(DCELL(*array)[2], int n, double quant)
+{
+    DCELL total, target, error, below, k, prev;
+    int integral = 1;
+    int left, right, i;
+
+    if (n <= CUMULATE_MAX)
+	return cumulate_sorted_w(array, n, quant);
+
+    total = 0.0;
+    for (i = 0; i < n; i++) {
+	DCELL w = array[i][1];
+
+	if (w < 0)
+	    return cumulate_sorted_w(array, n, quant);
+	if (w != floor(w))
+	    integral = 0;
+	total += w;
+    }
+
+    target = total * quant;
+    /* sums of integers below 2^53 are exact */
+    error = (integral && total < 9007199254740992.0)
+	? 0.0 : 4 * (n + 1) * DBL_EPSILON * total;
+
+    /* weight of the pairs before left */
+    below = 0.0;
+    left = 0;
+    right = n - 1;
+    while (right - left >= CUMULATE_MAX) {
+	int mid = left + (right - left) / 2;
+
+	select_range_w(array, left, right, mid);
+
+	k = below;
+	for (i = left; i < mid; i++)
+	    k += array[i][1];
+
+	if (k >= target)
+	    right = mid - 1;
+	else if (k + array[mid][1] < target) {
+	    below = k + array[mid][1];
+	    left = mid + 1;
+	}
+	else {
+	    below = k;
+	    left = right = mid;
+	}
+    }
+
+    qsort(&array[left], right - left + 1, 2 * sizeof(DCELL), ascending_w);
+
+    prev = k = below;
+    for (i = left; i <= right; i++) {
+	prev = k;
+	k += array[i][1];
+	if (k >= target)
+	    break;
+    }
+
+    if (i <= right && prev < target - error && k >= target + error)
+	return array[i][0];
+
+    return cumulate_sorted_w(array, n, quant);
+}
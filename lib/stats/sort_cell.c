@@ -27,16 +27,7 @@ static int ascending(const void *aa, const void *bb)
 
 int sort_cell(DCELL * array, int n)
 {
-    int i, j;
-
-    j = 0;
-    for (i = 0; i < n; i++) {
-	if (!Rast_is_d_null_value(&array[i])) {
-	    array[j] = array[i];
-	    j++;
-	}
-    }
-    n = j;
+    n = compact_cell(array, n);
 
     if (n > 0)
 	qsort(array, n, sizeof(DCELL), ascending);
@@ -46,18 +37,7 @@ int sort_cell(DCELL * array, int n)
 
 int sort_cell_w(DCELL(*array)[2], int n)
 {
-    int i, j;
-
-    j = 0;
-    for (i = 0; i < n; i++) {
-	if (!Rast_is_d_null_value(&array[i][0]) &&
-	    !Rast_is_d_null_value(&array[i][1])) {
-	    array[j][0] = array[i][0];
-	    array[j][1] = array[i][1];
-	    j++;
-	}
-    }
-    n = j;
+    n = compact_cell_w(array, n);
 
     if (n > 0)
 	qsort(array, n, 2 * sizeof(DCELL), ascending);
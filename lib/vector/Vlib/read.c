@@ -161,6 +161,7 @@ int Vect_read_line(const struct Map_info *Map,
 		   struct line_pnts *line_p, struct line_cats *line_c, int line)
 {
     int ret;
+    double t;
     
     G_debug(3, "Vect_read_line(): line = %d", line);
 
@@ -174,7 +175,9 @@ int Vect_read_line(const struct Map_info *Map,
         return -1;
     }
     
+    t = G_trace_begin();
     ret = (*Read_line_array[Map->format]) (Map, line_p, line_c, line);
+    G_trace_end("vector", "Vect_read_line", t);
 
     if (ret == -1)
 	G_warning(_("Unable to read feature %d from vector map <%s>"),
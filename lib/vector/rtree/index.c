@@ -298,9 +298,16 @@ void RTreeDestroyTree(struct RTree *t)
 int RTreeSearch(struct RTree *t, struct RTree_Rect *r,
                 SearchHitCallback *shcb, void *cbarg)
 {
+    double start;
+    int hits;
+
     assert(r && t);
 
-    return t->search_rect(t, r, shcb, cbarg);
+    start = G_trace_begin();
+    hits = t->search_rect(t, r, shcb, cbarg);
+    G_trace_end("vector", "RTreeSearch", start);
+
+    return hits;
 }
 
 /*!
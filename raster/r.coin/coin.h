@@ -39,7 +39,6 @@ extern long *catlist1, *catlist2;
 extern int no_data1, no_data2;
 extern int Rndex, Cndex;
 extern const char *dumpname;
-extern const char *statname;
 extern FILE *dumpfile;
 
 extern const char *map1name, *map2name;
@@ -35,7 +35,6 @@ long *catlist1, *catlist2;
 int no_data1, no_data2;
 int Rndex, Cndex;
 const char *dumpname;
-const char *statname;
 FILE *dumpfile;
 
 const char *map1name, *map2name;
@@ -110,7 +109,6 @@ int main(int argc, char *argv[])
     Rast_set_window(&window);
 
     dumpname = G_tempfile();
-    statname = G_tempfile();
 
     window_cells = Rast_window_rows() * Rast_window_cols();
 
@@ -126,7 +124,6 @@ int main(int argc, char *argv[])
     print_coin(*parm.units->answer, flag.w->answer ? 132 : 80, 0);
 
     remove(dumpname);
-    remove(statname);
 
     exit(EXIT_SUCCESS);
 }
@@ -23,88 +23,129 @@
 #include <grass/raster.h>
 #include <grass/glocale.h>
 
+/* floating-point maps are divided into the steps of r.stats -r */
+#define NSTEPS 255
+
 static int cmp(const void *, const void *);
 
+static int open_map(const char *name, int *is_fp)
+{
+    int fd = Rast_open_old(name, "");
+
+    *is_fp = Rast_map_is_fp(name, "");
+    if (*is_fp) {
+	struct FPRange fp_range;
+	struct Quant q;
+	DCELL dmin, dmax;
+
+	if (Rast_read_fp_range(name, "", &fp_range) < 0)
+	    G_fatal_error(_("Unable to read fp range of raster map <%s>"),
+			  name);
+	Rast_get_fp_range_min_max(&fp_range, &dmin, &dmax);
+
+	Rast_quant_init(&q);
+	Rast_quant_add_rule(&q, dmin, dmax, 1, NSTEPS + 1);
+	Rast_set_quant_rules(fd, &q);
+	Rast_quant_free(&q);
+    }
+
+    return fd;
+}
+
+static void read_row(int fd, int is_fp, CELL * cell, int row, int ncols)
+{
+    Rast_get_c_row(fd, cell, row);
+
+    /* include max FP value in the last step */
+    if (is_fp)
+	while (ncols-- > 0)
+	    if (!Rast_is_c_null_value(&cell[ncols]) && cell[ncols] > NSTEPS)
+		cell[ncols] = NSTEPS;
+}
 
 int make_coin(void)
 {
-    FILE *fp;
-    FILE *stat_fp;
-    struct stats
-    {
-	long cat1;
-	long cat2;
-	long count;
-	double area;
-    } stats;
+    struct Cross_stats stats;
+    CELL *cell1, *cell2;
+    CELL key[2];
+    long count;
+    double area;
+    int fd1, fd2, is_fp1, is_fp2;
+    int nrows, ncols, row, col;
+    int planimetric;
+    double unit_area;
+    long *cat1, *cat2;
     int n, n1, n2;
     int reversed;
-    char input[GNAME_MAX*2+8];
-    const char *args[5];
-    struct Popen child;
-    char buf[512];
-    int count;
 
     G_message(_("Tabulating Coincidence between '%s' and '%s'"),
 	      map1name, map2name);
 
-    sprintf(input, "input=%s,%s", map1name, map2name);
+    fd1 = open_map(map1name, &is_fp1);
+    fd2 = open_map(map2name, &is_fp2);
 
-    args[0] = "r.stats";
-    args[1] = "-anrc";
-    args[2] = "separator=:";
-    args[3] = input;
-    args[4] = NULL;
+    /* the areas of planimetric cells are counted, the others summed
+       (main() computed the area of the region on a window of one cell) */
+    G_set_window(&window);
+    planimetric = G_begin_cell_area_calculations() < 2;
+    unit_area = G_area_of_cell_at_row(0);
 
-    stat_fp = fopen(statname, "w");
-    if (!stat_fp)
-	G_fatal_error(_("Unable to create any tempfiles"));
+    nrows = Rast_window_rows();
+    ncols = Rast_window_cols();
+    cell1 = Rast_allocate_c_buf();
+    cell2 = Rast_allocate_c_buf();
 
-    fp = G_popen_read(&child, "r.stats", args);
-    if (!fp)
-	G_fatal_error(_("Unable to run r.stats"));
+    Rast_init_cross_stats(&stats, 2, planimetric ? 0 : 1, NULL);
 
-    /* need to find the number of cats in each file */
-    count = 0;
-    while (fgets(buf, sizeof buf, fp)) {
-	if (sscanf(buf, "%ld:%ld:%lf:%ld",
-		   &stats.cat1, &stats.cat2, &stats.area, &stats.count) != 4)
-	    G_fatal_error(_("Unexpected output from r.stats"));
+    for (row = 0; row < nrows; row++) {
+	double row_area = G_area_of_cell_at_row(row);
 
-	fwrite(&stats, sizeof(stats), 1, stat_fp);
-	count++;
-    }
+	G_percent(row, nrows, 2);
+
+	read_row(fd1, is_fp1, cell1, row, ncols);
+	read_row(fd2, is_fp2, cell2, row, ncols);
 
-    G_popen_close(&child);
+	for (col = 0; col < ncols; col++) {
+	    /* no data in either map is not counted */
+	    if (Rast_is_c_null_value(&cell1[col]) ||
+		Rast_is_c_null_value(&cell2[col]))
+		continue;
 
-    fclose(stat_fp);
+	    key[0] = cell1[col];
+	    key[1] = cell2[col];
+	    Rast_update_cross_stats(&stats, key, 1,
+				    planimetric ? NULL : &row_area);
+	}
+    }
+    G_percent(nrows, nrows, 2);
 
-    stat_fp = fopen(statname, "r");
-    if (!stat_fp)
-	G_fatal_error(_("Unable to open tempfile"));
+    G_free(cell1);
+    G_free(cell2);
+    Rast_close(fd1);
+    Rast_close(fd2);
 
     /* build a sorted list of cats in both maps */
-    catlist1 = (long *)G_calloc(count * 2, sizeof(long));
-    catlist2 = catlist1 + count;
+    catlist1 = (long *)G_calloc(stats.n * 2 + 2, sizeof(long));
+    catlist2 = catlist1 + stats.n + 1;
 
-    /* read the statsfile to get the cat lists */
+    /* the combinations come sorted by the first cat */
     count = 0;
-    while (fread(&stats, sizeof(stats), 1, stat_fp)) {
-	catlist1[count] = stats.cat1;
-	catlist2[count++] = stats.cat2;
+    Rast_rewind_cross_stats(&stats);
+    for (n = 0; Rast_next_cross_stat(&stats, key, &count, &area); n++) {
+	catlist1[n] = key[0];
+	catlist2[n] = key[1];
     }
 
-    /* sort both lists */
-    qsort(catlist1, count, sizeof(long), cmp);
-    qsort(catlist2, count, sizeof(long), cmp);
+    /* sort the second list */
+    qsort(catlist2, n, sizeof(long), cmp);
 
     /* collapse the lists so each cat appears only once */
-    ncat1 = collapse(catlist1, count);
-    ncat2 = collapse(catlist2, count);
+    ncat1 = collapse(catlist1, n);
+    ncat2 = collapse(catlist2, n);
 
     /* copy catlist2 to end of catlist1, then free the unused memory */
-    for (count = 0; count < ncat2; count++)
-	catlist1[ncat1 + count] = catlist2[count];
+    for (n = 0; n < ncat2; n++)
+	catlist1[ncat1 + n] = catlist2[n];
     catlist1 = (long *)G_realloc(catlist1, (ncat1 + ncat2) * sizeof(long));
     catlist2 = catlist1 + ncat1;
 
@@ -149,35 +190,27 @@ int make_coin(void)
 	if (catlist2[no_data2] == 0)
 	    break;
 
-    /* now read the statsfile and insert into the table */
-    G_fseek(stat_fp, 0L, 0);
-    while (fread(&stats, sizeof(stats), 1, stat_fp)) {
-	long z;
+    /* now insert the combinations into the table */
+    Rast_rewind_cross_stats(&stats);
+    while (Rast_next_cross_stat(&stats, key, &count, &area)) {
+	long c1 = reversed ? key[1] : key[0];
+	long c2 = reversed ? key[0] : key[1];
 
-	if (reversed) {
-	    z = stats.cat1;
-	    stats.cat1 = stats.cat2;
-	    stats.cat2 = z;
-	}
+	/* index these cats in their respective list */
+	cat1 = bsearch(&c1, catlist1, ncat1, sizeof(long), cmp);
+	cat2 = bsearch(&c2, catlist2, ncat2, sizeof(long), cmp);
+	n1 = cat1 - catlist1;
+	n2 = cat2 - catlist2;
 
-	/*
-	 * search the catlists to index these cats in their respective list
-	 * (this could be sped up by doing a binary search)
-	 */
-	for (n1 = 0; n1 < ncat1; n1++)
-	    if (catlist1[n1] == stats.cat1)
-		break;
-	for (n2 = 0; n2 < ncat2; n2++)
-	    if (catlist2[n2] == stats.cat2)
-		break;
 	/*
 	 * insert the coincidence count, area into the table
 	 */
 	n = n2 * ncat1 + n1;
-	table[n].count = stats.count;
-	table[n].area = stats.area;
+	table[n].count = count;
+	table[n].area = planimetric ? count * unit_area : area;
     }
-    fclose(stat_fp);
+
+    Rast_free_cross_stats(&stats);
 
     return 0;
 }
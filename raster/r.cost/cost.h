@@ -12,6 +12,9 @@
 #ifndef __COST_H__
 #define __COST_H__
 
+#include <grass/segment.h>
+#include "flag.h"
+
 struct cost
 {
     double min_cost;
@@ -21,10 +24,35 @@ struct cost
 };
 
 /* heap.c */
-struct cost *insert(double, int, int);
+int insert(double, int, int);
 struct cost *get_lowest(void);
-int delete(struct cost *);
 int init_heap(void);
 int free_heap(void);
 
+/* cell of the cost segment file */
+struct cc
+{
+    double cost_in, cost_out, nearest;
+};
+
+struct tile_search
+{
+    SEGMENT *cost_seg, *dir_seg, *solve_seg;
+    SEGMENT pred_seg;		/* set by tile_search_open() */
+    int nrows, ncols;
+    int srows, scols;		/* tile size, same as segment size */
+    int total_reviewed;		/* 8 or 16 neighbors */
+    int dir, dir_bin, have_solver;
+    double fac[5];		/* EW, NS, DIAG, V_DIAG, H_DIAG */
+    int have_max;
+    double max_cost;
+    int batch;			/* tiles read at a time */
+};
+
+/* tile.c */
+void tile_search_open(struct tile_search *, int);
+int tile_search(struct tile_search *, FLAG *);
+int tile_search_stop(struct tile_search *, double);
+void tile_search_close(struct tile_search *);
+
 #endif /* __COST_H__ */
@@ -23,23 +23,31 @@
  *
  ***************************************************************************/
 
-/* These routines manage the list of grid-cell candidates for 
+/* These routines manage the list of grid-cell candidates for
  * visiting to calculate distances to surrounding cells.
- * A min-heap approach is used.  Components are
- * sorted first by distance then by the order in which they were added.
+ * Components are sorted first by distance then by the order in which
+ * they were added.
+ *
+ * A radix heap is used as long as no distance smaller than the last
+ * retrieved one is inserted, which is the case for non-negative costs.
+ * The distances are mapped to unsigned integers in the same order, and
+ * each entry is kept in the bucket of the highest bit in which it
+ * differs from the last retrieved distance. The buckets keep the order
+ * of insertion, so that equal distances are retrieved in that order.
+ * When a smaller distance is inserted, all entries are moved to a min
+ * heap, which is used from then on.
  *
  * insert ()
  *   inserts a new row-col with its distance value into the heap
  *
- * delete()
- *   deletes a row-col entry in the heap
- *
  * get_lowest()
- *   retrieves the entry with the smallest distance value
+ *   retrieves the entry with the smallest distance value, which is
+ *   valid until the next call
  */
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <grass/gis.h>
 #include <grass/glocale.h>
 #include "cost.h"
@@ -47,37 +55,68 @@
 #define GET_PARENT(c) (((c) - 2) / 3 + 1)
 #define GET_CHILD(p) (((p) * 3) - 1)
 
+#define NBUCKETS 65
+
+struct bucket
+{
+    struct cost *pnt;
+    long first, n, alloced;	/* entries first..n-1 are used */
+};
+
 static long next_point = 0;
+static int use_radix;
+
+/* radix heap */
+static struct bucket bucket[NBUCKETS];
+static unsigned long long last_key;
+static long radix_size;
+
+/* min heap */
 static long heap_size = 0;
 static long heap_alloced = 0;
-static struct cost **heap_index, *free_point;
+static struct cost *heap_index;
+
+static struct cost lowest;
 
 int init_heap(void)
 {
+    int i;
+
     next_point = 0;
+    use_radix = 1;
+
+    for (i = 0; i < NBUCKETS; i++) {
+	bucket[i].pnt = NULL;
+	bucket[i].first = bucket[i].n = bucket[i].alloced = 0;
+    }
+    last_key = 0;
+    radix_size = 0;
+
     heap_size = 0;
     heap_alloced = 1000;
-    heap_index = (struct cost **) G_malloc(heap_alloced * sizeof(struct cost *));
+    heap_index = (struct cost *) G_malloc(heap_alloced * sizeof(struct cost));
 
-    free_point = NULL;
-    
     return 0;
 }
 
 int free_heap(void)
 {
+    int i;
+
+    for (i = 0; i < NBUCKETS; i++)
+	if (bucket[i].alloced)
+	    G_free(bucket[i].pnt);
+
     if (heap_alloced)
 	G_free(heap_index);
-
-    if (free_point)
-	G_free(free_point);
+    heap_alloced = 0;
 
     return 0;
 }
 
 /* compare two costs
  * return 1 if a < b else 0 */
-int cmp_costs(struct cost *a, struct cost *b)
+static int cmp_costs(const struct cost *a, const struct cost *b)
 {
     if (a->min_cost < b->min_cost)
 	return 1;
@@ -89,9 +128,10 @@ int cmp_costs(struct cost *a, struct cost *b)
     return 0;
 }
 
-long sift_up(long start, struct cost * child_pnt)
+static long sift_up(long start, const struct cost *child_pnt)
 {
     register long parent, child;
+    struct cost pnt = *child_pnt;
 
     child = start;
 
@@ -99,7 +139,7 @@ long sift_up(long start, struct cost * child_pnt)
 	parent = GET_PARENT(child);
 
 	/* child is smaller */
-	if (cmp_costs(child_pnt, heap_index[parent])) {
+	if (cmp_costs(&pnt, &heap_index[parent])) {
 	    /* push parent point down */
 	    heap_index[child] = heap_index[parent];
 	    child = parent;
@@ -111,58 +151,37 @@ long sift_up(long start, struct cost * child_pnt)
 
     /* put point in new slot */
     if (child < start) {
-	heap_index[child] = child_pnt;
+	heap_index[child] = pnt;
     }
 
     return child;
 }
 
-struct cost *insert(double min_cost, int row, int col)
+static void heap_insert(const struct cost *pnt)
 {
-    struct cost *new_cell;
-
-    if (free_point) {
-	new_cell = free_point;
-	free_point = NULL;
-    }
-    else
-	new_cell = (struct cost *)(G_malloc(sizeof(struct cost)));
-
-    new_cell->min_cost = min_cost;
-    new_cell->age = next_point;
-    new_cell->row = row;
-    new_cell->col = col;
-
-    next_point++;
     heap_size++;
     if (heap_size >= heap_alloced) {
 	heap_alloced += 1000;
-	heap_index = (struct cost **) G_realloc((void *)heap_index, heap_alloced * sizeof(struct cost *));
+	heap_index = (struct cost *) G_realloc((void *)heap_index, heap_alloced * sizeof(struct cost));
     }
 
-    heap_index[heap_size] = new_cell;
-    sift_up(heap_size, new_cell);
-
-    return (new_cell);
+    heap_index[heap_size] = *pnt;
+    sift_up(heap_size, pnt);
 }
 
-struct cost *get_lowest(void)
+static struct cost *heap_get_lowest(void)
 {
-    struct cost *next_cell;
     register long parent, child, childr, i;
 
     if (heap_size == 0)
 	return NULL;
-	
-    next_cell = heap_index[1];
-    heap_index[0] = next_cell;
+
+    lowest = heap_index[1];
 
     if (heap_size == 1) {
 	heap_size--;
 
-	heap_index[1] = NULL;
-
-	return next_cell;
+	return &lowest;
     }
 
     /* start with root */
@@ -177,7 +196,7 @@ struct cost *get_lowest(void)
 	    i = child + 3;
 	    while (childr < i && childr <= heap_size) {
 		/* get smallest child */
-		if (cmp_costs(heap_index[childr], heap_index[child])) {
+		if (cmp_costs(&heap_index[childr], &heap_index[child])) {
 		    child = childr;
 		}
 		childr++;
@@ -194,21 +213,150 @@ struct cost *get_lowest(void)
 	heap_index[parent] = heap_index[heap_size];
 
 	/* sift up last swapped point, only necessary if hole moved to heap end */
-	sift_up(parent, heap_index[parent]);
+	sift_up(parent, &heap_index[parent]);
     }
 
     /* the actual drop */
     heap_size--;
 
-    return next_cell;
+    return &lowest;
+}
+
+/* unsigned integer in the order of the distances */
+static unsigned long long cost_key(double min_cost)
+{
+    unsigned long long key;
+
+    /* -0 and 0 are equal distances */
+    if (min_cost == 0)
+	min_cost = 0;
+
+    memcpy(&key, &min_cost, sizeof(key));
+    if (key >> 63)
+	return ~key;
+
+    return key | (1ULL << 63);
 }
 
-int delete(struct cost *delete_cell)
+/* bucket of a key: 0 for the last key, else the highest different bit + 1 */
+static int key_bucket(unsigned long long key)
 {
-    if (free_point)
-	G_free(delete_cell);
-    else
-	free_point = delete_cell;
+    unsigned long long diff = key ^ last_key;
+    int shift, b;
+
+    if (!diff)
+	return 0;
+
+    b = 1;
+    for (shift = 32; shift; shift >>= 1) {
+	if (diff >> shift) {
+	    diff >>= shift;
+	    b += shift;
+	}
+    }
+
+    return b;
+}
+
+static void bucket_append(struct bucket *bkt, const struct cost *pnt)
+{
+    if (bkt->n >= bkt->alloced) {
+	bkt->alloced = bkt->alloced ? bkt->alloced * 2 : 64;
+	bkt->pnt = (struct cost *) G_realloc(bkt->pnt, bkt->alloced * sizeof(struct cost));
+    }
+    bkt->pnt[bkt->n++] = *pnt;
+}
+
+/* move all entries to the min heap */
+static void radix_to_heap(void)
+{
+    int b;
+    long i;
+
+    G_debug(1, "Costs are not monotone, switching to a min heap");
+
+    for (b = 0; b < NBUCKETS; b++) {
+	for (i = bucket[b].first; i < bucket[b].n; i++)
+	    heap_insert(&bucket[b].pnt[i]);
+	bucket[b].first = bucket[b].n = 0;
+    }
+    radix_size = 0;
+    use_radix = 0;
+}
+
+static struct cost *radix_get_lowest(void)
+{
+    struct bucket *bkt0 = &bucket[0];
+
+    if (radix_size == 0)
+	return NULL;
+
+    if (bkt0->first == bkt0->n) {
+	struct bucket *bkt;
+	unsigned long long min_key;
+	long i;
+	int b;
+
+	/* the first non-empty bucket holds the smallest distances */
+	bkt0->first = bkt0->n = 0;
+	for (b = 1; bucket[b].n == 0; b++) ;
+	bkt = &bucket[b];
+
+	min_key = cost_key(bkt->pnt[0].min_cost);
+	for (i = 1; i < bkt->n; i++) {
+	    unsigned long long key = cost_key(bkt->pnt[i].min_cost);
+
+	    if (key < min_key)
+		min_key = key;
+	}
+
+	/* redistribute to the lower, empty buckets in the same order */
+	last_key = min_key;
+	for (i = 0; i < bkt->n; i++)
+	    bucket_append(&bucket[key_bucket(cost_key(bkt->pnt[i].min_cost))],
+			  &bkt->pnt[i]);
+	bkt->n = 0;
+    }
+
+    lowest = bkt0->pnt[bkt0->first++];
+    radix_size--;
+
+    return &lowest;
+}
+
+int insert(double min_cost, int row, int col)
+{
+    struct cost new_cell;
+
+    new_cell.min_cost = min_cost;
+    new_cell.age = next_point;
+    new_cell.row = row;
+    new_cell.col = col;
+
+    next_point++;
+
+    if (use_radix) {
+	unsigned long long key = cost_key(min_cost);
+
+	if (key >= last_key) {
+	    bucket_append(&bucket[key_bucket(key)], &new_cell);
+	    radix_size++;
+
+	    return 0;
+	}
+
+	radix_to_heap();
+    }
+
+    heap_insert(&new_cell);
 
     return 0;
 }
+
+struct cost *get_lowest(void)
+{
+    if (use_radix)
+	return radix_get_lowest();
+
+    return heap_get_lowest();
+}
@@ -131,18 +131,17 @@ int main(int argc, char *argv[])
     int keep_nulls = 1;
     int start_with_raster_vals = 1;
     int neighbor;
+    int threads;
     long n_processed = 0;
     long total_cells;
     struct GModule *module;
     struct Flag *flag2, *flag3, *flag4, *flag5, *flag6;
     struct Option *opt1, *opt2, *opt3, *opt4, *opt5, *opt6, *opt7, *opt8;
-    struct Option *opt9, *opt10, *opt11, *opt12, *opt_solve;
+    struct Option *opt9, *opt10, *opt11, *opt12, *opt_solve, *opt_nprocs;
     struct cost *pres_cell;
     struct start_pt *head_start_pt = NULL;
     struct start_pt *next_start_pt;
-    struct cc {
-	double cost_in, cost_out, nearest;
-    } costs;
+    struct cc costs;
     FLAG *visited;
 
     void *ptr2;
@@ -258,6 +257,8 @@ int main(int argc, char *argv[])
     opt10->answer = "300";
     opt10->description = _("Maximum memory to be used in MB");
 
+    opt_nprocs = G_define_standard_option(G_OPT_M_NPROCS);
+
     flag2 = G_define_flag();
     flag2->key = 'k';
     flag2->description =
@@ -286,6 +287,8 @@ int main(int argc, char *argv[])
     if (G_parser(argc, argv))
 	exit(EXIT_FAILURE);
 
+    threads = G_set_num_threads(atoi(opt_nprocs->answer));
+
     /* If no outdir is specified, set flag to skip all dir */
     if (opt11->answer != NULL)
 	dir = 1;
@@ -417,20 +420,6 @@ int main(int argc, char *argv[])
     }
     G_debug(1, "  %d rows, %d cols", nrows, ncols);
 
-    /* this is most probably the limitation of r.cost for large datasets
-     * segment size needs to be reduced to avoid unnecessary disk IO
-     * but it doesn't make sense to go down to 1
-     * so use 64 segment rows and cols for <= 200 million cells
-     * for larger regions, 32 segment rows and cols
-     * maybe go down to 16 for > 500 million cells ? */
-    if ((double) nrows * ncols > 200000000)
-	srows = scols = SEGCOLSIZE / 2;
-    else
-	srows = scols = SEGCOLSIZE;
-
-    /* calculate total number of segments */
-    nseg = ((nrows + srows - 1) / srows) * ((ncols + scols - 1) / scols);
-
     /* calculate disk space and memory requirements */
     /* (nrows + ncols) * 8. * 20.0 / 1048576. for Dijkstra search */
     pq_mb = ((double)nrows + ncols) * 8. * 20.0 / 1048576.;
@@ -444,6 +433,25 @@ int main(int argc, char *argv[])
 	nbytes += 4;
     if (have_solver)
 	nbytes += 16;
+    if (threads > 1)
+	nbytes += 1;
+
+    /* this is most probably the limitation of r.cost for large datasets:
+     * the cells around the search front are visited in the order of
+     * their costs, so the segments along the front should stay in memory.
+     * The front is at most about 2 * (nrows + ncols) cells long and
+     * touches a band of segments along it, so the segment size is reduced
+     * until that band fits, unless all segments fit anyway.
+     * It doesn't make sense to go below 16 segment rows and cols */
+    srows = scols = SEGCOLSIZE;
+    while (srows > SEGCOLSIZE / 4 &&
+	   (double) nrows * ncols * nbytes / 1048576. > maxmem &&
+	   2. * ((double)nrows + ncols) * srows * nbytes / 1048576. > maxmem)
+	srows = scols = srows / 2;
+    G_debug(1, "segment size: %d x %d", srows, scols);
+
+    /* calculate total number of segments */
+    nseg = ((nrows + srows - 1) / srows) * ((ncols + scols - 1) / scols);
 
     disk_mb = (double) nrows * ncols * nbytes / 1048576.;
     segments_in_memory = maxmem / 
@@ -820,9 +828,65 @@ int main(int argc, char *argv[])
     n_processed = 0;
     visited = flag_create(nrows, ncols);
 
-    pres_cell = get_lowest();
+    if (threads > 1) {
+	/* search tiles in parallel, see tile.c */
+	struct tile_search ts;
+	int rounds, i;
+
+	/* the heap only holds the start points */
+	while ((pres_cell = get_lowest()) != NULL)
+	    FLAG_SET(visited, pres_cell->row, pres_cell->col);
+
+	ts.cost_seg = &cost_seg;
+	ts.dir_seg = &dir_seg;
+	ts.solve_seg = &solve_seg;
+	ts.nrows = nrows;
+	ts.ncols = ncols;
+	ts.srows = srows;
+	ts.scols = scols;
+	ts.total_reviewed = total_reviewed;
+	ts.dir = dir;
+	ts.dir_bin = dir_bin;
+	ts.have_solver = have_solver;
+	ts.fac[0] = EW_fac;
+	ts.fac[1] = NS_fac;
+	ts.fac[2] = DIAG_fac;
+	ts.fac[3] = V_DIAG_fac;
+	ts.fac[4] = H_DIAG_fac;
+	ts.have_max = maxcost != 0;
+	ts.max_cost = maxcost;
+	ts.batch = 4 * threads;
+
+	tile_search_open(&ts, segments_in_memory);
+	rounds = tile_search(&ts, visited);
+
+	/* the serial search stops once all stop points are reached:
+	 * cut the costs at the highest cost of a stop point */
+	if (stop_pnts) {
+	    double stop_cost = 0;
+
+	    for (i = 0; i < n_stop_pnts; i++) {
+		if (stop_pnts[i].r < 0 || stop_pnts[i].r >= nrows ||
+		    stop_pnts[i].c < 0 || stop_pnts[i].c >= ncols)
+		    break;
+		if (Segment_get(&cost_seg, &costs, stop_pnts[i].r,
+				stop_pnts[i].c) < 0)
+		    G_fatal_error(_("Can not read from temporary file"));
+		if (Rast_is_d_null_value(&costs.cost_out) ||
+		    (maxcost && (double)maxcost < costs.cost_out))
+		    break;
+		if (i == 0 || costs.cost_out > stop_cost)
+		    stop_cost = costs.cost_out;
+	    }
+	    if (i == n_stop_pnts)
+		rounds += tile_search_stop(&ts, stop_cost);
+	}
+	tile_search_close(&ts);
+	G_verbose_message(_("%d rounds of searching tiles"), rounds);
+    }
+
+    pres_cell = threads > 1 ? NULL : get_lowest();
     while (pres_cell != NULL) {
-	struct cost *ct;
 	double N, NE, E, SE, S, SW, W, NW;
 	double NNE, ENE, ESE, SSE, SSW, WSW, WNW, NNW;
 
@@ -839,13 +903,11 @@ int main(int argc, char *argv[])
 	old_min_cost = costs.cost_out;
 	if (!Rast_is_d_null_value(&old_min_cost)) {
 	    if (pres_cell->min_cost > old_min_cost) {
-		delete(pres_cell);
 		pres_cell = get_lowest();
 		continue;
 	    }
 	}
 	if (FLAG_GET(visited, pres_cell->row, pres_cell->col)) {
-	    delete(pres_cell);
 	    pres_cell = get_lowest();
 	    continue;
 	}
@@ -1121,8 +1183,7 @@ int main(int argc, char *argv[])
 	    if (Rast_is_d_null_value(&min_cost))
 		continue;
 
-	    if (Segment_get(&cost_seg, &costs, row, col) < 0)
-		G_fatal_error(_("Can not read from temporary file"));
+	    /* costs still holds the neighbor */
 	    old_min_cost = costs.cost_out;
 
 	    /* add to list */
@@ -1222,12 +1283,7 @@ int main(int argc, char *argv[])
 	if (stop_pnts && time_to_stop(pres_cell->row, pres_cell->col))
 	    break;
 
-	ct = pres_cell;
-	delete(pres_cell);
 	pres_cell = get_lowest();
-
-	if (ct == pres_cell)
-	    G_warning(_("Error, ct == pres_cell"));
     }
     G_percent(1, 1, 1);
 
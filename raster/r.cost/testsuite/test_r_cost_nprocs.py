@@ -0,0 +1,74 @@
+"""Test of r.cost searching tiles in parallel
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+START = [10.5, 10.5, 250.5, 150.5, 100.5, 100.5]
+COST = ('if((row() * 7 + col() * 3) % 31 == 0, null(), '
+        '0.5 + abs(sin(row() * 3.0) * cos(col() * 5.0)) * 10)')
+
+
+class TestNprocs(TestCase):
+    """Same maps with one and several threads"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        # several tiles, the last ones partial
+        cls.runModule('g.region', n=200, s=0, w=0, e=300, res=1)
+        cls.runModule('r.mapcalc', expression='cst = ' + COST)
+        cls.to_remove.append('cst')
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+
+    def compare(self, name, input='cst', **kwargs):
+        outputs = {}
+        for nprocs in [1, 4]:
+            maps = ['%s_%s_%d' % (name, key, nprocs)
+                    for key in ['cost', 'dir', 'near']]
+            self.to_remove.extend(maps)
+            self.assertModule('r.cost', input=input,
+                              start_coordinates=START, output=maps[0],
+                              outdir=maps[1], nearest=maps[2],
+                              nprocs=nprocs, overwrite=True, **kwargs)
+            outputs[nprocs] = maps
+        for actual, reference in zip(outputs[4], outputs[1]):
+            self.assertRastersNoDifference(actual=actual, reference=reference,
+                                           precision=0)
+
+    def test_search(self):
+        """Costs, directions and nearest start points"""
+        self.compare('plain')
+        self.compare('bitmask', flags='b')
+
+    def test_segments(self):
+        """Knight's move with segment files"""
+        # too large for the smallest amount of memory
+        self.runModule('g.region', n=800, s=0, w=0, e=800, res=1)
+        self.runModule('r.mapcalc', expression='cst_large = ' + COST)
+        self.to_remove.append('cst_large')
+        self.compare('knight', input='cst_large', flags='k', memory=1)
+        self.runModule('g.region', n=200, s=0, w=0, e=300, res=1)
+
+    def test_stop(self):
+        """Stop points and maximum cost"""
+        self.compare('stop', stop_coordinates=[200.5, 150.5])
+        self.compare('max', max_cost=150, flags='k')
+
+
+if __name__ == '__main__':
+    test()
@@ -0,0 +1,539 @@
+
+/****************************************************************************
+ *
+ * MODULE:       r.cost
+ *
+ * PURPOSE:      Parallel search of cumulative costs, tile by tile
+ *
+ * COPYRIGHT:    (C) 2026 by the GRASS Development Team
+ *
+ *               This program is free software under the GNU General Public
+ *               License (>=v2). Read the file COPYING that comes with GRASS
+ *               for details.
+ *
+ ***************************************************************************/
+
+/* The region is cut into tiles of the size of the segments. Each tile
+ * is searched with Dijkstra's algorithm, starting from those of its
+ * cells whose costs have been lowered since it was last searched: start
+ * points first, later cells reached from a neighboring tile. Costs
+ * lowered within reach of a move (two cells) outside of the tile are
+ * handed on to the tile they belong to. This is repeated until no costs
+ * are lowered any more, which gives the same cumulative costs as a
+ * single search over the whole region.
+ *
+ * Tiles are searched in four turns, by the parity of their row and
+ * column, so that tiles searched at the same time are one tile apart
+ * and do not touch the same cells. The cells of a tile and of a border
+ * around it are copied from the segment files by the main thread, a
+ * batch of tiles is searched in parallel, and the results are copied
+ * back by the main thread again.
+ *
+ * Directions and nearest start points follow the cell through which a
+ * cell was reached at the lowest cost. Of several such cells, the one
+ * with the lowest cumulative cost is taken (or the lowest value of the
+ * solver map), which is the one the serial search processes first. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/segment.h>
+#include <grass/glocale.h>
+#include "cost.h"
+
+/* reach of a knight's move */
+#define HALO 2
+/* cells read around a tile: the cells within reach of a move and
+ * the cells through which these were reached */
+#define BORDER (2 * HALO)
+
+struct move
+{
+    int dr, dc;			/* from current cell to neighbor */
+    int fac;			/* index of distance factor */
+    int via1, via2;		/* moves to the cells passed by a knight's move */
+    FCELL deg;			/* direction from neighbor to current cell */
+    int bit;			/* bitmask encoded direction */
+};
+
+/* in the order of the serial search */
+static const struct move moves[16] = {
+    { 0, -1, 0, -1, -1, 360.0, 1},
+    { 0, 1, 0, -1, -1, 180.0, 5},
+    {-1, 0, 1, -1, -1, 270.0, 3},
+    { 1, 0, 1, -1, -1, 90.0, 7},
+    {-1, -1, 2, -1, -1, 315.0, 2},
+    {-1, 1, 2, -1, -1, 225.0, 4},
+    { 1, 1, 2, -1, -1, 135.0, 6},
+    { 1, -1, 2, -1, -1, 45.0, 0},
+    {-2, -1, 3, 2, 4, 292.5, 11},
+    {-2, 1, 3, 2, 5, 247.5, 12},
+    { 2, 1, 3, 3, 6, 112.5, 15},
+    { 2, -1, 3, 3, 7, 67.5, 8},
+    {-1, -2, 4, 0, 4, 337.5, 10},
+    {-1, 2, 4, 1, 5, 202.5, 13},
+    { 1, 2, 4, 1, 6, 157.5, 14},
+    { 1, -2, 4, 0, 7, 22.5, 9}
+};
+
+struct entry
+{
+    double cost;
+    long age;
+    int cell;
+};
+
+struct tile
+{
+    int row, col, rows, cols;	/* cells of the tile */
+    int r0, c0, nr, nc;		/* cells read: tile and border, clipped */
+    struct cc *cc;
+    FCELL *dir;
+    DCELL *solve;		/* solver value, value of the chosen cell */
+    unsigned char *pred;	/* move + 1 by which a cell was reached */
+    char *changed;
+    struct entry *heap;		/* binary min heap, from index 1 */
+    long heap_size, heap_alloced, age;
+};
+
+static int ntrows, ntcols;	/* number of tiles */
+static char *active;		/* tiles with pending cells */
+static FLAG *pending;		/* cells whose costs were lowered */
+static FLAG *start;		/* start points */
+static struct tile *tiles;	/* one batch */
+
+static int cmp_entry(const struct entry *a, const struct entry *b)
+{
+    if (a->cost < b->cost)
+	return 1;
+    if (a->cost == b->cost && a->age < b->age)
+	return 1;
+
+    return 0;
+}
+
+static void push(struct tile *t, int cell, double cost)
+{
+    struct entry e;
+    long child, parent;
+
+    if (++t->heap_size >= t->heap_alloced) {
+	t->heap_alloced *= 2;
+	t->heap = G_realloc(t->heap, t->heap_alloced * sizeof(struct entry));
+    }
+    e.cost = cost;
+    e.age = t->age++;
+    e.cell = cell;
+
+    for (child = t->heap_size; child > 1; child = parent) {
+	parent = child / 2;
+	if (!cmp_entry(&e, &t->heap[parent]))
+	    break;
+	t->heap[child] = t->heap[parent];
+    }
+    t->heap[child] = e;
+}
+
+static int pop(struct tile *t, struct entry *lowest)
+{
+    struct entry last;
+    long parent, child;
+
+    if (t->heap_size == 0)
+	return 0;
+
+    *lowest = t->heap[1];
+    last = t->heap[t->heap_size--];
+
+    for (parent = 1; (child = 2 * parent) <= t->heap_size; parent = child) {
+	if (child < t->heap_size &&
+	    cmp_entry(&t->heap[child + 1], &t->heap[child]))
+	    child++;
+	if (!cmp_entry(&t->heap[child], &last))
+	    break;
+	t->heap[parent] = t->heap[child];
+    }
+    t->heap[parent] = last;
+
+    return 1;
+}
+
+static int in_tile(const struct tile *t, int row, int col)
+{
+    return (row >= t->row && row < t->row + t->rows &&
+	    col >= t->col && col < t->col + t->cols);
+}
+
+static int below_max(const struct tile_search *ts, double cost)
+{
+    return (!ts->have_max || cost <= ts->max_cost);
+}
+
+/* update neighbor j reached from current cell i by move k */
+static void relax(struct tile *t, const struct tile_search *ts,
+		  int i, int j, int k, double min_cost, int row, int col)
+{
+    struct cc *pres = &t->cc[i], *nb = &t->cc[j];
+    double old_min_cost = nb->cost_out;
+    const struct move *m = &moves[k];
+    int requeue = 0;
+
+    if (Rast_is_d_null_value(&old_min_cost) || old_min_cost > min_cost) {
+	nb->cost_out = min_cost;
+	nb->nearest = pres->nearest;
+	t->pred[j] = k + 1;
+	if (ts->dir)
+	    t->dir[j] = ts->dir_bin ? (FCELL) (1 << m->bit) : m->deg;
+	if (ts->have_solver)
+	    t->solve[2 * j + 1] = t->solve[2 * i];
+	t->changed[j] = 1;
+	if (in_tile(t, row, col) && below_max(ts, min_cost))
+	    push(t, j, min_cost);
+
+	return;
+    }
+    if (old_min_cost != min_cost)
+	return;
+
+    if (t->pred[j] == k + 1) {
+	/* the nearest start point of the current cell has changed */
+	if (nb->nearest == pres->nearest)
+	    return;
+	nb->nearest = pres->nearest;
+	requeue = 1;
+    }
+    else if (t->pred[j] && pres->cost_out < old_min_cost) {
+	/* equal costs: the current cell would have been processed
+	 * before the neighbor by the serial search */
+	const struct move *pm = &moves[t->pred[j] - 1];
+	double pred_cost = t->cc[j - pm->dr * t->nc - pm->dc].cost_out;
+	FCELL old_dir = ts->dir ? t->dir[j] : 0;
+	int better, bit = 1 << m->bit;
+
+	if (ts->have_solver) {
+	    DCELL mysolve = t->solve[2 * i], best = t->solve[2 * j + 1];
+
+	    better = mysolve < best ||
+		(mysolve == best && pres->cost_out < pred_cost);
+	    if (mysolve < best) {
+		t->solve[2 * j + 1] = mysolve;
+		if (ts->dir_bin)
+		    t->dir[j] = bit;
+	    }
+	    else if (ts->dir_bin && mysolve == best)
+		t->dir[j] = (int)t->dir[j] | bit;
+	}
+	else {
+	    better = pres->cost_out < pred_cost;
+	    if (ts->dir_bin)
+		t->dir[j] = (int)t->dir[j] | bit;
+	}
+	if (better) {
+	    requeue = nb->nearest != pres->nearest;
+	    nb->nearest = pres->nearest;
+	    t->pred[j] = k + 1;
+	    if (ts->dir && !ts->dir_bin)
+		t->dir[j] = m->deg;
+	}
+	else if (!ts->dir || t->dir[j] == old_dir)
+	    return;
+    }
+    else
+	return;
+
+    t->changed[j] = 1;
+    if (requeue && in_tile(t, row, col) && below_max(ts, min_cost))
+	push(t, j, min_cost);
+}
+
+/* costs of neighbors and of moves to them as in the serial search */
+static void relax_neighbors(struct tile *t, const struct tile_search *ts,
+			    int i)
+{
+    int row = t->r0 + i / t->nc, col = t->c0 + i % t->nc;
+    double my_cost = t->cc[i].cost_in, pres_cost = t->cc[i].cost_out;
+    double nb_cost[8];
+    int k;
+
+    for (k = 0; k < 8; k++)
+	Rast_set_d_null_value(&nb_cost[k], 1);
+
+    for (k = 0; k < ts->total_reviewed; k++) {
+	const struct move *m = &moves[k];
+	int nrow = row + m->dr, ncol = col + m->dc, j;
+	double fcost, min_cost;
+
+	if (nrow < 0 || nrow >= ts->nrows || ncol < 0 || ncol >= ts->ncols)
+	    continue;
+
+	j = i + m->dr * t->nc + m->dc;
+	if (k < 8) {
+	    nb_cost[k] = t->cc[j].cost_in;
+	    fcost = (double)(nb_cost[k] + my_cost);
+	}
+	else
+	    fcost = (double)(nb_cost[m->via1] + nb_cost[m->via2] +
+			     t->cc[j].cost_in + my_cost);
+	min_cost = pres_cost + fcost * ts->fac[m->fac];
+
+	/* skip if costs could not be calculated */
+	if (Rast_is_d_null_value(&min_cost))
+	    continue;
+
+	relax(t, ts, i, j, k, min_cost, nrow, ncol);
+    }
+}
+
+static void search_tiles(int first, int last, void *closure)
+{
+    const struct tile_search *ts = closure;
+    int n;
+
+    for (n = first; n < last; n++) {
+	struct tile *t = &tiles[n];
+	struct entry e;
+
+	while (pop(t, &e)) {
+	    /* skip if already updated */
+	    if (e.cost > t->cc[e.cell].cost_out)
+		continue;
+	    relax_neighbors(t, ts, e.cell);
+	}
+    }
+}
+
+static void read_tile(struct tile_search *ts, struct tile *t, int tile)
+{
+    int row, col, i;
+
+    t->row = (tile / ntcols) * ts->srows;
+    t->col = (tile % ntcols) * ts->scols;
+    t->rows = ts->nrows - t->row < ts->srows ? ts->nrows - t->row : ts->srows;
+    t->cols = ts->ncols - t->col < ts->scols ? ts->ncols - t->col : ts->scols;
+    t->r0 = t->row > BORDER ? t->row - BORDER : 0;
+    t->c0 = t->col > BORDER ? t->col - BORDER : 0;
+    t->nr = (t->row + t->rows + BORDER < ts->nrows ?
+	     t->row + t->rows + BORDER : ts->nrows) - t->r0;
+    t->nc = (t->col + t->cols + BORDER < ts->ncols ?
+	     t->col + t->cols + BORDER : ts->ncols) - t->c0;
+    t->heap_size = 0;
+    t->age = 0;
+
+    memset(t->changed, 0, (size_t)t->nr * t->nc);
+    for (row = t->r0, i = 0; row < t->r0 + t->nr; row++) {
+	for (col = t->c0; col < t->c0 + t->nc; col++, i++) {
+	    if (Segment_get(ts->cost_seg, &t->cc[i], row, col) < 0 ||
+		Segment_get(&ts->pred_seg, &t->pred[i], row, col) < 0 ||
+		(ts->dir && Segment_get(ts->dir_seg, &t->dir[i], row, col) < 0) ||
+		(ts->have_solver &&
+		 Segment_get(ts->solve_seg, &t->solve[2 * i], row, col) < 0))
+		G_fatal_error(_("Can not read from temporary file"));
+	}
+    }
+
+    for (row = t->row; row < t->row + t->rows; row++) {
+	for (col = t->col; col < t->col + t->cols; col++) {
+	    i = (row - t->r0) * t->nc + col - t->c0;
+	    if (!(FLAG_GET(pending, row, col)))
+		continue;
+	    FLAG_UNSET(pending, row, col);
+	    if (!Rast_is_d_null_value(&t->cc[i].cost_out) &&
+		below_max(ts, t->cc[i].cost_out))
+		push(t, i, t->cc[i].cost_out);
+	}
+    }
+}
+
+static void write_tile(struct tile_search *ts, const struct tile *t)
+{
+    int row, col, i;
+
+    for (row = t->row - HALO; row < t->row + t->rows + HALO; row++) {
+	if (row < 0 || row >= ts->nrows)
+	    continue;
+	for (col = t->col - HALO; col < t->col + t->cols + HALO; col++) {
+	    if (col < 0 || col >= ts->ncols)
+		continue;
+	    i = (row - t->r0) * t->nc + col - t->c0;
+	    if (!t->changed[i])
+		continue;
+
+	    if (Segment_put(ts->cost_seg, &t->cc[i], row, col) < 0 ||
+		Segment_put(&ts->pred_seg, &t->pred[i], row, col) < 0 ||
+		(ts->dir && Segment_put(ts->dir_seg, &t->dir[i], row, col) < 0) ||
+		(ts->have_solver &&
+		 Segment_put(ts->solve_seg, &t->solve[2 * i], row, col) < 0))
+		G_fatal_error(_("Can not write to temporary file"));
+
+	    /* hand on to the tile the cell belongs to */
+	    if (!in_tile(t, row, col) && below_max(ts, t->cc[i].cost_out)) {
+		FLAG_SET(pending, row, col);
+		active[(row / ts->srows) * ntcols + col / ts->scols] = 1;
+	    }
+	}
+    }
+}
+
+static int search(struct tile_search *ts)
+{
+    int *list = G_malloc(ntrows * ntcols * sizeof(int));
+    int rounds = 0;
+
+    for (;;) {
+	int turn, searched = 0;
+
+	for (turn = 0; turn < 4; turn++) {
+	    int tr, tc, n = 0, first, last, i;
+
+	    for (tr = turn >> 1; tr < ntrows; tr += 2) {
+		for (tc = turn & 1; tc < ntcols; tc += 2) {
+		    if (active[tr * ntcols + tc]) {
+			active[tr * ntcols + tc] = 0;
+			list[n++] = tr * ntcols + tc;
+		    }
+		}
+	    }
+
+	    for (first = 0; first < n; first = last) {
+		last = first + ts->batch < n ? first + ts->batch : n;
+		for (i = first; i < last; i++)
+		    read_tile(ts, &tiles[i - first], list[i]);
+		G_parallel_for(0, last - first, 1, search_tiles, ts);
+		for (i = first; i < last; i++)
+		    write_tile(ts, &tiles[i - first]);
+	    }
+	    searched += n;
+	}
+	if (!searched)
+	    break;
+	rounds++;
+	G_debug(1, "round %d: %d tiles searched", rounds, searched);
+    }
+    G_free(list);
+
+    return rounds;
+}
+
+void tile_search_open(struct tile_search *ts, int segments_in_memory)
+{
+    int i, size;
+
+    if (Segment_open(&ts->pred_seg, G_tempfile(), ts->nrows, ts->ncols,
+		     ts->srows, ts->scols, sizeof(unsigned char),
+		     segments_in_memory) != 1)
+	G_fatal_error(_("Can not create temporary file"));
+
+    ntrows = (ts->nrows + ts->srows - 1) / ts->srows;
+    ntcols = (ts->ncols + ts->scols - 1) / ts->scols;
+    active = G_calloc(ntrows * ntcols, 1);
+    pending = flag_create(ts->nrows, ts->ncols);
+
+    size = (ts->srows + 2 * BORDER) * (ts->scols + 2 * BORDER);
+    tiles = G_malloc(ts->batch * sizeof(struct tile));
+    for (i = 0; i < ts->batch; i++) {
+	struct tile *t = &tiles[i];
+
+	t->cc = G_malloc(size * sizeof(struct cc));
+	t->pred = G_malloc(size);
+	t->changed = G_malloc(size);
+	t->dir = ts->dir ? G_malloc(size * sizeof(FCELL)) : NULL;
+	t->solve = ts->have_solver ? G_malloc(size * 2 * sizeof(DCELL)) : NULL;
+	t->heap_alloced = 1024;
+	t->heap = G_malloc(t->heap_alloced * sizeof(struct entry));
+    }
+}
+
+/* search from the start points, returns the number of rounds */
+int tile_search(struct tile_search *ts, FLAG *start_flags)
+{
+    int row, col;
+    unsigned char none = 0;
+
+    start = start_flags;
+    for (row = 0; row < ts->nrows; row++) {
+	for (col = 0; col < ts->ncols; col++) {
+	    if (Segment_put(&ts->pred_seg, &none, row, col) < 0)
+		G_fatal_error(_("Can not write to temporary file"));
+	    if (FLAG_GET(start, row, col)) {
+		FLAG_SET(pending, row, col);
+		active[(row / ts->srows) * ntcols + col / ts->scols] = 1;
+	    }
+	}
+    }
+
+    return search(ts);
+}
+
+/* limit the search to cells up to the given cost, as if it had stopped
+ * there: costs above it are removed, except for start points, and the
+ * cells next to them are searched again */
+int tile_search_stop(struct tile_search *ts, double max_cost)
+{
+    int row, col, k;
+    unsigned char none = 0;
+    struct cc costs;
+    FCELL fnullval;
+    DCELL solvedir[2];
+
+    Rast_set_f_null_value(&fnullval, 1);
+
+    for (row = 0; row < ts->nrows; row++) {
+	for (col = 0; col < ts->ncols; col++) {
+	    if (Segment_get(ts->cost_seg, &costs, row, col) < 0)
+		G_fatal_error(_("Can not read from temporary file"));
+	    if (Rast_is_d_null_value(&costs.cost_out) ||
+		costs.cost_out <= max_cost || FLAG_GET(start, row, col))
+		continue;
+
+	    Rast_set_d_null_value(&costs.cost_out, 1);
+	    costs.nearest = 0;
+	    if (Segment_put(ts->cost_seg, &costs, row, col) < 0 ||
+		Segment_put(&ts->pred_seg, &none, row, col) < 0 ||
+		(ts->dir && Segment_put(ts->dir_seg, &fnullval, row, col) < 0))
+		G_fatal_error(_("Can not write to temporary file"));
+	    if (ts->have_solver) {
+		if (Segment_get(ts->solve_seg, solvedir, row, col) < 0)
+		    G_fatal_error(_("Can not read from temporary file"));
+		Rast_set_d_null_value(&solvedir[1], 1);
+		if (Segment_put(ts->solve_seg, solvedir, row, col) < 0)
+		    G_fatal_error(_("Can not write to temporary file"));
+	    }
+
+	    for (k = 0; k < ts->total_reviewed; k++) {
+		int nrow = row + moves[k].dr, ncol = col + moves[k].dc;
+
+		if (nrow < 0 || nrow >= ts->nrows ||
+		    ncol < 0 || ncol >= ts->ncols)
+		    continue;
+		FLAG_SET(pending, nrow, ncol);
+		active[(nrow / ts->srows) * ntcols + ncol / ts->scols] = 1;
+	    }
+	}
+    }
+
+    ts->have_max = 1;
+    ts->max_cost = max_cost;
+
+    return search(ts);
+}
+
+void tile_search_close(struct tile_search *ts)
+{
+    int i;
+
+    for (i = 0; i < ts->batch; i++) {
+	G_free(tiles[i].cc);
+	G_free(tiles[i].pred);
+	G_free(tiles[i].changed);
+	if (tiles[i].dir)
+	    G_free(tiles[i].dir);
+	if (tiles[i].solve)
+	    G_free(tiles[i].solve);
+	G_free(tiles[i].heap);
+    }
+    G_free(tiles);
+    G_free(active);
+    flag_destroy(pending);
+    Segment_close(&ts->pred_seg);
+}
@@ -23,7 +23,6 @@ extern const char *title;
 extern long *matr;
 extern long *rlst;
 extern int ncat;
-extern const char *stats_file;
 
 #define LAYER struct _layer_
 extern LAYER *layers;
@@ -37,7 +37,6 @@ const char *title;
 long *matr;
 long *rlst;
 int ncat;
-const char *stats_file;
 
 LAYER *layers;
 int nlayers;
@@ -127,7 +126,7 @@ int main(int argc, char **argv)
 
     title = parms.titles->answer;
 
-    /* run r.stats to obtain statistics of map layers */
+    /* cross tabulate the categories of the map layers */
     stats();
 
     if(flags.m->answer)
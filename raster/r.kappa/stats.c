@@ -1,89 +1,81 @@
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
 #include <grass/gis.h>
-#include <grass/spawn.h>
+#include <grass/raster.h>
 #include "kappa.h"
 #include <grass/glocale.h>
 #include "local_proto.h"
 
 
-static void die(void)
-{
-    unlink(stats_file);
-    G_fatal_error(_("Problem reading r.stats output"));
-}
-
-
 int stats(void)
 {
-    char buf[1024];
-    char mname[GNAME_MAX], rname[GMAPSET_MAX];
-    const char *mmapset, *rmapset;
-    int i, nl;
+    struct Cross_stats cstats;
+    CELL **cell;
+    CELL *key;
+    long count;
+    int *fd;
+    int nrows, ncols, row, col;
+    int nl;
     size_t ns;
-    FILE *fd;
-    char **tokens;
-    const char *argv[9];
-    int argc = 0;
-
-    strcpy(mname, maps[0]);
-    mmapset = G_find_raster2(mname, "");
-    if (mmapset == NULL)
-	G_fatal_error(_("Raster map <%s> not found"), maps[0]);
-
-    strcpy(rname, maps[1]);
-    rmapset = G_find_raster2(rname, "");
-    if (rmapset == NULL)
-	G_fatal_error(_("Raster map <%s> not found"), maps[1]);
 
-    stats_file = G_tempfile();
-
-    argv[argc++] = "r.stats";
+    /* the maps are read as integers, floating-point maps through their
+       quant rules */
+    fd = (int *)G_malloc(nlayers * sizeof(int));
+    cell = (CELL **) G_malloc(nlayers * sizeof(CELL *));
+    for (nl = 0; nl < nlayers; nl++) {
+	if (G_find_raster2(maps[nl], "") == NULL)
+	    G_fatal_error(_("Raster map <%s> not found"), maps[nl]);
+	fd[nl] = Rast_open_old(maps[nl], "");
+	cell[nl] = Rast_allocate_c_buf();
+    }
+    key = (CELL *) G_malloc(nlayers * sizeof(CELL));
 
-    argv[argc++] = "-cin";
+    nrows = Rast_window_rows();
+    ncols = Rast_window_cols();
 
-    argv[argc++] = "separator=:";
+    Rast_init_cross_stats(&cstats, nlayers, 0, NULL);
 
-    sprintf(buf, "input=%s,%s",
-	    G_fully_qualified_name(mname, mmapset),
-	    G_fully_qualified_name(rname, rmapset));
-    argv[argc++] = buf;
+    for (row = 0; row < nrows; row++) {
+	G_percent(row, nrows, 2);
 
-    argv[argc++] = SF_REDIRECT_FILE;
-    argv[argc++] = SF_STDOUT;
-    argv[argc++] = SF_MODE_OUT;
-    argv[argc++] = stats_file;
+	for (nl = 0; nl < nlayers; nl++)
+	    Rast_get_c_row(fd[nl], cell[nl], row);
 
-    argv[argc++] = NULL;
+	for (col = 0; col < ncols; col++) {
+	    /* cells with no data in any map are not counted */
+	    for (nl = 0; nl < nlayers; nl++) {
+		if (Rast_is_c_null_value(&cell[nl][col]))
+		    break;
+		key[nl] = cell[nl][col];
+	    }
+	    if (nl < nlayers)
+		continue;
 
-    if (G_vspawn_ex(argv[0], argv) != 0) {
-	remove(stats_file);
-	G_fatal_error("error running r.stats");
+	    Rast_update_cross_stats(&cstats, key, 1, NULL);
+	}
     }
+    G_percent(nrows, nrows, 2);
 
-    fd = fopen(stats_file, "r");
-    if (fd == NULL) {
-	unlink(stats_file);
-	sprintf(buf, "Unable to open result file <%s>\n", stats_file);
+    for (nl = 0; nl < nlayers; nl++) {
+	Rast_close(fd[nl]);
+	G_free(cell[nl]);
     }
+    G_free(fd);
+    G_free(cell);
 
-    while (G_getl(buf, sizeof buf, fd)) {
-	tokens = G_tokenize(buf, ":");
-	i = 0;
+    /* the combinations in the order of the categories */
+    Gstats = (GSTATS *) G_realloc(Gstats, (nstats + cstats.n) * sizeof(GSTATS));
+    Rast_rewind_cross_stats(&cstats);
+    while (Rast_next_cross_stat(&cstats, key, &count, NULL)) {
 	ns = nstats++;
-	Gstats = (GSTATS *) G_realloc(Gstats, nstats * sizeof(GSTATS));
 	Gstats[ns].cats = (long *)G_calloc(nlayers, sizeof(long));
-	for (nl = 0; nl < nlayers; nl++) {
-	    if (sscanf(tokens[i++], "%ld", &Gstats[ns].cats[nl]) != 1)
-		die();
-	}
-	if (sscanf(tokens[i++], "%ld", &Gstats[ns].count) != 1)
-	    die();
-	G_free_tokens(tokens);
+	for (nl = 0; nl < nlayers; nl++)
+	    Gstats[ns].cats[nl] = key[nl];
+	Gstats[ns].count = count;
     }
-    fclose(fd);
-    unlink(stats_file);
+
+    G_free(key);
+    Rast_free_cross_stats(&cstats);
 
     return 0;
 }
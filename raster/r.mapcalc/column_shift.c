@@ -16,38 +16,38 @@ void column_shift(void *buf, int res_type, int col)
     if (col > 0) {
 	switch (res_type) {
 	case CELL_TYPE:
-	    for (i = 0; i < columns - col; i++) {
+	    for (i = 0; i < cols - col; i++) {
 		if (IS_NULL_C(&ibuf[i + col]))
 		    SET_NULL_C(&ibuf[i]);
 		else
 		    ibuf[i] = ibuf[i + col];
 	    }
 
-	    for (; i < columns; i++)
+	    for (; i < cols; i++)
 		SET_NULL_C(&ibuf[i]);
 	    break;
 
 	case FCELL_TYPE:
-	    for (i = 0; i < columns - col; i++) {
+	    for (i = 0; i < cols - col; i++) {
 		if (IS_NULL_F(&fbuf[i + col]))
 		    SET_NULL_F(&fbuf[i]);
 		else
 		    fbuf[i] = fbuf[i + col];
 	    }
 
-	    for (; i < columns; i++)
+	    for (; i < cols; i++)
 		SET_NULL_F(&fbuf[i]);
 	    break;
 
 	case DCELL_TYPE:
-	    for (i = 0; i < columns - col; i++) {
+	    for (i = 0; i < cols - col; i++) {
 		if (IS_NULL_D(&dbuf[i + col]))
 		    SET_NULL_D(&dbuf[i]);
 		else
 		    dbuf[i] = dbuf[i + col];
 	    }
 
-	    for (; i < columns; i++)
+	    for (; i < cols; i++)
 		SET_NULL_D(&dbuf[i]);
 	    break;
 	}
@@ -57,7 +57,7 @@ void column_shift(void *buf, int res_type, int col)
 
 	switch (res_type) {
 	case CELL_TYPE:
-	    for (i = columns - 1; i >= col; i--) {
+	    for (i = cols - 1; i >= col; i--) {
 		if (IS_NULL_C(&ibuf[i - col]))
 		    SET_NULL_C(&ibuf[i]);
 		else
@@ -69,7 +69,7 @@ void column_shift(void *buf, int res_type, int col)
 	    break;
 
 	case FCELL_TYPE:
-	    for (i = columns - 1; i >= col; i--) {
+	    for (i = cols - 1; i >= col; i--) {
 		if (IS_NULL_F(&fbuf[i - col]))
 		    SET_NULL_F(&fbuf[i]);
 		else
@@ -81,7 +81,7 @@ void column_shift(void *buf, int res_type, int col)
 	    break;
 
 	case DCELL_TYPE:
-	    for (i = columns - 1; i >= col; i--) {
+	    for (i = cols - 1; i >= col; i--) {
 		if (IS_NULL_D(&dbuf[i - col]))
 		    SET_NULL_D(&dbuf[i]);
 		else
@@ -1,7 +1,12 @@
 
+#include <grass/config.h>
+
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #include <grass/gis.h>
 #include <grass/raster.h>
@@ -13,19 +18,83 @@
 
 /****************************************************************************/
 
-int current_depth, current_row;
-int depths, rows;
+int depths, rows, cols;
+
+/* The functions are evaluated on tiles of a row which fit into the
+ * cache together with the buffers of the other nodes of the expression,
+ * instead of on the whole row. The tiles of the maps are taken from
+ * whole rows, which are padded with nulls to a multiple of the tile
+ * width.
+ */
+#define TILE_CELLS 4096
+
+static int tiles;		/* tiles per row */
 
 /* Local variables for map management */
 static expression **map_list = NULL;
 static int num_maps = 0;
 static int max_maps = 0;
 
+/* Rows are evaluated concurrently in blocks of consecutive rows. Each
+ * block is evaluated in its own context, which has a copy of the
+ * expressions with private buffers and reads the maps through its own
+ * row caches (see setup_map_contexts()).
+ */
+struct context
+{
+    int id;
+    int depth, row;
+    int col;			/* first column of the tile */
+    expr_list *exprs;
+};
+
+static struct context main_context;
+static struct context *contexts;
+static int num_contexts = 1;
+
+#ifdef HAVE_PTHREAD_H
+static pthread_key_t context_key;
+#endif
+
+/****************************************************************************/
+
+static struct context *get_context(void)
+{
+#ifdef HAVE_PTHREAD_H
+    if (num_contexts > 1) {
+	struct context *c = pthread_getspecific(context_key);
+
+	if (c)
+	    return c;
+    }
+#endif
+
+    return &main_context;
+}
+
+int current_depth(void)
+{
+    return get_context()->depth;
+}
+
+int current_row(void)
+{
+    return get_context()->row;
+}
+
+int current_col(void)
+{
+    return get_context()->col;
+}
+
 /****************************************************************************/
 
 static void extract_maps(expression *e);
 static void initialize(expression *e);
 static void evaluate(expression *e);
+static void evaluate_row(struct context *c);
+static void evaluate_constant(expression *e);
+static void evaluate_function(expression *e);
 static int append_map(expression *e);
 
 /****************************************************************************/
@@ -79,36 +148,163 @@ static void set_buf(expression * e, void *buf)
 
 /****************************************************************************/
 
+/* Expressions are optimized while they are initialized:
+ * - functions of constants are computed once (constant folding),
+ * - maps and functions which are equal to an earlier node of the same
+ *   list of expressions are not evaluated again, they use the value of
+ *   the earlier node (common subexpression elimination).
+ * Nodes are initialized in the order in which they are evaluated, so
+ * the earlier node has always been evaluated when its value is used.
+ */
+
+static expression **evaluated;	/* maps and functions evaluated so far */
+static int num_evaluated, max_evaluated;
+
+/* rand() gives a different value every time it is called */
+static int is_pure(const expression * e)
+{
+    return e->type != expr_type_function || e->data.func.func != f_rand;
+}
+
+static const expression *value_of(const expression * e)
+{
+    for (;;) {
+	if (e->type == expr_type_variable)
+	    e = e->data.var.bind;
+	else if (e->type == expr_type_binding)
+	    e = e->data.bind.val;
+	else if (e->same)
+	    e = e->same;
+	else
+	    return e;
+    }
+}
+
+static int same_value(const expression * e1, const expression * e2)
+{
+    int i;
+
+    e1 = value_of(e1);
+    e2 = value_of(e2);
+
+    if (e1 == e2)
+	return 1;
+
+    if (e1->type != e2->type || e1->res_type != e2->res_type)
+	return 0;
+
+    switch (e1->type) {
+    case expr_type_constant:
+	return e1->res_type == CELL_TYPE
+	    ? e1->data.con.ival == e2->data.con.ival
+	    : e1->data.con.fval == e2->data.con.fval;
+    case expr_type_map:
+	return e1->data.map.idx == e2->data.map.idx &&
+	    e1->data.map.mod == e2->data.map.mod &&
+	    e1->data.map.row == e2->data.map.row &&
+	    e1->data.map.col == e2->data.map.col &&
+	    e1->data.map.depth == e2->data.map.depth;
+    case expr_type_function:
+	if (e1->data.func.func != e2->data.func.func ||
+	    e1->data.func.argc != e2->data.func.argc ||
+	    !is_pure(e1))
+	    return 0;
+	/* the arguments have been registered before, equal arguments
+	 * are the same node unless they are constant */
+	for (i = 1; i <= e1->data.func.argc; i++) {
+	    const expression *a1 = value_of(e1->data.func.args[i]);
+	    const expression *a2 = value_of(e2->data.func.args[i]);
+
+	    if (a1 != a2 &&
+		!(a1->constant && a2->constant && same_value(a1, a2)))
+		return 0;
+	}
+	return 1;
+    default:
+	return 0;
+    }
+}
+
+/* returns the earlier node with the same value, or registers e */
+static expression *find_same(expression * e)
+{
+    int i;
+
+    for (i = 0; i < num_evaluated; i++)
+	if (same_value(evaluated[i], e))
+	    return evaluated[i];
+
+    if (num_evaluated >= max_evaluated) {
+	max_evaluated += 20;
+	evaluated = G_realloc(evaluated, max_evaluated * sizeof(expression *));
+    }
+
+    evaluated[num_evaluated++] = e;
+
+    return NULL;
+}
+
+/****************************************************************************/
+
 static void initialize_constant(expression * e)
 {
     allocate_buf(e);
+    evaluate_constant(e);
+    e->constant = 1;
 }
 
 static void initialize_variable(expression * e)
 {
-    set_buf(e, e->data.var.bind->data.bind.val->buf);
+    expression *val = e->data.var.bind->data.bind.val;
+
+    set_buf(e, val->buf);
+    e->constant = val->constant;
 }
 
 static void initialize_map(expression * e)
 {
-    allocate_buf(e);
-
     e->data.map.idx = open_map(e->data.map.name, e->data.map.mod,
-                               e->data.map.row, e->data.map.col);
+			       e->data.map.depth, e->data.map.row,
+			       e->data.map.col);
+
+    e->same = find_same(e);
+    if (e->same)
+	return;
+
+    /* the whole row is read, the tiles are taken from it */
+    e->row = G_malloc((size_t) tiles * columns * Rast_cell_size(e->res_type));
+    Rast_set_null_value(e->row, tiles * columns, e->res_type);
+    set_buf(e, e->row);
 }
 
 static void initialize_function(expression * e)
 {
+    int constant = e->data.func.argc > 0 && is_pure(e);
     int i;
 
+    for (i = 1; i <= e->data.func.argc; i++) {
+        initialize(e->data.func.args[i]);
+        if (!e->data.func.args[i]->constant)
+            constant = 0;
+    }
+
+    if (!constant) {
+	e->same = find_same(e);
+	if (e->same)
+	    return;
+    }
+
     allocate_buf(e);
 
     e->data.func.argv = G_malloc((e->data.func.argc + 1) * sizeof(void *));
     e->data.func.argv[0] = e->buf;
 
-    for (i = 1; i <= e->data.func.argc; i++) {
-        initialize(e->data.func.args[i]);
+    for (i = 1; i <= e->data.func.argc; i++)
         e->data.func.argv[i] = e->data.func.args[i]->buf;
+
+    if (constant) {
+	evaluate_function(e);
+	e->constant = 1;
     }
 }
 
@@ -116,6 +312,7 @@ static void initialize_binding(expression * e)
 {
     initialize(e->data.bind.val);
     set_buf(e, e->data.bind.val->buf);
+    e->constant = e->data.bind.val->constant;
 }
 
 static void initialize(expression * e)
@@ -144,23 +341,6 @@ static void initialize(expression * e)
 
 /****************************************************************************/
 
-static void do_evaluate(void *p)
-{
-    evaluate((struct expression *) p);
-}
-
-static void begin_evaluate(struct expression *e)
-{
-    G_begin_execute(do_evaluate, e, &e->worker, 0);
-}
-
-static void end_evaluate(struct expression *e)
-{
-    G_end_execute(&e->worker);
-}
-
-/****************************************************************************/
-
 static void evaluate_constant(expression * e)
 {
     int *ibuf = e->buf;
@@ -190,16 +370,23 @@ static void evaluate_constant(expression * e)
 
 static void evaluate_variable(expression * e)
 {
-    /* this is a no-op */
+    set_buf(e, e->data.var.bind->buf);
 }
 
 static void evaluate_map(expression * e)
 {
-    get_map_row(e->data.map.idx,
-                e->data.map.mod,
-                current_depth + e->data.map.depth,
-                current_row + e->data.map.row,
-                e->data.map.col, e->buf, e->res_type);
+    struct context *c = get_context();
+
+    /* read the row with the first tile */
+    if (c->col == 0)
+	get_map_row(c->id,
+		    e->data.map.idx,
+		    e->data.map.mod,
+		    c->depth + e->data.map.depth,
+		    c->row + e->data.map.row,
+		    e->data.map.col, e->row, e->res_type);
+
+    set_buf(e, (char *)e->row + (size_t) c->col * Rast_cell_size(e->res_type));
 }
 
 static void evaluate_function(expression * e)
@@ -207,16 +394,10 @@ static void evaluate_function(expression * e)
     int i;
     int res;
 
-    if (e->data.func.argc > 1 && e->data.func.func != f_eval) {
-	for (i = 1; i <= e->data.func.argc; i++)
-	    begin_evaluate(e->data.func.args[i]);
-
-	for (i = 1; i <= e->data.func.argc; i++)
-	    end_evaluate(e->data.func.args[i]);
+    for (i = 1; i <= e->data.func.argc; i++) {
+	evaluate(e->data.func.args[i]);
+	e->data.func.argv[i] = e->data.func.args[i]->buf;
     }
-    else
-	for (i = 1; i <= e->data.func.argc; i++)
-	    evaluate(e->data.func.args[i]);
 
     res = (*e->data.func.func) (e->data.func.argc,
 				e->data.func.argt, e->data.func.argv);
@@ -255,12 +436,23 @@ static void evaluate_function(expression * e)
 static void evaluate_binding(expression * e)
 {
     evaluate(e->data.bind.val);
+    set_buf(e, e->data.bind.val->buf);
 }
 
 /****************************************************************************/
 
 static void evaluate(expression * e)
 {
+    /* computed at initialization */
+    if (e->constant)
+	return;
+
+    /* computed by an earlier node */
+    if (e->same) {
+	set_buf(e, e->same->buf);
+	return;
+    }
+
     switch (e->type) {
         case expr_type_constant:
             evaluate_constant(e);
@@ -282,6 +474,387 @@ static void evaluate(expression * e)
     }
 }
 
+/* evaluates the expressions of a context on all tiles of its current row,
+ * the results of the bindings are copied into their whole rows */
+static void evaluate_row(struct context *c)
+{
+    expr_list *l;
+
+    for (c->col = 0; c->col < cols; c->col += columns) {
+	int n = cols - c->col < columns ? cols - c->col : columns;
+
+	for (l = c->exprs; l; l = l->next) {
+	    expression *e = l->exp;
+	    size_t size;
+
+	    evaluate(e);
+
+	    if (e->type != expr_type_binding)
+		continue;
+
+	    size = Rast_cell_size(e->res_type);
+	    memcpy((char *)e->row + c->col * size, e->buf, n * size);
+	}
+    }
+}
+
+/****************************************************************************/
+
+static expression **copied;	/* pairs of bindings and their copies */
+static int num_copied, max_copied;
+
+static expression *copy_expression(const expression * e)
+{
+    expression *x = G_malloc(sizeof(expression));
+    int i;
+
+    *x = *e;
+    x->buf = NULL;
+    x->row = NULL;
+    x->constant = 0;
+    x->same = NULL;
+
+    switch (e->type) {
+    case expr_type_variable:
+	for (i = 0; i < num_copied; i += 2)
+	    if (copied[i] == e->data.var.bind)
+		x->data.var.bind = copied[i + 1];
+	break;
+    case expr_type_function:
+	x->data.func.args =
+	    G_malloc((e->data.func.argc + 1) * sizeof(expression *));
+	for (i = 1; i <= e->data.func.argc; i++)
+	    x->data.func.args[i] = copy_expression(e->data.func.args[i]);
+	break;
+    case expr_type_binding:
+	x->data.bind.val = copy_expression(e->data.bind.val);
+	x->data.bind.fd = -1;
+	if (num_copied + 2 > max_copied) {
+	    max_copied += 20;
+	    copied = G_realloc(copied, max_copied * sizeof(expression *));
+	}
+	copied[num_copied++] = (expression *) e;
+	copied[num_copied++] = x;
+	break;
+    }
+
+    return x;
+}
+
+static expr_list *copy_list(expr_list * ee)
+{
+    expr_list *head = NULL, **tail = &head;
+    expr_list *l;
+
+    /* in order, variables refer to the copies of earlier bindings */
+    num_evaluated = 0;
+    for (l = ee; l; l = l->next) {
+	*tail = list(copy_expression(l->exp), NULL);
+	initialize((*tail)->exp);
+	tail = &(*tail)->next;
+    }
+
+    num_copied = 0;
+
+    return head;
+}
+
+/* rand() draws from a single sequence, its rows must be evaluated in order */
+static int is_reentrant(const expression * e)
+{
+    int i;
+
+    switch (e->type) {
+    case expr_type_function:
+	if (e->data.func.func == f_rand)
+	    return 0;
+	for (i = 1; i <= e->data.func.argc; i++)
+	    if (!is_reentrant(e->data.func.args[i]))
+		return 0;
+	return 1;
+    case expr_type_binding:
+	return is_reentrant(e->data.bind.val);
+    default:
+	return 1;
+    }
+}
+
+static int is_reentrant_list(expr_list * ee)
+{
+    expr_list *l;
+
+    for (l = ee; l; l = l->next)
+	if (!is_reentrant(l->exp))
+	    return 0;
+
+    return 1;
+}
+
+static int setup_contexts(expr_list * ee)
+{
+    int n = G_num_threads();
+    int i;
+
+    if (n <= 1)
+	return 1;
+
+    if (!is_reentrant_list(ee)) {
+	G_verbose_message(_("Expression uses rand(), "
+			    "rows are evaluated sequentially"));
+	return 1;
+    }
+
+    n = setup_map_contexts(n);
+    if (n <= 1)
+	return 1;
+
+#ifdef HAVE_PTHREAD_H
+    pthread_key_create(&context_key, NULL);
+#endif
+
+    contexts = G_calloc(n, sizeof(struct context));
+    for (i = 0; i < n; i++) {
+	contexts[i].id = i;
+	contexts[i].exprs = i ? copy_list(ee) : ee;
+    }
+
+    G_debug(1, "Evaluating rows with %d threads", n);
+
+    return n;
+}
+
+/****************************************************************************/
+
+/* The rows are evaluated slab by slab. A slab is a box of rows and depths
+ * which the maps read and write at once (see get_slab_size()): the whole
+ * map for r.mapcalc, a layer of tiles of the output maps for r3.mapcalc.
+ * The rows of a slab are numbered depth by depth.
+ */
+struct slab
+{
+    int depth, row;		/* first depth and row */
+    int ndepths, nrows;
+};
+
+static void begin_slab(struct slab *s, int ndepths, int nrows)
+{
+    s->ndepths = depths - s->depth < ndepths ? depths - s->depth : ndepths;
+    s->nrows = rows - s->row < nrows ? rows - s->row : nrows;
+
+    read_slab(s->depth, s->row);
+}
+
+static void slab_row(const struct slab *s, int i, int *depth, int *row)
+{
+    *depth = s->depth + i / s->nrows;
+    *row = s->row + i % s->nrows;
+}
+
+/* size of the blocks of rows evaluated by one thread */
+#define BLOCK_CELLS (1 << 18)
+#define BLOCK_ROWS 32
+
+struct pass
+{
+    struct slab slab;
+    int first, last;		/* rows of the slab in the pass */
+    int block;			/* rows per block */
+    void **out;			/* rows of each output map */
+};
+
+static void evaluate_blocks(int first, int last, void *closure)
+{
+    struct pass *p = closure;
+    int i;
+
+#ifdef HAVE_PTHREAD_H
+    void *saved = pthread_getspecific(context_key);
+#endif
+
+    for (i = first; i < last; i++) {
+	struct context *c = &contexts[i];
+	int row0 = p->first + i * p->block;
+	int row1 = row0 + p->block;
+	int row;
+
+	if (row1 > p->last)
+	    row1 = p->last;
+
+#ifdef HAVE_PTHREAD_H
+	pthread_setspecific(context_key, c);
+#endif
+
+	for (row = row0; row < row1; row++) {
+	    expr_list *l;
+	    int k = 0;
+
+	    slab_row(&p->slab, row, &c->depth, &c->row);
+
+	    /* the results are written straight into the rows of the pass */
+	    for (l = c->exprs; l; l = l->next) {
+		expression *e = l->exp;
+
+		if (e->type != expr_type_binding)
+		    continue;
+
+		e->row = (char *)p->out[k++] + (size_t) (row - p->first) *
+		    cols * Rast_cell_size(e->res_type);
+	    }
+
+	    evaluate_row(c);
+	}
+    }
+
+#ifdef HAVE_PTHREAD_H
+    pthread_setspecific(context_key, saved);
+#endif
+}
+
+static void execute_serial(expr_list * ee, int verbose)
+{
+    struct slab s;
+    expr_list *l;
+    int ndepths, nrows;
+    int count, n, i;
+
+    for (l = ee; l; l = l->next)
+	if (l->exp->type == expr_type_binding)
+	    l->exp->row = G_malloc((size_t) cols *
+				   Rast_cell_size(l->exp->res_type));
+
+    main_context.exprs = ee;
+
+    get_slab_size(&nrows, &ndepths);
+
+    count = rows * depths;
+    n = 0;
+
+    for (s.depth = 0; s.depth < depths; s.depth += ndepths) {
+	for (s.row = 0; s.row < rows; s.row += nrows) {
+	    begin_slab(&s, ndepths, nrows);
+
+	    for (i = 0; i < s.ndepths * s.nrows; i++) {
+		if (verbose)
+		    G_percent(n, count, 2);
+
+		slab_row(&s, i, &main_context.depth, &main_context.row);
+
+		evaluate_row(&main_context);
+
+		for (l = ee; l; l = l->next) {
+		    expression *e = l->exp;
+		    int fd;
+
+		    if (e->type != expr_type_binding)
+			continue;
+
+		    fd = e->data.bind.fd;
+		    put_map_row(fd, e->row, e->res_type);
+		}
+
+		n++;
+	    }
+
+	    write_slab();
+	}
+    }
+
+    if (verbose)
+	G_percent(n, count, 2);
+
+    for (l = ee; l; l = l->next)
+	if (l->exp->type == expr_type_binding)
+	    G_free(l->exp->row);
+}
+
+/* Evaluates the rows of a slab in passes of one block per context, and
+ * writes the rows of a pass in order once all its blocks are done
+ */
+static void execute_parallel(expr_list * ee, int verbose)
+{
+    struct pass p;
+    expr_list *l;
+    int ndepths, nrows, lines;
+    int count, n, k;
+
+    get_slab_size(&nrows, &ndepths);
+
+    lines = (nrows < rows ? nrows : rows) *
+	(ndepths < depths ? ndepths : depths);
+
+    p.block = BLOCK_CELLS / cols;
+    if (p.block > BLOCK_ROWS)
+	p.block = BLOCK_ROWS;
+    if (p.block > (lines + num_contexts - 1) / num_contexts)
+	p.block = (lines + num_contexts - 1) / num_contexts;
+    if (p.block < 1)
+	p.block = 1;
+
+    for (l = ee, n = 0; l; l = l->next)
+	if (l->exp->type == expr_type_binding)
+	    n++;
+
+    p.out = G_malloc(n * sizeof(void *));
+    for (l = ee, k = 0; l; l = l->next)
+	if (l->exp->type == expr_type_binding)
+	    p.out[k++] = G_malloc((size_t) num_contexts * p.block * cols *
+				  Rast_cell_size(l->exp->res_type));
+
+    count = rows * depths;
+    n = 0;
+
+    for (p.slab.depth = 0; p.slab.depth < depths; p.slab.depth += ndepths) {
+	for (p.slab.row = 0; p.slab.row < rows; p.slab.row += nrows) {
+	    begin_slab(&p.slab, ndepths, nrows);
+	    lines = p.slab.ndepths * p.slab.nrows;
+
+	    for (p.first = 0; p.first < lines; p.first = p.last) {
+		int i;
+
+		if (verbose)
+		    G_percent(n, count, 2);
+
+		p.last = p.first + num_contexts * p.block;
+		if (p.last > lines)
+		    p.last = lines;
+
+		G_parallel_for(0, (p.last - p.first + p.block - 1) / p.block,
+			       1, evaluate_blocks, &p);
+
+		for (i = p.first; i < p.last; i++) {
+		    slab_row(&p.slab, i, &main_context.depth,
+			     &main_context.row);
+
+		    for (l = ee, k = 0; l; l = l->next) {
+			expression *e = l->exp;
+			size_t size;
+
+			if (e->type != expr_type_binding)
+			    continue;
+
+			size = (size_t) cols * Rast_cell_size(e->res_type);
+			put_map_row(e->data.bind.fd,
+				    (char *)p.out[k++] + (i - p.first) * size,
+				    e->res_type);
+		    }
+		}
+
+		n += p.last - p.first;
+	    }
+
+	    write_slab();
+	}
+    }
+
+    if (verbose)
+	G_percent(n, count, 2);
+
+    for (k = 0, l = ee; l; l = l->next)
+	if (l->exp->type == expr_type_binding)
+	    G_free(p.out[k++]);
+    G_free(p.out);
+}
+
 /****************************************************************************/
 
 static expr_list *exprs;
@@ -305,7 +878,6 @@ void execute(expr_list * ee)
 {
     int verbose = isatty(2);
     expr_list *l;
-    int count, n;
 
     exprs = ee;
     G_add_error_handler(error_handler, NULL);
@@ -342,7 +914,12 @@ void execute(expr_list * ee)
 
     setup_region();
 
+    /* rand() is called on whole rows to draw the same sequence */
+    calc_init(cols < TILE_CELLS || !is_reentrant_list(ee) ? cols : TILE_CELLS);
+    tiles = columns > 0 ? (cols + columns - 1) / columns : 0;
+
     /* Parse each expression and initialize the maps, buffers and variables */
+    num_evaluated = 0;
     for (l = ee; l; l = l->next) {
         expression *e = l->exp;
         const char *var;
@@ -360,39 +937,19 @@ void execute(expr_list * ee)
 
     setup_maps();
 
-    count = rows * depths;
-    n = 0;
-
     G_init_workers();
 
-    for (current_depth = 0; current_depth < depths; current_depth++) {
-        for (current_row = 0; current_row < rows; current_row++) {
-            if (verbose)
-		G_percent(n, count, 2);
-
-            for (l = ee; l; l = l->next) {
-		expression *e = l->exp;
-		int fd;
-
-		evaluate(e);
+    num_contexts = setup_contexts(ee);
 
-		if (e->type != expr_type_binding)
-		    continue;
-
-		fd = e->data.bind.fd;
-		put_map_row(fd, e->buf, e->res_type);
-            }
-
-            n++;
-        }
-    }
+    if (num_contexts > 1)
+	execute_parallel(ee, verbose);
+    else
+	execute_serial(ee, verbose);
 
     G_finish_workers();
 
-    if (verbose)
-	G_percent(n, count, 2);
-
     close_maps();
+    num_contexts = 1;
 
     for (l = ee; l; l = l->next) {
         expression *e = l->exp;
@@ -431,6 +988,7 @@ void describe_maps(FILE *fp, expr_list *ee)
 
     fprintf(fp, "output=");
 
+    num_evaluated = 0;
     for (l = ee; l; l = l->next) {
         expression *e = l->exp;
         const char *var;
@@ -47,7 +47,9 @@ static expression *allocate(int type, int res_type)
     e->type = type;
     e->res_type = res_type;
     e->buf = NULL;
-    e->worker = NULL;
+    e->row = NULL;
+    e->constant = 0;
+    e->same = NULL;
     return e;
 }
 
@@ -67,7 +67,9 @@ typedef struct expression
 	expr_data_func func;
 	expr_data_bind bind;
     } data;
-    void *worker;
+    void *row;			/* whole row of a map or an output */
+    int constant;		/* value computed at initialization */
+    struct expression *same;	/* earlier node with the same value */
 } expression;
 
 typedef struct expr_list
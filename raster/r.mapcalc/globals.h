@@ -7,7 +7,13 @@ extern long seed_value;
 extern long seeded;
 extern int region_approach;
 
-extern int current_depth, current_row;
-extern int depths, rows, columns;
+/* size of the region, the functions of lib/calc are called on tiles of
+ * <columns> (see calc.h) cells of a row */
+extern int depths, rows, cols;
+
+/* depth, row and first column of the tile evaluated by the calling thread */
+extern int current_depth(void);
+extern int current_row(void);
+extern int current_col(void);
 
 #endif /* __GLOBALS_H_ */
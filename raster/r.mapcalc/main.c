@@ -60,7 +60,7 @@ static expr_list *parse_file(const char *filename)
 int main(int argc, char **argv)
 {
     struct GModule *module;
-    struct Option *expr, *file, *seed, *region;
+    struct Option *expr, *file, *seed, *region, *nprocs;
     struct Flag *random, *describe;
     int all_ok;
 
@@ -104,6 +104,8 @@ int main(int argc, char **argv)
     seed->required = NO;
     seed->description = _("Seed for rand() function");
 
+    nprocs = G_define_standard_option(G_OPT_M_NPROCS);
+
     random = G_define_flag();
     random->key = 's';
     random->description = _("Generate random seed (result is non-deterministic)");
@@ -127,6 +129,8 @@ int main(int argc, char **argv)
 
     overwrite_flag = module->overwrite;
 
+    G_set_num_threads(atoi(nprocs->answer));
+
     if (expr->answer && file->answer)
         G_fatal_error(_("%s= and %s= are mutually exclusive"),
                         expr->key, file->key);
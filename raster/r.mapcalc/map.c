@@ -1,6 +1,7 @@
 
 #include <grass/config.h>
 
+#include <assert.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
@@ -23,7 +24,6 @@
 /****************************************************************************/
 
 static void prepare_region_from_maps(expression **, int, int);
-int columns;
 struct Cell_head current_region2;
 
 void setup_region(void)
@@ -31,8 +31,7 @@ void setup_region(void)
     G_get_window(&current_region2);
 
     rows = Rast_window_rows();
-    columns = Rast_window_cols();
-    calc_init(columns);
+    cols = Rast_window_cols();
     depths = 1;
 }
 
@@ -48,6 +47,7 @@ struct sub_cache
 struct row_cache
 {
     int fd;
+    struct R_read_ctx *ctx;	/* NULL: read through fd */
     int nrows;
     struct sub_cache *sub[3];
 };
@@ -64,10 +64,7 @@ struct map
     struct Categories cats;
     struct Colors colors;
     BTREE btree;
-    struct row_cache cache;
-#ifdef HAVE_PTHREAD_H
-    pthread_mutex_t mutex;
-#endif
+    struct row_cache *cache;	/* one per evaluation context */
 };
 
 /****************************************************************************/
@@ -75,7 +72,7 @@ struct map
 static struct map *maps;
 static int num_maps;
 static int max_maps;
-static int masking;
+static int num_contexts = 1;
 
 static int min_row = INT_MAX;
 static int max_row = -INT_MAX;
@@ -86,22 +83,23 @@ static int max_rows_in_memory = 8;
 
 #ifdef HAVE_PTHREAD_H
 static pthread_mutex_t cats_mutex;
-static pthread_mutex_t mask_mutex;
+static pthread_mutex_t colors_mutex;
 #endif
 
 /****************************************************************************/
 
-static void read_row(int fd, void *buf, int row, int res_type)
+static void read_row(struct row_cache *cache, void *buf, int row,
+		     int res_type)
 {
-#ifdef HAVE_PTHREAD_H
-    if (masking)
-	pthread_mutex_lock(&mask_mutex);
-#endif
-    Rast_get_row(fd, buf, row, res_type);
-#ifdef HAVE_PTHREAD_H
-    if (masking)
-	pthread_mutex_unlock(&mask_mutex);
-#endif
+    if (cache->ctx) {
+	Rast_get_row_ctx(cache->ctx, buf, row, res_type);
+	return;
+    }
+
+    /* the state of the map and of the mask is shared, only one context
+       reads without a read context of its own */
+    assert(num_contexts == 1);
+    Rast_get_row(cache->fd, buf, row, res_type);
 }
 
 static void cache_sub_init(struct row_cache *cache, int data_type)
@@ -121,6 +119,7 @@ static void cache_sub_init(struct row_cache *cache, int data_type)
 static void cache_setup(struct row_cache *cache, int fd, int nrows)
 {
     cache->fd = fd;
+    cache->ctx = NULL;
     cache->nrows = nrows;
     cache->sub[CELL_TYPE] = NULL;
     cache->sub[FCELL_TYPE] = NULL;
@@ -131,6 +130,9 @@ static void cache_release(struct row_cache *cache)
 {
     int t;
 
+    if (cache->ctx)
+	Rast_free_read_ctx(cache->ctx);
+
     for (t = 0; t < 3; t++) {
 	struct sub_cache *sub = cache->sub[t];
 	int i;
@@ -164,7 +166,7 @@ static void *cache_get_raw(struct row_cache *cache, int row, int data_type)
 
     if (i >= 0 && i < cache->nrows) {
 	if (!sub->valid[i]) {
-	    read_row(cache->fd, sub->buf[i], row, data_type);
+	    read_row(cache, sub->buf[i], row, data_type);
 	    sub->valid[i] = 1;
 	}
 	return sub->buf[i];
@@ -173,7 +175,7 @@ static void *cache_get_raw(struct row_cache *cache, int row, int data_type)
     if (i <= -cache->nrows || i >= cache->nrows * 2 - 1) {
 	memset(sub->valid, 0, cache->nrows);
 	sub->row = row;
-	read_row(cache->fd, sub->buf[0], row, data_type);
+	read_row(cache, sub->buf[0], row, data_type);
 	sub->valid[0] = 1;
 	return sub->buf[0];
     }
@@ -201,7 +203,7 @@ static void *cache_get_raw(struct row_cache *cache, int row, int data_type)
     G_freea(tmp);
     G_freea(vtmp);
 
-    read_row(cache->fd, sub->buf[i], row, data_type);
+    read_row(cache, sub->buf[i], row, data_type);
     sub->valid[i] = 1;
 
     return sub->buf[i];
@@ -210,7 +212,7 @@ static void *cache_get_raw(struct row_cache *cache, int row, int data_type)
 static void cache_get(struct row_cache *cache, void *buf, int row, int res_type)
 {
     void *p = cache_get_raw(cache, row, res_type);
-    memcpy(buf, p, columns * Rast_cell_size(res_type));
+    memcpy(buf, p, cols * Rast_cell_size(res_type));
 }
 
 /****************************************************************************/
@@ -245,13 +247,19 @@ static void init_cats(struct map *m)
 static void translate_from_colors(struct map *m, DCELL *rast, CELL *cell,
 				  int ncols, int mod)
 {
-    unsigned char *red = G_alloca(columns);
-    unsigned char *grn = G_alloca(columns);
-    unsigned char *blu = G_alloca(columns);
-    unsigned char *set = G_alloca(columns);
+    unsigned char *red = G_alloca(cols);
+    unsigned char *grn = G_alloca(cols);
+    unsigned char *blu = G_alloca(cols);
+    unsigned char *set = G_alloca(cols);
     int i;
 
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&colors_mutex);
+#endif
     Rast_lookup_d_colors(rast, red, grn, blu, set, ncols, &m->colors);
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&colors_mutex);
+#endif
 
     switch (mod) {
     case 'r':
@@ -388,19 +396,13 @@ static void setup_map(struct map *m)
 {
     int nrows = m->max_row - m->min_row + 1;
 
-#ifdef HAVE_PTHREAD_H
-    pthread_mutex_init(&m->mutex, NULL);
-#endif
-
-    if (nrows > 1 && nrows <= max_rows_in_memory) {
-	cache_setup(&m->cache, m->fd, nrows);
-	m->use_rowio = 1;
-    }
-    else
-	m->use_rowio = 0;
+    m->use_rowio = nrows > 1 && nrows <= max_rows_in_memory;
+    m->cache = G_malloc(sizeof(struct row_cache));
+    cache_setup(&m->cache[0], m->fd, nrows);
 }
 
-static void read_map(struct map *m, void *buf, int res_type, int row, int col)
+static void read_map(struct map *m, struct row_cache *cache, void *buf,
+		     int res_type, int row, int col)
 {
     CELL *ibuf = buf;
     FCELL *fbuf = buf;
@@ -411,15 +413,15 @@ static void read_map(struct map *m, void *buf, int res_type, int row, int col)
 
 	switch (res_type) {
 	case CELL_TYPE:
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < cols; i++)
 		SET_NULL_C(&ibuf[i]);
 	    break;
 	case FCELL_TYPE:
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < cols; i++)
 		SET_NULL_F(&fbuf[i]);
 	    break;
 	case DCELL_TYPE:
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < cols; i++)
 		SET_NULL_D(&dbuf[i]);
 	    break;
 	default:
@@ -431,9 +433,9 @@ static void read_map(struct map *m, void *buf, int res_type, int row, int col)
     }
 
     if (m->use_rowio)
-	cache_get(&m->cache, buf, row, res_type);
+	cache_get(cache, buf, row, res_type);
     else
-	read_row(m->fd, buf, row, res_type);
+	read_row(cache, buf, row, res_type);
 
     if (col)
 	column_shift(buf, res_type, col);
@@ -441,14 +443,20 @@ static void read_map(struct map *m, void *buf, int res_type, int row, int col)
 
 static void close_map(struct map *m)
 {
+    int i;
+
     if (m->fd < 0)
 	return;
 
-    Rast_close(m->fd);
+    /* read contexts must be freed before the map is closed */
+    if (m->cache) {
+	for (i = 0; i < num_contexts; i++)
+	    cache_release(&m->cache[i]);
+	G_free(m->cache);
+	m->cache = NULL;
+    }
 
-#ifdef HAVE_PTHREAD_H
-    pthread_mutex_destroy(&m->mutex);
-#endif
+    Rast_close(m->fd);
 
     if (m->have_cats) {
 	btree_free(&m->btree);
@@ -461,10 +469,7 @@ static void close_map(struct map *m)
 	m->have_colors = 0;
     }
 
-    if (m->use_rowio) {
-	cache_release(&m->cache);
-	m->use_rowio = 0;
-    }
+    m->use_rowio = 0;
 }
 
 /****************************************************************************/
@@ -497,7 +502,7 @@ int map_type(const char *name, int mod)
     }
 }
 
-int open_map(const char *name, int mod, int row, int col)
+int open_map(const char *name, int mod, int depth, int row, int col)
 {
     int i;
     const char *mapset;
@@ -573,6 +578,7 @@ int open_map(const char *name, int mod, int row, int col)
     m->min_row = row;
     m->max_row = row;
     m->fd = -1;
+    m->cache = NULL;
 
     if (use_cats)
 	init_cats(m);
@@ -590,33 +596,61 @@ void setup_maps(void)
 
 #ifdef HAVE_PTHREAD_H
     pthread_mutex_init(&cats_mutex, NULL);
-    pthread_mutex_init(&mask_mutex, NULL);
-    masking = Rast_maskfd() >= 0;
+    pthread_mutex_init(&colors_mutex, NULL);
 #endif
 
     for (i = 0; i < num_maps; i++)
 	setup_map(&maps[i]);
 }
 
-void get_map_row(int idx, int mod, int depth, int row, int col, void *buf,
-		 int res_type)
+int setup_map_contexts(int n)
+{
+    int i, j;
+
+    for (i = 0; i < num_maps; i++) {
+	struct map *m = &maps[i];
+
+	m->cache = G_realloc(m->cache, n * sizeof(struct row_cache));
+	for (j = 0; j < n; j++) {
+	    if (j > 0)
+		cache_setup(&m->cache[j], m->fd, m->cache[0].nrows);
+	    /* private decode state, rows are read concurrently */
+	    m->cache[j].ctx = Rast_create_read_ctx(m->fd);
+	}
+    }
+
+    num_contexts = n;
+
+    return n;
+}
+
+/* the rows are read in order, a slab is the whole map */
+void get_slab_size(int *nrows, int *ndepths)
+{
+    *nrows = rows;
+    *ndepths = 1;
+}
+
+void read_slab(int depth, int row)
+{
+}
+
+void get_map_row(int context, int idx, int mod, int depth, int row, int col,
+		 void *buf, int res_type)
 {
     CELL *ibuf;
     DCELL *fbuf;
     struct map *m = &maps[idx];
-
-#ifdef HAVE_PTHREAD_H
-    pthread_mutex_lock(&m->mutex);
-#endif
+    struct row_cache *cache = &m->cache[context];
 
     switch (mod) {
     case 'M':
-	read_map(m, buf, res_type, row, col);
+	read_map(m, cache, buf, res_type, row, col);
 	break;
     case '@':
-	ibuf = G_alloca(columns * sizeof(CELL));
-	read_map(m, ibuf, CELL_TYPE, row, col);
-	translate_from_cats(m, ibuf, buf, columns);
+	ibuf = G_alloca(cols * sizeof(CELL));
+	read_map(m, cache, ibuf, CELL_TYPE, row, col);
+	translate_from_cats(m, ibuf, buf, cols);
 	G_freea(ibuf);
 	break;
     case 'r':
@@ -625,19 +659,15 @@ void get_map_row(int idx, int mod, int depth, int row, int col, void *buf,
     case '#':
     case 'y':
     case 'i':
-	fbuf = G_alloca(columns * sizeof(DCELL));
-	read_map(m, fbuf, DCELL_TYPE, row, col);
-	translate_from_colors(m, fbuf, buf, columns, mod);
+	fbuf = G_alloca(cols * sizeof(DCELL));
+	read_map(m, cache, fbuf, DCELL_TYPE, row, col);
+	translate_from_colors(m, fbuf, buf, cols, mod);
 	G_freea(fbuf);
 	break;
     default:
 	G_fatal_error(_("Invalid map modifier: '%c'"), mod);
 	break;
     }
-
-#ifdef HAVE_PTHREAD_H
-    pthread_mutex_unlock(&m->mutex);
-#endif
 }
 
 void close_maps(void)
@@ -648,10 +678,11 @@ void close_maps(void)
 	close_map(&maps[i]);
 
     num_maps = 0;
+    num_contexts = 1;
 
 #ifdef HAVE_PTHREAD_H
     pthread_mutex_destroy(&cats_mutex);
-    pthread_mutex_destroy(&mask_mutex);
+    pthread_mutex_destroy(&colors_mutex);
 #endif
 }
 
@@ -682,6 +713,10 @@ void put_map_row(int fd, void *buf, int res_type)
     Rast_put_row(fd, buf, res_type);
 }
 
+void write_slab(void)
+{
+}
+
 void close_output_map(int fd)
 {
     Rast_close(fd);
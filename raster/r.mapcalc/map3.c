@@ -1,8 +1,13 @@
 
+#include <grass/config.h>
+
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
 #include <unistd.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #include <grass/gis.h>
 #include <grass/raster.h>
@@ -27,9 +32,8 @@ void setup_region(void)
     Rast3d_get_window(&current_region3);
 
     rows = current_region3.rows;
-    columns = current_region3.cols;
+    cols = current_region3.cols;
     depths = current_region3.depths;
-    calc_init(columns);
 }
 
 /****************************************************************************/
@@ -40,21 +44,35 @@ typedef struct map
     const char *mapset;
     int have_cats;
     int have_colors;
+    int min_depth, max_depth;
     int min_row, max_row;
     void *handle;
+    int resample;		/* region differs from the current region */
+    DCELL *slab;		/* rows of the current slab */
+    size_t slab_size;
+    int depth0, ndepths;
+    int row0, nrows;
     int fd;
     struct Categories cats;
     struct Colors colors;
     BTREE btree;
 } map;
 
+typedef struct omap
+{
+    void *handle;
+    int type;			/* FCELL_TYPE or DCELL_TYPE */
+    void *slab;			/* rows of the current slab */
+    void *tile;
+} omap;
+
 /****************************************************************************/
 
 static map *maps;
 static int num_maps;
 static int max_maps;
 
-static void **omaps;
+static omap *omaps;
 static int num_omaps;
 static int max_omaps;
 
@@ -66,100 +84,138 @@ static int max_row = -INT_MAX;
 static int min_col = INT_MAX;
 static int max_col = -INT_MAX;
 
+/* The maps are read and written by slabs of one layer of tiles of the
+ * output maps, which all have the same tile size. The input maps are read
+ * by blocks which cover the slab and its neighborhood.
+ */
+static int tile_x, tile_y, tile_z;
+static int slab_depth, slab_row;	/* origin of the current slab */
+
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t cats_mutex;
+static pthread_mutex_t colors_mutex;
+#endif
+
 /****************************************************************************/
 
-static void read_row(void *handle, char *buf, int type, int depth, int row)
+static void setup_tiles(void)
 {
-    int i;
+    if (tile_x)
+	return;
 
-    switch (type) {
-    case CELL_TYPE:
-	for (i = 0; i < columns; i++) {
-	    double x;
+    Rast3d_compute_optimal_tile_dimension(&current_region3, DCELL_TYPE,
+					  &tile_x, &tile_y, &tile_z, 32);
+}
 
-	    Rast3d_get_value(handle, i, row, depth, (char *)&x, DCELL_TYPE);
-	    if (Rast3d_is_null_value_num(&x, DCELL_TYPE))
-		SET_NULL_C(&((CELL *) buf)[i]);
-	    else
-		((CELL *) buf)[i] = (CELL) x;
-	}
-	break;
-    case FCELL_TYPE:
-	for (i = 0; i < columns; i++) {
-	    float x;
+static int same_region(const RASTER3D_Region * a, const RASTER3D_Region * b)
+{
+    return a->north == b->north && a->south == b->south &&
+	a->east == b->east && a->west == b->west &&
+	a->top == b->top && a->bottom == b->bottom &&
+	a->rows == b->rows && a->cols == b->cols && a->depths == b->depths;
+}
 
-	    Rast3d_get_value(handle, i, row, depth, (char *)&x, FCELL_TYPE);
-	    if (Rast3d_is_null_value_num(&x, FCELL_TYPE))
-		SET_NULL_F(&((FCELL *) buf)[i]);
-	    else
-		((FCELL *) buf)[i] = x;
-	}
-	break;
-    case DCELL_TYPE:
-	for (i = 0; i < columns; i++) {
-	    double x;
+static void read_block(map * m)
+{
+    int z0 = slab_depth + m->min_depth;
+    int z1 = slab_depth + tile_z + m->max_depth;
+    int y0 = slab_row + m->min_row;
+    int y1 = slab_row + tile_y + m->max_row;
+    size_t size;
+
+    if (z0 < 0)
+	z0 = 0;
+    if (z1 > depths)
+	z1 = depths;
+    if (y0 < 0)
+	y0 = 0;
+    if (y1 > rows)
+	y1 = rows;
+
+    m->depth0 = z0;
+    m->ndepths = z1 > z0 ? z1 - z0 : 0;
+    m->row0 = y0;
+    m->nrows = y1 > y0 ? y1 - y0 : 0;
+
+    size = (size_t) m->ndepths * m->nrows * cols;
+    if (size == 0)
+	return;
 
-	    Rast3d_get_value(handle, i, row, depth, (char *)&x, DCELL_TYPE);
-	    if (Rast3d_is_null_value_num(&x, DCELL_TYPE))
-		SET_NULL_D(&((DCELL *) buf)[i]);
-	    else
-		((DCELL *) buf)[i] = x;
-	}
-	break;
+    if (size > m->slab_size) {
+	m->slab = G_realloc(m->slab, size * sizeof(DCELL));
+	m->slab_size = size;
     }
+
+    if (m->resample) {
+	/* the values are resampled voxel by voxel */
+	DCELL *p = m->slab;
+	int x, y, z;
+
+	for (z = z0; z < z1; z++)
+	    for (y = y0; y < y1; y++)
+		for (x = 0; x < cols; x++)
+		    Rast3d_get_value(m->handle, x, y, z, (char *)p++,
+				     DCELL_TYPE);
+    }
+    else
+	Rast3d_get_block(m->handle, 0, y0, z0, cols, m->nrows, m->ndepths,
+			 m->slab, DCELL_TYPE);
 }
 
-static void write_row(void *handle, const char *buf, int type, int depth,
-		      int row)
+static void read_row(map * m, void *buf, int type, int depth, int row)
 {
+    const DCELL *x = m->slab +
+	((size_t) (depth - m->depth0) * m->nrows + row - m->row0) * cols;
     int i;
 
     switch (type) {
     case CELL_TYPE:
-	for (i = 0; i < columns; i++) {
-	    double x;
-
-	    if (IS_NULL_C(&((CELL *) buf)[i]))
-		Rast3d_set_null_value(&x, 1, DCELL_TYPE);
+	for (i = 0; i < cols; i++) {
+	    if (Rast3d_is_null_value_num(&x[i], DCELL_TYPE))
+		SET_NULL_C(&((CELL *) buf)[i]);
 	    else
-		x = ((CELL *) buf)[i];
-
-	    if (Rast3d_put_value(handle, i, row, depth, (char *)&x, DCELL_TYPE) <
-		0)
-		G_fatal_error(_("Error writing data"));
+		((CELL *) buf)[i] = (CELL) x[i];
 	}
 	break;
     case FCELL_TYPE:
-	for (i = 0; i < columns; i++) {
-	    float x;
-
-	    if (IS_NULL_F(&((FCELL *) buf)[i]))
-		Rast3d_set_null_value(&x, 1, FCELL_TYPE);
+	for (i = 0; i < cols; i++) {
+	    if (Rast3d_is_null_value_num(&x[i], DCELL_TYPE))
+		SET_NULL_F(&((FCELL *) buf)[i]);
 	    else
-		x = ((FCELL *) buf)[i];
-
-	    if (Rast3d_put_value(handle, i, row, depth, (char *)&x, FCELL_TYPE) <
-		0)
-		G_fatal_error(_("Error writing data"));
+		((FCELL *) buf)[i] = (FCELL) x[i];
 	}
 	break;
     case DCELL_TYPE:
-	for (i = 0; i < columns; i++) {
-	    double x;
-
-	    if (IS_NULL_D(&((DCELL *) buf)[i]))
-		Rast3d_set_null_value(&x, 1, DCELL_TYPE);
-	    else
-		x = ((DCELL *) buf)[i];
-
-	    if (Rast3d_put_value(handle, i, row, depth, (char *)&x, DCELL_TYPE) <
-		0)
-		G_fatal_error(_("Error writing data"));
-	}
+	memcpy(buf, x, cols * sizeof(DCELL));
 	break;
     }
 }
 
+static void write_tiles(omap * o)
+{
+    int length = Rast3d_length(o->type);
+    int nrows = rows - slab_row < tile_y ? rows - slab_row : tile_y;
+    int ndepths = depths - slab_depth < tile_z ? depths - slab_depth : tile_z;
+    int tx, x0, y, z;
+
+    for (tx = 0, x0 = 0; x0 < cols; tx++, x0 += tile_x) {
+	int nx = cols - x0 < tile_x ? cols - x0 : tile_x;
+	int idx = Rast3d_tile2tile_index(o->handle, tx, slab_row / tile_y,
+					 slab_depth / tile_z);
+
+	for (z = 0; z < ndepths; z++)
+	    for (y = 0; y < nrows; y++)
+		memcpy((char *)o->tile +
+		       ((size_t) (z * tile_y + y) * tile_x) * length,
+		       (char *)o->slab +
+		       (((size_t) z * tile_y + y) * cols + x0) * length,
+		       (size_t) nx * length);
+
+	if (!Rast3d_write_tile(o->handle, idx, o->tile, o->type))
+	    G_fatal_error(_("Error writing data"));
+    }
+}
+
 /****************************************************************************/
 
 static int compare_ints(const void *a, const void *b)
@@ -170,13 +226,13 @@ static int compare_ints(const void *a, const void *b)
 static void init_colors(map * m)
 {
     if (!red)
-	red = G_malloc(columns);
+	red = G_malloc(cols);
     if (!grn)
-	grn = G_malloc(columns);
+	grn = G_malloc(cols);
     if (!blu)
-	blu = G_malloc(columns);
+	blu = G_malloc(cols);
     if (!set)
-	set = G_malloc(columns);
+	set = G_malloc(cols);
 
     if (Rast3d_read_colors((char *)m->name, (char *)m->mapset, &m->colors) < 0)
 	G_fatal_error(_("Unable to read color file for raster map <%s@%s>"),
@@ -203,6 +259,10 @@ static void translate_from_colors(map * m, DCELL * rast, CELL * cell,
 {
     int i;
 
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&colors_mutex);
+#endif
+
     Rast_lookup_d_colors(rast, red, grn, blu, set, ncols, &m->colors);
 
     switch (mod) {
@@ -240,6 +300,10 @@ static void translate_from_colors(map * m, DCELL * rast, CELL * cell,
 	G_fatal_error(_("Invalid map modifier: '%c'"), mod);
 	break;
     }
+
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&colors_mutex);
+#endif
 }
 
 /* convert cell values to double based on the values in the
@@ -277,6 +341,10 @@ static void translate_from_cats(map * m, CELL * cell, DCELL * xcell,
     void *ptr;
     char *label;
 
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&cats_mutex);
+#endif
+
     btree = &m->btree;
     pcats = &m->cats;
 
@@ -321,6 +389,10 @@ static void translate_from_cats(map * m, CELL * cell, DCELL * xcell,
 	else
 	    *xcell = values[idx];
     }
+
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&cats_mutex);
+#endif
 }
 
 static void setup_map(map * m)
@@ -339,15 +411,15 @@ static void read_map(map * m, void *buf, int res_type, int depth, int row,
 
 	switch (res_type) {
 	case CELL_TYPE:
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < cols; i++)
 		SET_NULL_C(&ibuf[i]);
 	    break;
 	case FCELL_TYPE:
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < cols; i++)
 		SET_NULL_F(&fbuf[i]);
 	    break;
 	case DCELL_TYPE:
-	    for (i = 0; i < columns; i++)
+	    for (i = 0; i < cols; i++)
 		SET_NULL_D(&dbuf[i]);
 	    break;
 	default:
@@ -358,7 +430,7 @@ static void read_map(map * m, void *buf, int res_type, int depth, int row,
 	return;
     }
 
-    read_row(m->handle, buf, res_type, depth, row);
+    read_row(m, buf, res_type, depth, row);
 
     if (col)
 	column_shift(buf, res_type, col);
@@ -373,6 +445,8 @@ static void close_map(map * m)
 	G_fatal_error(_("Unable to close raster map <%s@%s>"),
 		      m->name, m->mapset);
 
+    G_free(m->slab);
+
     if (m->have_cats) {
 	btree_free(&m->btree);
 	Rast_free_cats(&m->cats);
@@ -426,11 +500,12 @@ int map_type(const char *name, int mod)
     }
 }
 
-int open_map(const char *name, int mod, int row, int col)
+int open_map(const char *name, int mod, int depth, int row, int col)
 {
     int i;
     const char *mapset;
     char *tmpname;
+    RASTER3D_Region region;
     int use_cats = 0;
     int use_colors = 0;
     map *m;
@@ -476,6 +551,10 @@ int open_map(const char *name, int mod, int row, int col)
 	if (strcmp(m->name, name) != 0 || strcmp(m->mapset, mapset) != 0)
 	    continue;
 
+	if (depth < m->min_depth)
+	    m->min_depth = depth;
+	if (depth > m->max_depth)
+	    m->max_depth = depth;
 	if (row < m->min_row)
 	    m->min_row = row;
 	if (row > m->max_row)
@@ -502,17 +581,28 @@ int open_map(const char *name, int mod, int row, int col)
     m->mapset = mapset;
     m->have_cats = 0;
     m->have_colors = 0;
+    m->min_depth = depth;
+    m->max_depth = depth;
     m->min_row = row;
     m->max_row = row;
+    m->slab = NULL;
+    m->slab_size = 0;
 
     if (use_cats)
 	init_cats(m);
     if (use_colors)
 	init_colors(m);
 
+    /* blocks of a map in the current region are copied from its tiles,
+     * other maps are resampled through the tile cache */
+    if (!Rast3d_read_region_map(name, mapset, &region))
+	G_fatal_error(_("Unable to read header of raster map <%s>"), name);
+    m->resample = !same_region(&region, &current_region3);
+
     m->handle = Rast3d_open_cell_old((char *)name, (char *)mapset,
 				&current_region3, DCELL_TYPE,
-				RASTER3D_USE_CACHE_DEFAULT);
+				m->resample ? RASTER3D_USE_CACHE_DEFAULT :
+				RASTER3D_NO_CACHE);
 
     if (!m->handle)
 	G_fatal_error(_("Unable to open raster map <%s>"), name);
@@ -524,21 +614,46 @@ void setup_maps(void)
 {
     int i;
 
-    /* We need to reduce the number of worker threads to one, to
-     * avoid that several threads access a single map for reading
-     * at the same time. The raster3d library is not thread safe.
-     * */
-    putenv("WORKERS=0");
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_init(&cats_mutex, NULL);
+    pthread_mutex_init(&colors_mutex, NULL);
+#endif
 
     for (i = 0; i < num_maps; i++)
 	setup_map(&maps[i]);
 }
 
-void get_map_row(int idx, int mod, int depth, int row, int col, void *buf,
-		 int res_type)
+int setup_map_contexts(int n)
+{
+    /* the raster3d library is not thread safe, but the rows are read
+     * from the blocks read by read_slab() */
+    return n;
+}
+
+void get_slab_size(int *nrows, int *ndepths)
+{
+    setup_tiles();
+
+    *nrows = tile_y;
+    *ndepths = tile_z;
+}
+
+void read_slab(int depth, int row)
+{
+    int i;
+
+    slab_depth = depth;
+    slab_row = row;
+
+    for (i = 0; i < num_maps; i++)
+	read_block(&maps[i]);
+}
+
+void get_map_row(int context, int idx, int mod, int depth, int row, int col,
+		 void *buf, int res_type)
 {
-    static CELL *ibuf;
-    static DCELL *fbuf;
+    CELL *ibuf;
+    DCELL *fbuf;
     map *m = &maps[idx];
 
     switch (mod) {
@@ -546,10 +661,10 @@ void get_map_row(int idx, int mod, int depth, int row, int col, void *buf,
 	read_map(m, buf, res_type, depth, row, col);
 	break;
     case '@':
-	if (!ibuf)
-	    ibuf = G_malloc(columns * sizeof(CELL));
+	ibuf = G_alloca(cols * sizeof(CELL));
 	read_map(m, ibuf, CELL_TYPE, depth, row, col);
-	translate_from_cats(m, ibuf, buf, columns);
+	translate_from_cats(m, ibuf, buf, cols);
+	G_freea(ibuf);
 	break;
     case 'r':
     case 'g':
@@ -557,10 +672,10 @@ void get_map_row(int idx, int mod, int depth, int row, int col, void *buf,
     case '#':
     case 'y':
     case 'i':
-	if (!fbuf)
-	    fbuf = G_malloc(columns * sizeof(DCELL));
+	fbuf = G_alloca(cols * sizeof(DCELL));
 	read_map(m, fbuf, DCELL_TYPE, depth, row, col);
-	translate_from_colors(m, fbuf, buf, columns, mod);
+	translate_from_colors(m, fbuf, buf, cols, mod);
+	G_freea(fbuf);
 	break;
     default:
 	G_fatal_error(_("Invalid map modifier: '%c'"), mod);
@@ -576,6 +691,11 @@ void close_maps(void)
 	close_map(&maps[i]);
 
     num_maps = 0;
+
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_destroy(&cats_mutex);
+    pthread_mutex_destroy(&colors_mutex);
+#endif
 }
 
 void list_maps(FILE *fp, const char *sep)
@@ -597,39 +717,76 @@ int check_output_map(const char *name)
 
 int open_output_map(const char *name, int res_type)
 {
-    void *handle;
-
-    Rast3d_set_file_type(res_type == FCELL_TYPE ? FCELL_TYPE : DCELL_TYPE);
-
-    handle = Rast3d_open_new_opt_tile_size((char *)name, RASTER3D_USE_CACHE_XYZ, &current_region3, res_type == FCELL_TYPE ? FCELL_TYPE : DCELL_TYPE, 32);
-
-    if (!handle)
-	G_fatal_error(_("Unable to create raster map <%s>"), name);
+    int type = res_type == FCELL_TYPE ? FCELL_TYPE : DCELL_TYPE;
+    int compression, precision;
+    omap *o;
 
+    setup_tiles();
+    Rast3d_get_compression_mode(&compression, &precision);
 
     if (num_omaps >= max_omaps) {
 	max_omaps += 10;
-	omaps = G_realloc(omaps, max_omaps * sizeof(void *));
+	omaps = G_realloc(omaps, max_omaps * sizeof(omap));
     }
 
-    omaps[num_omaps] = handle;
+    o = &omaps[num_omaps];
+
+    /* the tiles are written by write_slab() */
+    o->handle = Rast3d_open_new_param(name, type, RASTER3D_NO_CACHE,
+				      &current_region3, type, compression,
+				      precision, tile_x, tile_y, tile_z);
+
+    if (!o->handle)
+	G_fatal_error(_("Unable to create raster map <%s>"), name);
+
+    o->type = type;
+    o->slab = G_malloc((size_t) tile_z * tile_y * cols * Rast3d_length(type));
+    o->tile = G_malloc((size_t) tile_z * tile_y * tile_x * Rast3d_length(type));
 
     return num_omaps++;
 }
 
 void put_map_row(int fd, void *buf, int res_type)
 {
-    void *handle = omaps[fd];
+    omap *o = &omaps[fd];
+    int depth = current_depth() - slab_depth;
+    int row = current_row() - slab_row;
+    char *dst = (char *)o->slab +
+	((size_t) depth * tile_y + row) * cols * Rast3d_length(o->type);
+
+    if (res_type == CELL_TYPE) {
+	const CELL *ibuf = buf;
+	DCELL *dbuf = (DCELL *) dst;
+	int i;
 
-    write_row(handle, buf, res_type, current_depth, current_row);
+	for (i = 0; i < cols; i++) {
+	    if (IS_NULL_C(&ibuf[i]))
+		SET_NULL_D(&dbuf[i]);
+	    else
+		dbuf[i] = ibuf[i];
+	}
+    }
+    else
+	memcpy(dst, buf, cols * Rast_cell_size(res_type));
+}
+
+void write_slab(void)
+{
+    int i;
+
+    for (i = 0; i < num_omaps; i++)
+	write_tiles(&omaps[i]);
 }
 
 void close_output_map(int fd)
 {
-    void *handle = omaps[fd];
+    omap *o = &omaps[fd];
 
-    if (!Rast3d_close(handle))
+    if (!Rast3d_close(o->handle))
 	G_fatal_error(_("Unable to close output raster map"));
+
+    G_free(o->slab);
+    G_free(o->tile);
 }
 
 void unopen_output_map(int fd)
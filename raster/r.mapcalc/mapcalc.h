@@ -45,16 +45,20 @@ extern void describe_maps(FILE *, expr_list *);
 extern void setup_region(void);
 
 extern int map_type(const char *name, int mod);
-extern int open_map(const char *name, int mod, int row, int col);
+extern int open_map(const char *name, int mod, int depth, int row, int col);
 extern void setup_maps(void);
-extern void get_map_row(int idx, int mod, int depth, int row, int col,
-			void *buf, int res_type);
+extern int setup_map_contexts(int n);
+extern void get_slab_size(int *nrows, int *ndepths);
+extern void read_slab(int depth, int row);
+extern void get_map_row(int context, int idx, int mod, int depth, int row,
+			int col, void *buf, int res_type);
 extern void close_maps(void);
 extern void list_maps(FILE *, const char *);
 
 extern int check_output_map(const char *name);
 extern int open_output_map(const char *name, int res_type);
 extern void put_map_row(int fd, void *buf, int res_type);
+extern void write_slab(void);
 extern void close_output_map(int fd);
 extern void unopen_output_map(int fd);
 
@@ -0,0 +1,63 @@
+"""Test of r3.mapcalc evaluating the volumes by layers of tiles
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+
+class TestTiles(TestCase):
+    """Neighborhoods across tiles and evaluation with several threads"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        # several layers of tiles, the last ones partial
+        cls.runModule('g.region', n=50, s=0, e=70, w=0, b=0, t=30,
+                      res=1, res3=1)
+        cls.runModule('r3.mapcalc',
+                      expression='v = col() + row() * 1000 + depth() * 1000000')
+        cls.to_remove.append('v')
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster_3d',
+                      name=cls.to_remove)
+
+    def assert_value(self, name, expression, value, nprocs=1):
+        self.assertModule('r3.mapcalc', nprocs=nprocs,
+                          expression='%s = %s' % (name, expression))
+        self.to_remove.append(name)
+        self.assertRaster3dMinMax(name, refmin=value, refmax=value)
+
+    def test_neighborhood(self):
+        """Offsets in rows, columns and depths"""
+        self.assert_value('t_col', 'v[0,1,0] - v', 1)
+        self.assert_value('t_row', 'v[1,0,0] - v', 1000)
+        self.assert_value('t_depth', 'v[0,0,1] - v', 1000000)
+        self.assert_value('t_all', 'v - v[-3,-2,-5]', 5003002)
+
+    def test_threads(self):
+        """Same maps with one and four threads"""
+        expression = 'sin(v * 0.001) + v[2,-1,3] - z()'
+        self.assertModule('r3.mapcalc', nprocs=1,
+                          expression='serial = ' + expression)
+        self.assertModule('r3.mapcalc', nprocs=4,
+                          expression='par = ' + expression)
+        self.to_remove.extend(['serial', 'par'])
+        self.assertRasters3dNoDifference(actual='par', reference='serial',
+                                         precision=0)
+        self.assert_value('t_par', 'v[0,0,-1] - v', -1000000, nprocs=4)
+
+
+if __name__ == '__main__':
+    test()
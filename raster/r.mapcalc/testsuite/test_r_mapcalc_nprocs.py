@@ -0,0 +1,85 @@
+"""Test of r.mapcalc evaluating rows with several threads
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+EXPRESSION = """\
+{p}_nbr = elev[-1,0] + elev[1,1] * 2 - elev[0,-2] + elev[-3,3]
+{p}_pos = row() * 1000 + col() + y() + area()
+{p}_fun = median(elev, elev[-1,0], elev[1,0]) + mode(elev, elev[0,1], 3)
+{p}_var = eval(t = elev * 2, t + elev[2,0])
+{p}_cnd = if(row() % 5 == 0, null(), int(elev) % 7)
+"""
+
+OUTPUTS = ['nbr', 'pos', 'fun', 'var', 'cnd']
+
+
+class TestRowParallel(TestCase):
+    """Results do not depend on the number of threads"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=97, s=0, w=0, e=61, res=1)
+        cls.runModule('r.mapcalc',
+                      expression='elev = sin(row() * 0.3) * 50 + col() % 13')
+        cls.to_remove.append('elev')
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+
+    def run_mapcalc(self, prefix, nprocs, expression=EXPRESSION):
+        self.assertModule('r.mapcalc', nprocs=nprocs, overwrite=True,
+                          expression=expression.format(p=prefix))
+        self.to_remove.extend(prefix + '_' + o for o in OUTPUTS)
+
+    def assert_same(self, prefix1, prefix2):
+        for o in OUTPUTS:
+            self.assertRastersNoDifference(actual=prefix2 + '_' + o,
+                                           reference=prefix1 + '_' + o,
+                                           precision=0)
+
+    def test_threads(self):
+        """Neighborhood modifiers, row() and col() with 1 to 7 threads"""
+        self.run_mapcalc('serial', 1)
+        for nprocs in (2, 4, 7):
+            self.run_mapcalc('par%d' % nprocs, nprocs)
+            self.assert_same('serial', 'par%d' % nprocs)
+
+    def test_mask(self):
+        """Rows are masked the same way with several threads"""
+        self.runModule('r.mapcalc',
+                       expression='MASK = if(elev < 30 && col() > 5, 1, null())')
+        try:
+            self.run_mapcalc('mserial', 1)
+            self.run_mapcalc('mpar', 4)
+        finally:
+            self.runModule('r.mask', flags='r')
+        self.assert_same('mserial', 'mpar')
+
+    def test_rand(self):
+        """rand() with a seed gives the same map with several threads"""
+        self.assertModule('r.mapcalc', nprocs=1, seed=42,
+                          expression='rnd1 = rand(0, 1000) + row()')
+        self.assertModule('r.mapcalc', nprocs=4, seed=42,
+                          expression='rnd4 = rand(0, 1000) + row()')
+        self.to_remove.extend(['rnd1', 'rnd4'])
+        self.assertRastersNoDifference(actual='rnd4', reference='rnd1',
+                                       precision=0)
+
+
+if __name__ == '__main__':
+    test()
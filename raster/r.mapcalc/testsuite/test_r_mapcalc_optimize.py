@@ -0,0 +1,69 @@
+"""Test of the optimizations of r.mapcalc expressions
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+
+class TestOptimize(TestCase):
+    """Folded constants, shared subexpressions and tiles of wide rows"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        # wider than one tile of evaluation
+        cls.runModule('g.region', n=3, s=0, w=0, e=10000, res=1)
+        cls.runModule('r.mapcalc', expression='c = col()')
+        cls.to_remove.append('c')
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+
+    def assert_value(self, name, expression, value):
+        self.assertModule('r.mapcalc',
+                          expression='%s = %s' % (name, expression))
+        self.to_remove.append(name)
+        self.assertRasterMinMax(name, refmin=value, refmax=value)
+
+    def test_tiles(self):
+        """col(), x() and column offsets on all tiles of a row"""
+        self.assertRasterMinMax('c', refmin=1, refmax=10000)
+        self.assert_value('t_x', 'x() - (c - 0.5)', 0)
+        self.assert_value('t_shift', 'c[0,1] - c', 1)
+        self.assert_value('t_shift_back', 'c - c[0,-4099]', 4099)
+
+    def test_constant_folding(self):
+        """Functions of constants"""
+        self.assert_value('t_const', 'sqrt(16) * 2 + c - c', 8)
+        self.assert_value('t_const_map',
+                          'if(1, c, 0) - c + float(7) / 2', 3.5)
+
+    def test_common_subexpressions(self):
+        """Repeated map references and subterms"""
+        self.assert_value('t_cse', '(c + 1) * (c + 1) - c * c - 2 * c', 1)
+        self.assert_value('t_eval',
+                          'eval(a = c * 2, b = c * 2, a - b + c[0,1] - c[0,1])',
+                          0)
+
+    def test_rand(self):
+        """rand() calls are not shared"""
+        self.assertModule('r.mapcalc', seed=1,
+                          expression='t_rand = rand(0, 1000) == rand(0, 1000)')
+        self.to_remove.append('t_rand')
+        self.assertRasterFitsUnivar('t_rand', reference=dict(min=0))
+
+
+if __name__ == '__main__':
+    test()
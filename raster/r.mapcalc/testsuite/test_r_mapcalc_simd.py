@@ -0,0 +1,195 @@
+"""Test of the vectorized operators of r.mapcalc (GRASS_RASTER_SIMD)
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import os
+import struct
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+# an odd number of columns leaves a tail for the scalar code
+ROWS = 7
+COLS = 103
+
+INPUTS = """\
+ci = if(col() % 11 == 0, null(), (row() * 37 - col() * 13) % 9 - 4)
+cj = if(col() % 7 == 3, null(), (col() * 7 + row()) % 5 - 2)
+fi = float(ci) / 2
+fj = float(cj) / 3
+di = double(ci) / 2
+dj = double(cj) / 3
+"""
+
+
+def c_mod(a, b):
+    """% of C, the sign of the dividend"""
+    r = abs(a) % abs(b)
+    return r if a >= 0 else -r
+
+
+def ci(r, c):
+    return None if c % 11 == 0 else c_mod(r * 37 - c * 13, 9) - 4
+
+
+def cj(r, c):
+    return None if c % 7 == 3 else c_mod(c * 7 + r, 5) - 2
+
+
+def f32(value):
+    """Value rounded to a FCELL"""
+    return struct.unpack('f', struct.pack('f', value))[0]
+
+
+# values of the maps and rounding of the results of each type
+VALUES = {
+    'ci': (ci, int), 'cj': (cj, int),
+    'fi': (lambda r, c: None if ci(r, c) is None else f32(ci(r, c) / 2.0),
+           f32),
+    'fj': (lambda r, c: None if cj(r, c) is None else f32(cj(r, c) / 3.0),
+           f32),
+    'di': (lambda r, c: None if ci(r, c) is None else ci(r, c) / 2.0,
+           float),
+    'dj': (lambda r, c: None if cj(r, c) is None else cj(r, c) / 3.0,
+           float),
+}
+
+
+def binop(function):
+    """Null if an operand is null"""
+    return lambda a, b, rnd: (None if a is None or b is None
+                              else function(a, b, rnd))
+
+
+def divide(a, b, rnd):
+    if b == 0:
+        return None
+    if rnd is int:
+        # rounded towards zero
+        q = abs(a) // abs(b)
+        return q if (a < 0) == (b < 0) else -q
+    return rnd(a / b)
+
+
+def and2(a, b, rnd):
+    """0 if an operand is 0, otherwise null if one is null"""
+    if 0 in (a, b):
+        return 0
+    return None if None in (a, b) else 1
+
+
+def or2(a, b, rnd):
+    """1 if an operand is not 0, otherwise null if one is null"""
+    if any(v is not None and v != 0 for v in (a, b)):
+        return 1
+    return None if None in (a, b) else 0
+
+
+OPERATORS = [
+    ('{a} + {b}', binop(lambda a, b, rnd: rnd(a + b))),
+    ('{a} - {b}', binop(lambda a, b, rnd: rnd(a - b))),
+    ('{a} * {b}', binop(lambda a, b, rnd: rnd(a * b))),
+    ('{a} / {b}', binop(divide)),
+    ('min({a}, {b})', binop(lambda a, b, rnd: min(a, b))),
+    ('max({a}, {b})', binop(lambda a, b, rnd: max(a, b))),
+    ('{a} == {b}', binop(lambda a, b, rnd: int(a == b))),
+    ('{a} != {b}', binop(lambda a, b, rnd: int(a != b))),
+    ('{a} > {b}', binop(lambda a, b, rnd: int(a > b))),
+    ('{a} >= {b}', binop(lambda a, b, rnd: int(a >= b))),
+    ('{a} < {b}', binop(lambda a, b, rnd: int(a < b))),
+    ('{a} <= {b}', binop(lambda a, b, rnd: int(a <= b))),
+    ('isnull({a})', lambda a, b, rnd: int(a is None)),
+    ('if({a}, {b})',
+     lambda a, b, rnd: None if a is None else (b if a != 0 else 0)),
+    ('if({a}, {b}, {a})',
+     lambda a, b, rnd: None if a is None else (b if a != 0 else a)),
+]
+
+LOGICAL = [
+    ('{a} && {b}', binop(lambda a, b, rnd: int(a != 0 and b != 0))),
+    ('{a} || {b}', binop(lambda a, b, rnd: int(a != 0 or b != 0))),
+    ('{a} &&& {b}', and2),
+    ('{a} ||| {b}', or2),
+    ('if({a})', lambda a, b, rnd: None if a is None else int(a != 0)),
+]
+
+
+def expected_map(a, b, function):
+    """Map of the operator as ascii raster"""
+    value_a, rnd = VALUES[a]
+    value_b = VALUES[b][0]
+    lines = ['north: %d' % ROWS, 'south: 0', 'east: %d' % COLS, 'west: 0',
+             'rows: %d' % ROWS, 'cols: %d' % COLS]
+    for r in range(1, ROWS + 1):
+        cells = []
+        for c in range(1, COLS + 1):
+            result = function(value_a(r, c), value_b(r, c), rnd)
+            cells.append('*' if result is None else '%.17g' % result)
+        lines.append(' '.join(cells))
+    return '\n'.join(lines) + '\n'
+
+
+class TestSimdOperators(TestCase):
+    """Operators with and without SIMD against their values"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        cls.runModule('r.mapcalc', expression=INPUTS)
+        cls.to_remove.extend(VALUES)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+
+    def compare(self, a, b, operators):
+        exprs = ['{p}_%s%d = %s' % (a, i, op.format(a=a, b=b))
+                 for i, (op, function) in enumerate(operators)]
+        expression = '\n'.join(exprs)
+        os.environ['GRASS_RASTER_SIMD'] = 'none'
+        try:
+            self.assertModule('r.mapcalc', overwrite=True,
+                              expression=expression.format(p='none'))
+        finally:
+            del os.environ['GRASS_RASTER_SIMD']
+        self.assertModule('r.mapcalc', overwrite=True,
+                          expression=expression.format(p='simd'))
+        for i, (op, function) in enumerate(operators):
+            reference = 'ref_%s%d' % (a, i)
+            self.runModule('r.in.ascii', input='-', output=reference,
+                           type='DCELL', overwrite=True,
+                           stdin_=expected_map(a, b, function))
+            self.to_remove.append(reference)
+            for p in ['none', 'simd']:
+                actual = '%s_%s%d' % (p, a, i)
+                self.to_remove.append(actual)
+                self.assertRastersNoDifference(actual=actual,
+                                               reference=reference,
+                                               precision=0)
+
+    def test_cell(self):
+        """Operators on CELL maps"""
+        self.compare('ci', 'cj', OPERATORS + LOGICAL)
+
+    def test_fcell(self):
+        """Operators on FCELL maps"""
+        self.compare('fi', 'fj', OPERATORS)
+
+    def test_dcell(self):
+        """Operators on DCELL maps"""
+        self.compare('di', 'dj', OPERATORS)
+
+
+if __name__ == '__main__':
+    test()
@@ -1,3 +1,8 @@
+#include <grass/config.h>
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #include <grass/gis.h>
 #include <grass/raster.h>
@@ -9,12 +14,16 @@
 area() area of a cell in square meters
 **********************************************************************/
 
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t area_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static int initialized;
+
 int f_area(int argc, const int *argt, void **args)
 {
     DCELL *res = args[0];
+    DCELL cell_area;
     int i;
-    static int row = -1;
-    static double cell_area = 0;
 
     if (argc > 0)
 	return E_ARG_HI;
@@ -22,13 +31,18 @@ int f_area(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    if (row != current_row) {
-	if (row == -1)
-	    G_begin_cell_area_calculations();
-
-	row = current_row;
-	cell_area = G_area_of_cell_at_row(row);
+    /* the area calculations of the GIS library are not reentrant */
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&area_mutex);
+#endif
+    if (!initialized) {
+	G_begin_cell_area_calculations();
+	initialized = 1;
     }
+    cell_area = G_area_of_cell_at_row(current_row());
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&area_mutex);
+#endif
 
     for (i = 0; i < columns; i++)
 	res[i] = cell_area;
@@ -1,4 +1,11 @@
 
+#include <grass/config.h>
+
+#include <string.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 #include <grass/gis.h>
 #include <grass/raster.h>
 #include "globals.h"
@@ -12,24 +19,48 @@ y() northing at center of row
 z() height at center of depth
 **********************************************************************/
 
-int f_x(int argc, const int *argt, void **args)
+/* eastings of the whole row, summed from the west edge like a single
+ * call over the whole row would, the tiles of a row copy their part;
+ * the last tile may extend past the end of the row */
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t eastings_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static DCELL *eastings;
+
+static const DCELL *get_eastings(void)
 {
-    DCELL *res = args[0];
     DCELL x;
     int i;
 
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&eastings_mutex);
+#endif
+    if (!eastings) {
+	eastings = G_malloc((cols + columns) * sizeof(DCELL));
+	x = Rast_col_to_easting(0.5, &current_region2);
+	for (i = 0; i < cols + columns; i++) {
+	    eastings[i] = x;
+	    x += current_region2.ew_res;
+	}
+    }
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&eastings_mutex);
+#endif
+
+    return eastings;
+}
+
+int f_x(int argc, const int *argt, void **args)
+{
+    DCELL *res = args[0];
+
     if (argc > 0)
 	return E_ARG_HI;
 
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    x = Rast_col_to_easting(0.5, &current_region2);
-
-    for (i = 0; i < columns; i++) {
-	res[i] = x;
-	x += current_region2.ew_res;
-    }
+    memcpy(res, get_eastings() + current_col(), columns * sizeof(DCELL));
 
     return 0;
 }
@@ -46,7 +77,7 @@ int f_y(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    y = Rast_row_to_northing(current_row + 0.5, &current_region2);
+    y = Rast_row_to_northing(current_row() + 0.5, &current_region2);
 
     for (i = 0; i < columns; i++)
 	res[i] = y;
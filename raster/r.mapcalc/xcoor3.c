@@ -1,4 +1,11 @@
 
+#include <grass/config.h>
+
+#include <string.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 #include <grass/gis.h>
 #include <grass/raster3d.h>
 #include "globals.h"
@@ -12,25 +19,49 @@ y() northing at center of row
 z() height at center of depth
 **********************************************************************/
 
-int f_x(int argc, const int *argt, void **args)
+/* eastings of the whole row, summed from the west edge like a single
+ * call over the whole row would, the tiles of a row copy their part;
+ * the last tile may extend past the end of the row */
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t eastings_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static DCELL *eastings;
+
+static const DCELL *get_eastings(void)
 {
     RASTER3D_Region *window = &current_region3;
-    DCELL *res = args[0];
     DCELL x;
     int i;
 
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&eastings_mutex);
+#endif
+    if (!eastings) {
+	eastings = G_malloc((cols + columns) * sizeof(DCELL));
+	x = window->west + 0.5 * window->ew_res;
+	for (i = 0; i < cols + columns; i++) {
+	    eastings[i] = x;
+	    x += window->ew_res;
+	}
+    }
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&eastings_mutex);
+#endif
+
+    return eastings;
+}
+
+int f_x(int argc, const int *argt, void **args)
+{
+    DCELL *res = args[0];
+
     if (argc > 0)
 	return E_ARG_HI;
 
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    x = window->west + 0.5 * window->ew_res;
-
-    for (i = 0; i < columns; i++) {
-	res[i] = x;
-	x += window->ew_res;
-    }
+    memcpy(res, get_eastings() + current_col(), columns * sizeof(DCELL));
 
     return 0;
 }
@@ -48,7 +79,7 @@ int f_y(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    y = window->north - (current_row + 0.5) * window->ns_res;
+    y = window->north - (current_row() + 0.5) * window->ns_res;
 
     for (i = 0; i < columns; i++)
 	res[i] = y;
@@ -69,7 +100,7 @@ int f_z(int argc, const int *argt, void **args)
     if (argt[0] != DCELL_TYPE)
 	return E_RES_TYPE;
 
-    z = window->bottom + ((current_depth) + 0.5) * window->tb_res;
+    z = window->bottom + (current_depth() + 0.5) * window->tb_res;
 
     for (i = 0; i < columns; i++)
 	res[i] = z;
@@ -26,7 +26,7 @@ int f_col(int argc, const int *argt, void **args)
 	return E_RES_TYPE;
 
     for (i = 0; i < columns; i++)
-	res[i] = i + 1;
+	res[i] = current_col() + i + 1;
 
     return 0;
 }
@@ -34,7 +34,7 @@ int f_col(int argc, const int *argt, void **args)
 int f_row(int argc, const int *argt, void **args)
 {
     CELL *res = args[0];
-    int row = current_row + 1;
+    int row = current_row() + 1;
     int i;
 
     if (argc > 0)
@@ -52,7 +52,7 @@ int f_row(int argc, const int *argt, void **args)
 int f_depth(int argc, const int *argt, void **args)
 {
     CELL *res = args[0];
-    int depth = current_depth + 1;
+    int depth = current_depth() + 1;
     int i;
 
     if (argc > 0)
@@ -96,7 +96,7 @@ int f_ncols(int argc, const int *argt, void **args)
 	return E_RES_TYPE;
 
     for (i = 0; i < columns; i++)
-	res[i] = columns;
+	res[i] = cols;
 
     return 0;
 }
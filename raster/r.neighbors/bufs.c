@@ -10,33 +10,34 @@
 
  */
 
-int allocate_bufs(void)
+DCELL **allocate_bufs(void)
 {
+    DCELL **buf;
     int i;
     int bufsize;
 
     bufsize = (Rast_window_cols() + 2 * ncb.dist) * sizeof(DCELL);
 
-    ncb.buf = (DCELL **) G_malloc(ncb.nsize * sizeof(DCELL *));
+    buf = (DCELL **) G_malloc(ncb.nsize * sizeof(DCELL *));
     for (i = 0; i < ncb.nsize; i++) {
-	ncb.buf[i] = (DCELL *) G_malloc(bufsize);
-	Rast_set_d_null_value(ncb.buf[i], Rast_window_cols() + 2 * ncb.dist);
+	buf[i] = (DCELL *) G_malloc(bufsize);
+	Rast_set_d_null_value(buf[i], Rast_window_cols() + 2 * ncb.dist);
     }
 
-    return 0;
+    return buf;
 }
 
-int rotate_bufs(void)
+int rotate_bufs(DCELL **buf)
 {
     DCELL *temp;
     int i;
 
-    temp = ncb.buf[0];
+    temp = buf[0];
 
     for (i = 1; i < ncb.nsize; i++)
-	ncb.buf[i - 1] = ncb.buf[i];
+	buf[i - 1] = buf[i];
 
-    ncb.buf[ncb.nsize - 1] = temp;
+    buf[ncb.nsize - 1] = temp;
 
     return 0;
 }
@@ -1,15 +1,26 @@
+#include <grass/stats.h>
+
 /* bufs.c */
-extern int allocate_bufs(void);
-extern int rotate_bufs(void);
+extern DCELL **allocate_bufs(void);
+extern int rotate_bufs(DCELL **);
 
 /* gather */
 extern void circle_mask(void);
 extern void weights_mask(void);
-extern int gather(DCELL *, int);
-extern int gather_w(DCELL *, DCELL(*)[2], int);
+extern int gather(DCELL **, DCELL *, int);
+extern int gather_w(DCELL **, DCELL *, DCELL(*)[2], int);
+
+/* sliding.c */
+struct sliding;
+extern int sliding_add(int, stat_func *, const double *, RASTER_MAP_TYPE);
+extern struct sliding *sliding_create(void);
+extern void sliding_begin(struct sliding *, DCELL **);
+extern void sliding_remove_row(struct sliding *, DCELL **);
+extern void sliding_add_row(struct sliding *, DCELL **);
+extern void sliding_row(struct sliding *, DCELL **, DCELL **);
 
 /* readcell.c */
-extern int readcell(int, int, int, int);
+extern int readcell(DCELL **, int, struct R_read_ctx *, int, int, int);
 
 /* divr_cats.c */
 extern int divr_cats(void);
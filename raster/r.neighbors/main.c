@@ -82,15 +82,54 @@ struct output
     const char *name;
     char title[1024];
     int fd;
-    DCELL *buf;
     stat_func *method_fn;
     stat_func_w *method_fn_w;
     int copycolr;
     ifunc cat_names;
     int map_type;
     double quantile;
+    int sliding;		/* computed by sliding.c */
 };
 
+/* The rows are computed in bands of consecutive rows. Each band has
+   its own i/o bufs, readers and state of the incremental methods, and
+   reads the rows of the neighborhoods around its rows, so that the
+   bands of a pass can be computed concurrently: the nsize - 1 input
+   rows above a band are read and added to its state once more, which
+   is the cost of splitting. The main thread then writes the rows of
+   the bands in order.
+ */
+#define BAND_CELLS (1 << 21)	/* output cells of all outputs per band */
+
+struct band
+{
+    DCELL **buf;		/* i/o bufs */
+    struct R_read_ctx *in_ctx;	/* NULL: read through the descriptors */
+    struct R_read_ctx *sel_ctx;
+    char *selection;
+    struct sliding *sliding;
+    DCELL *values;		/* list of neighborhood values */
+    DCELL *values_tmp;		/* list of neighborhood values */
+    DCELL(*values_w)[2];	/* list of neighborhood values and weights */
+    DCELL(*values_w_tmp)[2];	/* list of neighborhood values and weights */
+    int nrows;			/* rows of the outputs kept by the band */
+    DCELL **out;		/* rows of each output */
+    DCELL **row;		/* current row of each output */
+};
+
+struct pass
+{
+    struct band *bands;
+    int first;			/* first row of the pass */
+    int rows;			/* rows per band */
+};
+
+static struct output *outputs;
+static int num_outputs, num_gather;
+static int in_fd, selection_fd;
+static int weights;
+static int nrows, ncols;
+
 static int find_method(const char *method_name)
 {
     int i;
@@ -123,19 +162,139 @@ static RASTER_MAP_TYPE output_type(RASTER_MAP_TYPE input_type, int weighted, int
     }
 }
 
+static void init_band(struct band *b, int rows, int use_ctx)
+{
+    int i;
+
+    b->buf = allocate_bufs();
+    b->in_ctx = use_ctx ? Rast_create_read_ctx(in_fd) : NULL;
+    b->sel_ctx = NULL;
+    b->selection = NULL;
+    if (selection_fd >= 0) {
+	if (use_ctx)
+	    b->sel_ctx = Rast_create_read_ctx(selection_fd);
+	b->selection = Rast_allocate_null_buf();
+    }
+
+    b->sliding = sliding_create();
+
+    b->values_w = NULL;
+    b->values_w_tmp = NULL;
+    if (weights) {
+	b->values_w =
+	    (DCELL(*)[2]) G_malloc(ncb.nsize * ncb.nsize * 2 * sizeof(DCELL));
+	b->values_w_tmp =
+	    (DCELL(*)[2]) G_malloc(ncb.nsize * ncb.nsize * 2 * sizeof(DCELL));
+    }
+    b->values = (DCELL *) G_malloc(ncb.nsize * ncb.nsize * sizeof(DCELL));
+    b->values_tmp = (DCELL *) G_malloc(ncb.nsize * ncb.nsize * sizeof(DCELL));
+
+    b->nrows = rows;
+    b->out = G_malloc(num_outputs * sizeof(DCELL *));
+    b->row = G_malloc(num_outputs * sizeof(DCELL *));
+    for (i = 0; i < num_outputs; i++)
+	b->out[i] = G_malloc((size_t) rows * ncols * sizeof(DCELL));
+}
+
+/* compute the rows first .. last - 1, writing them if write is set */
+static void compute_rows(struct band *b, int first, int last, int write)
+{
+    int readrow, row, col;
+    int i, n;
+
+    /* fill the i/o bufs with the rows above the first row */
+    for (readrow = first - ncb.dist - 1; readrow < first + ncb.dist; readrow++)
+	readcell(b->buf, in_fd, b->in_ctx, readrow, nrows, ncols);
+
+    sliding_begin(b->sliding, b->buf);
+
+    for (row = first; row < last; row++) {
+	DCELL **buf = b->buf;
+
+	if (write)
+	    G_percent(row, nrows, 2);
+
+	for (i = 0; i < num_outputs; i++)
+	    b->row[i] = b->out[i] + (size_t) ((row - first) % b->nrows) * ncols;
+
+	sliding_remove_row(b->sliding, buf);
+	readcell(buf, in_fd, b->in_ctx, readrow++, nrows, ncols);
+	sliding_add_row(b->sliding, buf);
+
+	if (b->sel_ctx)
+	    Rast_get_null_value_row_ctx(b->sel_ctx, b->selection, row);
+	else if (b->selection)
+            Rast_get_null_value_row(selection_fd, b->selection, row);
+
+	sliding_row(b->sliding, buf, b->row);
+
+	for (col = 0; col < ncols; col++) {
+
+            if (b->selection && b->selection[col]) {
+                /* the bufs length is region row length + 2 * ncb.dist (eq. floor(neighborhood/2))
+                 * Thus original data start is shifted by ncb.dist! */
+		for (i = 0; i < num_outputs; i++)
+		    b->row[i][col] = buf[ncb.dist][col + ncb.dist];
+		continue;
+	    }
+
+	    if (!num_gather)
+		continue;
+
+	    if (weights)
+		n = gather_w(buf, b->values, b->values_w, col);
+	    else
+		n = gather(buf, b->values, col);
+
+	    for (i = 0; i < num_outputs; i++) {
+		struct output *out = &outputs[i];
+		DCELL *rp = &b->row[i][col];
+
+		if (out->sliding)
+		    continue;
+
+		if (n == 0) {
+		    Rast_set_d_null_value(rp, 1);
+		}
+		else {
+		    if (out->method_fn_w) {
+			memcpy(b->values_w_tmp, b->values_w, n * 2 * sizeof(DCELL));
+			(*out->method_fn_w)(rp, b->values_w_tmp, n, &out->quantile);
+		    }
+		    else {
+			memcpy(b->values_tmp, b->values, n * sizeof(DCELL));
+			(*out->method_fn)(rp, b->values_tmp, n, &out->quantile);
+		    }
+		}
+	    }
+	}
+
+	if (write)
+	    for (i = 0; i < num_outputs; i++)
+		Rast_put_d_row(outputs[i].fd, b->row[i]);
+    }
+}
+
+static void compute_bands(int first, int last, void *closure)
+{
+    const struct pass *p = closure;
+    int k;
+
+    for (k = first; k < last; k++) {
+	int row = p->first + k * p->rows;
+	int end = row + p->rows < nrows ? row + p->rows : nrows;
+
+	compute_rows(&p->bands[k], row, end, 0);
+    }
+}
+
 int main(int argc, char *argv[])
 {
     char *p;
-    int in_fd;
-    int selection_fd;
-    int num_outputs;
-    struct output *outputs = NULL;
-    int copycolr, weights, have_weights_mask;
-    char *selection;
+    int copycolr, have_weights_mask;
     RASTER_MAP_TYPE map_type;
-    int row, col;
-    int readrow;
-    int nrows, ncols;
+    struct band *bands;
+    int threads, nbands, band_rows;
     int i, n;
     struct Colors colr;
     struct Cell_head cellhd;
@@ -150,17 +309,13 @@ int main(int argc, char *argv[])
 	struct Option *weight;
 	struct Option *gauss;
 	struct Option *quantile;
+	struct Option *nprocs;
     } parm;
     struct
     {
 	struct Flag *align, *circle;
     } flag;
 
-    DCELL *values;		/* list of neighborhood values */
-    DCELL *values_tmp;		/* list of neighborhood values */
-    DCELL(*values_w)[2];	/* list of neighborhood values and weights */
-    DCELL(*values_w_tmp)[2];	/* list of neighborhood values and weights */
-
     G_gisinit(argv[0]);
 
     module = G_define_module();
@@ -239,6 +394,8 @@ int main(int argc, char *argv[])
     parm.quantile->description = _("Quantile to calculate for method=quantile");
     parm.quantile->options = "0.0-1.0";
 
+    parm.nprocs = G_define_standard_option(G_OPT_M_NPROCS);
+
     flag.align = G_define_flag();
     flag.align->key = 'a';
     flag.align->description = _("Do not align output with the input");
@@ -258,6 +415,8 @@ int main(int argc, char *argv[])
 	G_fatal_error(_("Neighborhood size must be odd"));
     ncb.dist = ncb.nsize / 2;
 
+    threads = G_set_num_threads(atoi(parm.nprocs->answer));
+
     if (parm.weight->answer && flag.circle->answer)
 	G_fatal_error(_("-%c and %s= are mutually exclusive"),
 			flag.circle->key, parm.weight->key);
@@ -353,7 +512,6 @@ int main(int argc, char *argv[])
 	out->quantile = (parm.quantile->answer && parm.quantile->answers[i])
 	    ? atof(parm.quantile->answers[i])
 	    : 0;
-	out->buf = Rast_allocate_d_buf();
 	out->fd = Rast_open_new(output_name, otype);
 	/* TODO: method=mode should propagate its type */
 
@@ -373,91 +531,103 @@ int main(int argc, char *argv[])
 	G_suppress_warnings(0);
     }
 
-    /* allocate the cell buffers */
-    allocate_bufs();
-
-    /* initialize the cell bufs with 'dist' rows of the old cellfile */
-    readrow = 0;
-    for (row = 0; row < ncb.dist; row++)
-	readcell(in_fd, readrow++, nrows, ncols);
-
     /* open the selection raster map */
     if (parm.selection->answer) {
 	G_message(_("Opening selection map <%s>"), parm.selection->answer);
 	selection_fd = Rast_open_old(parm.selection->answer, "");
-        selection = Rast_allocate_null_buf();
     } else {
         selection_fd = -1;
-        selection = NULL;
     }
 
     if (flag.circle->answer)
 	circle_mask();
 
-    values_w = NULL;
-    values_w_tmp = NULL;
-    if (weights) {
-	values_w =
-	    (DCELL(*)[2]) G_malloc(ncb.nsize * ncb.nsize * 2 * sizeof(DCELL));
-	values_w_tmp =
-	    (DCELL(*)[2]) G_malloc(ncb.nsize * ncb.nsize * 2 * sizeof(DCELL));
+    /* the statistics of whole square neighborhoods are updated
+       incrementally, the others are computed from the gathered values */
+    num_gather = 0;
+    for (i = 0; i < num_outputs; i++) {
+	struct output *out = &outputs[i];
+
+	out->sliding = !out->method_fn_w && !ncb.mask &&
+	    sliding_add(i, out->method_fn, &out->quantile, map_type);
+	if (!out->sliding)
+	    num_gather++;
     }
-    values = (DCELL *) G_malloc(ncb.nsize * ncb.nsize * sizeof(DCELL));
-    values_tmp = (DCELL *) G_malloc(ncb.nsize * ncb.nsize * sizeof(DCELL));
 
-    for (row = 0; row < nrows; row++) {
-	G_percent(row, nrows, 2);
-	readcell(in_fd, readrow++, nrows, ncols);
+    /* bands of multiples of nsize rows give the same results as a
+       single band, see sliding.c: bands of nsize rows which exceed
+       BAND_CELLS are computed by fewer threads, so that all bands
+       together stay within the memory of threads bands of BAND_CELLS */
+    nbands = 1;
+    band_rows = 0;
+    if (threads > 1 && nrows > ncb.nsize) {
+	size_t row_cells = (size_t) ncols * num_outputs;
+	int max = (nrows + threads - 1) / threads;
+
+	max = (max + ncb.nsize - 1) / ncb.nsize * ncb.nsize;
+	band_rows = BAND_CELLS / row_cells / ncb.nsize * ncb.nsize;
+	if (band_rows > max)
+	    band_rows = max;
+	if (band_rows < ncb.nsize)
+	    band_rows = ncb.nsize;
+
+	nbands = (nrows + band_rows - 1) / band_rows;
+	if (nbands > threads)
+	    nbands = threads;
+	if ((size_t) nbands * band_rows * row_cells >
+	    (size_t) threads * BAND_CELLS)
+	    nbands = (size_t) threads * BAND_CELLS / (band_rows * row_cells);
+    }
 
-	if (selection)
-            Rast_get_null_value_row(selection_fd, selection, row);
+    if (nbands > 1) {
+	struct pass p;
+	int row;
 
-	for (col = 0; col < ncols; col++) {
+	p.rows = band_rows;
 
-            if (selection && selection[col]) {
-                /* ncb.buf length is region row length + 2 * ncb.dist (eq. floor(neighborhood/2))
-                 * Thus original data start is shifted by ncb.dist! */
-		for (i = 0; i < num_outputs; i++)
-		    outputs[i].buf[col] = ncb.buf[ncb.dist][col + ncb.dist];
-		continue;
-	    }
+	G_debug(1, "%d bands of %d rows", nbands, p.rows);
 
-	    if (weights)
-		n = gather_w(values, values_w, col);
-	    else
-		n = gather(values, col);
+	bands = G_malloc(nbands * sizeof(struct band));
+	for (i = 0; i < nbands; i++)
+	    init_band(&bands[i], p.rows, 1);
+	p.bands = bands;
 
-	    for (i = 0; i < num_outputs; i++) {
-		struct output *out = &outputs[i];
-		DCELL *rp = &out->buf[col];
+	for (p.first = 0; p.first < nrows; p.first += nbands * p.rows) {
+	    int last = p.first + nbands * p.rows;
 
-		if (n == 0) {
-		    Rast_set_d_null_value(rp, 1);
-		}
-		else {
-		    if (out->method_fn_w) {
-			memcpy(values_w_tmp, values_w, n * 2 * sizeof(DCELL));
-			(*out->method_fn_w)(rp, values_w_tmp, n, &out->quantile);
-		    }
-		    else {
-			memcpy(values_tmp, values, n * sizeof(DCELL));
-			(*out->method_fn)(rp, values_tmp, n, &out->quantile);
-		    }
-		}
+	    if (last > nrows)
+		last = nrows;
+
+	    G_percent(p.first, nrows, 2);
+
+	    G_parallel_for(0, (last - p.first + p.rows - 1) / p.rows, 1,
+			   compute_bands, &p);
+
+	    for (row = p.first; row < last; row++) {
+		struct band *b = &bands[(row - p.first) / p.rows];
+		size_t offset = (size_t) ((row - p.first) % p.rows) * ncols;
+
+		for (i = 0; i < num_outputs; i++)
+		    Rast_put_d_row(outputs[i].fd, b->out[i] + offset);
 	    }
 	}
 
-	for (i = 0; i < num_outputs; i++) {
-	    struct output *out = &outputs[i];
-
-	    Rast_put_d_row(out->fd, out->buf);
+	for (i = 0; i < nbands; i++) {
+	    Rast_free_read_ctx(bands[i].in_ctx);
+	    if (bands[i].sel_ctx)
+		Rast_free_read_ctx(bands[i].sel_ctx);
 	}
     }
-    G_percent(row, nrows, 2);
+    else {
+	bands = G_malloc(sizeof(struct band));
+	init_band(bands, 1, 0);
+	compute_rows(bands, 0, nrows, 1);
+    }
+    G_percent(nrows, nrows, 2);
 
     Rast_close(in_fd);
 
-    if (selection)
+    if (selection_fd >= 0)
         Rast_close(selection_fd);
 
     for (i = 0; i < num_outputs; i++) {
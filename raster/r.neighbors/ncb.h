@@ -2,7 +2,6 @@
 
 struct ncb			/* neighborhood control block */
 {
-    DCELL **buf;		/* for reading raster map */
     int *value;			/* neighborhood values */
     int nsize;			/* size of the neighborhood */
     int dist;			/* nsize/2 */
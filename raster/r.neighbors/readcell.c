@@ -4,14 +4,17 @@
 #include "ncb.h"
 #include "local_proto.h"
 
-int readcell(int fd, int row, int nrows, int ncols)
+int readcell(DCELL **buf, int fd, struct R_read_ctx *ctx,
+	     int row, int nrows, int ncols)
 {
-    rotate_bufs();
+    rotate_bufs(buf);
 
-    if (row < nrows)
-	Rast_get_d_row(fd, ncb.buf[ncb.nsize - 1] + ncb.dist, row);
+    if (row < 0 || row >= nrows)
+	Rast_set_d_null_value(buf[ncb.nsize - 1] + ncb.dist, ncols);
+    else if (ctx)
+	Rast_get_row_ctx(ctx, buf[ncb.nsize - 1] + ncb.dist, row, DCELL_TYPE);
     else
-	Rast_set_d_null_value(ncb.buf[ncb.nsize - 1] + ncb.dist, ncols);
+	Rast_get_d_row(fd, buf[ncb.nsize - 1] + ncb.dist, row);
 
     return 0;
 }
@@ -0,0 +1,743 @@
+#include <math.h>
+#include <grass/gis.h>
+#include <grass/raster.h>
+#include <grass/glocale.h>
+#include <grass/stats.h>
+#include "ncb.h"
+#include "local_proto.h"
+
+/*
+   incremental computation of the statistics of the whole square
+   neighborhood, instead of gathering its nsize*nsize values for
+   every cell
+
+   average, sum, count, variance, stddev:
+   sums down each column of the neighborhood, updated as rows enter
+   and leave it, and running sums of these along the row; both are
+   recomputed every nsize steps to bound the rounding errors
+
+   minimum, maximum, range:
+   monotonic queues of the values down each column, and of the
+   column minima/maxima along the row
+
+   median, quantiles, mode, diversity, interspersion of CELL maps:
+   histogram of the neighborhood, updated by one column of values
+   per cell (Huang's algorithm)
+
+   the methods are registered once, each band of rows (see main.c)
+   has its own state; the sums are recomputed from scratch at the rows
+   which are multiples of nsize, so the results do not depend on the
+   bands as long as these start at such rows
+ */
+
+enum kind
+{
+    K_SUM,
+    K_MIN,
+    K_MAX,
+    K_RANGE,
+    K_HIST
+};
+
+struct method
+{
+    stat_func *fn;
+    int kind;
+    const double *quantile;
+    int index;			/* output row passed to sliding_row() */
+};
+
+static struct method *methods;
+static int num_methods;
+
+static int width;		/* columns of the i/o bufs */
+static int ncols;
+
+static int use_sums, use_squares;
+static DCELL shift;		/* subtracted from the values for the squares */
+static int use_min, use_max;
+
+/* histogram of a CELL map */
+#define SHIFT 6
+#define MAX_BINS (1 << 16)
+
+static int use_hist, use_mode;
+static int have_range = -1;
+static CELL hist_min;
+static int nbins;
+
+/* monotonic queues, the maxima are kept as negated minima */
+struct queue
+{
+    int *pos;			/* ring buffer of nsize rows per column */
+    DCELL *val;
+    int *head, *len;
+    DCELL *col;			/* minimum of each column */
+    DCELL *win;			/* minimum of each neighborhood */
+};
+
+/* state of the methods for a band of rows */
+struct sliding
+{
+    int nrows;			/* rows added since sliding_begin() */
+
+    /* column and neighborhood sums */
+    DCELL *col_cnt, *col_sum, *col_ssum, *col_ssq;
+    DCELL *win_cnt, *win_sum, *win_ssum, *win_ssq;
+
+    struct queue qmin, qmax;
+    int *deque;
+
+    int *hist, *coarse;
+    int hist_n, distinct;
+    int *freq, max_count;	/* number of bins with each count */
+    int *block_max;
+    char *block_dirty;
+};
+
+/****************************************************************************/
+
+static int method_kind(stat_func * fn, RASTER_MAP_TYPE map_type)
+{
+    if (fn == c_ave || fn == c_sum || fn == c_count ||
+	fn == c_var || fn == c_stddev)
+	return K_SUM;
+    if (fn == c_min)
+	return K_MIN;
+    if (fn == c_max)
+	return K_MAX;
+    if (fn == c_range)
+	return K_RANGE;
+    if (map_type == CELL_TYPE &&
+	(fn == c_median || fn == c_mode || fn == c_divr || fn == c_intr ||
+	 fn == c_quart1 || fn == c_quart3 || fn == c_perc90 ||
+	 fn == c_quant))
+	return K_HIST;
+
+    return -1;
+}
+
+/* whether the histogram is cheaper than gathering the values */
+static int setup_range(void)
+{
+    struct Range range;
+    CELL min, max;
+
+    if (have_range >= 0)
+	return have_range;
+
+    have_range = 0;
+
+    if (Rast_read_range(ncb.oldcell, "", &range) != 1)
+	return 0;
+
+    Rast_get_range_min_max(&range, &min, &max);
+    if (Rast_is_c_null_value(&min) || Rast_is_c_null_value(&max))
+	return 0;
+
+    if ((double)max - min + 1 > MAX_BINS)
+	return 0;
+
+    hist_min = min;
+    nbins = max - min + 1;
+
+    have_range = (nbins >> SHIFT) + (1 << SHIFT) < ncb.nsize * ncb.nsize;
+
+    return have_range;
+}
+
+/* center the values to limit the loss of precision of the squares */
+static void setup_shift(void)
+{
+    struct FPRange range;
+    DCELL min, max;
+
+    shift = 0;
+    if (Rast_read_fp_range(ncb.oldcell, "", &range) == 1) {
+	Rast_get_fp_range_min_max(&range, &min, &max);
+	if (!Rast_is_d_null_value(&min) && !Rast_is_d_null_value(&max))
+	    shift = floor((min + max) / 2);
+    }
+}
+
+/*
+   register the output with the given index for which the method is
+   computed incrementally; returns 0 if the method has to be computed
+   from the gathered values
+ */
+int sliding_add(int index, stat_func * fn, const double *quantile,
+		RASTER_MAP_TYPE map_type)
+{
+    struct method *m;
+    int kind = method_kind(fn, map_type);
+
+    if (kind < 0)
+	return 0;
+
+    if (kind == K_HIST && !setup_range())
+	return 0;
+
+    methods = G_realloc(methods, (num_methods + 1) * sizeof(struct method));
+    m = &methods[num_methods++];
+
+    m->fn = fn;
+    m->kind = kind;
+    m->quantile = quantile;
+    m->index = index;
+
+    switch (kind) {
+    case K_SUM:
+	use_sums = 1;
+	if ((fn == c_var || fn == c_stddev) && !use_squares) {
+	    setup_shift();
+	    use_squares = 1;
+	}
+	break;
+    case K_MIN:
+	use_min = 1;
+	break;
+    case K_MAX:
+	use_max = 1;
+	break;
+    case K_RANGE:
+	use_min = use_max = 1;
+	break;
+    case K_HIST:
+	use_hist = 1;
+	if (fn == c_mode)
+	    use_mode = 1;
+	break;
+    }
+
+    return 1;
+}
+
+/****************************************************************************/
+
+static void add_sums(struct sliding *s, const DCELL * row, double sign)
+{
+    int c;
+
+    for (c = 0; c < width; c++) {
+	DCELL v = row[c];
+
+	if (Rast_is_d_null_value(&v))
+	    continue;
+
+	s->col_cnt[c] += sign;
+	s->col_sum[c] += sign * v;
+	if (use_squares) {
+	    v -= shift;
+	    s->col_ssum[c] += sign * v;
+	    s->col_ssq[c] += sign * v * v;
+	}
+    }
+}
+
+static void clear_sums(struct sliding *s)
+{
+    int c;
+
+    for (c = 0; c < width; c++) {
+	s->col_cnt[c] = s->col_sum[c] = 0;
+	if (use_squares)
+	    s->col_ssum[c] = s->col_ssq[c] = 0;
+    }
+}
+
+/* sums of the neighborhoods of a row from the column sums */
+static void window_sums(const DCELL * col, DCELL * win)
+{
+    DCELL s = 0;
+    int i, c;
+
+    for (c = 0; c < ncols; c++) {
+	if (c % ncb.nsize == 0)
+	    for (s = 0, i = c; i < c + ncb.nsize; i++)
+		s += col[i];
+	else
+	    s += col[c + ncb.nsize - 1] - col[c - 1];
+	win[c] = s;
+    }
+}
+
+/****************************************************************************/
+
+static void alloc_queue(struct queue *q)
+{
+    q->pos = G_malloc((size_t) width * ncb.nsize * sizeof(int));
+    q->val = G_malloc((size_t) width * ncb.nsize * sizeof(DCELL));
+    q->head = G_calloc(width, sizeof(int));
+    q->len = G_calloc(width, sizeof(int));
+    q->col = G_malloc(width * sizeof(DCELL));
+    q->win = G_malloc(ncols * sizeof(DCELL));
+}
+
+static void clear_queue(struct queue *q)
+{
+    int c;
+
+    for (c = 0; c < width; c++)
+	q->head[c] = q->len[c] = 0;
+}
+
+static void push_queue(struct queue *q, const DCELL * row, double sign,
+		       int nrows)
+{
+    int c;
+
+    for (c = 0; c < width; c++) {
+	int *pos = &q->pos[(size_t) c * ncb.nsize];
+	DCELL *val = &q->val[(size_t) c * ncb.nsize];
+	int h = q->head[c];
+	int n = q->len[c];
+
+	/* drop the row which left the neighborhood */
+	if (n > 0 && pos[h] <= nrows - ncb.nsize) {
+	    h = (h + 1) % ncb.nsize;
+	    n--;
+	}
+
+	if (!Rast_is_d_null_value(&row[c])) {
+	    DCELL v = sign * row[c];
+
+	    while (n > 0 && val[(h + n - 1) % ncb.nsize] >= v)
+		n--;
+	    pos[(h + n) % ncb.nsize] = nrows;
+	    val[(h + n) % ncb.nsize] = v;
+	    n++;
+	}
+
+	q->head[c] = h;
+	q->len[c] = n;
+
+	if (n > 0)
+	    q->col[c] = val[h];
+	else
+	    Rast_set_d_null_value(&q->col[c], 1);
+    }
+}
+
+/* minima of the neighborhoods of a row from the column minima */
+static void window_min(struct queue *q, int *deque)
+{
+    int h = 0, n = 0;
+    int c;
+
+    for (c = 0; c < width; c++) {
+	int o = c - ncb.nsize + 1;
+
+	if (!Rast_is_d_null_value(&q->col[c])) {
+	    while (n > 0 && q->col[deque[h + n - 1]] >= q->col[c])
+		n--;
+	    deque[h + n++] = c;
+	}
+
+	if (o < 0)
+	    continue;
+
+	if (n > 0 && deque[h] < o) {
+	    h++;
+	    n--;
+	}
+
+	if (n > 0)
+	    q->win[o] = q->col[deque[h]];
+	else
+	    Rast_set_d_null_value(&q->win[o], 1);
+    }
+}
+
+/****************************************************************************/
+
+static int bin(DCELL v)
+{
+    int b = (int)v - hist_min;
+
+    if (b < 0 || b >= nbins)
+	G_fatal_error(_("Value %g outside of the range of raster map <%s>"),
+		      v, ncb.oldcell);
+
+    return b;
+}
+
+static void add_value(struct sliding *s, DCELL v)
+{
+    int b = bin(v);
+    int k = ++s->hist[b];
+
+    if (k == 1)
+	s->distinct++;
+    s->coarse[b >> SHIFT]++;
+    s->hist_n++;
+
+    if (use_mode) {
+	s->freq[k - 1]--;
+	s->freq[k]++;
+	if (k > s->max_count)
+	    s->max_count = k;
+	if (k > s->block_max[b >> SHIFT])
+	    s->block_max[b >> SHIFT] = k;
+    }
+}
+
+static void remove_value(struct sliding *s, DCELL v)
+{
+    int b = bin(v);
+    int k = s->hist[b]--;
+
+    if (k == 1)
+	s->distinct--;
+    s->coarse[b >> SHIFT]--;
+    s->hist_n--;
+
+    if (use_mode) {
+	s->freq[k]--;
+	s->freq[k - 1]++;
+	if (k == s->max_count && s->freq[k] == 0)
+	    s->max_count--;
+	if (k == s->block_max[b >> SHIFT])
+	    s->block_dirty[b >> SHIFT] = 1;
+    }
+}
+
+static void add_column(struct sliding *s, DCELL ** buf, int c, int sign)
+{
+    int r;
+
+    for (r = 0; r < ncb.nsize; r++) {
+	DCELL v = buf[r][c];
+
+	if (Rast_is_d_null_value(&v))
+	    continue;
+
+	if (sign > 0)
+	    add_value(s, v);
+	else
+	    remove_value(s, v);
+    }
+}
+
+/* value of the given rank in the neighborhood */
+static DCELL rank_value(const struct sliding *s, int rank)
+{
+    int acc = 0;
+    int i, b;
+
+    for (i = 0; acc + s->coarse[i] <= rank; i++)
+	acc += s->coarse[i];
+
+    for (b = i << SHIFT; acc + s->hist[b] <= rank; b++)
+	acc += s->hist[b];
+
+    return (DCELL) hist_min + b;
+}
+
+/* smallest of the most frequent values */
+static DCELL mode_value(struct sliding *s)
+{
+    int i, b;
+
+    for (i = 0;; i++) {
+	if (s->block_dirty[i]) {
+	    int end = (i + 1) << SHIFT;
+
+	    if (end > nbins)
+		end = nbins;
+	    s->block_max[i] = 0;
+	    for (b = i << SHIFT; b < end; b++)
+		if (s->hist[b] > s->block_max[i])
+		    s->block_max[i] = s->hist[b];
+	    s->block_dirty[i] = 0;
+	}
+	if (s->block_max[i] == s->max_count)
+	    break;
+    }
+
+    for (b = i << SHIFT; s->hist[b] != s->max_count; b++) ;
+
+    return (DCELL) hist_min + b;
+}
+
+static void quantile_value(const struct sliding *s, DCELL * result,
+			   double quant)
+{
+    double k;
+    int i0, i1;
+
+    k = s->hist_n * quant;
+    i0 = (int)floor(k);
+    i1 = (int)ceil(k);
+    if (i1 > s->hist_n - 1)
+	i1 = s->hist_n - 1;
+    if (i0 > i1)
+	i0 = i1;
+
+    *result = (i0 == i1)
+	? rank_value(s, i0)
+	: rank_value(s, i0) * (i1 - k) + rank_value(s, i1) * (k - i0);
+}
+
+static void hist_result(struct sliding *s, const struct method *m,
+			DCELL ** buf, DCELL * rp, int col)
+{
+    stat_func *fn = m->fn;
+
+    if (fn == c_divr) {
+	*rp = s->distinct;
+	return;
+    }
+
+    if (fn == c_intr) {
+	DCELL center = buf[ncb.dist][col + ncb.dist];
+	int count, diff;
+
+	if (Rast_is_d_null_value(&center)) {
+	    Rast_set_d_null_value(rp, 1);
+	    return;
+	}
+
+	count = s->hist_n - 1;
+	diff = s->hist_n - s->hist[bin(center)];
+	if (count <= 0)
+	    *rp = 0;
+	else
+	    *rp = (diff * 100.0 + (count / 2)) / count + 1;
+	return;
+    }
+
+    if (s->hist_n < 1) {
+	Rast_set_d_null_value(rp, 1);
+	return;
+    }
+
+    if (fn == c_median)
+	*rp = (rank_value(s, (s->hist_n - 1) / 2) +
+	       rank_value(s, s->hist_n / 2)) / 2;
+    else if (fn == c_mode)
+	*rp = mode_value(s);
+    else if (fn == c_quart1)
+	quantile_value(s, rp, 0.25);
+    else if (fn == c_quart3)
+	quantile_value(s, rp, 0.75);
+    else if (fn == c_perc90)
+	quantile_value(s, rp, 0.90);
+    else
+	quantile_value(s, rp, *m->quantile);
+}
+
+static void hist_row(struct sliding *s, DCELL ** buf, DCELL ** out)
+{
+    int c, i;
+
+    for (c = 0; c < ncb.nsize - 1; c++)
+	add_column(s, buf, c, 1);
+
+    for (c = 0; c < ncols; c++) {
+	add_column(s, buf, c + ncb.nsize - 1, 1);
+
+	for (i = 0; i < num_methods; i++)
+	    if (methods[i].kind == K_HIST)
+		hist_result(s, &methods[i], buf, &out[methods[i].index][c], c);
+
+	add_column(s, buf, c, -1);
+    }
+
+    for (c = ncols; c < width; c++)
+	add_column(s, buf, c, -1);
+}
+
+/****************************************************************************/
+
+/* allocate the state of the registered methods for a band of rows */
+struct sliding *sliding_create(void)
+{
+    struct sliding *s = G_calloc(1, sizeof(struct sliding));
+
+    if (!num_methods)
+	return s;
+
+    ncols = Rast_window_cols();
+    width = ncols + 2 * ncb.dist;
+
+    if (use_sums) {
+	s->col_cnt = G_calloc(width, sizeof(DCELL));
+	s->col_sum = G_calloc(width, sizeof(DCELL));
+	s->win_cnt = G_malloc(ncols * sizeof(DCELL));
+	s->win_sum = G_malloc(ncols * sizeof(DCELL));
+    }
+
+    if (use_squares) {
+	s->col_ssum = G_calloc(width, sizeof(DCELL));
+	s->col_ssq = G_calloc(width, sizeof(DCELL));
+	s->win_ssum = G_malloc(ncols * sizeof(DCELL));
+	s->win_ssq = G_malloc(ncols * sizeof(DCELL));
+    }
+
+    if (use_min)
+	alloc_queue(&s->qmin);
+    if (use_max)
+	alloc_queue(&s->qmax);
+    if (use_min || use_max)
+	s->deque = G_malloc(width * sizeof(int));
+
+    /* the histogram is empty again after each row */
+    if (use_hist) {
+	int nblocks = (nbins >> SHIFT) + 1;
+
+	s->hist = G_calloc(nbins, sizeof(int));
+	s->coarse = G_calloc(nblocks, sizeof(int));
+	if (use_mode) {
+	    s->freq = G_calloc(ncb.nsize * ncb.nsize + 1, sizeof(int));
+	    s->freq[0] = nbins;
+	    s->block_max = G_calloc(nblocks, sizeof(int));
+	    s->block_dirty = G_calloc(nblocks, 1);
+	}
+    }
+
+    return s;
+}
+
+/* start a band with the rows which are in the i/o bufs */
+void sliding_begin(struct sliding *s, DCELL ** buf)
+{
+    int r;
+
+    if (!num_methods)
+	return;
+
+    s->nrows = 0;
+
+    if (use_sums)
+	clear_sums(s);
+    if (use_min)
+	clear_queue(&s->qmin);
+    if (use_max)
+	clear_queue(&s->qmax);
+
+    for (r = 0; r < ncb.nsize; r++) {
+	if (use_sums)
+	    add_sums(s, buf[r], 1);
+	if (use_min)
+	    push_queue(&s->qmin, buf[r], 1, s->nrows);
+	if (use_max)
+	    push_queue(&s->qmax, buf[r], -1, s->nrows);
+	s->nrows++;
+    }
+}
+
+/* the first row of the i/o bufs is about to leave the neighborhood */
+void sliding_remove_row(struct sliding *s, DCELL ** buf)
+{
+    if (use_sums)
+	add_sums(s, buf[0], -1);
+}
+
+/* the last row of the i/o bufs has entered the neighborhood */
+void sliding_add_row(struct sliding *s, DCELL ** buf)
+{
+    int r;
+
+    if (!num_methods)
+	return;
+
+    if (use_sums) {
+	if (s->nrows % ncb.nsize == 0) {
+	    clear_sums(s);
+	    for (r = 0; r < ncb.nsize; r++)
+		add_sums(s, buf[r], 1);
+	}
+	else
+	    add_sums(s, buf[ncb.nsize - 1], 1);
+    }
+
+    if (use_min)
+	push_queue(&s->qmin, buf[ncb.nsize - 1], 1, s->nrows);
+    if (use_max)
+	push_queue(&s->qmax, buf[ncb.nsize - 1], -1, s->nrows);
+
+    s->nrows++;
+}
+
+/* compute the current row of the registered outputs into out[index] */
+void sliding_row(struct sliding *s, DCELL ** buf, DCELL ** out)
+{
+    int i, c;
+
+    if (!num_methods)
+	return;
+
+    if (use_sums) {
+	window_sums(s->col_cnt, s->win_cnt);
+	window_sums(s->col_sum, s->win_sum);
+    }
+    if (use_squares) {
+	window_sums(s->col_ssum, s->win_ssum);
+	window_sums(s->col_ssq, s->win_ssq);
+    }
+    if (use_min)
+	window_min(&s->qmin, s->deque);
+    if (use_max)
+	window_min(&s->qmax, s->deque);
+
+    for (i = 0; i < num_methods; i++) {
+	struct method *m = &methods[i];
+	stat_func *fn = m->fn;
+	DCELL *rp = out[m->index];
+
+	switch (m->kind) {
+	case K_SUM:
+	    for (c = 0; c < ncols; c++) {
+		DCELL n = s->win_cnt[c];
+		DCELL var;
+
+		if (fn == c_count) {
+		    rp[c] = n;
+		    continue;
+		}
+
+		if (n == 0) {
+		    Rast_set_d_null_value(&rp[c], 1);
+		    continue;
+		}
+
+		if (fn == c_sum) {
+		    rp[c] = s->win_sum[c];
+		    continue;
+		}
+
+		if (fn == c_ave) {
+		    rp[c] = s->win_sum[c] / n;
+		    continue;
+		}
+
+		var = (s->win_ssq[c] - s->win_ssum[c] * s->win_ssum[c] / n) / n;
+		if (var < 0)
+		    var = 0;
+		rp[c] = fn == c_var ? var : sqrt(var);
+	    }
+	    break;
+	case K_MIN:
+	    for (c = 0; c < ncols; c++)
+		rp[c] = s->qmin.win[c];
+	    break;
+	case K_MAX:
+	    for (c = 0; c < ncols; c++)
+		if (Rast_is_d_null_value(&s->qmax.win[c]))
+		    rp[c] = s->qmax.win[c];
+		else
+		    rp[c] = -s->qmax.win[c];
+	    break;
+	case K_RANGE:
+	    for (c = 0; c < ncols; c++)
+		if (Rast_is_d_null_value(&s->qmin.win[c]))
+		    rp[c] = s->qmin.win[c];
+		else
+		    rp[c] = -s->qmax.win[c] - s->qmin.win[c];
+	    break;
+	}
+    }
+
+    if (use_hist)
+	hist_row(s, buf, out);
+}
@@ -0,0 +1,158 @@
+"""Test of r.neighbors computing bands of rows in parallel
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import math
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+# several passes of bands, the last one partial
+ROWS = 203
+COLS = 37
+
+# rows and columns counted from 1 as in r.mapcalc, sin() takes degrees
+INPUTS = {
+    'ci': ('if(col() % 13 == 0, null(), (row() * 37 + col() * 11) % 23 - 5)',
+           lambda r, c: None if c % 13 == 0 else (r * 37 + c * 11) % 23 - 5),
+    'di': ('sin(row() * 0.1) * 100 + col() * 0.01',
+           lambda r, c: math.sin(math.radians(r * 0.1)) * 100 + c * 0.01),
+    'sel': ('if(row() % 5 == 0, null(), 1)',
+            lambda r, c: None if r % 5 == 0 else 1),
+}
+
+
+def average(values):
+    return sum(values) / len(values)
+
+
+def median(values):
+    n = len(values)
+    return (values[(n - 1) // 2] + values[n // 2]) / 2.0
+
+
+def mode(values):
+    """Smallest of the most frequent values"""
+    best = max(values.count(v) for v in values)
+    return min(v for v in values if values.count(v) == best)
+
+
+def stddev(values):
+    mean = average(values)
+    return math.sqrt(sum((v - mean) ** 2 for v in values) / len(values))
+
+
+def perc90(values):
+    """Interpolated between the ranks around 0.9 n"""
+    n = len(values)
+    k = n * 0.9
+    i1 = min(int(math.ceil(k)), n - 1)
+    i0 = min(int(math.floor(k)), i1)
+    if i0 == i1:
+        return values[i0]
+    return values[i0] * (i1 - k) + values[i1] * (k - i0)
+
+
+# methods of the sorted values of a neighborhood without the nulls,
+# none of them may be empty but for the diversity
+METHODS = [('average', average), ('median', median), ('mode', mode),
+           ('minimum', min), ('maximum', max), ('stddev', stddev),
+           ('diversity', lambda values: len(set(values))),
+           ('perc90', perc90)]
+
+
+def expected_map(name, size, method, circle=False, selection=None):
+    """Map of the method as ascii raster, the cells not selected are
+    copied from the input"""
+    value = INPUTS[name][1]
+    dist = size // 2
+    window = [(i, j) for i in range(-dist, dist + 1)
+              for j in range(-dist, dist + 1)
+              if not circle or i * i + j * j <= dist * dist]
+    lines = ['north: %d' % ROWS, 'south: 0', 'east: %d' % COLS, 'west: 0',
+             'rows: %d' % ROWS, 'cols: %d' % COLS]
+    for r in range(1, ROWS + 1):
+        cells = []
+        for c in range(1, COLS + 1):
+            if selection and INPUTS[selection][1](r, c) is None:
+                result = value(r, c)
+            else:
+                values = sorted(value(r + i, c + j) for i, j in window
+                                if 1 <= r + i <= ROWS and 1 <= c + j <= COLS
+                                and value(r + i, c + j) is not None)
+                if values or method == 'diversity':
+                    result = dict(METHODS)[method](values)
+                else:
+                    result = None
+            cells.append('*' if result is None else '%.17g' % result)
+        lines.append(' '.join(cells))
+    return '\n'.join(lines) + '\n'
+
+
+class TestNprocs(TestCase):
+    """Maps with one and several threads against the neighborhoods"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        for name, (expression, value) in INPUTS.items():
+            cls.runModule('r.mapcalc',
+                          expression='%s = %s' % (name, expression))
+        cls.to_remove.extend(INPUTS)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+
+    def compare(self, name, size, flags='', selection=None):
+        methods = [method for method, function in METHODS]
+        references = {}
+        for method in methods:
+            reference = '%s_%d%s_%s_ref' % (name, size, flags, method)
+            self.to_remove.append(reference)
+            self.runModule('r.in.ascii', input='-', output=reference,
+                           type='DCELL', overwrite=True,
+                           stdin_=expected_map(name, size, method,
+                                               circle='c' in flags,
+                                               selection=selection))
+            references[method] = reference
+        kwargs = {'selection': selection} if selection else {}
+        for nprocs in [1, 4]:
+            outputs = ['%s_%d%s_%s_%d' % (name, size, flags, method, nprocs)
+                       for method in methods]
+            self.to_remove.extend(outputs)
+            self.assertModule('r.neighbors', input=name, size=size,
+                              flags=flags, method=methods, output=outputs,
+                              nprocs=nprocs, overwrite=True, **kwargs)
+            for output, method in zip(outputs, methods):
+                self.assertRastersNoDifference(actual=output,
+                                               reference=references[method],
+                                               precision=1e-9)
+
+    def test_square(self):
+        """Incremental methods of square neighborhoods"""
+        self.compare('ci', 5)
+        self.compare('di', 7)
+
+    def test_circle(self):
+        """Gathered values of circular neighborhoods"""
+        self.compare('di', 5, flags='c')
+
+    def test_selection(self):
+        """Selection map read by each band"""
+        self.compare('ci', 3, selection='sel')
+
+
+if __name__ == '__main__':
+    test()
@@ -0,0 +1,172 @@
+"""Test of the incremental algorithms of r.neighbors for square windows
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import math
+import os
+
+import grass.script as gscript
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+SIZE = 5
+ROWS = 30
+COLS = 40
+
+
+def in_block(r, c):
+    """A block of nulls as large as the window"""
+    return 10 <= r <= 14 and 10 <= c <= 14
+
+
+# few values, many of them repeated in a window; rows and columns
+# counted from 1 as in r.mapcalc, cos() takes degrees
+INPUTS = {
+    'sc': ('if((row() >= 10 && row() <= 14 && col() >= 10 && col() <= 14)'
+           ' || (row() + 2 * col()) % 9 == 0, null(),'
+           ' (row() * 3 + col() * 5) % 7)',
+           lambda r, c: None if in_block(r, c) or (r + 2 * c) % 9 == 0
+           else (r * 3 + c * 5) % 7),
+    'sd': ('if(row() % 6 == 0 && col() % 4 == 0, null(),'
+           ' cos(row() * 7.0) * 10 + col() * 0.5)',
+           lambda r, c: None if r % 6 == 0 and c % 4 == 0
+           else math.cos(math.radians(r * 7.0)) * 10 + c * 0.5),
+}
+
+
+def variance(values):
+    mean = sum(values) / len(values)
+    return sum((v - mean) ** 2 for v in values) / len(values)
+
+
+def mode(values):
+    """Smallest of the most frequent values"""
+    best = max(values.count(v) for v in values)
+    return min(v for v in values if values.count(v) == best)
+
+
+def interspersion(values, center):
+    """Percent of the values different from the center, plus 1"""
+    count = len(values) - 1
+    if count <= 0:
+        return 0
+    diff = len([v for v in values if v != center])
+    return int((diff * 100.0 + count // 2) / count + 1)
+
+
+# methods of the values of a window without the nulls, None for nulls
+METHODS = {
+    'minimum': lambda v: min(v) if v else None,
+    'maximum': lambda v: max(v) if v else None,
+    'range': lambda v: max(v) - min(v) if v else None,
+    'diversity': lambda v: len(set(v)),
+    'mode': lambda v: mode(v) if v else None,
+    'average': lambda v: sum(v) / len(v) if v else None,
+    'sum': lambda v: sum(v) if v else None,
+    'count': len,
+    'stddev': lambda v: math.sqrt(variance(v)) if v else None,
+    'variance': lambda v: variance(v) if v else None,
+}
+
+
+def expected_map(name, method):
+    """Map of the method as ascii raster"""
+    value = INPUTS[name][1]
+    dist = SIZE // 2
+    lines = ['north: %d' % ROWS, 'south: 0', 'east: %d' % COLS, 'west: 0',
+             'rows: %d' % ROWS, 'cols: %d' % COLS]
+    for r in range(1, ROWS + 1):
+        cells = []
+        for c in range(1, COLS + 1):
+            values = [value(r + i, c + j)
+                      for i in range(-dist, dist + 1)
+                      for j in range(-dist, dist + 1)
+                      if 1 <= r + i <= ROWS and 1 <= c + j <= COLS
+                      and value(r + i, c + j) is not None]
+            if method == 'interspersion':
+                center = value(r, c)
+                result = (None if center is None
+                          else interspersion(values, center))
+            else:
+                result = METHODS[method](values)
+            cells.append('*' if result is None else '%.17g' % result)
+        lines.append(' '.join(cells))
+    return '\n'.join(lines) + '\n'
+
+
+class TestSliding(TestCase):
+    """Square windows and the generic code against the windows"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        for name, (expression, value) in INPUTS.items():
+            cls.runModule('r.mapcalc',
+                          expression='%s = %s' % (name, expression))
+        cls.to_remove.extend(INPUTS)
+        # a weights file of ones selects the generic code
+        cls.weights = gscript.tempfile()
+        with open(cls.weights, 'w') as f:
+            for i in range(SIZE):
+                f.write(' '.join(['1'] * SIZE) + '\n')
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+        os.remove(cls.weights)
+
+    def compare(self, name):
+        methods = sorted(METHODS) + ['interspersion']
+        square = ['%s_square_%s' % (name, m) for m in methods]
+        weighted = ['%s_weighted_%s' % (name, m) for m in methods]
+        self.to_remove.extend(square + weighted)
+        self.assertModule('r.neighbors', input=name, size=SIZE,
+                          method=methods, output=square)
+        self.assertModule('r.neighbors', input=name, size=SIZE,
+                          weight=self.weights, method=methods,
+                          output=weighted)
+        for method, actual, generic in zip(methods, square, weighted):
+            reference = '%s_%s_ref' % (name, method)
+            self.to_remove.append(reference)
+            self.runModule('r.in.ascii', input='-', output=reference,
+                           type='DCELL', stdin_=expected_map(name, method))
+            self.assertRastersNoDifference(actual=actual, reference=reference,
+                                           precision=1e-9)
+            self.assertRastersNoDifference(actual=generic,
+                                           reference=reference,
+                                           precision=1e-9)
+
+    def test_cell(self):
+        """Methods on a CELL map with a window of nulls"""
+        self.compare('sc')
+
+    def test_dcell(self):
+        """Methods on a DCELL map with NULLs"""
+        self.compare('sd')
+
+    def test_median(self):
+        """Median of the sliding histogram"""
+        terms = ['double(sc[%d,%d])' % (r, c)
+                 for r in range(-2, 3) for c in range(-2, 3)]
+        self.assertModule('r.mapcalc',
+                          expression='sc_nmedian = nmedian(%s)' % ','.join(terms))
+        self.assertModule('r.neighbors', input='sc', size=SIZE,
+                          method='median', output='sc_median')
+        self.to_remove.extend(['sc_nmedian', 'sc_median'])
+        self.assertRastersNoDifference(actual='sc_median',
+                                       reference='sc_nmedian', precision=0)
+
+
+if __name__ == '__main__':
+    test()
@@ -0,0 +1,130 @@
+"""Test of the weighted median and quantiles of r.neighbors
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import os
+
+import grass.script as gscript
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+ROWS = COLS = 30
+
+# fractional weights: the cumulated weights often reach the target
+# only up to rounding, so the order in which they are summed matters;
+# the 49 pairs of the larger window are partitioned before the rest is
+# sorted
+WEIGHTS = {3: [[0.1, 0.2, 0.3],
+               [0.3, 0.1, 0.2],
+               [0.2, 0.3, 0.1]],
+           7: [[0.1 * (1 + (3 * i + 5 * j) % 4) for j in range(7)]
+               for i in range(7)]}
+
+# equal values are summed in ascending order of their weights
+INPUT = ('wv = if((row() * col()) % 7 == 3, null(), '
+         '(17 * row() + 29 * col()) % 101)')
+
+METHODS = [('median', 0.5), ('quart1', 0.25), ('quart3', 0.75),
+           ('perc90', 0.9), ('quantile', 0.3)]
+
+
+def value(row, col):
+    """Cell of INPUT, rows and columns counted from 0"""
+    if 0 <= row < ROWS and 0 <= col < COLS:
+        if (row + 1) * (col + 1) % 7 != 3:
+            return float((17 * (row + 1) + 29 * (col + 1)) % 101)
+    return None
+
+
+def weighted_quantile(pairs, quant):
+    """Sort the values, then cumulate their weights in that order up to
+    quant times their total, as the weighted methods always did"""
+    pairs = sorted(pairs)
+    total = 0.0
+    for v, w in pairs:
+        total += w
+    k = 0.0
+    for v, w in pairs:
+        k += w
+        if k >= total * quant:
+            return v
+    return pairs[-1][0]
+
+
+def expected_map(size, quant):
+    """Map of weighted quantiles as ascii raster"""
+    dist = size // 2
+    lines = ['north: %d' % ROWS, 'south: 0', 'east: %d' % COLS, 'west: 0',
+             'rows: %d' % ROWS, 'cols: %d' % COLS]
+    for row in range(ROWS):
+        cells = []
+        for col in range(COLS):
+            pairs = [(value(row + i - dist, col + j - dist),
+                      WEIGHTS[size][i][j])
+                     for i in range(size) for j in range(size)
+                     if value(row + i - dist, col + j - dist) is not None]
+            cells.append('%.17g' % weighted_quantile(pairs, quant)
+                         if pairs else '*')
+        lines.append(' '.join(cells))
+    return '\n'.join(lines) + '\n'
+
+
+class TestWeighted(TestCase):
+    """Weighted methods against the sort and cumulate rule"""
+
+    to_remove = ['wv']
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        cls.runModule('r.mapcalc', expression=INPUT)
+        cls.weights = {}
+        for size, weights in WEIGHTS.items():
+            cls.weights[size] = gscript.tempfile()
+            with open(cls.weights[size], 'w') as f:
+                for row in weights:
+                    f.write(' '.join(repr(w) for w in row) + '\n')
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+        for weights in cls.weights.values():
+            os.remove(weights)
+
+    def compare(self, size):
+        outputs = ['wv_%d_%s' % (size, method) for method, quant in METHODS]
+        self.to_remove.extend(outputs)
+        self.assertModule('r.neighbors', input='wv', size=size,
+                          weight=self.weights[size],
+                          method=[method for method, quant in METHODS],
+                          quantile=[quant for method, quant in METHODS],
+                          output=outputs)
+        for output, (method, quant) in zip(outputs, METHODS):
+            reference = output + '_ref'
+            self.to_remove.append(reference)
+            self.runModule('r.in.ascii', input='-', output=reference,
+                           type='DCELL', stdin_=expected_map(size, quant))
+            self.assertRastersNoDifference(actual=output,
+                                           reference=reference,
+                                           precision=0)
+
+    def test_fractional_weights(self):
+        """Weighted median and quantiles of fractional weights"""
+        self.compare(3)
+
+    def test_selection(self):
+        """Weighted median and quantiles selected from partitions"""
+        self.compare(7)
+
+
+if __name__ == '__main__':
+    test()
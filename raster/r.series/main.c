@@ -13,9 +13,14 @@
  *               for details.
  *
  *****************************************************************************/
+#include <grass/config.h>
+
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
 
 #include <grass/gis.h>
 #include <grass/raster.h>
@@ -59,8 +64,9 @@ struct menu
 struct input
 {
     const char *name;
-    int fd;
-    DCELL *buf;
+    int fd;			/* -1 while the map is closed */
+    int keep;			/* kept open between blocks */
+    DCELL *buf;			/* rows of the block */
     DCELL weight;
 };
 
@@ -68,12 +74,184 @@ struct output
 {
     const char *name;
     int fd;
-    DCELL *buf;
+    DCELL *buf;			/* rows of the block */
     stat_func *method_fn;
     stat_func_w *method_fn_w;
     double quantile;
+    int shared;			/* one of the quantiles of the block */
 };
 
+/* The rows are processed in blocks. The rows of a block are read from
+   the inputs on several threads, each input by one thread, then the
+   cells of the block are computed in parallel and the rows of the
+   outputs are written in order.
+
+   As many input maps as the limit of open files allows stay open,
+   the others are opened for each block in groups of up to "slots"
+   maps, read and closed again. Maps are only opened and closed on the
+   main thread, between the reads.
+ */
+#define BLOCK_CELLS (1 << 22)	/* cells of all inputs per block */
+
+struct block
+{
+    struct input *inputs;
+    int num_inputs;
+    struct output *outputs;
+    int num_outputs;
+    int row, nrows;		/* rows of the block */
+    int have_weights;
+    int nulls;			/* propagate NULLs */
+    int have_range;
+    double lo, hi;
+    int num_quants;		/* quantiles computed together */
+    int *quant_outputs;
+    double *quants;
+};
+
+static int slots;
+
+/* number of input maps which may be open at the same time */
+static int open_limit(void)
+{
+    int limit = 256;
+
+#ifdef HAVE_SYS_RESOURCE_H
+    struct rlimit rlim;
+
+    /* a map may use a data and a null file, some are left for the
+       outputs and the support files */
+    if (getrlimit(RLIMIT_NOFILE, &rlim) == 0 && rlim.rlim_cur != RLIM_INFINITY)
+	limit = ((int)rlim.rlim_cur - 64) / 2;
+#endif
+
+    return limit > 8 ? limit : 8;
+}
+
+static void read_inputs(int first, int last, void *closure)
+{
+    const struct block *b = closure;
+    int i;
+
+    for (i = first; i < last; i++)
+	Rast_get_rows(b->inputs[i].fd, b->inputs[i].buf, b->row, b->nrows,
+		      DCELL_TYPE);
+}
+
+static void read_block(struct block *b)
+{
+    int first, last;
+    int i, n;
+
+    for (first = 0; first < b->num_inputs; first = last) {
+	for (last = first, n = 0; last < b->num_inputs; last++) {
+	    struct input *p = &b->inputs[last];
+
+	    if (p->fd >= 0)
+		continue;
+	    if (n == slots)
+		break;
+	    p->fd = Rast_open_old(p->name, "");
+	    n++;
+	}
+
+	G_parallel_for(first, last, 1, read_inputs, b);
+
+	for (i = first; i < last; i++) {
+	    struct input *p = &b->inputs[i];
+
+	    if (!p->keep) {
+		Rast_close(p->fd);
+		p->fd = -1;
+	    }
+	}
+    }
+}
+
+static void compute_cells(int first, int last, void *closure)
+{
+    const struct block *b = closure;
+    int num_inputs = b->num_inputs;
+    DCELL *values, *values_tmp;
+    DCELL(*values_w)[2];	/* list of values and weights */
+    DCELL(*values_w_tmp)[2];	/* list of values and weights */
+    DCELL *quants = NULL;
+    int i, k;
+
+    values = G_malloc(num_inputs * sizeof(DCELL));
+    values_tmp = G_malloc(num_inputs * sizeof(DCELL));
+    values_w = NULL;
+    values_w_tmp = NULL;
+    if (b->have_weights) {
+	values_w = (DCELL(*)[2]) G_malloc(num_inputs * 2 * sizeof(DCELL));
+	values_w_tmp = (DCELL(*)[2]) G_malloc(num_inputs * 2 * sizeof(DCELL));
+    }
+    if (b->num_quants)
+	quants = G_malloc(b->num_quants * sizeof(DCELL));
+
+    for (k = first; k < last; k++) {
+	int null = 0;
+
+	for (i = 0; i < num_inputs; i++) {
+	    DCELL v = b->inputs[i].buf[k];
+
+	    if (Rast_is_d_null_value(&v))
+		null = 1;
+	    else if (b->have_range && (v < b->lo || v > b->hi)) {
+		Rast_set_d_null_value(&v, 1);
+		null = 1;
+	    }
+	    values[i] = v;
+	    if (b->have_weights) {
+		values_w[i][0] = v;
+		values_w[i][1] = b->inputs[i].weight;
+	    }
+	}
+
+	/* the quantiles share one partition of the values */
+	if (b->num_quants) {
+	    if (null && b->nulls)
+		Rast_set_d_null_value(quants, b->num_quants);
+	    else {
+		memcpy(values_tmp, values, num_inputs * sizeof(DCELL));
+		c_quantiles(quants, values_tmp, num_inputs, b->quants,
+			    b->num_quants);
+	    }
+	    for (i = 0; i < b->num_quants; i++)
+		b->outputs[b->quant_outputs[i]].buf[k] = quants[i];
+	}
+
+	for (i = 0; i < b->num_outputs; i++) {
+	    struct output *out = &b->outputs[i];
+
+	    if (out->shared)
+		continue;
+
+	    if (null && b->nulls)
+		Rast_set_d_null_value(&out->buf[k], 1);
+	    else {
+		if (out->method_fn_w) {
+		    memcpy(values_w_tmp, values_w, num_inputs * 2 * sizeof(DCELL));
+		    (*out->method_fn_w)(&out->buf[k], values_w_tmp, num_inputs, &out->quantile);
+		}
+		else {
+		    memcpy(values_tmp, values, num_inputs * sizeof(DCELL));
+		    (*out->method_fn)(&out->buf[k], values_tmp, num_inputs, &out->quantile);
+		}
+	    }
+	}
+    }
+
+    G_free(values);
+    G_free(values_tmp);
+    if (quants)
+	G_free(quants);
+    if (b->have_weights) {
+	G_free(values_w);
+	G_free(values_w_tmp);
+    }
+}
+
 static char *build_method_list(void)
 {
     char *buf = G_malloc(1024);
@@ -112,6 +290,7 @@ int main(int argc, char *argv[])
     struct
     {
 	struct Option *input, *file, *output, *method, *weights, *quantile, *range;
+	struct Option *nprocs;
     } parm;
     struct
     {
@@ -123,12 +302,11 @@ int main(int argc, char *argv[])
     int num_outputs;
     struct output *outputs = NULL;
     struct History history;
-    DCELL *values = NULL, *values_tmp = NULL;
-    DCELL(*values_w)[2];	/* list of values and weights */
-    DCELL(*values_w_tmp)[2];	/* list of values and weights */
+    struct block block;
     int have_weights;
     int nrows, ncols;
-    int row, col;
+    int row, rows;
+    int threads, max_open, num_open;
     double lo, hi;
     RASTER_MAP_TYPE intype, maptype;
 
@@ -183,6 +361,8 @@ int main(int argc, char *argv[])
     parm.range->key_desc = "lo,hi";
     parm.range->description = _("Ignore values outside this range");
 
+    parm.nprocs = G_define_standard_option(G_OPT_M_NPROCS);
+
     flag.nulls = G_define_flag();
     flag.nulls->key = 'n';
     flag.nulls->description = _("Propagate NULLs");
@@ -194,6 +374,16 @@ int main(int argc, char *argv[])
     if (G_parser(argc, argv))
 	exit(EXIT_FAILURE);
 
+    threads = G_set_num_threads(atoi(parm.nprocs->answer));
+
+    /* maps opened for each block, the others are kept open */
+    max_open = open_limit();
+    slots = 4 * threads;
+    if (slots > max_open / 2)
+	slots = max_open / 2;
+    max_open = flag.lazy->answer ? 0 : max_open - slots;
+    num_open = 0;
+
     lo = -1.0 / 0.0; /* -inf */
     hi = 1.0 / 0.0; /* inf */
     if (parm.range->answer) {
@@ -279,9 +469,13 @@ int main(int argc, char *argv[])
 		if (intype != maptype)
 		    intype = DCELL_TYPE;
 	    }
-	    if (flag.lazy->answer)
+	    p->keep = num_open < max_open;
+	    if (p->keep)
+		num_open++;
+	    else {
 		Rast_close(p->fd);
-	    p->buf = Rast_allocate_d_buf();
+		p->fd = -1;
+	    }
 	}
 
 	if (num_inputs < 1)
@@ -339,9 +533,13 @@ int main(int argc, char *argv[])
 		if (intype != maptype)
 		    intype = DCELL_TYPE;
 	    }
-	    if (flag.lazy->answer)
+	    p->keep = num_open < max_open;
+	    if (p->keep)
+		num_open++;
+	    else {
 		Rast_close(p->fd);
-	    p->buf = Rast_allocate_d_buf();
+		p->fd = -1;
+	    }
     	}
     }
 
@@ -391,87 +589,86 @@ int main(int argc, char *argv[])
 	out->quantile = (parm.quantile->answer && parm.quantile->answers[i])
 	    ? atof(parm.quantile->answers[i])
 	    : 0;
-	out->buf = Rast_allocate_d_buf();
 	if (menu[method].outtype == -1)
 	    out->fd = Rast_open_new(output_name, intype);
 	else
 	    out->fd = Rast_open_new(output_name, menu[method].outtype);
     }
 
-    /* initialise variables */
-    values = G_malloc(num_inputs * sizeof(DCELL));
-    values_tmp = G_malloc(num_inputs * sizeof(DCELL));
-    values_w = NULL;
-    values_w_tmp = NULL;
-    if (have_weights) {
-	values_w = (DCELL(*)[2]) G_malloc(num_inputs * 2 * sizeof(DCELL));
-	values_w_tmp = (DCELL(*)[2]) G_malloc(num_inputs * 2 * sizeof(DCELL));
-    }
-
     nrows = Rast_window_rows();
     ncols = Rast_window_cols();
 
-    /* process the data */
-    G_verbose_message(_("Percent complete..."));
+    rows = BLOCK_CELLS / ((size_t) num_inputs * ncols);
+    if (rows > nrows)
+	rows = nrows;
+    if (rows < 1)
+	rows = 1;
+
+    G_debug(1, "%d rows per block, %d inputs kept open", rows, num_open);
+
+    for (i = 0; i < num_inputs; i++)
+	inputs[i].buf = G_malloc((size_t) rows * ncols * sizeof(DCELL));
+    for (i = 0; i < num_outputs; i++)
+	outputs[i].buf = G_malloc((size_t) rows * ncols * sizeof(DCELL));
+
+    block.inputs = inputs;
+    block.num_inputs = num_inputs;
+    block.outputs = outputs;
+    block.num_outputs = num_outputs;
+    block.have_weights = have_weights;
+    block.nulls = flag.nulls->answer;
+    block.have_range = parm.range->answer != NULL;
+    block.lo = lo;
+    block.hi = hi;
+
+    /* several quantiles are selected in one pass */
+    block.num_quants = 0;
+    block.quant_outputs = G_malloc(num_outputs * sizeof(int));
+    block.quants = G_malloc(num_outputs * sizeof(double));
+    for (i = 0; i < num_outputs; i++) {
+	struct output *out = &outputs[i];
+	double q;
+
+	if (out->method_fn == c_quart1)
+	    q = 0.25;
+	else if (out->method_fn == c_quart3)
+	    q = 0.75;
+	else if (out->method_fn == c_perc90)
+	    q = 0.90;
+	else if (out->method_fn == c_quant)
+	    q = out->quantile;
+	else
+	    continue;
 
-    for (row = 0; row < nrows; row++) {
-	G_percent(row, nrows, 2);
+	block.quant_outputs[block.num_quants] = i;
+	block.quants[block.num_quants++] = q;
+    }
+    if (block.num_quants < 2)
+	block.num_quants = 0;
+    for (i = 0; i < block.num_quants; i++)
+	outputs[block.quant_outputs[i]].shared = 1;
 
-	if (flag.lazy->answer) {
-	    /* Open the files only on run time */
-	    for (i = 0; i < num_inputs; i++) {
-		inputs[i].fd = Rast_open_old(inputs[i].name, "");
-		Rast_get_d_row(inputs[i].fd, inputs[i].buf, row);
-		Rast_close(inputs[i].fd);
-	    }
-	}
-	else {
-	    for (i = 0; i < num_inputs; i++)
-	        Rast_get_d_row(inputs[i].fd, inputs[i].buf, row);
-	}
+    /* process the data */
+    G_verbose_message(_("Percent complete..."));
 
-	for (col = 0; col < ncols; col++) {
-	    int null = 0;
+    for (row = 0; row < nrows; row += rows) {
+	int r;
 
-	    for (i = 0; i < num_inputs; i++) {
-		DCELL v = inputs[i].buf[col];
+	G_percent(row, nrows, 2);
 
-		if (Rast_is_d_null_value(&v))
-		    null = 1;
-		else if (parm.range->answer && (v < lo || v > hi)) {
-		    Rast_set_d_null_value(&v, 1);
-		    null = 1;
-		}
-		values[i] = v;
-		if (have_weights) {
-		    values_w[i][0] = v;
-		    values_w[i][1] = inputs[i].weight;
-		}
-	    }
+	block.row = row;
+	block.nrows = row + rows < nrows ? rows : nrows - row;
 
-	    for (i = 0; i < num_outputs; i++) {
-		struct output *out = &outputs[i];
+	read_block(&block);
 
-		if (null && flag.nulls->answer)
-		    Rast_set_d_null_value(&out->buf[col], 1);
-		else {
-		    if (out->method_fn_w) {
-			memcpy(values_w_tmp, values_w, num_inputs * 2 * sizeof(DCELL));
-			(*out->method_fn_w)(&out->buf[col], values_w_tmp, num_inputs, &out->quantile);
-		    }
-		    else {
-			memcpy(values_tmp, values, num_inputs * sizeof(DCELL));
-			(*out->method_fn)(&out->buf[col], values_tmp, num_inputs, &out->quantile);
-		    }
-		}
-	    }
-	}
+	G_parallel_for(0, block.nrows * ncols, 1024, compute_cells, &block);
 
-	for (i = 0; i < num_outputs; i++)
-	    Rast_put_d_row(outputs[i].fd, outputs[i].buf);
+	for (r = 0; r < block.nrows; r++)
+	    for (i = 0; i < num_outputs; i++)
+		Rast_put_d_row(outputs[i].fd, outputs[i].buf + (size_t) r * ncols);
     }
 
-    G_percent(row, nrows, 2);
+    G_percent(nrows, nrows, 2);
 
     /* close output maps */
     for (i = 0; i < num_outputs; i++) {
@@ -485,10 +682,9 @@ int main(int argc, char *argv[])
     }
 
     /* Close input maps */
-    if (!flag.lazy->answer) {
-    	for (i = 0; i < num_inputs; i++)
+    for (i = 0; i < num_inputs; i++)
+	if (inputs[i].fd >= 0)
 	    Rast_close(inputs[i].fd);
-    }
 
     exit(EXIT_SUCCESS);
 }
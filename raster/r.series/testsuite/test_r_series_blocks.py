@@ -0,0 +1,67 @@
+"""Test of r.series processing blocks of rows in parallel
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+NUM_INPUTS = 12
+
+METHODS = ['average', 'median', 'mode', 'min_raster', 'stddev', 'slope']
+
+
+class TestBlocks(TestCase):
+    """Same maps with one or several threads and with -z"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=40, s=0, w=0, e=50, res=1)
+        cls.inputs = ['series_%d' % i for i in range(NUM_INPUTS)]
+        for i, name in enumerate(cls.inputs):
+            cls.runModule('r.mapcalc', expression=(
+                '%s = if((row() + col() * %d) %% 17 == 0, null(), '
+                '(row() * %d + col() * 7) %% 29 - 10)' % (name, i, i)))
+        cls.to_remove.extend(cls.inputs)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+
+    def run_series(self, prefix, **kwargs):
+        outputs = ['%s_%s' % (prefix, m) for m in METHODS]
+        self.to_remove.extend(outputs)
+        self.assertModule('r.series', input=self.inputs, method=METHODS,
+                          output=outputs, overwrite=True, **kwargs)
+        return outputs
+
+    def compare(self, actual, reference):
+        for a, r in zip(actual, reference):
+            self.assertRastersNoDifference(actual=a, reference=r,
+                                           precision=0)
+
+    def test_nprocs(self):
+        """Several threads"""
+        serial = self.run_series('serial', nprocs=1)
+        par = self.run_series('par', nprocs=4)
+        self.compare(par, serial)
+
+    def test_lazy(self):
+        """Maps opened for each block of rows"""
+        serial = self.run_series('open', nprocs=1)
+        lazy = self.run_series('lazy', nprocs=3, flags='z')
+        self.compare(lazy, serial)
+
+
+if __name__ == '__main__':
+    test()
@@ -0,0 +1,57 @@
+"""Test of r.series computing several quantiles together
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+
+NUM_INPUTS = 9
+
+
+class TestQuantiles(TestCase):
+    """Quantiles selected in one pass match those computed one by one"""
+
+    to_remove = []
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=30, s=0, w=0, e=40, res=1)
+        cls.inputs = ['quant_%d' % i for i in range(NUM_INPUTS)]
+        for i, name in enumerate(cls.inputs):
+            cls.runModule('r.mapcalc', expression=(
+                '%s = if((row() * %d + col()) %% 13 == 0, null(), '
+                '((row() + 3) * %d + col() * 5) %% 23 / 4.0)' % (name, i, i)))
+        cls.to_remove.extend(cls.inputs)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=cls.to_remove)
+
+    def test_grouped(self):
+        """quart1, quart3, perc90 and quantile in one run"""
+        methods = ['quart1', 'quart3', 'perc90', 'quantile', 'median']
+        quantiles = [0, 0, 0, 0.37, 0]
+        grouped = ['grouped_%s' % m for m in methods]
+        self.to_remove.extend(grouped)
+        self.assertModule('r.series', input=self.inputs, method=methods,
+                          quantile=quantiles, output=grouped)
+        for m, q, g in zip(methods, quantiles, grouped):
+            single = 'single_%s' % m
+            self.to_remove.append(single)
+            self.assertModule('r.series', input=self.inputs, method=m,
+                              quantile=q, output=single)
+            self.assertRastersNoDifference(actual=g, reference=single,
+                                           precision=0)
+
+
+if __name__ == '__main__':
+    test()
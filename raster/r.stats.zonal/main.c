@@ -70,10 +70,195 @@ struct menu menu[] = {
     {0, 0, 0}
 };
 
+/* accumulators of the zones: of the first pass, of the second pass and
+   the result */
+#define A_SUM     0
+#define A_SUM2    1
+#define A_SUM3    2
+#define A_SUM4    3
+#define A_MIN     4
+#define A_MAX     5
+#define A_SUMU    6
+#define A_DEV2    7
+#define A_DEV3    8
+#define A_DEV4    9
+#define A_RESULT 10
+#define NUM_ACC  11
+
+/* position of each accumulator in the entries of the zones, -1: unused */
+static int acc[NUM_ACC];
+static int ops[NUM_ACC];
+static int nacc;
+
+static void use_acc(int a, int op)
+{
+    acc[a] = nacc;
+    ops[nacc++] = op;
+}
+
+static void init_accs(int method)
+{
+    int i;
+
+    for (i = 0; i < NUM_ACC; i++)
+	acc[i] = -1;
+    nacc = 0;
+
+    switch (method) {
+    case SUM:
+    case AVERAGE:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	break;
+    case MIN:
+	use_acc(A_MIN, CROSS_STATS_MIN);
+	break;
+    case MAX:
+	use_acc(A_MAX, CROSS_STATS_MAX);
+	break;
+    case RANGE:
+	use_acc(A_MIN, CROSS_STATS_MIN);
+	use_acc(A_MAX, CROSS_STATS_MAX);
+	break;
+    case ADEV:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	use_acc(A_SUMU, CROSS_STATS_SUM);
+	break;
+    case VARIANCE1:
+    case STDDEV1:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	use_acc(A_SUM2, CROSS_STATS_SUM);
+	break;
+    case SKEWNESS1:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	use_acc(A_SUM2, CROSS_STATS_SUM);
+	use_acc(A_SUM3, CROSS_STATS_SUM);
+	break;
+    case KURTOSIS1:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	use_acc(A_SUM2, CROSS_STATS_SUM);
+	use_acc(A_SUM3, CROSS_STATS_SUM);
+	use_acc(A_SUM4, CROSS_STATS_SUM);
+	break;
+    case VARIANCE2:
+    case STDDEV2:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	use_acc(A_DEV2, CROSS_STATS_SUM);
+	break;
+    case SKEWNESS2:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	use_acc(A_DEV2, CROSS_STATS_SUM);
+	use_acc(A_DEV3, CROSS_STATS_SUM);
+	break;
+    case KURTOSIS2:
+	use_acc(A_SUM, CROSS_STATS_SUM);
+	use_acc(A_DEV2, CROSS_STATS_SUM);
+	use_acc(A_DEV4, CROSS_STATS_SUM);
+	break;
+    }
+
+    use_acc(A_RESULT, CROSS_STATS_SUM);
+}
+
+/* accumulators of the first pass for one value, zero for the others */
+static void set_accs(double *vals, DCELL v)
+{
+    int i;
+
+    for (i = 0; i < nacc; i++)
+	vals[i] = 0;
+
+    if (acc[A_SUM] >= 0)
+	vals[acc[A_SUM]] = v;
+    if (acc[A_SUM2] >= 0)
+	vals[acc[A_SUM2]] = v * v;
+    if (acc[A_SUM3] >= 0)
+	vals[acc[A_SUM3]] = v * v * v;
+    if (acc[A_SUM4] >= 0)
+	vals[acc[A_SUM4]] = v * v * v * v;
+    if (acc[A_MIN] >= 0)
+	vals[acc[A_MIN]] = v;
+    if (acc[A_MAX] >= 0)
+	vals[acc[A_MAX]] = v;
+}
+
+/* accumulators of a zone without values */
+static void empty_accs(double *vals)
+{
+    int i;
+
+    for (i = 0; i < nacc; i++)
+	vals[i] = 0;
+
+    if (acc[A_MIN] >= 0)
+	vals[acc[A_MIN]] = 1e300;
+    if (acc[A_MAX] >= 0)
+	vals[acc[A_MAX]] = -1e300;
+}
+
+static DCELL zone_result(int method, double n, const double *vals)
+{
+#define V(a) vals[acc[a]]
+    double var, sdev;
+
+    switch (method) {
+    case COUNT:
+	return n;
+    case SUM:
+	return V(A_SUM);
+    case AVERAGE:
+	return V(A_SUM) / n;
+    case MIN:
+	return V(A_MIN);
+    case MAX:
+	return V(A_MAX);
+    case RANGE:
+	return V(A_MAX) - V(A_MIN);
+    case VARIANCE1:
+	return (V(A_SUM2) - V(A_SUM) * V(A_SUM) / n) / (n - 1);
+    case STDDEV1:
+	return sqrt((V(A_SUM2) - V(A_SUM) * V(A_SUM) / n) / (n - 1));
+    case SKEWNESS1:
+	var = (V(A_SUM2) - V(A_SUM) * V(A_SUM) / n) / (n - 1);
+	return (V(A_SUM3) / n
+		- 3 * V(A_SUM) * V(A_SUM2) / (n * n)
+		+ 2 * V(A_SUM) * V(A_SUM) * V(A_SUM) / (n * n * n))
+	    / (pow(var, 1.5));
+    case KURTOSIS1:
+	var = (V(A_SUM2) - V(A_SUM) * V(A_SUM) / n) / (n - 1);
+	return (V(A_SUM4) / n
+		- 4 * V(A_SUM) * V(A_SUM3) / (n * n)
+		+ 6 * V(A_SUM) * V(A_SUM) * V(A_SUM2) / (n * n * n)
+		- 3 * V(A_SUM) * V(A_SUM) * V(A_SUM) * V(A_SUM) / (n * n * n * n))
+	    / (var * var) - 3;
+    case ADEV:
+	return V(A_SUMU) / n;
+    case VARIANCE2:
+	return V(A_DEV2) / (n - 1);
+    case STDDEV2:
+	return sqrt(V(A_DEV2) / (n - 1));
+    case SKEWNESS2:
+	sdev = sqrt(V(A_DEV2) / (n - 1));
+	return V(A_DEV3) / (sdev * sdev * sdev) / n;
+    case KURTOSIS2:
+	var = V(A_DEV2) / (n - 1);
+	return V(A_DEV4) / (var * var) / n - 3;
+    }
+#undef V
+
+    return 0;
+}
+
+/* cover value of a cell */
+static DCELL cover_value(DCELL v, int usecats, struct Categories *cats)
+{
+    if (usecats)
+	sscanf(Rast_get_c_cat((CELL *) &v, cats), "%lf", &v);
+
+    return v;
+}
+
 int main(int argc, char **argv)
 {
-    static DCELL *count, *sum, *mean, *sumu, *sum2, *sum3, *sum4, *min, *max;
-    DCELL *result;
     struct GModule *module;
     struct {
 	struct Option *method, *basemap, *covermap, *output;
@@ -91,10 +276,15 @@ int main(int argc, char **argv)
     CELL *base_buf;
     DCELL *cover_buf;
     struct Range range;
-    CELL mincat, ncats;
+    struct Cross_stats zones;
+    double *vals, *empty;
+    DCELL empty_result;
+    long count;
     int method;
     int rows, cols;
     int row, col, i;
+    CELL cat;
+
 
     G_gisinit(argv[0]);
 
@@ -184,64 +374,14 @@ int main(int argc, char **argv)
     if (Rast_read_range(basemap, "", &range) < 0)
 	G_fatal_error(_("Unable to read range of base map <%s>"), basemap);
 
-    mincat = range.min;
-    ncats = range.max - range.min + 1;
-
     rows = Rast_window_rows();
     cols = Rast_window_cols();
 
-    switch (method) {
-    case COUNT:
-	count = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case SUM:
-	sum = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case MIN:
-	min = G_malloc(ncats * sizeof(DCELL));
-	break;
-    case MAX:
-	max = G_malloc(ncats * sizeof(DCELL));
-	break;
-    case RANGE:
-	min = G_malloc(ncats * sizeof(DCELL));
-	max = G_malloc(ncats * sizeof(DCELL));
-	break;
-    case AVERAGE:
-    case ADEV:
-    case VARIANCE2:
-    case STDDEV2:
-    case SKEWNESS2:
-    case KURTOSIS2:
-	count = G_calloc(ncats, sizeof(DCELL));
-	sum = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case VARIANCE1:
-    case STDDEV1:
-	count = G_calloc(ncats, sizeof(DCELL));
-	sum = G_calloc(ncats, sizeof(DCELL));
-	sum2 = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case SKEWNESS1:
-	count = G_calloc(ncats, sizeof(DCELL));
-	sum = G_calloc(ncats, sizeof(DCELL));
-	sum2 = G_calloc(ncats, sizeof(DCELL));
-	sum3 = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case KURTOSIS1:
-	count = G_calloc(ncats, sizeof(DCELL));
-	sum = G_calloc(ncats, sizeof(DCELL));
-	sum2 = G_calloc(ncats, sizeof(DCELL));
-	sum4 = G_calloc(ncats, sizeof(DCELL));
-	break;
-    }
-
-    if (min)
-	for (i = 0; i < ncats; i++)
-	    min[i] = 1e300;
-    if (max)
-	for (i = 0; i < ncats; i++)
-	    max[i] = -1e300;
+    /* the zones are the entries of a hash table, so that only the
+       categories present in the base map take memory */
+    init_accs(method);
+    Rast_init_cross_stats(&zones, 1, nacc, ops);
+    vals = G_malloc(nacc * sizeof(double));
 
     base_buf = Rast_allocate_c_buf();
     cover_buf = Rast_allocate_d_buf();
@@ -253,37 +393,13 @@ int main(int argc, char **argv)
 	Rast_get_d_row(cover_fd, cover_buf, row);
 
 	for (col = 0; col < cols; col++) {
-	    int n;
-	    DCELL v;
-
 	    if (Rast_is_c_null_value(&base_buf[col]))
 		continue;
 	    if (Rast_is_d_null_value(&cover_buf[col]))
 		continue;
 
-	    n = base_buf[col] - mincat;
-
-	    if (n < 0 || n >= ncats)
-		continue;
-
-	    v = cover_buf[col];
-	    if (usecats)
-		sscanf(Rast_get_c_cat((CELL *) &v, &cats), "%lf", &v);
-
-	    if (count)
-		count[n]++;
-	    if (sum)
-		sum[n] += v;
-	    if (sum2)
-		sum2[n] += v * v;
-	    if (sum3)
-		sum3[n] += v * v * v;
-	    if (sum4)
-		sum4[n] += v * v * v * v;
-	    if (min && min[n] > v)
-		min[n] = v;
-	    if (max && max[n] < v)
-		max[n] = v;
+	    set_accs(vals, cover_value(cover_buf[col], usecats, &cats));
+	    Rast_update_cross_stats(&zones, &base_buf[col], 1, vals);
 	}
 
 	G_percent(row, rows, 2);
@@ -291,40 +407,7 @@ int main(int argc, char **argv)
 
     G_percent(row, rows, 2);
 
-    result = G_calloc(ncats, sizeof(DCELL));
-
-    switch (method) {
-    case ADEV:
-    case VARIANCE2:
-    case STDDEV2:
-    case SKEWNESS2:
-    case KURTOSIS2:
-	mean = G_calloc(ncats, sizeof(DCELL));
-	for (i = 0; i < ncats; i++)
-	    mean[i] = sum[i] / count[i];
-	G_free(sum);
-	break;
-    }
-
-    switch (method) {
-    case ADEV:
-	sumu = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case VARIANCE2:
-    case STDDEV2:
-	sum2 = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case SKEWNESS2:
-	sum2 = G_calloc(ncats, sizeof(DCELL));
-	sum3 = G_calloc(ncats, sizeof(DCELL));
-	break;
-    case KURTOSIS2:
-	sum2 = G_calloc(ncats, sizeof(DCELL));
-	sum4 = G_calloc(ncats, sizeof(DCELL));
-	break;
-    }
-
-    if (mean) {
+    if (acc[A_SUMU] >= 0 || acc[A_DEV2] >= 0) {
 	G_message(_("Second pass"));
 
 	for (row = 0; row < rows; row++) {
@@ -332,139 +415,51 @@ int main(int argc, char **argv)
 	    Rast_get_d_row(cover_fd, cover_buf, row);
 
 	    for (col = 0; col < cols; col++) {
-		int n;
-		DCELL v, d;
+		double *zone;
+		DCELL d;
 
 		if (Rast_is_c_null_value(&base_buf[col]))
 		    continue;
 		if (Rast_is_d_null_value(&cover_buf[col]))
 		    continue;
 
-		n = base_buf[col] - mincat;
+		Rast_find_cross_stat(&zones, &base_buf[col], &count, &zone);
 
-		if (n < 0 || n >= ncats)
-		    continue;
+		d = cover_value(cover_buf[col], usecats, &cats) -
+		    zone[acc[A_SUM]] / count;
 
-		v = cover_buf[col];
-		if (usecats)
-		    sscanf(Rast_get_c_cat((CELL *) &v, &cats), "%lf", &v);
-		d = v - mean[n];
-
-		if (sumu)
-		    sumu[n] += fabs(d);
-		if (sum2)
-		    sum2[n] += d * d;
-		if (sum3)
-		    sum3[n] += d * d * d;
-		if (sum4)
-		    sum4[n] += d * d * d * d;
+		if (acc[A_SUMU] >= 0)
+		    zone[acc[A_SUMU]] += fabs(d);
+		if (acc[A_DEV2] >= 0)
+		    zone[acc[A_DEV2]] += d * d;
+		if (acc[A_DEV3] >= 0)
+		    zone[acc[A_DEV3]] += d * d * d;
+		if (acc[A_DEV4] >= 0)
+		    zone[acc[A_DEV4]] += d * d * d * d;
 	    }
 
 	    G_percent(row, rows, 2);
 	}
 
 	G_percent(row, rows, 2);
-	G_free(mean);
-	G_free(cover_buf);
     }
 
-    switch (method) {
-    case COUNT:
-	for (i = 0; i < ncats; i++)
-	    result[i] = count[i];
-	break;
-    case SUM:
-	for (i = 0; i < ncats; i++)
-	    result[i] = sum[i];
-	break;
-    case AVERAGE:
-	for (i = 0; i < ncats; i++)
-	    result[i] = sum[i] / count[i];
-	break;
-    case MIN:
-	for (i = 0; i < ncats; i++)
-	    result[i] = min[i];
-	break;
-    case MAX:
-	for (i = 0; i < ncats; i++)
-	    result[i] = max[i];
-	break;
-    case RANGE:
-	for (i = 0; i < ncats; i++)
-	    result[i] = max[i] - min[i];
-	break;
-    case VARIANCE1:
-	for (i = 0; i < ncats; i++) {
-	    double n = count[i];
-	    double var = (sum2[i] - sum[i] * sum[i] / n) / (n - 1);
-	    result[i] = var;
-	}
-	break;
-    case STDDEV1:
-	for (i = 0; i < ncats; i++) {
-	    double n = count[i];
-	    double var = (sum2[i] - sum[i] * sum[i] / n) / (n - 1);
-	    result[i] = sqrt(var);
-	}
-	break;
-    case SKEWNESS1:
-	for (i = 0; i < ncats; i++) {
-	    double n = count[i];
-	    double var = (sum2[i] - sum[i] * sum[i] / n) / (n - 1);
-	    double skew = (sum3[i] / n
-			   - 3 * sum[i] * sum2[i] / (n * n)
-			   + 2 * sum[i] * sum[i] * sum[i] / (n * n * n))
-		/ (pow(var, 1.5));
-	    result[i] = skew;
-	}
-	break;
-    case KURTOSIS1:
-	for (i = 0; i < ncats; i++) {
-	    double n = count[i];
-	    double var = (sum2[i] - sum[i] * sum[i] / n) / (n - 1);
-	    double kurt = (sum4[i] / n
-			   - 4 * sum[i] * sum3[i] / (n * n)
-			   + 6 * sum[i] * sum[i] * sum2[i] / (n * n * n)
-			   - 3 * sum[i] * sum[i] * sum[i] * sum[i] / (n * n * n * n))
-		/ (var * var) - 3;
-	    result[i] = kurt;
-	}
-	break;
-    case ADEV:
-	for (i = 0; i < ncats; i++)
-	    result[i] = sumu[i] / count[i];
-	break;
-    case VARIANCE2:
-	for (i = 0; i < ncats; i++)
-	    result[i] = sum2[i] / (count[i] - 1);
-	break;
-    case STDDEV2:
-	for (i = 0; i < ncats; i++)
-	    result[i] = sqrt(sum2[i] / (count[i] - 1));
-	break;
-    case SKEWNESS2:
-	for (i = 0; i < ncats; i++) {
-	    double n = count[i];
-	    double var = sum2[i] / (n - 1);
-	    double sdev = sqrt(var);
-	    result[i] = sum3[i] / (sdev * sdev * sdev) / n;
-	}
-	G_free(count);
-	G_free(sum2);
-	G_free(sum3);
-	break;
-    case KURTOSIS2:
-	for (i = 0; i < ncats; i++) {
-	    double n = count[i];
-	    double var = sum2[i] / (n - 1);
-	    result[i] = sum4[i] / (var * var) / n - 3;
-	}
-	G_free(count);
-	G_free(sum2);
-	G_free(sum4);
-	break;
+    G_free(cover_buf);
+
+    /* the results of the zones, and of the categories without values */
+    Rast_rewind_cross_stats(&zones);
+    while (Rast_next_cross_stat(&zones, &cat, &count, vals)) {
+	double *zone;
+
+	Rast_find_cross_stat(&zones, &cat, NULL, &zone);
+	zone[acc[A_RESULT]] = zone_result(method, count, zone);
     }
 
+    empty = G_malloc(nacc * sizeof(double));
+    empty_accs(empty);
+    empty_result = zone_result(method, 0, empty);
+    G_free(empty);
+
     if (reclass) {
 	const char *tempfile = G_tempfile();
 	char *input_arg = G_malloc(strlen(basemap) + 7);
@@ -482,8 +477,17 @@ int main(int argc, char **argv)
 	if (!fp)
 	    G_fatal_error(_("Unable to open temporary file"));
 
-	for (i = 0; i < ncats; i++)
-	    fprintf(fp, "%d = %d %f\n", mincat + i, mincat + i, result[i]);
+	for (cat = range.min; cat <= range.max; cat++) {
+	    double *zone;
+	    DCELL result = empty_result;
+
+	    if (Rast_find_cross_stat(&zones, &cat, NULL, &zone))
+		result = zone[acc[A_RESULT]];
+	    fprintf(fp, "%d = %d %f\n", cat, cat, result);
+
+	    if (cat == range.max)
+		break;
+	}
 
 	fclose(fp);
 
@@ -503,11 +507,17 @@ int main(int argc, char **argv)
 	for (row = 0; row < rows; row++) {
 	    Rast_get_c_row(base_fd, base_buf, row);
 
-	    for (col = 0; col < cols; col++)
+	    for (col = 0; col < cols; col++) {
+		double *zone;
+
 		if (Rast_is_c_null_value(&base_buf[col]))
 		    Rast_set_d_null_value(&out_buf[col], 1);
+		else if (Rast_find_cross_stat(&zones, &base_buf[col], NULL,
+					      &zone))
+		    out_buf[col] = zone[acc[A_RESULT]];
 		else
-		    out_buf[col] = result[base_buf[col] - mincat];
+		    out_buf[col] = empty_result;
+	    }
 
 	    Rast_put_d_row(out_fd, out_buf);
 
@@ -526,6 +536,8 @@ int main(int argc, char **argv)
 	    Rast_write_colors(output, G_mapset(), &colors);
     }
 
+    Rast_free_cross_stats(&zones);
+    G_free(vals);
+
     return 0;
 }
-
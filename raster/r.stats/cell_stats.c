@@ -2,21 +2,97 @@
 #include <grass/glocale.h>
 #include "global.h"
 
-int cell_stats(int fd[], int with_percents, int with_counts,
-	       int with_areas, int do_sort, int with_labels, char *fmt)
+/* The rows are read and counted in bands, several bands at a time on
+   several threads, each band in its own table. The tables of the bands
+   are added to the table of the maps in the order of the bands, so the
+   results do not depend on the number of threads. */
+#define BAND_CELLS (1 << 18)
+
+struct band
 {
+    struct R_read_ctx **ctx;	/* NULL: read through the descriptors */
+    int row, nrows;
     CELL **cell;
+    long cells, some_nulls, all_nulls;
+    struct Cross_stats stats;
+};
+
+struct pass
+{
+    struct band *bands;
+    const int *fd;
+    const double *areas;	/* areas of the cells of the rows, or NULL */
+    int first, rows;		/* rows of the pass and of a band */
+};
+
+static void count_bands(int first, int last, void *closure)
+{
+    const struct pass *p = closure;
+    int b, i, r, col;
+
+    for (b = first; b < last; b++) {
+	struct band *band = &p->bands[b];
+
+	band->row = p->first + b * p->rows;
+	band->nrows = nrows - band->row < p->rows ? nrows - band->row : p->rows;
+
+	for (r = band->row; r < band->row + band->nrows; r++) {
+	    for (i = 0; i < nfiles; i++) {
+		if (band->ctx)
+		    Rast_get_row_ctx(band->ctx[i], band->cell[i], r, CELL_TYPE);
+		else
+		    Rast_get_c_row(p->fd[i], band->cell[i], r);
+
+		/* include max FP value in nsteps'th bin */
+		if (is_fp[i])
+		    fix_max_fp_val(band->cell[i], ncols);
+
+		reset_null_vals(band->cell[i], ncols);
+	    }
+
+	    Rast_update_cross_stats_row(&band->stats, band->cell, ncols, 1,
+					p->areas ? &p->areas[r] : NULL);
+
+	    for (col = 0; col < ncols; col++) {
+		int nulls = 0;
+
+		for (i = 0; i < nfiles; i++)
+		    if (band->cell[i][col] == NULL_CELL)
+			nulls++;
+
+		band->cells++;
+		if (nulls)
+		    band->some_nulls++;
+		if (nulls == nfiles)
+		    band->all_nulls++;
+	    }
+	}
+    }
+}
+
+/* the categories of the maps and the nulls, in which the combinations
+   are counted in an array when there are few of them */
+static void set_ranges(struct Cross_stats *s)
+{
     int i;
-    int row;
+
+    for (i = 0; i < nfiles; i++)
+	if (!Rast_is_c_null_value(&CMIN[i]) && CMIN[i] <= NULL_CELL)
+	    Rast_set_cross_stats_range(s, i, CMIN[i], NULL_CELL);
+}
+
+int cell_stats(int fd[], int with_percents, int with_counts,
+	       int with_areas, int do_sort, int with_labels, char *fmt,
+	       int memory, int threads)
+{
+    struct Cross_stats stats;
+    struct pass p;
+    double *areas;
+    int i, b, nbands;
     double unit_area;
     int planimetric = 0;
     int compute_areas;
-    double G_area_of_cell_at_row();
-
-    /* allocate i/o buffers for each raster map */
-    cell = (CELL **) G_calloc(nfiles, sizeof(CELL *));
-    for (i = 0; i < nfiles; i++)
-	cell[i] = Rast_allocate_c_buf();
+    long cells, some_nulls, all_nulls, total_count;
 
     /* if we want area totals, set this up.
      * distinguish projections which are planimetric (all cells same size)
@@ -37,36 +113,102 @@ int cell_stats(int fd[], int with_percents, int with_counts,
     }
     compute_areas = with_areas && !planimetric;
 
-    /* here we go */
-    initialize_cell_stats(nfiles);
+    /* the areas of the rows are summed, the areas of planimetric cells
+       are counted */
+    areas = NULL;
+    if (compute_areas) {
+	int row;
 
-    for (row = 0; row < nrows; row++) {
-	if (compute_areas)
-	    unit_area = G_area_of_cell_at_row(row);
+	areas = G_malloc(nrows * sizeof(double));
+	for (row = 0; row < nrows; row++)
+	    areas[row] = G_area_of_cell_at_row(row);
+    }
 
-	G_percent(row, nrows, 2);
+    /* here we go */
+    Rast_init_cross_stats(&stats, nfiles, compute_areas ? 1 : 0, NULL);
+    Rast_set_cross_stats_memory(&stats, memory);
+    set_ranges(&stats);
 
-	for (i = 0; i < nfiles; i++) {
-	    Rast_get_c_row(fd[i], cell[i], row);
+    p.fd = fd;
+    p.areas = areas;
+    p.rows = BAND_CELLS / ncols;
+    if (p.rows < 1)
+	p.rows = 1;
+    if (p.rows > nrows)
+	p.rows = nrows;
 
-	    /* include max FP value in nsteps'th bin */
-	    if(is_fp[i])
-		fix_max_fp_val(cell[i], ncols);
+    nbands = (nrows + p.rows - 1) / p.rows;
+    if (nbands > threads)
+	nbands = threads;
 
-	    /* we can't compute hash on null values, so we change all
-	       nulls to max+1, set NULL_CELL to max+1, and later compare
-	       with NULL_CELL to chack for nulls */
-	    reset_null_vals(cell[i], ncols);
+    p.bands = G_malloc(nbands * sizeof(struct band));
+    for (b = 0; b < nbands; b++) {
+	struct band *band = &p.bands[b];
+
+	band->ctx = NULL;
+	if (nbands > 1) {
+	    band->ctx = G_malloc(nfiles * sizeof(struct R_read_ctx *));
+	    for (i = 0; i < nfiles; i++)
+		band->ctx[i] = Rast_create_read_ctx(fd[i]);
 	}
+	band->cell = G_malloc(nfiles * sizeof(CELL *));
+	for (i = 0; i < nfiles; i++)
+	    band->cell[i] = Rast_allocate_c_buf();
+	band->cells = band->some_nulls = band->all_nulls = 0;
+	Rast_init_cross_stats(&band->stats, nfiles, compute_areas ? 1 : 0,
+			      NULL);
+	set_ranges(&band->stats);
+    }
 
-	update_cell_stats(cell, ncols, unit_area);
+    for (p.first = 0; p.first < nrows; p.first += nbands * p.rows) {
+	int n = (nrows - p.first + p.rows - 1) / p.rows;
+
+	if (n > nbands)
+	    n = nbands;
+
+	G_percent(p.first, nrows, 2);
+
+	G_parallel_for(0, n, 1, count_bands, &p);
+
+	for (b = 0; b < n; b++)
+	    Rast_merge_cross_stats(&stats, &p.bands[b].stats);
     }
 
-    G_percent(row, nrows, 2);
+    G_percent(nrows, nrows, 2);
+
+    cells = some_nulls = all_nulls = 0;
+    for (b = 0; b < nbands; b++) {
+	struct band *band = &p.bands[b];
+
+	cells += band->cells;
+	some_nulls += band->some_nulls;
+	all_nulls += band->all_nulls;
+
+	if (band->ctx) {
+	    for (i = 0; i < nfiles; i++)
+		Rast_free_read_ctx(band->ctx[i]);
+	    G_free(band->ctx);
+	}
+	for (i = 0; i < nfiles; i++)
+	    G_free(band->cell[i]);
+	G_free(band->cell);
+	Rast_free_cross_stats(&band->stats);
+    }
+    G_free(p.bands);
+    if (areas)
+	G_free(areas);
+
+    /* percents of the reported cells */
+    total_count = cells;
+    if (no_nulls)
+	total_count -= some_nulls;
+    else if (no_nulls_all)
+	total_count -= all_nulls;
+
+    print_cell_stats(&stats, total_count, unit_area, do_sort, fmt,
+		     with_percents, with_counts, with_areas, with_labels, fs);
 
-    sort_cell_stats(do_sort);
-    print_cell_stats(fmt, with_percents, with_counts, with_areas, with_labels,
-		     fs);
+    Rast_free_cross_stats(&stats);
 
     return 0;
 }
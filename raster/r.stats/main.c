@@ -35,6 +35,7 @@ int ncols, no_nulls, no_nulls_all;
 int nsteps, cat_ranges, raw_output, as_int, averaged;
 int *is_fp;
 DCELL *DMAX, *DMIN;
+CELL *CMIN;
 
 CELL NULL_CELL;
 
@@ -56,6 +57,7 @@ int main(int argc, char *argv[])
     int with_areas;
     int with_labels;
     int do_sort;
+    int threads;
 
     /* printf format */
     char fmt[20];
@@ -98,6 +100,8 @@ int main(int argc, char *argv[])
 				   explicit fp ranges in cats or when the map 
 				   is int, nsteps is ignored */
         struct Option *sort;    /* sort by cell counts */
+	struct Option *memory;	/* of the table of the categories */
+	struct Option *nprocs;
     } option;
 
     G_gisinit(argv[0]);
@@ -150,6 +154,18 @@ int main(int argc, char *argv[])
                _("Sort by cell counts in descending order"));
     option.sort->guisection = _("Formatting");
 
+    option.memory = G_define_option();
+    option.memory->key = "memory";
+    option.memory->type = TYPE_INTEGER;
+    option.memory->key_desc = "value";
+    option.memory->required = NO;
+    option.memory->multiple = NO;
+    option.memory->answer = "300";
+    option.memory->description =
+	_("Maximum memory to be used for the categories in MB");
+
+    option.nprocs = G_define_standard_option(G_OPT_M_NPROCS);
+
     /* Define the different flags */
 
     flag.a = G_define_flag();
@@ -229,6 +245,8 @@ int main(int argc, char *argv[])
 	}
     }
 
+    threads = G_set_num_threads(atoi(option.nprocs->answer));
+
     sscanf(option.nsteps->answer, "%d", &nsteps);
     if (nsteps <= 0) {
 	G_warning(_("'%s' must be greater than zero; using %s=255"),
@@ -293,6 +311,7 @@ int main(int argc, char *argv[])
 	is_fp = (int *)G_realloc(is_fp, (nfiles + 1) * sizeof(int));
 	DMAX = (DCELL *) G_realloc(DMAX, (nfiles + 1) * sizeof(DCELL));
 	DMIN = (DCELL *) G_realloc(DMIN, (nfiles + 1) * sizeof(DCELL));
+	CMIN = (CELL *) G_realloc(CMIN, (nfiles + 1) * sizeof(CELL));
 
 	fd[nfiles] = Rast_open_old(name, "");
 
@@ -359,6 +378,7 @@ int main(int argc, char *argv[])
 		G_fatal_error(_("Unable to read range for map <%s>"), name);
 	    Rast_get_range_min_max(&range, &min, &max);
 	}
+	CMIN[nfiles] = min;
 	if (!null_set) {
 	    null_set = 1;
 	    NULL_CELL = max + 1;
@@ -378,7 +398,7 @@ int main(int argc, char *argv[])
 	raw_stats(fd, with_coordinates, with_xy, with_labels);
     else
 	cell_stats(fd, with_percents, with_counts, with_areas, do_sort,
-                   with_labels, fmt);
+                   with_labels, fmt, atoi(option.memory->answer), threads);
 
     exit(EXIT_SUCCESS);
 }
@@ -0,0 +1,112 @@
+"""Test of r.stats with several threads and a memory limit
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+from grass.gunittest.gmodules import SimpleModule
+
+ROWS = 300
+COLS = 200
+
+# few categories in a dense table and the nulls, rows and columns
+# counted from 1 as in r.mapcalc
+INPUTS = {
+    'st_a': ('if(col() % 11 == 0, null(), (row() * 37 + col()) % 13)',
+             lambda r, c: None if c % 11 == 0 else (r * 37 + c) % 13),
+    'st_b': ('if(row() % 7 == 0, null(), row() / 10 + col() / 20)',
+             lambda r, c: None if r % 7 == 0 else r // 10 + c // 20),
+    # a category for each cell
+    'st_c': ('row() * 1000 + col()', lambda r, c: r * 1000 + c),
+}
+
+
+def expected(names, flags):
+    """Output of r.stats, the percents of the reported cells"""
+    counts = {}
+    for r in range(1, ROWS + 1):
+        for c in range(1, COLS + 1):
+            key = tuple(INPUTS[name][1](r, c) for name in names)
+            counts[key] = counts.get(key, 0) + 1
+
+    # -n skips the cells with a null, -N the cells with nulls only
+    if 'n' in flags:
+        skip = [key for key in counts if None in key]
+    elif 'N' in flags:
+        skip = [key for key in counts if key.count(None) == len(key)]
+    else:
+        skip = []
+    for key in skip:
+        del counts[key]
+    total = sum(counts.values())
+
+    lines = []
+    # nulls after the categories
+    for key in sorted(counts, key=lambda k: [(v is None, v) for v in k]):
+        fields = ['*' if v is None else str(v) for v in key]
+        if 'a' in flags:
+            fields.append('%f' % counts[key])
+        if 'c' in flags:
+            fields.append(str(counts[key]))
+        if 'p' in flags:
+            fields.append('%.2f%%' % (100.0 * counts[key] / total))
+        lines.append(' '.join(fields))
+    return '\n'.join(lines) + '\n'
+
+
+class TestNprocsMemory(TestCase):
+    """Counts, areas and percents with one and several threads and when
+    spilled"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        for name, (expression, value) in INPUTS.items():
+            cls.runModule('r.mapcalc',
+                          expression='%s = %s' % (name, expression))
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=list(INPUTS))
+
+    def stats(self, flags, **kwargs):
+        module = SimpleModule('r.stats', flags=flags, separator='space',
+                              **kwargs)
+        self.assertModule(module)
+        return module.outputs.stdout
+
+    def test_nprocs(self):
+        """Counts and percents with one and four threads"""
+        names = ['st_a', 'st_b']
+        for flags in ['c', 'acn', 'cN', 'pc', 'pn', 'pN']:
+            for nprocs in [1, 4]:
+                self.assertMultiLineEqual(
+                    self.stats(flags, input=names, nprocs=nprocs),
+                    expected(names, flags))
+
+    def test_memory(self):
+        """Counts and percents when the table is spilled to disk"""
+        names = ['st_c', 'st_a']
+        for flags in ['c', 'pn']:
+            self.assertMultiLineEqual(
+                self.stats(flags, input=names, memory=1),
+                expected(names, flags))
+
+    def test_count(self):
+        """All the cells are counted once"""
+        counts = self.stats('cn', input='st_c')
+        self.assertMultiLineEqual(counts, expected(['st_c'], 'cn'))
+        self.assertEqual(len(counts.splitlines()), ROWS * COLS)
+
+
+if __name__ == '__main__':
+    test()
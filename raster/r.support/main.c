@@ -10,6 +10,7 @@
  * PURPOSE:      Build support files for raster map
  *               - Edit header
  *               - Update status (histogram, range)
+ *               - Build overviews
  *
  * COPYRIGHT:    (C) 2000-2007 by the GRASS Development Team
  *
@@ -42,7 +43,8 @@ int main(int argc, char *argv[])
     struct Option *datasrc1_opt, *datasrc2_opt, *datadesc_opt;
     struct Option *map_opt, *units_opt, *vdatum_opt;
     struct Option *load_opt, *save_opt;
-    struct Flag *stats_flag, *null_flag, *del_flag;
+    struct Option *overviews_opt, *resample_opt;
+    struct Flag *stats_flag, *null_flag, *del_flag, *delovr_flag;
     int is_reclass;		/* Is raster reclass? */
     const char *infile;
     struct History hist;
@@ -124,6 +126,29 @@ int main(int argc, char *argv[])
     save_opt->required = NO;
     save_opt->description = _("Text file in which to save history");
 
+    overviews_opt = G_define_option();
+    overviews_opt->key = "overviews";
+    overviews_opt->type = TYPE_INTEGER;
+    overviews_opt->required = NO;
+    overviews_opt->multiple = YES;
+    overviews_opt->options = "2-1000000";
+    overviews_opt->label = _("Reduction factors of the overviews to build");
+    overviews_opt->description =
+	_("Example: 2,4,8,16 (replaces existing overviews)");
+    overviews_opt->guisection = _("Overviews");
+
+    resample_opt = G_define_option();
+    resample_opt->key = "resample";
+    resample_opt->type = TYPE_STRING;
+    resample_opt->required = NO;
+    resample_opt->options = "nearest,average";
+    resample_opt->answer = "nearest";
+    resample_opt->description = _("Resampling method for overviews");
+    resample_opt->descriptions = _("nearest;Nearest neighbor (same values as "
+				   "reading the map at coarse resolution);"
+				   "average;Average of the non-null cells");
+    resample_opt->guisection = _("Overviews");
+
     stats_flag = G_define_flag();
     stats_flag->key = 's';
     stats_flag->description = _("Update statistics (histogram, range)");
@@ -136,6 +161,11 @@ int main(int argc, char *argv[])
     del_flag->key = 'd';
     del_flag->description = _("Delete the null file");
 
+    delovr_flag = G_define_flag();
+    delovr_flag->key = 'o';
+    delovr_flag->description = _("Delete the overviews");
+    delovr_flag->guisection = _("Overviews");
+
     /* Parse command-line options */
     if (G_parser(argc, argv))
 	exit(EXIT_FAILURE);
@@ -256,7 +286,8 @@ int main(int argc, char *argv[])
     if (title_opt->answer || history_opt->answer || units_opt->answer
 	|| vdatum_opt->answer || datasrc1_opt->answer || datasrc2_opt->answer
 	|| datadesc_opt->answer || map_opt->answer)
-	exit(EXIT_SUCCESS);
+	if (!overviews_opt->answer && !delovr_flag->answer)
+	    exit(EXIT_SUCCESS);
 
 
     /* Check the histogram and range */
@@ -308,9 +339,38 @@ int main(int argc, char *argv[])
 	unlink(path);
 	G_file_name_misc(path, "cell_misc", "nullcmpr", raster->answer, G_mapset());
 	unlink(path);
+	Rast_remove_overviews(raster->answer);
 
 	G_done_msg(_("Done."));
     }
 
+    if (delovr_flag->answer) {
+	if (is_reclass)
+	    G_fatal_error(_("[%s] is a reclass of another map. Exiting."),
+			  raster->answer);
+
+	G_message(_("Removing overviews of [%s]..."), raster->answer);
+	Rast_remove_overviews(raster->answer);
+    }
+
+    /* overviews are built last, from the final null file */
+    if (overviews_opt->answer) {
+	int *factors, count, i;
+
+	if (is_reclass)
+	    G_fatal_error(_("[%s] is a reclass of another map. Exiting."),
+			  raster->answer);
+
+	for (count = 0; overviews_opt->answers[count]; count++) ;
+	factors = G_malloc(count * sizeof(int));
+	for (i = 0; i < count; i++)
+	    factors[i] = atoi(overviews_opt->answers[i]);
+
+	Rast_build_overviews(raster->answer, factors, count,
+			     strcmp(resample_opt->answer, "average") == 0
+			     ? OVERVIEW_AVERAGE : OVERVIEW_NEAREST);
+	G_free(factors);
+    }
+
     return EXIT_SUCCESS;
 }
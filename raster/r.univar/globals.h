@@ -27,24 +27,42 @@
 /*- Parameters and global variables -----------------------------------------*/
 typedef struct
 {
-    double sum;
-    double sumsq;
+    double sum, sum_c;		/* compensated sums */
+    double sum_abs, sum_abs_c;
+    double mean, m2;		/* mean and sum of squared deviations */
     double min;
     double max;
     unsigned int n_perc;
     double *perc;
-    double sum_abs;
     unsigned long n;
     unsigned long size;
-    DCELL *dcell_array;
-    FCELL *fcell_array;
-    CELL *cell_array;
-    int map_type;
-    void *nextp;
-    size_t n_alloc;
     int first;
+    /* extended statistics */
+    double quartile_25, median, quartile_75;
+    double *quartile_perc;
+    struct sketch *sketch;	/* approximate percentiles */
 } univar_stat;
 
+/* statistics of a band of cells, which are computed in parallel and
+   merged into the univar_stat of the zones in the order of the bands */
+struct moments
+{
+    unsigned long n, size;
+    double shift;		/* first value, the sums are of the differences */
+    double s1, s1_c, s2;
+    double sum_abs, sum_abs_c;
+    double min, max;
+};
+
+typedef struct
+{
+    struct moments *mom;	/* one per zone */
+    int *touched;		/* zones with cells in the band */
+    int n_touched;
+    struct sketch **sketch;	/* one per zone, approximate percentiles */
+    unsigned int seed;
+} band_stat;
+
 typedef struct
 {
     CELL min, max, n_zones;
@@ -56,6 +74,7 @@ typedef struct
 typedef struct
 {
     struct Option *inputfile, *zonefile, *percentile, *output_file, *separator;
+    struct Option *error, *nprocs;
     struct Flag *shell_style, *extended, *table, *use_rast_region;
 } param_type;
 
@@ -63,12 +82,32 @@ extern param_type param;
 extern zone_type zone_info;
 
 /* fn prototypes */
-void heapsort_double(double *data, int n);
-void heapsort_float(float *data, int n);
-void heapsort_int(int *data, int n);
+/* stats.c */
 int print_stats(univar_stat * stats);
 int print_stats_table(univar_stat * stats);
-univar_stat *create_univar_stat_struct(int map_type, int n_perc);
+univar_stat *create_univar_stat_struct(int n_perc);
 void free_univar_stat_struct(univar_stat * stats);
+void init_band_stat(band_stat * b, unsigned int seed);
+void free_band_stat(band_stat * b);
+void add_cells(band_stat * b, const DCELL * values, const CELL * zones,
+	       size_t n);
+void merge_band_stat(univar_stat * stats, band_stat * b);
+int get_ranks(const univar_stat * stats, unsigned long *ranks);
+void set_quantiles(univar_stat * stats, const double *values);
+void sketch_quantiles(univar_stat * stats);
+
+/* quantiles.c */
+void begin_exact_quantiles(univar_stat * stats, double lo, double hi,
+			   int is_int);
+void bin_cells(const DCELL * values, const CELL * zones, size_t n);
+int next_exact_pass(univar_stat * stats);
+
+/* sketch.c */
+struct sketch *sketch_create(double error, unsigned int seed);
+void sketch_free(struct sketch *s);
+void sketch_update(struct sketch *s, DCELL value);
+void sketch_merge(struct sketch *s, const struct sketch *other);
+void sketch_ranks(struct sketch *s, unsigned long n,
+		  const unsigned long *ranks, double *values, int nranks);
 
 #endif
@@ -0,0 +1,450 @@
+/*
+ *  Exact percentiles in bounded memory
+ *
+ *   Copyright (C) 2026 by the GRASS Development Team
+ *
+ *      This program is free software under the GNU General Public
+ *      License (>=v2). Read the file COPYING that comes with GRASS
+ *      for details.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <grass/stats.h>
+#include "globals.h"
+
+/* The values of the ranks of the extended statistics are found by
+   histogram refinement over several passes over the cells.
+
+   The first pass counts the values of each zone in bins over the
+   range of the maps, the bins of integer maps are single values when
+   the range is small enough. It also collects the values while there
+   are few enough of them, the ranks are then selected from these.
+
+   Otherwise each rank lies in a bin whose count and smallest and
+   largest values are known. A bin with a single value gives the value
+   of the rank, the others are the targets of the next pass, in which
+   the values of a target are collected if there are few enough of
+   them, or counted again in finer bins between its smallest and
+   largest value. Each pass shrinks the targets, as the smallest and
+   largest value of a target fall into different bins.
+ */
+
+#define HIST_BINS (1 << 20)	/* bins of the histograms of a pass */
+#define MAX_BINS 65536		/* bins of a histogram */
+#define MIN_BINS 16
+#define COLLECT_CELLS (1 << 24)	/* values collected in a pass, the
+				   GRASS_UNIVAR_COLLECT_CELLS variable
+				   overrides it for testing the passes */
+
+struct target
+{
+    double lo, hi;		/* closed range of the values */
+    unsigned long below;	/* values of the zone below lo */
+    unsigned long count;	/* values in the range */
+    int all;			/* first pass, all values of the zone */
+    int collect;
+    DCELL *values;		/* collected values */
+    size_t n, alloc;
+    int nbins;			/* counts in bins otherwise */
+    int unit;			/* bins of width one from lo */
+    double scale;
+    unsigned long *counts;
+    double *min, *max;
+};
+
+struct zone_quant
+{
+    int nranks;
+    unsigned long *ranks;	/* in ascending order */
+    int *index;			/* position of the rank for set_quantiles() */
+    int *done;
+    double *values;
+    struct target *targets;
+    int ntargets;
+};
+
+static struct zone_quant *zq;
+static int n_zones;
+static int pass;
+static int collecting;		/* first pass, all values are collected */
+static size_t collected;
+static size_t collect_cells;
+
+static double half_width(double lo, double hi)
+{
+    return hi * 0.5 - lo * 0.5;
+}
+
+static void alloc_bins(struct target *t, int nbins)
+{
+    double width = half_width(t->lo, t->hi);
+
+    t->nbins = nbins;
+    t->scale = width > 0 && width <= DBL_MAX ? nbins / width : 0;
+    t->counts = G_calloc(nbins, sizeof(unsigned long));
+    t->min = G_malloc(nbins * sizeof(double));
+    t->max = G_malloc(nbins * sizeof(double));
+}
+
+static void free_target(struct target *t)
+{
+    if (t->values)
+	G_free(t->values);
+    if (t->nbins) {
+	G_free(t->counts);
+	G_free(t->min);
+	G_free(t->max);
+    }
+}
+
+static int bin_of(const struct target *t, DCELL v)
+{
+    double x = t->unit ? v - t->lo : (v * 0.5 - t->lo * 0.5) * t->scale;
+
+    if (!(x >= 0))
+	return 0;
+    if (x >= t->nbins)
+	return t->nbins - 1;
+    return (int)x;
+}
+
+/*!
+   \brief Prepare the first pass
+
+   \param stats statistics of the zones
+   \param lo,hi range of the maps
+   \param is_int all maps are integer maps
+ */
+void begin_exact_quantiles(univar_stat * stats, double lo, double hi,
+			   int is_int)
+{
+    const char *p;
+    int z, nbins;
+
+    n_zones = zone_info.n_zones;
+    if (n_zones == 0)
+	n_zones = 1;
+
+    nbins = HIST_BINS / n_zones;
+    if (nbins > MAX_BINS)
+	nbins = MAX_BINS;
+    if (nbins < MIN_BINS)
+	nbins = MIN_BINS;
+
+    zq = G_calloc(n_zones, sizeof(struct zone_quant));
+    for (z = 0; z < n_zones; z++) {
+	struct target *t = G_calloc(1, sizeof(struct target));
+
+	t->all = 1;
+	t->lo = lo;
+	t->hi = hi;
+	if (is_int && hi - lo < nbins) {
+	    t->unit = 1;
+	    alloc_bins(t, (int)(hi - lo) + 1);
+	}
+	else
+	    alloc_bins(t, nbins);
+
+	zq[z].targets = t;
+	zq[z].ntargets = 1;
+    }
+
+    pass = 0;
+    collecting = 1;
+    collected = 0;
+
+    collect_cells = COLLECT_CELLS;
+    if ((p = getenv("GRASS_UNIVAR_COLLECT_CELLS")) && *p && atol(p) >= 0)
+	collect_cells = atol(p);
+}
+
+static void stop_collecting(void)
+{
+    int z;
+
+    for (z = 0; z < n_zones; z++) {
+	struct target *t = &zq[z].targets[0];
+
+	G_free(t->values);
+	t->values = NULL;
+	t->n = t->alloc = 0;
+    }
+
+    collecting = 0;
+}
+
+/*!
+   \brief Count or collect cells in the targets of the pass
+
+   Called on the main thread for the cells of the maps in any order.
+
+   \param values values
+   \param zones zones of the cells, NULL without zones
+   \param n number of cells
+ */
+void bin_cells(const DCELL * values, const CELL * zones, size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	struct zone_quant *q;
+	struct target *t;
+	DCELL v = values[i];
+	int zone = 0, b;
+
+	if (zones) {
+	    if (Rast_is_c_null_value(&zones[i]))
+		continue;
+	    zone = zones[i] - zone_info.min;
+	}
+	if (Rast_is_d_null_value(&v))
+	    continue;
+
+	q = &zq[zone];
+	if (pass == 0)
+	    t = &q->targets[0];
+	else {
+	    int j;
+
+	    t = NULL;
+	    for (j = 0; j < q->ntargets; j++) {
+		if (v < q->targets[j].lo)
+		    break;
+		if (v <= q->targets[j].hi) {
+		    t = &q->targets[j];
+		    break;
+		}
+	    }
+	    if (!t)
+		continue;
+	}
+
+	if (pass == 0 && collecting) {
+	    if (collected++ == collect_cells)
+		stop_collecting();
+	    else {
+		if (t->n == t->alloc) {
+		    t->alloc = t->alloc ? 2 * t->alloc : 1024;
+		    t->values = G_realloc(t->values, t->alloc * sizeof(DCELL));
+		}
+		t->values[t->n++] = v;
+	    }
+	}
+
+	if (t->collect) {
+	    if (t->n < t->alloc)
+		t->values[t->n++] = v;
+	}
+	else {
+	    b = bin_of(t, v);
+	    if (t->counts[b]++ == 0)
+		t->min[b] = t->max[b] = v;
+	    else if (v < t->min[b])
+		t->min[b] = v;
+	    else if (v > t->max[b])
+		t->max[b] = v;
+	}
+    }
+}
+
+/* ranks of a zone in ascending order */
+static void init_ranks(struct zone_quant *q, const univar_stat * stats)
+{
+    unsigned long *ranks;
+    int i, j;
+
+    ranks = G_malloc((4 + stats->n_perc) * sizeof(unsigned long));
+    q->nranks = get_ranks(stats, ranks);
+
+    /* a few ranks, insertion sort */
+    q->index = G_malloc(q->nranks * sizeof(int));
+    for (i = 0; i < q->nranks; i++) {
+	for (j = i; j > 0 && ranks[q->index[j - 1]] > ranks[i]; j--)
+	    q->index[j] = q->index[j - 1];
+	q->index[j] = i;
+    }
+
+    q->ranks = G_malloc(q->nranks * sizeof(unsigned long));
+    for (i = 0; i < q->nranks; i++)
+	q->ranks[i] = ranks[q->index[i]];
+    q->done = G_calloc(q->nranks, sizeof(int));
+    q->values = G_malloc(q->nranks * sizeof(double));
+
+    G_free(ranks);
+}
+
+/* values of the ranks in collected values */
+static void select_ranks(struct zone_quant *q, struct target *t)
+{
+    int *sel = G_malloc(q->nranks * sizeof(int));
+    int i, m;
+
+    m = 0;
+    for (i = 0; i < q->nranks; i++) {
+	unsigned long r = q->ranks[i];
+
+	if (q->done[i] || r < t->below || r >= t->below + t->n)
+	    continue;
+	if (m == 0 || sel[m - 1] != (int)(r - t->below))
+	    sel[m++] = r - t->below;
+    }
+    select_cells(t->values, (int)t->n, sel, m);
+
+    for (i = 0; i < q->nranks; i++) {
+	unsigned long r = q->ranks[i];
+
+	if (q->done[i] || r < t->below || r >= t->below + t->n)
+	    continue;
+	q->values[q->index[i]] = t->values[r - t->below];
+	q->done[i] = 1;
+    }
+
+    G_free(sel);
+}
+
+/* bins of the ranks in counted values, as new targets */
+static void split_ranks(struct zone_quant *q, struct target *t,
+			struct target *next, int *nnext)
+{
+    unsigned long cum = t->below;
+    int i, b = 0, last = -1;
+
+    for (i = 0; i < q->nranks; i++) {
+	unsigned long r = q->ranks[i];
+
+	if (q->done[i] || r < t->below || r >= t->below + t->count)
+	    continue;
+
+	while (cum + t->counts[b] <= r)
+	    cum += t->counts[b++];
+
+	if (t->min[b] == t->max[b]) {
+	    q->values[q->index[i]] = t->min[b];
+	    q->done[i] = 1;
+	}
+	else if (b != last) {
+	    struct target *n = &next[(*nnext)++];
+
+	    memset(n, 0, sizeof(struct target));
+	    n->lo = t->min[b];
+	    n->hi = t->max[b];
+	    n->below = cum;
+	    n->count = t->counts[b];
+	    last = b;
+	}
+    }
+}
+
+/*!
+   \brief Resolve the ranks after a pass
+
+   \param stats statistics of the zones
+
+   \return 1 if another pass is needed, 0 when the extended statistics
+   are set
+ */
+int next_exact_pass(univar_stat * stats)
+{
+    int z, total, nbinned, nbins;
+    unsigned long limit;
+
+    total = 0;
+    for (z = 0; z < n_zones; z++) {
+	struct zone_quant *q = &zq[z];
+	struct target *next;
+	int i, nnext;
+
+	if (pass == 0) {
+	    if (stats[z].n == 0) {
+		free_target(&q->targets[0]);
+		q->ntargets = 0;
+		continue;
+	    }
+	    init_ranks(q, &stats[z]);
+	    q->targets[0].count = stats[z].n;
+	}
+
+	next = G_malloc(q->nranks * sizeof(struct target));
+	nnext = 0;
+	for (i = 0; i < q->ntargets; i++) {
+	    struct target *t = &q->targets[i];
+
+	    if (t->collect || (t->all && collecting))
+		select_ranks(q, t);
+	    else
+		split_ranks(q, t, next, &nnext);
+	    free_target(t);
+	}
+
+	G_free(q->targets);
+	q->targets = next;
+	q->ntargets = nnext;
+	total += nnext;
+    }
+
+    pass++;
+
+    if (total == 0) {
+	for (z = 0; z < n_zones; z++) {
+	    struct zone_quant *q = &zq[z];
+
+	    if (stats[z].n > 0) {
+		set_quantiles(&stats[z], q->values);
+		G_free(q->ranks);
+		G_free(q->index);
+		G_free(q->done);
+		G_free(q->values);
+	    }
+	    G_free(q->targets);
+	}
+	G_free(zq);
+
+	return 0;
+    }
+
+    /* collect the values of the small targets, count the others in
+       finer bins */
+    limit = collect_cells / total;
+    nbinned = 0;
+    for (z = 0; z < n_zones; z++) {
+	int i;
+
+	for (i = 0; i < zq[z].ntargets; i++) {
+	    struct target *t = &zq[z].targets[i];
+	    double width = half_width(t->lo, t->hi);
+
+	    t->collect = t->count <= limit || !(width > 0 && width <= DBL_MAX);
+	    if (!t->collect)
+		nbinned++;
+	}
+    }
+
+    nbins = nbinned ? HIST_BINS / nbinned : 0;
+    if (nbins > MAX_BINS)
+	nbins = MAX_BINS;
+    if (nbins < MIN_BINS)
+	nbins = MIN_BINS;
+
+    for (z = 0; z < n_zones; z++) {
+	int i;
+
+	for (i = 0; i < zq[z].ntargets; i++) {
+	    struct target *t = &zq[z].targets[i];
+
+	    if (t->collect) {
+		t->alloc = t->count;
+		t->values = G_malloc(t->alloc * sizeof(DCELL));
+	    }
+	    else
+		alloc_bins(t, nbins);
+	}
+    }
+
+    G_debug(1, "pass %d: %d targets, %d counted in bins", pass + 1, total,
+	    nbinned);
+
+    return 1;
+}
@@ -15,7 +15,6 @@
  *   This program is a replacement for the r.univar shell script
  */
 
-#include <assert.h>
 #include <string.h>
 #include "globals.h"
 
@@ -51,6 +50,18 @@ void set_params()
     param.percentile->description =
 	_("Percentile to calculate (requires extended statistics flag)");
     param.percentile->guisection = _("Extended");
+
+    param.error = G_define_option();
+    param.error->key = "error";
+    param.error->type = TYPE_DOUBLE;
+    param.error->required = NO;
+    param.error->label =
+	_("Rank error of approximate percentiles, relative to the number of cells");
+    param.error->description =
+	_("Percentiles are computed in one pass in bounded memory, exact if not given");
+    param.error->guisection = _("Extended");
+
+    param.nprocs = G_define_standard_option(G_OPT_M_NPROCS);
     
     param.separator = G_define_standard_option(G_OPT_F_SEP);
     param.separator->guisection = _("Formatting");
@@ -78,10 +89,37 @@ void set_params()
     return;
 }
 
+/* The cells are processed in bands of rows, which are read and
+   summarized on several threads. The statistics of the bands are
+   merged in the order of the bands, so the results do not depend on
+   the number of threads. */
+#define BAND_CELLS (1 << 20)
+
+struct band
+{
+    struct R_read_ctx *ctx, *zctx;	/* NULL: read through the descriptors */
+    int row, nrows;
+    DCELL *values;
+    CELL *zones;
+    band_stat stat;
+};
+
+struct pass
+{
+    struct band *bands;
+    int fd, fdz;
+    int first, rows;		/* rows of the pass and of a band */
+    int nrows, ncols;
+};
+
+static int pass;		/* passes over the maps for exact percentiles */
+static unsigned int num_bands;
+
 static int open_raster(const char *infile);
-static univar_stat *univar_stat_with_percentiles(int map_type);
+static univar_stat *univar_stat_with_percentiles(void);
+static void get_range(double *lo, double *hi, int *is_int);
 static void process_raster(univar_stat * stats, int fd, int fdz,
-			   const struct Cell_head *region);
+			   const struct Cell_head *region, int threads);
 
 /* *************************************************************** */
 /* **** the main functions for r.univar ************************** */
@@ -94,7 +132,8 @@ int main(int argc, char *argv[])
     struct GModule *module;
     univar_stat *stats;
     char **p, *z;
-    int fd, fdz, cell_type, min, max;
+    int fd, fdz, cell_type, min, max, threads;
+    int exact;
     struct Range zone_range;
     const char *mapset, *name;
 
@@ -123,6 +162,11 @@ int main(int argc, char *argv[])
     	G_fatal_error(_("zones option and region flag -r are mutually exclusive"));
     }
 
+    if (param.error->answer && atof(param.error->answer) <= 0)
+	G_fatal_error(_("The error must be positive"));
+
+    threads = G_set_num_threads(atoi(param.nprocs->answer));
+
     name = param.output_file->answer;
     if (name != NULL && strcmp(name, "-") != 0) {
 	if (NULL == freopen(name, "w", stdout)) {
@@ -165,48 +209,46 @@ int main(int argc, char *argv[])
 	 *p; p++, rasters++) ;
 
     /* process all input rasters */
-    int map_type = param.extended->answer ? -2 : -1;
+    stats = param.extended->answer ? univar_stat_with_percentiles()
+	: create_univar_stat_struct(0);
 
-    stats = ((map_type == -1)
-	     ? create_univar_stat_struct(-1, 0)
-	     : 0);
+    /* exact percentiles take more passes over the maps */
+    exact = param.extended->answer && !param.error->answer;
+    if (exact) {
+	double lo, hi;
+	int is_int;
 
-    for (p = param.inputfile->answers; *p; p++) {
+	get_range(&lo, &hi, &is_int);
+	begin_exact_quantiles(stats, lo, hi, is_int);
+    }
 
-	/* Check if the native extent and resolution
-	   of the input map should be used */
-	if(param.use_rast_region->answer) {
-    	    mapset = G_find_raster2(*p, "");
-	    Rast_get_cellhd(*p, mapset, &region);
-	    /* Set the computational region */
-	    Rast_set_window(&region);
-        } else {
-    	    G_get_window(&region);
-        }
-
-	fd = open_raster(*p);
-
-	if (map_type != -1) {
-	    /* NB: map_type must match when doing extended stats */
-	    int this_type = Rast_get_map_type(fd);
-
-	    assert(this_type > -1);
-	    if (map_type < -1) {
-		/* extended stats */
-		assert(stats == 0);
-		map_type = this_type;
-		stats = univar_stat_with_percentiles(map_type);
-	    }
-	    else if (this_type != map_type) {
-		G_fatal_error(_("Raster <%s> type mismatch"), *p);
+    pass = 0;
+    do {
+	for (p = param.inputfile->answers; *p; p++) {
+
+	    /* Check if the native extent and resolution
+	       of the input map should be used */
+	    if(param.use_rast_region->answer) {
+		mapset = G_find_raster2(*p, "");
+		Rast_get_cellhd(*p, mapset, &region);
+		/* Set the computational region */
+		Rast_set_window(&region);
+	    } else {
+		G_get_window(&region);
 	    }
-	}
 
-	process_raster(stats, fd, fdz, &region);
+	    fd = open_raster(*p);
 
-	/* close input raster */
-	Rast_close(fd);
-    }
+	    process_raster(stats, fd, fdz, &region, threads);
+
+	    /* close input raster */
+	    Rast_close(fd);
+	}
+	pass++;
+    } while (exact && next_exact_pass(stats));
+
+    if (param.extended->answer && param.error->answer)
+	sketch_quantiles(stats);
 
     /* close zoning raster */
     if (z)
@@ -239,7 +281,7 @@ static int open_raster(const char *infile)
     return fd;
 }
 
-static univar_stat *univar_stat_with_percentiles(int map_type)
+static univar_stat *univar_stat_with_percentiles(void)
 {
     univar_stat *stats;
     unsigned int i, j;
@@ -251,7 +293,7 @@ static univar_stat *univar_stat_with_percentiles(int map_type)
     i = 0;
     while (param.percentile->answers[i])
 	i++;
-    stats = create_univar_stat_struct(map_type, i);
+    stats = create_univar_stat_struct(i);
     for (i = 0; i < n_zones; i++) {
 	for (j = 0; j < stats[i].n_perc; j++) {
 	    sscanf(param.percentile->answers[j], "%lf", &(stats[i].perc[j]));
@@ -262,124 +304,146 @@ static univar_stat *univar_stat_with_percentiles(int map_type)
     return stats;
 }
 
-static void
-process_raster(univar_stat * stats, int fd, int fdz, const struct Cell_head *region)
+/* range of the input maps */
+static void get_range(double *lo, double *hi, int *is_int)
 {
-    /* use G_window_rows(), G_window_cols() here? */
-    const unsigned int rows = region->rows;
-    const unsigned int cols = region->cols;
-
-    const RASTER_MAP_TYPE map_type = Rast_get_map_type(fd);
-    const size_t value_sz = Rast_cell_size(map_type);
-    unsigned int row;
-    void *raster_row;
-    CELL *zoneraster_row = NULL;
-    int n_zones = zone_info.n_zones;
-    
-    raster_row = Rast_allocate_buf(map_type);
-    if (n_zones)
-	zoneraster_row = Rast_allocate_c_buf();
-
-    for (row = 0; row < rows; row++) {
-	void *ptr;
-	CELL *zptr = NULL;
-	unsigned int col;
-
-	Rast_get_row(fd, raster_row, row, map_type);
-	if (n_zones) {
-	    Rast_get_c_row(fdz, zoneraster_row, row);
-	    zptr = zoneraster_row;
-	}
+    char **p;
 
-	ptr = raster_row;
+    *lo = *hi = 0;
+    *is_int = 1;
 
-	for (col = 0; col < cols; col++) {
-	    double val;
-	    int zone = 0;
+    for (p = param.inputfile->answers; *p; p++) {
+	const char *mapset = G_find_raster2(*p, "");
+	struct FPRange range;
+	DCELL min, max;
+
+	if (Rast_read_fp_range(*p, mapset, &range) < 0)
+	    G_fatal_error(_("Unable to read range of raster map <%s>"), *p);
+	Rast_get_fp_range_min_max(&range, &min, &max);
+	if (Rast_is_d_null_value(&min))
+	    continue;
+
+	if (p == param.inputfile->answers || min < *lo)
+	    *lo = min;
+	if (p == param.inputfile->answers || max > *hi)
+	    *hi = max;
+	if (Rast_map_type(*p, mapset) != CELL_TYPE)
+	    *is_int = 0;
+    }
+}
 
-	    if (n_zones) {
-		/* skip NULL cells in zone map */
-		if (Rast_is_c_null_value(zptr)) {
-		    ptr = G_incr_void_ptr(ptr, value_sz);
-		    zptr++;
-		    continue;
-		}
-		zone = *zptr - zone_info.min;
-	    }
+static void read_bands(int first, int last, void *closure)
+{
+    const struct pass *p = closure;
+    int i, r;
 
-	    /* count all including NULL cells in input map */
-	    stats[zone].size++;
-	    
-	    /* can't do stats with NULL cells in input map */
-	    if (Rast_is_null_value(ptr, map_type)) {
-		ptr = G_incr_void_ptr(ptr, value_sz);
-		if (n_zones)
-		    zptr++;
-		continue;
-	    }
+    for (i = first; i < last; i++) {
+	struct band *b = &p->bands[i];
+	size_t n;
 
-	    if (param.extended->answer) {
-		/* check allocated memory */
-		if (stats[zone].n >= stats[zone].n_alloc) {
-		    stats[zone].n_alloc += 1000;
-		    size_t msize;
-		    switch (map_type) {
-			case DCELL_TYPE:
-			    msize = stats[zone].n_alloc * sizeof(DCELL);
-			    stats[zone].dcell_array =
-				(DCELL *)G_realloc((void *)stats[zone].dcell_array, msize);
-			    stats[zone].nextp = (void *)&(stats[zone].dcell_array[stats[zone].n]);
-			    break;
-			case FCELL_TYPE:
-			    msize = stats[zone].n_alloc * sizeof(FCELL);
-			    stats[zone].fcell_array =
-				(FCELL *)G_realloc((void *)stats[zone].fcell_array, msize);
-			    stats[zone].nextp = (void *)&(stats[zone].fcell_array[stats[zone].n]);
-			    break;
-			case CELL_TYPE:
-			    msize = stats[zone].n_alloc * sizeof(CELL);
-			    stats[zone].cell_array =
-				(CELL *)G_realloc((void *)stats[zone].cell_array, msize);
-			    stats[zone].nextp = (void *)&(stats[zone].cell_array[stats[zone].n]);
-			    break;
-			default:
-			    break;
-		    }
-		}
-		/* put the value into stats->XXXcell_array */
-		memcpy(stats[zone].nextp, ptr, value_sz);
-		stats[zone].nextp = G_incr_void_ptr(stats[zone].nextp, value_sz);
-	    }
+	b->row = p->first + i * p->rows;
+	b->nrows = p->nrows - b->row < p->rows ? p->nrows - b->row : p->rows;
 
-	    val = ((map_type == DCELL_TYPE) ? *((DCELL *) ptr)
-			  : (map_type == FCELL_TYPE) ? *((FCELL *) ptr)
-			  : *((CELL *) ptr));
+	for (r = 0; r < b->nrows; r++) {
+	    DCELL *values = b->values + (size_t) r * p->ncols;
+	    CELL *zones = b->zones + (size_t) r * p->ncols;
 
-	    stats[zone].sum += val;
-	    stats[zone].sumsq += val * val;
-	    stats[zone].sum_abs += fabs(val);
+	    if (b->ctx)
+		Rast_get_row_ctx(b->ctx, values, b->row + r, DCELL_TYPE);
+	    else
+		Rast_get_d_row(p->fd, values, b->row + r);
+	    if (p->fdz < 0)
+		continue;
+	    if (b->zctx)
+		Rast_get_row_ctx(b->zctx, zones, b->row + r, CELL_TYPE);
+	    else
+		Rast_get_c_row(p->fdz, zones, b->row + r);
+	}
 
-	    if (stats[zone].first) {
-		stats[zone].max = val;
-		stats[zone].min = val;
-		stats[zone].first = FALSE;
-	    }
-	    else {
-		if (val > stats[zone].max)
-		    stats[zone].max = val;
-		if (val < stats[zone].min)
-		    stats[zone].min = val;
-	    }
+	/* the moments are known after the first pass */
+	n = (size_t) b->nrows * p->ncols;
+	if (pass == 0)
+	    add_cells(&b->stat, b->values, p->fdz < 0 ? NULL : b->zones, n);
+    }
+}
 
-	    ptr = G_incr_void_ptr(ptr, value_sz);
-	    if (n_zones)
-		zptr++;
-	    stats[zone].n++;
+static void
+process_raster(univar_stat * stats, int fd, int fdz, const struct Cell_head *region,
+	       int threads)
+{
+    struct pass p;
+    int i, nbands;
+
+    p.fd = fd;
+    p.fdz = fdz;
+    p.nrows = region->rows;
+    p.ncols = region->cols;
+
+    p.rows = BAND_CELLS / p.ncols;
+    if (p.rows < 1)
+	p.rows = 1;
+    if (p.rows > p.nrows)
+	p.rows = p.nrows;
+
+    nbands = (p.nrows + p.rows - 1) / p.rows;
+    if (nbands > threads)
+	nbands = threads;
+
+    p.bands = G_malloc(nbands * sizeof(struct band));
+    for (i = 0; i < nbands; i++) {
+	struct band *b = &p.bands[i];
+
+	b->ctx = b->zctx = NULL;
+	if (nbands > 1) {
+	    b->ctx = Rast_create_read_ctx(fd);
+	    if (fdz >= 0)
+		b->zctx = Rast_create_read_ctx(fdz);
 	}
+	b->values = G_malloc((size_t) p.rows * p.ncols * sizeof(DCELL));
+	b->zones = fdz < 0 ? NULL
+	    : G_malloc((size_t) p.rows * p.ncols * sizeof(CELL));
+	init_band_stat(&b->stat, 0);
+    }
+
+    for (p.first = 0; p.first < p.nrows; p.first += nbands * p.rows) {
+	int n = (p.nrows - p.first + p.rows - 1) / p.rows;
+
+	if (n > nbands)
+	    n = nbands;
+
 	if (!(param.shell_style->answer))
-	    G_percent(row, rows, 2);
+	    G_percent(p.first, p.nrows, 2);
+
+	/* each band has its own seed for the sketches */
+	for (i = 0; i < n; i++)
+	    p.bands[i].stat.seed = num_bands++;
+
+	G_parallel_for(0, n, 1, read_bands, &p);
+
+	for (i = 0; i < n; i++) {
+	    struct band *b = &p.bands[i];
+	    const CELL *zones = fdz < 0 ? NULL : b->zones;
+
+	    if (pass == 0)
+		merge_band_stat(stats, &b->stat);
+	    if (param.extended->answer && !param.error->answer)
+		bin_cells(b->values, zones, (size_t) b->nrows * p.ncols);
+	}
     }
     if (!(param.shell_style->answer))
-	G_percent(rows, rows, 2);	/* finish it off */
-
+	G_percent(p.nrows, p.nrows, 2);	/* finish it off */
+
+    for (i = 0; i < nbands; i++) {
+	struct band *b = &p.bands[i];
+
+	if (b->ctx)
+	    Rast_free_read_ctx(b->ctx);
+	if (b->zctx)
+	    Rast_free_read_ctx(b->zctx);
+	G_free(b->values);
+	if (b->zones)
+	    G_free(b->zones);
+	free_band_stat(&b->stat);
+    }
+    G_free(p.bands);
 }
@@ -51,6 +51,17 @@ void set_params()
     param.percentile->description =
 	_("Percentile to calculate (requires extended statistics flag)");
 
+    param.error = G_define_option();
+    param.error->key = "error";
+    param.error->type = TYPE_DOUBLE;
+    param.error->required = NO;
+    param.error->label =
+	_("Rank error of approximate percentiles, relative to the number of cells");
+    param.error->description =
+	_("Percentiles are computed in one pass in bounded memory, exact if not given");
+
+    param.nprocs = G_define_standard_option(G_OPT_M_NPROCS);
+
     param.separator = G_define_standard_option(G_OPT_F_SEP);
 
     param.shell_style = G_define_flag();
@@ -69,25 +80,191 @@ void set_params()
     return;
 }
 
+/* The cells are read by slabs of one row of tiles of the input map, as
+   the raster3d library is not thread safe the slabs are read on the
+   main thread and summarized on several threads. The statistics of the
+   slabs are merged in the order of the slabs, so the results do not
+   depend on the number of threads. */
+struct band
+{
+    int depth, row;		/* first depth and row of the slab */
+    int ndepths, nrows;
+    DCELL *values;
+    CELL *zones;
+    band_stat stat;
+};
+
+static RASTER3D_Region region;
+static void *map, *zmap;
+static int map_resample, zmap_resample;
+static int tile_y, tile_z;
+static int pass;		/* passes over the map for exact percentiles */
+
+static int same_region(const RASTER3D_Region * a, const RASTER3D_Region * b)
+{
+    return a->north == b->north && a->south == b->south &&
+	a->east == b->east && a->west == b->west &&
+	a->top == b->top && a->bottom == b->bottom &&
+	a->rows == b->rows && a->cols == b->cols && a->depths == b->depths;
+}
+
+/* maps in the current region are read by blocks of tiles, the others
+   are resampled voxel by voxel through the tile cache */
+static void *open_map(const char *name, int *resample)
+{
+    const char *mapset = G_find_raster3d(name, "");
+    RASTER3D_Region map_region;
+    void *handle;
+
+    if (mapset == NULL)
+	Rast3d_fatal_error(_("3D raster map <%s> not found"), name);
+
+    if (!Rast3d_read_region_map(name, mapset, &map_region))
+	Rast3d_fatal_error(_("Unable to read header of 3D raster map <%s>"),
+			   name);
+    *resample = !same_region(&map_region, &region);
+
+    handle = Rast3d_open_cell_old(name, mapset, &region,
+				  RASTER3D_TILE_SAME_AS_FILE,
+				  *resample ? RASTER3D_USE_CACHE_DEFAULT :
+				  RASTER3D_NO_CACHE);
+    if (handle == NULL)
+	Rast3d_fatal_error(_("Unable to open 3D raster map <%s>"), name);
+
+    return handle;
+}
+
+static void read_block(void *handle, int resample, const struct band *b,
+		       DCELL * buf)
+{
+    if (resample) {
+	DCELL *p = buf;
+	int x, y, z;
+
+	for (z = b->depth; z < b->depth + b->ndepths; z++)
+	    for (y = b->row; y < b->row + b->nrows; y++)
+		for (x = 0; x < region.cols; x++)
+		    Rast3d_get_value(handle, x, y, z, p++, DCELL_TYPE);
+    }
+    else
+	Rast3d_get_block(handle, 0, b->row, b->depth, region.cols, b->nrows,
+			 b->ndepths, buf, DCELL_TYPE);
+}
+
+static void read_band(struct band *b, DCELL * zbuf)
+{
+    size_t i, n = (size_t) b->ndepths * b->nrows * region.cols;
+
+    read_block(map, map_resample, b, b->values);
+    if (!zmap)
+	return;
+
+    /* zones are the rounded values */
+    read_block(zmap, zmap_resample, b, zbuf);
+    for (i = 0; i < n; i++) {
+	if (Rast_is_d_null_value(&zbuf[i]))
+	    Rast_set_c_null_value(&b->zones[i], 1);
+	else if (zbuf[i] < 0)
+	    b->zones[i] = zbuf[i] - 0.5;
+	else
+	    b->zones[i] = zbuf[i] + 0.5;
+    }
+}
+
+static void sum_bands(int first, int last, void *closure)
+{
+    struct band *bands = closure;
+    int i;
+
+    for (i = first; i < last; i++) {
+	struct band *b = &bands[i];
+
+	add_cells(&b->stat, b->values, zmap ? b->zones : NULL,
+		  (size_t) b->ndepths * b->nrows * region.cols);
+    }
+}
+
+static void process_map(univar_stat * stats, int threads)
+{
+    struct band *bands;
+    DCELL *zbuf = NULL;
+    size_t size = (size_t) tile_z * tile_y * region.cols;
+    int nslabs, slab, i;
+
+    bands = G_malloc(threads * sizeof(struct band));
+    for (i = 0; i < threads; i++) {
+	bands[i].values = G_malloc(size * sizeof(DCELL));
+	bands[i].zones = zmap ? G_malloc(size * sizeof(CELL)) : NULL;
+	init_band_stat(&bands[i].stat, 0);
+    }
+    if (zmap)
+	zbuf = G_malloc(size * sizeof(DCELL));
+
+    /* the slabs are numbered by layers of tiles from the bottom */
+    nslabs = ((region.depths + tile_z - 1) / tile_z) *
+	((region.rows + tile_y - 1) / tile_y);
+
+    for (slab = 0; slab < nslabs; slab += threads) {
+	int n = nslabs - slab < threads ? nslabs - slab : threads;
+
+	if (!(param.shell_style->answer))
+	    G_percent(slab, nslabs, 2);
+
+	for (i = 0; i < n; i++) {
+	    struct band *b = &bands[i];
+	    int row_slabs = (region.rows + tile_y - 1) / tile_y;
+
+	    b->depth = (slab + i) / row_slabs * tile_z;
+	    b->row = (slab + i) % row_slabs * tile_y;
+	    b->ndepths = region.depths - b->depth < tile_z ?
+		region.depths - b->depth : tile_z;
+	    b->nrows = region.rows - b->row < tile_y ?
+		region.rows - b->row : tile_y;
+	    b->stat.seed = slab + i;
+
+	    read_band(b, zbuf);
+	}
+
+	/* the moments are known after the first pass */
+	if (pass == 0)
+	    G_parallel_for(0, n, 1, sum_bands, bands);
+
+	for (i = 0; i < n; i++) {
+	    struct band *b = &bands[i];
+
+	    if (pass == 0)
+		merge_band_stat(stats, &b->stat);
+	    if (param.extended->answer && !param.error->answer)
+		bin_cells(b->values, zmap ? b->zones : NULL,
+			  (size_t) b->ndepths * b->nrows * region.cols);
+	}
+    }
+    if (!(param.shell_style->answer))
+	G_percent(nslabs, nslabs, 2);
+
+    for (i = 0; i < threads; i++) {
+	G_free(bands[i].values);
+	if (bands[i].zones)
+	    G_free(bands[i].zones);
+	free_band_stat(&bands[i].stat);
+    }
+    G_free(bands);
+    if (zbuf)
+	G_free(zbuf);
+}
+
 
 /* *************************************************************** */
 /* **** the main functions for r3.univar ************************* */
 /* *************************************************************** */
 int main(int argc, char *argv[])
 {
-    FCELL val_f;		/* for misc use */
-    DCELL val_d;		/* for misc use */
-    int map_type, zmap_type;
     univar_stat *stats;
 
-    char *infile, *zonemap;
-    void *map, *zmap = NULL;
-    RASTER3D_Region region;
+    char *zonemap;
     unsigned int i;
-    unsigned int rows, cols, depths;
-    unsigned int x, y, z;
     double dmin, dmax;
-    int zone, n_zones, use_zone = 0;
+    int n_zones, threads, tile_x, exact;
     const char *mapset, *name;
 
     struct GModule *module;
@@ -112,16 +289,17 @@ int main(int argc, char *argv[])
     if (G_parser(argc, argv))
 	exit(EXIT_FAILURE);
 
+    if (param.error->answer && atof(param.error->answer) <= 0)
+	G_fatal_error(_("The error must be positive"));
+
+    threads = G_set_num_threads(atoi(param.nprocs->answer));
+
     /* Set the defaults */
     Rast3d_init_defaults();
 
     /* get the current region */
     Rast3d_get_window(&region);
 
-    cols = region.cols;
-    rows = region.rows;
-    depths = region.depths;
-
     name = param.output_file->answer;
     if (name != NULL && strcmp(name, "-") != 0) {
 	if (NULL == freopen(name, "w", stdout)) {
@@ -140,18 +318,9 @@ int main(int argc, char *argv[])
 
     /* open 3D zoning raster with default region */
     if ((zonemap = param.zonefile->answer) != NULL) {
-	if (NULL == (mapset = G_find_raster3d(zonemap, "")))
-	    Rast3d_fatal_error(_("3D raster map <%s> not found"), zonemap);
-
-	zmap =
-	    Rast3d_open_cell_old(zonemap, G_find_raster3d(zonemap, ""), &region,
-			    RASTER3D_TILE_SAME_AS_FILE, RASTER3D_USE_CACHE_DEFAULT);
+	mapset = G_find_raster3d(zonemap, "");
+	zmap = open_map(zonemap, &zmap_resample);
 
-	if (zmap == NULL)
-	    Rast3d_fatal_error(_("Unable to open 3D raster map <%s>"), zonemap);
-
-	zmap_type = Rast3d_tile_type_map(zmap);
-	
 	if (Rast3d_read_cats(zonemap, mapset, &(zone_info.cats)))
 	    G_warning("No category support for zoning raster");
 	    
@@ -171,24 +340,11 @@ int main(int argc, char *argv[])
 
 	G_debug(1, "min: %d, max: %d", zone_info.min, zone_info.max);
 	zone_info.n_zones = zone_info.max - zone_info.min + 1;
-
-	use_zone = 1;
     }
 
     /* Open 3D input raster with default region */
-    infile = param.inputfile->answer;
-
-    if (NULL == G_find_raster3d(infile, ""))
-	Rast3d_fatal_error(_("3D raster map <%s> not found"), infile);
-
-    map =
-	Rast3d_open_cell_old(infile, G_find_raster3d(infile, ""), &region,
-			RASTER3D_TILE_SAME_AS_FILE, RASTER3D_USE_CACHE_DEFAULT);
-
-    if (map == NULL)
-	Rast3d_fatal_error(_("Unable to open 3D raster map <%s>"), infile);
-
-    map_type = Rast3d_tile_type_map(map);
+    map = open_map(param.inputfile->answer, &map_resample);
+    Rast3d_get_tile_dimensions_map(map, &tile_x, &tile_y, &tile_z);
 
     i = 0;
     while (param.percentile->answers[i])
@@ -199,7 +355,7 @@ int main(int argc, char *argv[])
     if (n_zones == 0)
         n_zones = 1;
 
-    stats = create_univar_stat_struct(map_type, i);
+    stats = create_univar_stat_struct(i);
     for (i = 0; i < n_zones; i++) {
 	unsigned int j;
 	for (j = 0; j < stats[i].n_perc; j++) {
@@ -207,105 +363,24 @@ int main(int argc, char *argv[])
 	}
     }
 
-    for (z = 0; z < depths; z++) {	/* From the bottom to the top */
-	if (!(param.shell_style->answer))
-	    G_percent(z, depths - 1, 2);
-	for (y = 0; y < rows; y++) {
-	    for (x = 0; x < cols; x++) {
-		zone = 0;
-		if (zone_info.n_zones) {
-		    if (zmap_type == FCELL_TYPE) {
-			Rast3d_get_value(zmap, x, y, z, &val_f, FCELL_TYPE);
-			if (Rast3d_is_null_value_num(&val_f, FCELL_TYPE))
-			    continue;
-			if (val_f < 0)
-			    zone = val_f - 0.5;
-			else
-			    zone = val_f + 0.5;
-		    }
-		    else if (zmap_type == DCELL_TYPE) {
-			Rast3d_get_value(zmap, x, y, z, &val_d, DCELL_TYPE);
-			if (Rast3d_is_null_value_num(&val_d, DCELL_TYPE))
-			    continue;
-			if (val_d < 0)
-			    zone = val_d - 0.5;
-			else
-			    zone = val_d + 0.5;
-		    }
-                    zone -= zone_info.min;
-                }
-		if (map_type == FCELL_TYPE) {
-		    Rast3d_get_value(map, x, y, z, &val_f, map_type);
-		    if (!Rast3d_is_null_value_num(&val_f, map_type)) {
-			if (param.extended->answer) {
-			    if (stats[zone].n >= stats[zone].n_alloc) {
-				size_t msize;
-				stats[zone].n_alloc += 1000;
-				msize = stats[zone].n_alloc * sizeof(FCELL);
-				stats[zone].fcell_array =
-				    (FCELL *)G_realloc((void *)stats[zone].fcell_array, msize);
-			    }
-
-			    stats[zone].fcell_array[stats[zone].n] = val_f;
-			}
-
-			stats[zone].sum += val_f;
-			stats[zone].sumsq += (val_f * val_f);
-			stats[zone].sum_abs += fabs(val_f);
-
-			if (stats[zone].first) {
-			    stats[zone].max = val_f;
-			    stats[zone].min = val_f;
-			    stats[zone].first = FALSE;
-			}
-			else {
-			    if (val_f > stats[zone].max)
-				stats[zone].max = val_f;
-			    if (val_f < stats[zone].min)
-				stats[zone].min = val_f;
-			}
-			stats[zone].n++;
-		    }
-		    stats[zone].size++;
-		}
-		else if (map_type == DCELL_TYPE) {
-		    Rast3d_get_value(map, x, y, z, &val_d, map_type);
-		    if (!Rast3d_is_null_value_num(&val_d, map_type)) {
-			if (param.extended->answer) {
-			    if (stats[zone].n >= stats[zone].n_alloc) {
-				size_t msize;
-				stats[zone].n_alloc += 1000;
-				msize = stats[zone].n_alloc * sizeof(DCELL);
-				stats[zone].dcell_array =
-				    (DCELL *)G_realloc((void *)stats[zone].dcell_array, msize);
-				}
-
-			    stats[zone].dcell_array[stats[zone].n] = val_d;
-			}
-
-			stats[zone].sum += val_d;
-			stats[zone].sumsq += val_d * val_d;
-			stats[zone].sum_abs += fabs(val_d);
-
-			if (stats[zone].first) {
-			    stats[zone].max = val_d;
-			    stats[zone].min = val_d;
-			    stats[zone].first = FALSE;
-			}
-			else {
-			    if (val_d > stats[zone].max)
-				stats[zone].max = val_d;
-			    if (val_d < stats[zone].min)
-				stats[zone].min = val_d;
-			}
-			stats[zone].n++;
-		    }
-		    stats[zone].size++;
-		}
-	    }
-	}
+    /* exact percentiles take more passes over the map */
+    exact = param.extended->answer && !param.error->answer;
+    if (exact) {
+	Rast3d_range_init(map);
+	Rast3d_range_load(map);
+	Rast3d_range_min_max(map, &dmin, &dmax);
+	begin_exact_quantiles(stats, dmin, dmax, 0);
     }
 
+    pass = 0;
+    do {
+	process_map(stats, threads);
+	pass++;
+    } while (exact && next_exact_pass(stats));
+
+    if (param.extended->answer && param.error->answer)
+	sketch_quantiles(stats);
+
     /* close maps */
     Rast3d_close(map);
     if (zone_info.n_zones)
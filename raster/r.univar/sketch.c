@@ -0,0 +1,334 @@
+/*
+ *  Approximate percentiles in bounded memory
+ *
+ *   Copyright (C) 2026 by the GRASS Development Team
+ *
+ *      This program is free software under the GNU General Public
+ *      License (>=v2). Read the file COPYING that comes with GRASS
+ *      for details.
+ *
+ */
+
+#include <string.h>
+#include <math.h>
+#include "globals.h"
+
+/* KLL sketch (Karnin, Lang and Liberty, 2016)
+
+   The values are kept in levels of compactors, a value of level h
+   standing for 2^h values of the input. When a level is full it is
+   sorted and every second value, starting at the first or the second
+   one at random, moves up a level. The capacities of the levels shrink
+   by 2/3 from the top down, so the sketch keeps about 3k values and
+   the rank of a value is known within about n/k with high probability.
+
+   The levels above the first are kept sorted, the values moved up are
+   merged into them. Sketches of parts of the input are merged by
+   merging the levels and compacting again. The random choices come from a seeded
+   generator, so the results only depend on the order of the merges.
+ */
+
+struct level
+{
+    DCELL *items;
+    int n, alloc;
+};
+
+struct sketch
+{
+    int k;			/* capacity of the top level */
+    int levels;
+    struct level *level;
+    int size, max_size;		/* values in the levels, capacity */
+    unsigned int seed;
+};
+
+struct item
+{
+    DCELL value;
+    unsigned long weight;
+};
+
+#define MIN_WIDTH 8		/* smallest capacity of a level */
+
+static int capacity(const struct sketch *s, int h)
+{
+    int c = (int)ceil(s->k * pow(2.0 / 3.0, s->levels - 1 - h));
+
+    return c > MIN_WIDTH ? c : MIN_WIDTH;
+}
+
+static void grow(struct sketch *s)
+{
+    int h;
+
+    s->level = G_realloc(s->level, (s->levels + 1) * sizeof(struct level));
+    s->level[s->levels].items = NULL;
+    s->level[s->levels].n = s->level[s->levels].alloc = 0;
+    s->levels++;
+
+    s->max_size = 0;
+    for (h = 0; h < s->levels; h++)
+	s->max_size += capacity(s, h);
+}
+
+static void reserve(struct level *l, int n)
+{
+    if (l->n + n > l->alloc) {
+	l->alloc = l->n + n > 2 * l->alloc ? l->n + n : 2 * l->alloc;
+	if (l->alloc < 16)
+	    l->alloc = 16;
+	l->items = G_realloc(l->items, l->alloc * sizeof(DCELL));
+    }
+}
+
+static void append(struct level *l, const DCELL * items, int n)
+{
+    reserve(l, n);
+    memcpy(l->items + l->n, items, n * sizeof(DCELL));
+    l->n += n;
+}
+
+/* merge sorted values into a sorted level, from the end */
+static void merge(struct level *l, const DCELL * items, int n)
+{
+    int i, j, k;
+
+    reserve(l, n);
+    i = l->n - 1;
+    j = n - 1;
+    k = l->n + n - 1;
+    while (j >= 0) {
+	if (i >= 0 && l->items[i] > items[j])
+	    l->items[k--] = l->items[i--];
+	else
+	    l->items[k--] = items[j--];
+    }
+    l->n += n;
+}
+
+/* quicksort without the calls of qsort(), the first level holds many
+   values when the error is small */
+static void sort_values(DCELL * items, int n)
+{
+    while (n > 16) {
+	DCELL a = items[0], b = items[n / 2], c = items[n - 1];
+	DCELL pivot = a < b ? (b < c ? b : (a < c ? c : a))
+	    : (a < c ? a : (b < c ? c : b));
+	int i = 0, j = n - 1;
+
+	while (i <= j) {
+	    while (items[i] < pivot)
+		i++;
+	    while (items[j] > pivot)
+		j--;
+	    if (i <= j) {
+		DCELL t = items[i];
+
+		items[i++] = items[j];
+		items[j--] = t;
+	    }
+	}
+
+	/* recurse into the smaller part */
+	if (j + 1 < n - i) {
+	    sort_values(items, j + 1);
+	    items += i;
+	    n -= i;
+	}
+	else {
+	    sort_values(items + i, n - i);
+	    n = j + 1;
+	}
+    }
+
+    {
+	int i, j;
+
+	for (i = 1; i < n; i++) {
+	    DCELL v = items[i];
+
+	    for (j = i; j > 0 && items[j - 1] > v; j--)
+		items[j] = items[j - 1];
+	    items[j] = v;
+	}
+    }
+}
+
+static int item_ascending(const void *aa, const void *bb)
+{
+    const struct item *a = aa, *b = bb;
+
+    if (a->value < b->value)
+	return -1;
+    return (a->value > b->value);
+}
+
+static unsigned int next_random(struct sketch *s)
+{
+    s->seed ^= s->seed << 13;
+    s->seed ^= s->seed >> 17;
+    s->seed ^= s->seed << 5;
+
+    return s->seed;
+}
+
+/* move every second value of level h up, keep an odd one */
+static void compact(struct sketch *s, int h)
+{
+    struct level *l;
+    int offset, i, m;
+
+    if (h + 1 == s->levels)
+	grow(s);
+    l = &s->level[h];
+
+    if (h == 0)
+	sort_values(l->items, l->n);
+    offset = next_random(s) & 1;
+    m = l->n & ~1;
+    for (i = 0; i < m / 2; i++)
+	l->items[i] = l->items[2 * i + offset];
+    merge(&s->level[h + 1], l->items, m / 2);
+
+    if (l->n & 1)
+	l->items[0] = l->items[l->n - 1];
+    l->n &= 1;
+
+    s->size -= m / 2;
+}
+
+static void compress(struct sketch *s)
+{
+    while (s->size >= s->max_size) {
+	int h;
+
+	for (h = 0; h < s->levels; h++)
+	    if (s->level[h].n >= capacity(s, h))
+		break;
+	compact(s, h);
+    }
+}
+
+/*!
+   \brief Create a sketch
+
+   \param error rank error relative to the number of values
+   \param seed seed of the random choices
+
+   \return sketch
+ */
+struct sketch *sketch_create(double error, unsigned int seed)
+{
+    struct sketch *s = G_malloc(sizeof(struct sketch));
+
+    s->k = (int)ceil(3.0 / error);
+    if (s->k < 8)
+	s->k = 8;
+    s->levels = 0;
+    s->level = NULL;
+    s->size = 0;
+    s->seed = seed * 2654435761U | 1;
+    grow(s);
+
+    return s;
+}
+
+void sketch_free(struct sketch *s)
+{
+    int h;
+
+    for (h = 0; h < s->levels; h++)
+	G_free(s->level[h].items);
+    G_free(s->level);
+    G_free(s);
+}
+
+void sketch_update(struct sketch *s, DCELL value)
+{
+    struct level *l = &s->level[0];
+
+    if (l->n == l->alloc)
+	reserve(l, 1);
+    l->items[l->n++] = value;
+    s->size++;
+    if (s->size >= s->max_size)
+	compress(s);
+}
+
+/*!
+   \brief Add the values of another sketch of the same error
+ */
+void sketch_merge(struct sketch *s, const struct sketch *other)
+{
+    int h;
+
+    while (s->levels < other->levels)
+	grow(s);
+
+    for (h = 0; h < other->levels; h++) {
+	if (h == 0)
+	    append(&s->level[h], other->level[h].items, other->level[h].n);
+	else
+	    merge(&s->level[h], other->level[h].items, other->level[h].n);
+	s->size += other->level[h].n;
+    }
+
+    compress(s);
+}
+
+/*!
+   \brief Approximate values of the given ranks
+
+   \param s sketch
+   \param n number of values added to the sketch
+   \param ranks ranks between 0 and n - 1
+   \param[out] values values of the ranks
+   \param nranks number of ranks
+ */
+void sketch_ranks(struct sketch *s, unsigned long n,
+		  const unsigned long *ranks, double *values, int nranks)
+{
+    struct item *items;
+    unsigned long *cum, total;
+    int h, i, m;
+
+    items = G_malloc(s->size * sizeof(struct item));
+    cum = G_malloc(s->size * sizeof(unsigned long));
+
+    m = 0;
+    for (h = 0; h < s->levels; h++) {
+	for (i = 0; i < s->level[h].n; i++) {
+	    items[m].value = s->level[h].items[i];
+	    items[m].weight = 1UL << h;
+	    m++;
+	}
+    }
+    qsort(items, m, sizeof(struct item), item_ascending);
+
+    total = 0;
+    for (i = 0; i < m; i++) {
+	total += items[i].weight;
+	cum[i] = total;
+    }
+
+    /* first value whose cumulated weight exceeds the rank, scaled
+       to the total weight */
+    for (i = 0; i < nranks; i++) {
+	double target = (double)ranks[i] * total / n;
+	int lo = 0, hi = m - 1;
+
+	while (lo < hi) {
+	    int mid = (lo + hi) / 2;
+
+	    if (cum[mid] > target)
+		hi = mid;
+	    else
+		lo = mid + 1;
+	}
+	values[i] = m > 0 ? items[lo].value : 0.0 / 0.0;
+    }
+
+    G_free(items);
+    G_free(cum);
+}
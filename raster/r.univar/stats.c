@@ -11,12 +11,13 @@
  *
  */
 
+#include <string.h>
 #include "globals.h"
 
 /* *************************************************************** */
 /* **** univar_stat constructor ********************************** */
 /* *************************************************************** */
-univar_stat *create_univar_stat_struct(int map_type, int n_perc)
+univar_stat *create_univar_stat_struct(int n_perc)
 {
     univar_stat *stats;
     int i;
@@ -28,43 +29,34 @@ univar_stat *create_univar_stat_struct(int map_type, int n_perc)
     stats = (univar_stat *) G_calloc(n_zones, sizeof(univar_stat));
 
     for (i = 0; i < n_zones; i++) {
-	stats[i].sum = 0.0;
-	stats[i].sumsq = 0.0;
+	int j;
+
+	stats[i].sum = stats[i].sum_c = 0.0;
+	stats[i].sum_abs = stats[i].sum_abs_c = 0.0;
+	stats[i].mean = stats[i].m2 = 0.0;
 	stats[i].min = 0.0 / 0.0;	/* set to nan as default */
 	stats[i].max = 0.0 / 0.0;	/* set to nan as default */
 	stats[i].n_perc = n_perc;
-	if (n_perc > 0)
+	if (n_perc > 0) {
 	    stats[i].perc = (double *)G_malloc(n_perc * sizeof(double));
-	else
+	    stats[i].quartile_perc =
+		(double *)G_malloc(n_perc * sizeof(double));
+	}
+	else {
 	    stats[i].perc = NULL;
-	stats[i].sum_abs = 0.0;
+	    stats[i].quartile_perc = NULL;
+	}
 	stats[i].n = 0;
 	stats[i].size = 0;
-	stats[i].dcell_array = NULL;
-	stats[i].fcell_array = NULL;
-	stats[i].cell_array = NULL;
-	stats[i].map_type = map_type;
-
-	stats[i].n_alloc = 0;
 
 	stats[i].first = TRUE;
 
-	/* allocate memory for extended computation */
-	/* changed to on-demand block allocation */
-
-/*	if (param.extended->answer) {
-	    if (map_type == DCELL_TYPE) {
-		stats[i].dcell_array = NULL;
-	    }
-	    else if (map_type == FCELL_TYPE) {
-		stats[i].fcell_array =NULL;
-	    }
-	    else if (map_type == CELL_TYPE) {
-		stats[i].cell_array = NULL;
-	    }
-	}
-*/
-
+	/* extended statistics are set once all cells are seen */
+	stats[i].quartile_25 = stats[i].median = stats[i].quartile_75 =
+	    0.0 / 0.0;
+	for (j = 0; j < n_perc; j++)
+	    stats[i].quartile_perc[j] = 0.0 / 0.0;
+	stats[i].sketch = NULL;
     }
 
     return stats;
@@ -85,12 +77,10 @@ void free_univar_stat_struct(univar_stat * stats)
     for (i = 0; i < n_zones; i++){
 	if (stats[i].perc)
 	    G_free(stats[i].perc);
-	if (stats[i].dcell_array)
-	    G_free(stats[i].dcell_array);
-	if (stats[i].fcell_array)
-	    G_free(stats[i].fcell_array);
-	if (stats[i].cell_array)
-	    G_free(stats[i].cell_array);
+	if (stats[i].quartile_perc)
+	    G_free(stats[i].quartile_perc);
+	if (stats[i].sketch)
+	    sketch_free(stats[i].sketch);
     }
 
     G_free(stats);
@@ -99,6 +89,290 @@ void free_univar_stat_struct(univar_stat * stats)
 }
 
 
+/* *************************************************************** */
+/* **** statistics of bands of cells ***************************** */
+/* *************************************************************** */
+
+/* Kahan-Babuska summation */
+static void add_compensated(double *sum, double *c, double x)
+{
+    double t = *sum + x;
+
+    if (fabs(*sum) >= fabs(x))
+	*c += (*sum - t) + x;
+    else
+	*c += (x - t) + *sum;
+    *sum = t;
+}
+
+void init_band_stat(band_stat * b, unsigned int seed)
+{
+    int n_zones = zone_info.n_zones;
+
+    if (n_zones == 0)
+	n_zones = 1;
+
+    b->mom = G_calloc(n_zones, sizeof(struct moments));
+    b->touched = G_malloc(n_zones * sizeof(int));
+    b->n_touched = 0;
+    b->sketch = NULL;
+    if (param.extended->answer && param.error->answer)
+	b->sketch = G_calloc(n_zones, sizeof(struct sketch *));
+    b->seed = seed;
+}
+
+void free_band_stat(band_stat * b)
+{
+    int n_zones = zone_info.n_zones;
+    int i;
+
+    if (n_zones == 0)
+	n_zones = 1;
+
+    if (b->sketch) {
+	for (i = 0; i < n_zones; i++)
+	    if (b->sketch[i])
+		sketch_free(b->sketch[i]);
+	G_free(b->sketch);
+    }
+    G_free(b->mom);
+    G_free(b->touched);
+}
+
+/*!
+   \brief Add cells to the statistics of a band
+
+   \param b band
+   \param values values, NULL for null cells
+   \param zones zones of the cells, NULL without zones; cells in a
+   null zone are skipped
+   \param n number of cells
+ */
+void add_cells(band_stat * b, const DCELL * values, const CELL * zones,
+	       size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+	struct moments *m;
+	DCELL v = values[i];
+	double d;
+	int zone = 0;
+
+	if (zones) {
+	    /* skip NULL cells in zone map */
+	    if (Rast_is_c_null_value(&zones[i]))
+		continue;
+	    zone = zones[i] - zone_info.min;
+	}
+
+	m = &b->mom[zone];
+	if (m->size == 0)
+	    b->touched[b->n_touched++] = zone;
+
+	/* count all including NULL cells in input map */
+	m->size++;
+
+	/* can't do stats with NULL cells in input map */
+	if (Rast_is_d_null_value(&v))
+	    continue;
+
+	if (m->n == 0) {
+	    m->shift = v;
+	    m->min = m->max = v;
+	}
+	else {
+	    if (v > m->max)
+		m->max = v;
+	    if (v < m->min)
+		m->min = v;
+	}
+
+	/* the sums are of the differences to the first value, which
+	   keeps the sum of squares from cancelling out */
+	d = v - m->shift;
+	add_compensated(&m->s1, &m->s1_c, d);
+	m->s2 += d * d;
+	add_compensated(&m->sum_abs, &m->sum_abs_c, fabs(v));
+	m->n++;
+
+	if (b->sketch) {
+	    if (!b->sketch[zone])
+		b->sketch[zone] = sketch_create(atof(param.error->answer),
+						b->seed + zone);
+	    sketch_update(b->sketch[zone], v);
+	}
+    }
+}
+
+/*!
+   \brief Merge the statistics of a band into those of the zones
+
+   The band is emptied for the next cells.
+ */
+void merge_band_stat(univar_stat * stats, band_stat * b)
+{
+    int i;
+
+    for (i = 0; i < b->n_touched; i++) {
+	int zone = b->touched[i];
+	struct moments *m = &b->mom[zone];
+	univar_stat *s = &stats[zone];
+
+	s->size += m->size;
+
+	if (m->n > 0) {
+	    double s1 = m->s1 + m->s1_c;
+	    double mean = m->shift + s1 / m->n;
+	    double m2 = m->s2 - s1 * s1 / m->n;
+
+	    if (m2 < 0)
+		m2 = 0;
+
+	    /* pairwise update of mean and squared deviations (Chan et al.) */
+	    if (s->first) {
+		s->mean = mean;
+		s->m2 = m2;
+		s->min = m->min;
+		s->max = m->max;
+		s->first = FALSE;
+	    }
+	    else {
+		double delta = mean - s->mean;
+		double n = (double)s->n + m->n;
+
+		s->mean += delta * m->n / n;
+		s->m2 += m2 + delta * delta * ((double)s->n * m->n / n);
+		if (m->max > s->max)
+		    s->max = m->max;
+		if (m->min < s->min)
+		    s->min = m->min;
+	    }
+
+	    add_compensated(&s->sum, &s->sum_c, m->n * m->shift);
+	    add_compensated(&s->sum, &s->sum_c, s1);
+	    add_compensated(&s->sum_abs, &s->sum_abs_c,
+			    m->sum_abs + m->sum_abs_c);
+	    s->n += m->n;
+	}
+
+	if (b->sketch && b->sketch[zone]) {
+	    if (s->sketch) {
+		sketch_merge(s->sketch, b->sketch[zone]);
+		sketch_free(b->sketch[zone]);
+	    }
+	    else
+		s->sketch = b->sketch[zone];
+	    b->sketch[zone] = NULL;
+	}
+
+	memset(m, 0, sizeof(struct moments));
+    }
+
+    b->n_touched = 0;
+}
+
+
+/* *************************************************************** */
+/* **** ranks of the extended statistics ************************* */
+/* *************************************************************** */
+
+static unsigned long rank_of(unsigned long n, double p)
+{
+    double r = n * p - 0.5;
+
+    if (r <= 0)
+	return 0;
+    if (r >= n - 1)
+	return n - 1;
+    return (unsigned long)r;
+}
+
+/*!
+   \brief Ranks of the values of the extended statistics
+
+   First quartile, the two middle values, third quartile and the
+   percentiles.
+
+   \return number of ranks, 4 + n_perc
+ */
+int get_ranks(const univar_stat * stats, unsigned long *ranks)
+{
+    unsigned long n = stats->n;
+    unsigned int i;
+
+    ranks[0] = rank_of(n, 0.25);
+    ranks[1] = n % 2 ? n / 2 : n / 2 - 1;
+    ranks[2] = n / 2;
+    ranks[3] = rank_of(n, 0.75);
+    for (i = 0; i < stats->n_perc; i++)
+	ranks[4 + i] = rank_of(n, 1e-2 * stats->perc[i]);
+
+    return 4 + stats->n_perc;
+}
+
+/*!
+   \brief Set the extended statistics from the values of the ranks
+ */
+void set_quantiles(univar_stat * stats, const double *values)
+{
+    unsigned int i;
+
+    stats->quartile_25 = values[0];
+    stats->median = (values[1] + values[2]) / 2.0;
+    stats->quartile_75 = values[3];
+    for (i = 0; i < stats->n_perc; i++)
+	stats->quartile_perc[i] = values[4 + i];
+}
+
+/*!
+   \brief Set the extended statistics from the sketches
+ */
+void sketch_quantiles(univar_stat * stats)
+{
+    int z, n_zones = zone_info.n_zones;
+
+    if (n_zones == 0)
+	n_zones = 1;
+
+    for (z = 0; z < n_zones; z++) {
+	unsigned long *ranks;
+	double *values;
+	int nranks;
+
+	if (stats[z].n == 0 || !stats[z].sketch)
+	    continue;
+
+	ranks = G_malloc((4 + stats[z].n_perc) * sizeof(unsigned long));
+	values = G_malloc((4 + stats[z].n_perc) * sizeof(double));
+
+	nranks = get_ranks(&stats[z], ranks);
+	sketch_ranks(stats[z].sketch, stats[z].n, ranks, values, nranks);
+	set_quantiles(&stats[z], values);
+
+	G_free(ranks);
+	G_free(values);
+    }
+}
+
+/* mean, variance etc. of a zone */
+static void get_moments(univar_stat * stats, double *sum, double *sum_abs,
+			double *mean, double *variance)
+{
+    *sum = stats->sum + stats->sum_c;
+    *sum_abs = stats->sum_abs + stats->sum_abs_c;
+
+    /* all these calculations get promoted to doubles, so any DIV0 becomes nan */
+    *mean = *sum / stats->n;
+    *variance = stats->m2 / stats->n;
+    if (*variance < GRASS_EPSILON)
+	*variance = 0.0;
+
+    if (stats->n == 0)
+	*sum = *sum_abs = 0.0 / 0.0;
+}
+
+
 /* *************************************************************** */
 /* **** compute and print univar statistics to stdout ************ */
 /* *************************************************************** */
@@ -111,25 +385,14 @@ int print_stats(univar_stat * stats)
 
     for (z = 0; z < n_zones; z++) {
 	char sum_str[100];
-	double mean, variance, stdev, var_coef;
-
-	/* for extended stats */
-	double quartile_25 = 0.0, quartile_75 = 0.0, *quartile_perc;
-	double median = 0.0;
+	double sum, sum_abs, mean, variance, stdev, var_coef;
 	unsigned int i;
-	int qpos_25, qpos_75, *qpos_perc;
 
-	/* all these calculations get promoted to doubles, so any DIV0 becomes nan */
-	mean = stats[z].sum / stats[z].n;
-	variance = (stats[z].sumsq - stats[z].sum * stats[z].sum / stats[z].n) / stats[z].n;
-	if (variance < GRASS_EPSILON)
-	    variance = 0.0;
+	get_moments(&stats[z], &sum, &sum_abs, &mean, &variance);
 	stdev = sqrt(variance);
 	var_coef = (stdev / mean) * 100.;	/* perhaps stdev/fabs(mean) ? */
 
-	if (stats[z].n == 0)
-	    stats[z].sum = stats[z].sum_abs = 0.0 / 0.0;
-	sprintf(sum_str, "%.15g", stats[z].sum);
+	sprintf(sum_str, "%.15g", sum);
 	G_trim_decimal(sum_str);
 
 
@@ -155,7 +418,7 @@ int print_stats(univar_stat * stats)
 	    fprintf(stdout, "max=%.15g\n", stats[z].max);
 	    fprintf(stdout, "range=%.15g\n", stats[z].max - stats[z].min);
 	    fprintf(stdout, "mean=%.15g\n", mean);
-	    fprintf(stdout, "mean_of_abs=%.15g\n", stats[z].sum_abs / stats[z].n);
+	    fprintf(stdout, "mean_of_abs=%.15g\n", sum_abs / stats[z].n);
 	    fprintf(stdout, "stddev=%.15g\n", stdev);
 	    fprintf(stdout, "variance=%.15g\n", variance);
 	    fprintf(stdout, "coeff_var=%.15g\n", var_coef);
@@ -168,7 +431,7 @@ int print_stats(univar_stat * stats)
 	    fprintf(stdout, "range: %g\n", stats[z].max - stats[z].min);
 	    fprintf(stdout, "mean: %g\n", mean);
 	    fprintf(stdout, "mean of absolute values: %g\n",
-		    stats[z].sum_abs / stats[z].n);
+		    sum_abs / stats[z].n);
 	    fprintf(stdout, "standard deviation: %g\n", stdev);
 	    fprintf(stdout, "variance: %g\n", variance);
 	    fprintf(stdout, "variation coefficient: %g %%\n", var_coef);
@@ -178,74 +441,10 @@ int print_stats(univar_stat * stats)
 
 	/* TODO: mode, skewness, kurtosis */
 	if (param.extended->answer) {
-	    qpos_perc = (int *)G_calloc(stats[z].n_perc, sizeof(int));
-	    quartile_perc = (double *)G_calloc(stats[z].n_perc, sizeof(double));
-
-	    if (stats[z].n == 0) {
-		quartile_25 = median = quartile_75 = 0.0 / 0.0;
-		for (i = 0; i < stats[z].n_perc; i++)
-		    quartile_perc[i] = 0.0 / 0.0;
-	    }
-	    else {
-		for (i = 0; i < stats[z].n_perc; i++) {
-		    qpos_perc[i] = (int)(stats[z].n * 1e-2 * stats[z].perc[i] - 0.5);
-		}
-		qpos_25 = (int)(stats[z].n * 0.25 - 0.5);
-		qpos_75 = (int)(stats[z].n * 0.75 - 0.5);
-
-		switch (stats[z].map_type) {
-		case CELL_TYPE:
-		    heapsort_int(stats[z].cell_array, stats[z].n);
-
-		    quartile_25 = (double)stats[z].cell_array[qpos_25];
-		    if (stats[z].n % 2)	/* odd */
-			median = (double)stats[z].cell_array[(int)(stats[z].n / 2)];
-		    else		/* even */
-			median =
-			    (double)(stats[z].cell_array[stats[z].n / 2 - 1] +
-				     stats[z].cell_array[stats[z].n / 2]) / 2.0;
-		    quartile_75 = (double)stats[z].cell_array[qpos_75];
-		    for (i = 0; i < stats[z].n_perc; i++) {
-			quartile_perc[i] = (double)stats[z].cell_array[qpos_perc[i]];
-		    }
-		    break;
-
-		case FCELL_TYPE:
-		    heapsort_float(stats[z].fcell_array, stats[z].n);
-
-		    quartile_25 = (double)stats[z].fcell_array[qpos_25];
-		    if (stats[z].n % 2)	/* odd */
-			median = (double)stats[z].fcell_array[(int)(stats[z].n / 2)];
-		    else		/* even */
-			median =
-			    (double)(stats[z].fcell_array[stats[z].n / 2 - 1] +
-				     stats[z].fcell_array[stats[z].n / 2]) / 2.0;
-		    quartile_75 = (double)stats[z].fcell_array[qpos_75];
-		    for (i = 0; i < stats[z].n_perc; i++) {
-			quartile_perc[i] = (double)stats[z].fcell_array[qpos_perc[i]];
-		    }
-		    break;
-
-		case DCELL_TYPE:
-		    heapsort_double(stats[z].dcell_array, stats[z].n);
-
-		    quartile_25 = stats[z].dcell_array[qpos_25];
-		    if (stats[z].n % 2)	/* odd */
-			median = stats[z].dcell_array[(int)(stats[z].n / 2)];
-		    else		/* even */
-			median =
-			    (stats[z].dcell_array[stats[z].n / 2 - 1] +
-			     stats[z].dcell_array[stats[z].n / 2]) / 2.0;
-		    quartile_75 = stats[z].dcell_array[qpos_75];
-		    for (i = 0; i < stats[z].n_perc; i++) {
-			quartile_perc[i] = stats[z].dcell_array[qpos_perc[i]];
-		    }
-		    break;
-
-		default:
-		    break;
-		}
-	    }
+	    double quartile_25 = stats[z].quartile_25;
+	    double median = stats[z].median;
+	    double quartile_75 = stats[z].quartile_75;
+	    double *quartile_perc = stats[z].quartile_perc;
 
 	    if (param.shell_style->answer) {
 		fprintf(stdout, "first_quartile=%g\n", quartile_25);
@@ -292,8 +491,6 @@ int print_stats(univar_stat * stats)
 		    }
 		}
 	    }
-	    G_free((void *)quartile_perc);
-	    G_free((void *)qpos_perc);
 	}
 
 	/* G_message() prints to stderr not stdout: disabled. this \n is printed above with zone */
@@ -356,30 +553,16 @@ int print_stats_table(univar_stat * stats)
 
     for (z = 0; z < n_zones; z++) {
 	char sum_str[100];
-	double mean, variance, stdev, var_coef;
-
-	/* for extendet stats */
-	double quartile_25 = 0.0, quartile_75 = 0.0, *quartile_perc;
-	double median = 0.0;
-	int qpos_25, qpos_75, *qpos_perc;
+	double sum, sum_abs, mean, variance, stdev, var_coef;
 
 	/* stats collected for this zone? */
 	if (stats[z].size == 0)
 	    continue;
 
-	i = 0;
-
-	/* all these calculations get promoted to doubles, so any DIV0 becomes nan */
-	mean = stats[z].sum / stats[z].n;
-	variance = (stats[z].sumsq - stats[z].sum * stats[z].sum / stats[z].n) / stats[z].n;
-	if (variance < GRASS_EPSILON)
-	    variance = 0.0;
+	get_moments(&stats[z], &sum, &sum_abs, &mean, &variance);
 	stdev = sqrt(variance);
 	var_coef = (stdev / mean) * 100.;	/* perhaps stdev/fabs(mean) ? */
 
-	if (stats[z].n == 0)
-	    stats[z].sum = stats[z].sum_abs = 0.0 / 0.0;
-
 	if (zone_info.n_zones) {
 	    int z_cat = z + zone_info.min;
 	    /* zone number */
@@ -401,7 +584,7 @@ int print_stats_table(univar_stat * stats)
 	/* mean */
 	fprintf(stdout, "%.15g%s", mean, zone_info.sep);
 	/* mean of abs */
-	fprintf(stdout, "%.15g%s", stats[z].sum_abs / stats[z].n, zone_info.sep);
+	fprintf(stdout, "%.15g%s", sum_abs / stats[z].n, zone_info.sep);
 	/* stddev */
 	fprintf(stdout, "%.15g%s", stdev, zone_info.sep);
 	/* variance */
@@ -409,100 +592,27 @@ int print_stats_table(univar_stat * stats)
 	/* coefficient of variance */
 	fprintf(stdout, "%.15g%s", var_coef, zone_info.sep);
 	/* sum */
-	sprintf(sum_str, "%.15g", stats[z].sum);
+	sprintf(sum_str, "%.15g", sum);
 	G_trim_decimal(sum_str);
 	fprintf(stdout, "%s%s", sum_str, zone_info.sep);
 	/* absolute sum */
-	sprintf(sum_str, "%.15g", stats[z].sum_abs);
+	sprintf(sum_str, "%.15g", sum_abs);
 	G_trim_decimal(sum_str);
 	fprintf(stdout, "%s", sum_str);
 
 	/* TODO: mode, skewness, kurtosis */
 	if (param.extended->answer) {
-	    qpos_perc = (int *)G_calloc(stats[z].n_perc, sizeof(int));
-	    quartile_perc = (double *)G_calloc(stats[z].n_perc, sizeof(double));
-
-
-	    if (stats[z].n == 0) {
-		quartile_25 = median = quartile_75 = 0.0 / 0.0;
-		for (i = 0; i < stats[z].n_perc; i++)
-		    quartile_perc[i] = 0.0 / 0.0;
-	    }
-	    else {
-		for (i = 0; i < stats[z].n_perc; i++) {
-		    qpos_perc[i] = (int)(stats[z].n * 1e-2 * stats[z].perc[i] - 0.5);
-		}
-		qpos_25 = (int)(stats[z].n * 0.25 - 0.5);
-		qpos_75 = (int)(stats[z].n * 0.75 - 0.5);
-
-		switch (stats[z].map_type) {
-		case CELL_TYPE:
-		    heapsort_int(stats[z].cell_array, stats[z].n);
-
-		    quartile_25 = (double)stats[z].cell_array[qpos_25];
-		    if (stats[z].n % 2)	/* odd */
-			median = (double)stats[z].cell_array[(int)(stats[z].n / 2)];
-		    else		/* even */
-			median =
-			    (double)(stats[z].cell_array[stats[z].n / 2 - 1] +
-				     stats[z].cell_array[stats[z].n / 2]) / 2.0;
-		    quartile_75 = (double)stats[z].cell_array[qpos_75];
-		    for (i = 0; i < stats[z].n_perc; i++) {
-			quartile_perc[i] = (double)stats[z].cell_array[qpos_perc[i]];
-		    }
-		    break;
-
-		case FCELL_TYPE:
-		    heapsort_float(stats[z].fcell_array, stats[z].n);
-
-		    quartile_25 = (double)stats[z].fcell_array[qpos_25];
-		    if (stats[z].n % 2)	/* odd */
-			median = (double)stats[z].fcell_array[(int)(stats[z].n / 2)];
-		    else		/* even */
-			median =
-			    (double)(stats[z].fcell_array[stats[z].n / 2 - 1] +
-				     stats[z].fcell_array[stats[z].n / 2]) / 2.0;
-		    quartile_75 = (double)stats[z].fcell_array[qpos_75];
-		    for (i = 0; i < stats[z].n_perc; i++) {
-			quartile_perc[i] = (double)stats[z].fcell_array[qpos_perc[i]];
-		    }
-		    break;
-
-		case DCELL_TYPE:
-		    heapsort_double(stats[z].dcell_array, stats[z].n);
-
-		    quartile_25 = stats[z].dcell_array[qpos_25];
-		    if (stats[z].n % 2)	/* odd */
-			median = stats[z].dcell_array[(int)(stats[z].n / 2)];
-		    else		/* even */
-			median =
-			    (stats[z].dcell_array[stats[z].n / 2 - 1] +
-			     stats[z].dcell_array[stats[z].n / 2]) / 2.0;
-		    quartile_75 = stats[z].dcell_array[qpos_75];
-		    for (i = 0; i < stats[z].n_perc; i++) {
-			quartile_perc[i] = stats[z].dcell_array[qpos_perc[i]];
-		    }
-		    break;
-
-		default:
-		    break;
-		}
-	    }
-
 	    /* first quartile */
-	    fprintf(stdout, "%s%g", zone_info.sep, quartile_25);
+	    fprintf(stdout, "%s%g", zone_info.sep, stats[z].quartile_25);
 	    /* median */
-	    fprintf(stdout, "%s%g", zone_info.sep, median);
+	    fprintf(stdout, "%s%g", zone_info.sep, stats[z].median);
 	    /* third quartile */
-	    fprintf(stdout, "%s%g", zone_info.sep, quartile_75);
+	    fprintf(stdout, "%s%g", zone_info.sep, stats[z].quartile_75);
 	    /* percentiles */
 	    for (i = 0; i < stats[z].n_perc; i++) {
 		fprintf(stdout, "%s%g", zone_info.sep , 
-			quartile_perc[i]);
+			stats[z].quartile_perc[i]);
 	    }
-
-	    G_free((void *)quartile_perc);
-	    G_free((void *)qpos_perc);
 	}
 
 	fprintf(stdout, "\n");
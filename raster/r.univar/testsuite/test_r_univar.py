@@ -85,6 +85,23 @@ class TestRasterUnivar(TestCase):
         self.assertModuleKeyValue(module="r.univar", map="map_a", flags="rg",
                                   reference=univar_string, precision=3, sep='=')
 
+    def test_extended(self):
+        """
+        Check the -e flag
+        :return:
+        """
+
+        univar_string="""n=8100
+        first_quartile=165
+        median=191
+        third_quartile=217
+        percentile_10=141
+        percentile_90=241"""
+
+        self.assertModuleKeyValue(module="r.univar", map="map_a", flags="ge",
+                                  percentile=[10, 90],
+                                  reference=univar_string, precision=3, sep='=')
+
     def test_multiple_1(self):
         # Output of r.univar
         univar_string="""n=16200
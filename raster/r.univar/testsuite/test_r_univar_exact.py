@@ -0,0 +1,135 @@
+"""Test of the exact percentiles of r.univar over several passes
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import os
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+from grass.gunittest.gmodules import SimpleModule
+
+ROWS = 120
+COLS = 90
+PERCENTILES = [10, 90]
+
+# powers of two: many duplicates, and values so unevenly spread that
+# the quartiles take three passes of bins when they are not collected
+VALUES = ('ex_values = if(col() % 17 == 0, null(), '
+          '2.0 ^ ((row() * 7 + col() * 3) % 50))')
+ZONES = 'ex_zones = if(row() % 11 == 0, null(), 1 + (row() + col()) % 3)'
+
+
+def value(row, col):
+    """Cell of VALUES, rows and columns counted from 1"""
+    if col % 17 == 0:
+        return None
+    return 2.0 ** ((row * 7 + col * 3) % 50)
+
+
+def zone(row, col):
+    """Cell of ZONES"""
+    if row % 11 == 0:
+        return None
+    return 1 + (row + col) % 3
+
+
+def rank_of(n, p):
+    r = n * p - 0.5
+    if r <= 0:
+        return 0
+    if r >= n - 1:
+        return n - 1
+    return int(r)
+
+
+def extended(values):
+    """Extended statistics of r.univar -ge from the sorted values"""
+    values = sorted(values)
+    n = len(values)
+    lower = n // 2 if n % 2 else n // 2 - 1
+    stats = {'first_quartile': values[rank_of(n, 0.25)],
+             'median': (values[lower] + values[n // 2]) / 2.0,
+             'third_quartile': values[rank_of(n, 0.75)]}
+    for p in PERCENTILES:
+        stats['percentile_%d' % p] = values[rank_of(n, 1e-2 * p)]
+    return dict((key, '%g' % v) for key, v in stats.items())
+
+
+def parse(output):
+    """Extended statistics of each zone, zone 0 without zones"""
+    result = {}
+    stats = result[0] = {}
+    for line in output.splitlines():
+        key, val = line.split('=', 1)
+        if key == 'zone':
+            stats = result[int(val.split(';')[0])] = {}
+        elif key in ('first_quartile', 'median', 'third_quartile') or \
+                key.startswith('percentile_'):
+            stats[key] = val
+    return result
+
+
+class TestExact(TestCase):
+    """Quartiles and percentiles against the sorted values"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        cls.runModule('r.mapcalc', expression=VALUES)
+        cls.runModule('r.mapcalc', expression=ZONES)
+
+        cells = [(value(r, c), zone(r, c))
+                 for r in range(1, ROWS + 1) for c in range(1, COLS + 1)
+                 if value(r, c) is not None]
+        cls.expected = {0: extended([v for v, z in cells])}
+        cls.expected_zones = {}
+        for z in (1, 2, 3):
+            cls.expected_zones[z] = extended([v for v, vz in cells
+                                              if vz == z])
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=['ex_values', 'ex_zones'])
+
+    def univar(self, collect, **kwargs):
+        """Output of r.univar -ge, collecting at most collect values in
+        a pass, None for the default"""
+        if collect is not None:
+            os.environ['GRASS_UNIVAR_COLLECT_CELLS'] = str(collect)
+        try:
+            module = SimpleModule('r.univar', flags='ge', map='ex_values',
+                                  percentile=PERCENTILES, **kwargs)
+            self.assertModule(module)
+        finally:
+            os.environ.pop('GRASS_UNIVAR_COLLECT_CELLS', None)
+        return parse(module.outputs.stdout)
+
+    def test_collected(self):
+        """All values collected in the first pass"""
+        self.assertEqual(self.univar(None), self.expected)
+        stats = self.univar(None, zones='ex_zones')
+        del stats[0]
+        self.assertEqual(stats, self.expected_zones)
+
+    def test_passes(self):
+        """Values counted in bins over several passes, then collected
+        in the last pass, or never collected"""
+        for collect in [0, 1, 300, 6000, 9000]:
+            self.assertEqual(self.univar(collect), self.expected)
+            stats = self.univar(collect, zones='ex_zones')
+            del stats[0]
+            self.assertEqual(stats, self.expected_zones,
+                             msg='collecting %d values' % collect)
+
+
+if __name__ == '__main__':
+    test()
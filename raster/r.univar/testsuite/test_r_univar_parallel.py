@@ -0,0 +1,149 @@
+"""Test of r.univar with several threads and approximate percentiles
+
+@copyright 2026 by the GRASS Development Team
+
+@license This program is free software under the
+GNU General Public License (>=v2).
+Read the file COPYING that comes with GRASS
+for details
+"""
+
+import math
+
+from grass.gunittest.case import TestCase
+from grass.gunittest.main import test
+from grass.gunittest.gmodules import SimpleModule
+from grass.script.utils import parse_key_val
+
+ROWS = 300
+COLS = 200
+PERCENTILES = [10, 90]
+QUANTILES = ['first_quartile', 'median', 'third_quartile',
+             'percentile_10', 'percentile_90']
+
+# rows and columns counted from 1 as in r.mapcalc, sin() takes degrees
+INPUTS = {
+    'par_ci': ('if(col() % 11 == 0, null(), (row() * 37 + col()) % 1001)',
+               lambda r, c: None if c % 11 == 0 else (r * 37 + c) % 1001),
+    'par_di': ('sin(row() * 0.05) * 100 + col() * 0.001',
+               lambda r, c: math.sin(math.radians(r * 0.05)) * 100 +
+               c * 0.001),
+    'par_zones': ('if(row() % 7 == 0, null(), 1 + (row() + col()) % 3)',
+                  lambda r, c: None if r % 7 == 0 else 1 + (r + c) % 3),
+}
+
+
+def cells(name):
+    value = INPUTS[name][1]
+    return [value(r, c) for r in range(1, ROWS + 1)
+            for c in range(1, COLS + 1)]
+
+
+def rank_of(n, p):
+    r = n * p - 0.5
+    if r <= 0:
+        return 0
+    if r >= n - 1:
+        return n - 1
+    return int(r)
+
+
+def univar(values):
+    """Statistics of r.univar -ge of the values, None for nulls"""
+    data = sorted(v for v in values if v is not None)
+    n = len(data)
+    mean = math.fsum(data) / n
+    variance = math.fsum((v - mean) ** 2 for v in data) / n
+    lower = n // 2 if n % 2 else n // 2 - 1
+    stats = {'n': n, 'null_cells': len(values) - n, 'cells': len(values),
+             'min': data[0], 'max': data[-1], 'range': data[-1] - data[0],
+             'mean': mean, 'sum': math.fsum(data),
+             'stddev': math.sqrt(variance), 'variance': variance,
+             'first_quartile': data[rank_of(n, 0.25)],
+             'median': (data[lower] + data[n // 2]) / 2.0,
+             'third_quartile': data[rank_of(n, 0.75)]}
+    for p in PERCENTILES:
+        stats['percentile_%d' % p] = data[rank_of(n, 1e-2 * p)]
+    return stats
+
+
+def parse_zones(output):
+    """Statistics of each zone"""
+    result = {}
+    for line in output.splitlines():
+        key, val = line.split('=', 1)
+        if key == 'zone':
+            stats = result[int(val.split(';')[0])] = {}
+        else:
+            stats[key] = float(val)
+    return result
+
+
+class TestParallel(TestCase):
+    """Statistics with one and several threads against the values"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.use_temp_region()
+        cls.runModule('g.region', n=ROWS, s=0, w=0, e=COLS, res=1)
+        for name, (expression, value) in INPUTS.items():
+            cls.runModule('r.mapcalc',
+                          expression='%s = %s' % (name, expression))
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.del_temp_region()
+        cls.runModule('g.remove', flags='f', type='raster',
+                      name=list(INPUTS))
+
+    def univar(self, **kwargs):
+        module = SimpleModule('r.univar', flags='ge', percentile=PERCENTILES,
+                              **kwargs)
+        self.assertModule(module)
+        return module.outputs.stdout
+
+    def assertStats(self, actual, reference, precision):
+        """Statistics up to the relative precision"""
+        for key, value in reference.items():
+            self.assertAlmostEqual(actual[key], value,
+                                   delta=precision * max(1, abs(value)),
+                                   msg=key)
+
+    def test_nprocs(self):
+        """Statistics with one and four threads"""
+        # the percentiles of FP maps are printed with 6 digits
+        for name, precision in [('par_ci', 1e-12), ('par_di', 1e-5)]:
+            reference = univar(cells(name))
+            for nprocs in [1, 4]:
+                stats = parse_key_val(self.univar(map=name, nprocs=nprocs),
+                                      sep='=', val_type=float)
+                self.assertStats(stats, reference, precision)
+
+    def test_nprocs_zones(self):
+        """Statistics of the zones with one and four threads"""
+        values = cells('par_di')
+        zones = cells('par_zones')
+        reference = {}
+        for z in (1, 2, 3):
+            reference[z] = univar([v for v, vz in zip(values, zones)
+                                   if vz == z])
+        for nprocs in [1, 4]:
+            stats = parse_zones(self.univar(map='par_di', zones='par_zones',
+                                            nprocs=nprocs))
+            self.assertEqual(sorted(stats), sorted(reference))
+            for z in reference:
+                self.assertStats(stats[z], reference[z], 1e-5)
+
+    def test_error(self):
+        """Approximate percentiles within the error"""
+        exact = univar(cells('par_di'))
+        approx = parse_key_val(self.univar(map='par_di', error=0.01),
+                               sep='=', val_type=float)
+        # the values span less than 30
+        for key in QUANTILES:
+            self.assertAlmostEqual(approx[key], exact[key], delta=1)
+        self.assertEqual(approx['n'], exact['n'])
+
+
+if __name__ == '__main__':
+    test()
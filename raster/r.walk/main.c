@@ -540,20 +540,6 @@ int main(int argc, char *argv[])
     G_format_resolution(window.ns_res, buf, window.proj);
     G_debug(1, " NS resolution %s (%g)", buf, window.ns_res);
 
-    /* this is most probably the limitation of r.walk for large datasets
-     * segment size needs to be reduced to avoid unnecessary disk IO
-     * but it doesn't make sense to go down to 1
-     * so use 64 segment rows and cols for <= 200 million cells
-     * for larger regions, 32 segment rows and cols
-     * maybe go down to 16 for > 500 million cells ? */
-    if ((double) nrows * ncols > 200000000)
-	srows = scols = SEGCOLSIZE / 2;
-    else
-	srows = scols = SEGCOLSIZE;
-
-    /* calculate total number of segments */
-    nseg = ((nrows + srows - 1) / srows) * ((ncols + scols - 1) / scols);
-
     /* calculate disk space and memory requirements */
     /* (nrows + ncols) * 8. * 20.0 / 1048576. for Dijkstra search */
     pq_mb = ((double)nrows + ncols) * 8. * 20.0 / 1048576.;
@@ -568,6 +554,23 @@ int main(int argc, char *argv[])
     if (have_solver)
 	nbytes += 16;
 
+    /* this is most probably the limitation of r.walk for large datasets:
+     * the cells around the search front are visited in the order of
+     * their costs, so the segments along the front should stay in memory.
+     * The front is at most about 2 * (nrows + ncols) cells long and
+     * touches a band of segments along it, so the segment size is reduced
+     * until that band fits, unless all segments fit anyway.
+     * It doesn't make sense to go below 16 segment rows and cols */
+    srows = scols = SEGCOLSIZE;
+    while (srows > SEGCOLSIZE / 4 &&
+	   (double) nrows * ncols * nbytes / 1048576. > maxmem &&
+	   2. * ((double)nrows + ncols) * srows * nbytes / 1048576. > maxmem)
+	srows = scols = srows / 2;
+    G_debug(1, "segment size: %d x %d", srows, scols);
+
+    /* calculate total number of segments */
+    nseg = ((nrows + srows - 1) / srows) * ((ncols + scols - 1) / scols);
+
     disk_mb = (double) nrows * ncols * nbytes / 1048576.;
     segments_in_memory = maxmem / 
 			 ((double) srows * scols * (nbytes / 1048576.));
@@ -973,7 +976,6 @@ int main(int argc, char *argv[])
 
     pres_cell = get_lowest();
     while (pres_cell != NULL) {
-	struct cost *ct;
 	double N_dtm, NE_dtm, E_dtm, SE_dtm, S_dtm, SW_dtm, W_dtm, NW_dtm;
 	double NNE_dtm, ENE_dtm, ESE_dtm, SSE_dtm, SSW_dtm, WSW_dtm, WNW_dtm,
 	    NNW_dtm;
@@ -998,25 +1000,21 @@ int main(int argc, char *argv[])
 	old_min_cost = costs.cost_out;
 	if (!Rast_is_d_null_value(&old_min_cost)) {
 	    if (pres_cell->min_cost > old_min_cost) {
-		delete(pres_cell);
 		pres_cell = get_lowest();
 		continue;
 	    }
 	}
 	my_dtm = costs.dtm;
 	if (Rast_is_d_null_value(&my_dtm)) {
-	    delete(pres_cell);
 	    pres_cell = get_lowest();
 	    continue;
 	}
 	my_cost = costs.cost_in;
 	if (Rast_is_d_null_value(&my_cost)) {
-	    delete(pres_cell);
 	    pres_cell = get_lowest();
 	    continue;
 	}
 	if (FLAG_GET(visited, pres_cell->row, pres_cell->col)) {
-	    delete(pres_cell);
 	    pres_cell = get_lowest();
 	    continue;
 	}
@@ -1491,8 +1489,7 @@ int main(int argc, char *argv[])
 	    if (Rast_is_d_null_value(&min_cost))
 		continue;
 
-	    if (Segment_get(&cost_seg, &costs, row, col) < 0)
-		G_fatal_error(_("Can not read from temporary file"));
+	    /* costs still holds the neighbor */
 	    old_min_cost = costs.cost_out;
 
 	    /* add to list */
@@ -1592,12 +1589,7 @@ int main(int argc, char *argv[])
 	if (stop_pnts && time_to_stop(pres_cell->row, pres_cell->col))
 	    break;
 
-	ct = pres_cell;
-	delete(pres_cell);
 	pres_cell = get_lowest();
-
-	if (ct == pres_cell)
-	    G_warning(_("Error, ct == pres_cell"));
     }
     G_percent(1, 1, 1);
 